@@ -268,6 +268,7 @@ void pbsys_main_run_program(pbsys_main_program_t *program) {
     uint32_t align = MICROPY_BYTES_PER_GC_BLOCK -
         (uint32_t)program->code_end % MICROPY_BYTES_PER_GC_BLOCK;
     gc_init(program->code_end + align, program->data_end);
+    pb_gc_stats = (pb_gc_stats_t) { 0 };
 
     // Set program data reference to first script. This is used to run main,
     // and to set the starting point for finding downloaded modules.
@@ -301,10 +302,21 @@ void pbsys_main_run_program(pbsys_main_program_t *program) {
     mp_deinit();
 }
 
+pb_gc_stats_t pb_gc_stats;
+
 void gc_collect(void) {
+    uint32_t start = mp_hal_ticks_us();
+
     gc_collect_start();
     gc_helper_collect_regs_and_stack();
     gc_collect_end();
+
+    uint32_t time = mp_hal_ticks_us() - start;
+    pb_gc_stats.collections++;
+    pb_gc_stats.time_us += time;
+    if (time > pb_gc_stats.time_max_us) {
+        pb_gc_stats.time_max_us = time;
+    }
 }
 
 mp_obj_t mp_builtin_open(size_t n_args, const mp_obj_t *args, mp_map_t *kwargs) {
@@ -23,6 +23,7 @@ CONTIKI_SRC_C = $(addprefix lib/contiki-core/,\
 
 PYBRICKS_PYBRICKS_SRC_C = $(addprefix pybricks/,\
 	common/pb_type_battery.c \
+	common/pb_type_ble.c \
 	common/pb_type_charger.c \
 	common/pb_type_colorlight_external.c \
 	common/pb_type_colorlight_internal.c \
@@ -96,6 +97,8 @@ PYBRICKS_PYBRICKS_SRC_C = $(addprefix pybricks/,\
 	robotics/pb_type_drivebase.c \
 	robotics/pb_type_spikebase.c \
 	tools/pb_module_tools.c \
+	tools/pb_type_awaitable.c \
+	tools/pb_type_settings.c \
 	tools/pb_type_stopwatch.c \
 	util_mp/pb_obj_helper.c \
 	util_mp/pb_type_enum.c \
@@ -175,8 +178,10 @@ PBIO_SRC_C = $(addprefix lib/pbio/,\
 	drv/uart/uart_stm32f0.c \
 	drv/uart/uart_stm32f4_ll_irq.c \
 	drv/uart/uart_stm32l4_ll_dma.c \
+	drv/uart/uart_virtual.c \
 	drv/usb/usb_stm32.c \
 	drv/virtual.c \
+	drv/virtual_physics.c \
 	drv/watchdog/watchdog_stm32.c \
 	platform/$(PBIO_PLATFORM)/platform.c \
 	src/angle.c \
@@ -220,6 +225,7 @@ PBIO_SRC_C = $(addprefix lib/pbio/,\
 	sys/main.c \
 	sys/program_load.c \
 	sys/program_stop.c \
+	sys/settings.c \
 	sys/status.c \
 	sys/supervisor.c \
 	)
@@ -1,2 +1,2 @@
 
-#define PBSYS_APP_HUB_FEATURE_FLAGS (PBIO_PYBRICKS_FEATURE_REPL | PBIO_PYBRICKS_FEATURE_USER_PROG_FORMAT_MULTI_MPY_V6)
+#define PBSYS_APP_HUB_FEATURE_FLAGS (PBIO_PYBRICKS_FEATURE_REPL | PBIO_PYBRICKS_FEATURE_USER_PROG_FORMAT_MULTI_MPY_V6 | PBIO_PYBRICKS_FEATURE_USER_PROG_WRITE_WITHOUT_RESPONSE | PBIO_PYBRICKS_FEATURE_USER_PROG_COMPARE_RAM)
@@ -129,6 +129,10 @@ void pb_virtualhub_port_init(void) {
 
 // MICROPY_PORT_DEINIT_FUNC
 void pb_virtualhub_port_deinit(void) {
+    #if PROCESS_CONF_PROFILE
+    process_profile_print(stderr);
+    #endif
+
     pbio_error_t err = pbdrv_virtual_platform_stop();
 
     if (err != PBIO_SUCCESS) {
@@ -166,6 +170,13 @@ start:
         return;
     }
 
+    // With a simulated clock, being idle means nothing can happen until the
+    // next timer expires, so skip ahead instead of sleeping.
+    if (pbdrv_clock_virtual_is_simulated()) {
+        pbdrv_clock_virtual_advance(1000);
+        return;
+    }
+
     sigset_t sigmask;
     sigfillset(&sigmask);
 
@@ -194,9 +205,13 @@ start:
 }
 
 uint64_t pb_virtualhub_time_ns(void) {
-    uint64_t value;
-    pb_assert(pbdrv_virtual_get_u64("clock", -1, "nanoseconds", &value));
-    return value;
+    // A simulated clock doesn't advance while the program runs, no matter how
+    // much code runs, but only while it waits. Reading the clock lets 1 us
+    // pass, so that loops that poll the clock without waiting, e.g.
+    // `while watch.time() < 100: pass`, still finish.
+    pbdrv_clock_virtual_advance(1);
+
+    return pbdrv_clock_virtual_get_ns();
 }
 
 mp_uint_t pb_virtualhub_ticks_us(void) {
@@ -208,9 +223,12 @@ mp_uint_t pb_virtualhub_ticks_ms(void) {
 }
 
 void pb_virtualhub_delay_us(mp_uint_t us) {
-    mp_uint_t start = pb_virtualhub_ticks_us();
+    // Reads the clock without letting time pass, so the delay is exact.
+    mp_uint_t start = pbdrv_clock_virtual_get_ns() / 1000;
+    mp_uint_t elapsed;
 
-    while (pb_virtualhub_ticks_us() - start < us) {
+    while ((elapsed = pbdrv_clock_virtual_get_ns() / 1000 - start) < us) {
+        pbdrv_clock_virtual_advance(us - elapsed);
         pb_virtualhub_poll();
     }
 }
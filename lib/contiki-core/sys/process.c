@@ -49,6 +49,30 @@
 #include "sys/process.h"
 #include "sys/arg.h"
 
+#if PROCESS_CONF_PROFILE
+#include <string.h>
+
+#include "sys/clock.h"
+
+#ifndef PROCESS_CONF_PROFILE_CLOCK
+#define PROCESS_CONF_PROFILE_CLOCK clock_usecs
+#endif /* PROCESS_CONF_PROFILE_CLOCK */
+
+struct process_profile process_profile;
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+
+uint32_t
+process_profile_host_clock(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+#endif /* defined(__unix__) || defined(__APPLE__) */
+#endif /* PROCESS_CONF_PROFILE */
+
 /*
  * Pointer to the currently running process structure.
  */
@@ -64,6 +88,9 @@ struct event_data {
   process_event_t ev;
   process_data_t data;
   struct process *p;
+#if PROCESS_CONF_PROFILE
+  uint32_t posted;
+#endif /* PROCESS_CONF_PROFILE */
 };
 
 static process_num_events_t nevents, fevent;
@@ -81,6 +108,52 @@ static volatile unsigned char poll_requested;
 
 static void call_process(struct process *p, process_event_t ev, process_data_t data);
 
+#if PROCESS_CONF_PROFILE
+/*---------------------------------------------------------------------------*/
+static void
+profile_add(struct process_profile_time *t, uint32_t time)
+{
+  t->count++;
+  t->total += time;
+  if(time > t->max) {
+    t->max = time;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct process_profile_time *
+profile_process(struct process *p)
+{
+  int i;
+
+  for(i = 0; i < PROCESS_CONF_PROFILE_PROCESSES; i++) {
+    if(process_profile.processes[i].p == NULL) {
+      process_profile.processes[i].p = p;
+    }
+    if(process_profile.processes[i].p == p) {
+      return &process_profile.processes[i].run;
+    }
+  }
+
+  /* Too many processes, this one is not counted. */
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+profile_event(uint32_t posted)
+{
+  uint32_t latency = PROCESS_CONF_PROFILE_CLOCK() - posted;
+  int bucket = 0;
+
+  profile_add(&process_profile.latency, latency);
+
+  while(bucket < PROCESS_PROFILE_LATENCY_BUCKETS - 1 &&
+        latency >= (UINT32_C(1) << bucket)) {
+    bucket++;
+  }
+  process_profile.latency_histogram[bucket]++;
+}
+#endif /* PROCESS_CONF_PROFILE */
+
 #define DEBUG 0
 #if DEBUG
 #include <stdio.h>
@@ -188,7 +261,18 @@ call_process(struct process *p, process_event_t ev, process_data_t data)
     PRINTF("process: calling process '%s' with event 0x%02X\n", PROCESS_NAME_STRING(p), ev);
     process_current = p;
     p->state = PROCESS_STATE_CALLED;
+#if PROCESS_CONF_PROFILE
+    {
+      struct process_profile_time *t = profile_process(p);
+      uint32_t start = PROCESS_CONF_PROFILE_CLOCK();
+      ret = p->thread(&p->pt, ev, data);
+      if(t != NULL) {
+        profile_add(t, PROCESS_CONF_PROFILE_CLOCK() - start);
+      }
+    }
+#else
     ret = p->thread(&p->pt, ev, data);
+#endif /* PROCESS_CONF_PROFILE */
     if(ret == PT_EXITED ||
        ret == PT_ENDED ||
        ev == PROCESS_EVENT_EXIT) {
@@ -214,6 +298,9 @@ process_init(void)
 #if PROCESS_CONF_STATS
   process_maxevents = 0;
 #endif /* PROCESS_CONF_STATS */
+#if PROCESS_CONF_PROFILE
+  memset(&process_profile, 0, sizeof(process_profile));
+#endif /* PROCESS_CONF_PROFILE */
 
   process_current = process_list = NULL;
 }
@@ -266,6 +353,9 @@ do_event(void)
 
     data = events[fevent].data;
     receiver = events[fevent].p;
+#if PROCESS_CONF_PROFILE
+    profile_event(events[fevent].posted);
+#endif /* PROCESS_CONF_PROFILE */
 
     /* Since we have seen the new event, we move pointer upwards
        and decrease the number of events. */
@@ -333,6 +423,13 @@ process_post(struct process *p, process_event_t ev, process_data_t data)
 	   p == PROCESS_BROADCAST? "<broadcast>": PROCESS_NAME_STRING(p), nevents);
   }
 
+#if PROCESS_CONF_PROFILE
+  process_profile.posts++;
+  if(nevents == PROCESS_CONF_NUMEVENTS) {
+    process_profile.posts_dropped++;
+  }
+#endif /* PROCESS_CONF_PROFILE */
+
   if(nevents == PROCESS_CONF_NUMEVENTS) {
 #if DEBUG
     if(p == PROCESS_BROADCAST) {
@@ -350,6 +447,13 @@ process_post(struct process *p, process_event_t ev, process_data_t data)
   events[snum].p = p;
   ++nevents;
 
+#if PROCESS_CONF_PROFILE
+  events[snum].posted = PROCESS_CONF_PROFILE_CLOCK();
+  if(nevents > process_profile.maxevents) {
+    process_profile.maxevents = nevents;
+  }
+#endif /* PROCESS_CONF_PROFILE */
+
 #if PROCESS_CONF_STATS
   if(nevents > process_maxevents) {
     process_maxevents = nevents;
@@ -374,6 +478,12 @@ process_poll(struct process *p)
   if(p != NULL) {
     if(p->state == PROCESS_STATE_RUNNING ||
        p->state == PROCESS_STATE_CALLED) {
+#if PROCESS_CONF_PROFILE
+      process_profile.polls++;
+      if(p->needspoll) {
+        process_profile.polls_coalesced++;
+      }
+#endif /* PROCESS_CONF_PROFILE */
       p->needspoll = 1;
       poll_requested = 1;
       
@@ -391,4 +501,55 @@ process_is_running(struct process *p)
   return p->state != PROCESS_STATE_NONE;
 }
 /*---------------------------------------------------------------------------*/
+#if PROCESS_CONF_PROFILE
+static unsigned long
+profile_mean(const struct process_profile_time *t)
+{
+  return t->count ? (unsigned long)(t->total / t->count) : 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+process_profile_print(FILE *f)
+{
+  int i;
+
+  fprintf(f, "event loop profile:\n");
+  fprintf(f, "  events: %lu delivered, latency mean %lu us, max %lu us\n",
+          (unsigned long)process_profile.latency.count,
+          profile_mean(&process_profile.latency),
+          (unsigned long)process_profile.latency.max);
+  for(i = 0; i < PROCESS_PROFILE_LATENCY_BUCKETS; i++) {
+    if(process_profile.latency_histogram[i] == 0) {
+      continue;
+    }
+    if(i < PROCESS_PROFILE_LATENCY_BUCKETS - 1) {
+      fprintf(f, "    < %5lu us: %lu\n", 1UL << i,
+              (unsigned long)process_profile.latency_histogram[i]);
+    } else {
+      fprintf(f, "    >=%5lu us: %lu\n", 1UL << (i - 1),
+              (unsigned long)process_profile.latency_histogram[i]);
+    }
+  }
+  fprintf(f, "  queue: %lu posted, %lu dropped, high-water mark %d of %d\n",
+          (unsigned long)process_profile.posts,
+          (unsigned long)process_profile.posts_dropped,
+          process_profile.maxevents, PROCESS_CONF_NUMEVENTS);
+  fprintf(f, "  polls: %lu requested, %lu coalesced\n",
+          (unsigned long)process_profile.polls,
+          (unsigned long)process_profile.polls_coalesced);
+  fprintf(f, "  %-32s %10s %10s %10s %10s\n",
+          "process", "calls", "total us", "mean us", "max us");
+  for(i = 0; i < PROCESS_CONF_PROFILE_PROCESSES; i++) {
+    const struct process_profile_time *t = &process_profile.processes[i].run;
+    if(process_profile.processes[i].p == NULL) {
+      break;
+    }
+    fprintf(f, "  %-32s %10lu %10llu %10lu %10lu\n",
+            PROCESS_NAME_STRING(process_profile.processes[i].p),
+            (unsigned long)t->count, (unsigned long long)t->total,
+            profile_mean(t), (unsigned long)t->max);
+  }
+}
+/*---------------------------------------------------------------------------*/
+#endif /* PROCESS_CONF_PROFILE */
 /** @} */
@@ -520,6 +520,80 @@ int process_nevents(void);
 
 /** @} */
 
+#if PROCESS_CONF_PROFILE
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * \name Event loop profiler
+ *
+ * When PROCESS_CONF_PROFILE is enabled, the process kernel measures
+ * how long events wait in the queue, how long each process runs and
+ * how full the queue gets. Times are read from
+ * PROCESS_CONF_PROFILE_CLOCK(), in microseconds, which defaults to
+ * clock_usecs(). The statistics are reset by process_init().
+ * @{
+ */
+
+#ifndef PROCESS_CONF_PROFILE_PROCESSES
+#define PROCESS_CONF_PROFILE_PROCESSES 32
+#endif /* PROCESS_CONF_PROFILE_PROCESSES */
+
+/** Number of buckets of the latency histogram. Bucket n counts
+    latencies below 2^n microseconds, the last one all others. */
+#define PROCESS_PROFILE_LATENCY_BUCKETS 16
+
+struct process_profile_time {
+  uint32_t count;
+  uint32_t max;
+  uint64_t total;
+};
+
+struct process_profile {
+  /** Time from process_post() to delivery of the event. */
+  struct process_profile_time latency;
+  uint32_t latency_histogram[PROCESS_PROFILE_LATENCY_BUCKETS];
+  /** Events posted, including those that did not fit. */
+  uint32_t posts;
+  /** Events that did not fit in the queue. */
+  uint32_t posts_dropped;
+  /** Most events waiting in the queue at once. */
+  process_num_events_t maxevents;
+  /** Calls to process_poll(). */
+  uint32_t polls;
+  /** Calls to process_poll() for a process that was already polled. */
+  uint32_t polls_coalesced;
+  /** Time spent in each process, including synchronous calls to
+      other processes. */
+  struct {
+    struct process *p;
+    struct process_profile_time run;
+  } processes[PROCESS_CONF_PROFILE_PROCESSES];
+};
+
+extern struct process_profile process_profile;
+
+/**
+ * Print a report of the event loop profile.
+ *
+ * \param f The file to print to.
+ */
+void process_profile_print(FILE *f);
+
+#if defined(__unix__) || defined(__APPLE__)
+/**
+ * Read the computer's monotonic clock, in microseconds.
+ *
+ * Builds that run on a computer with a simulated clock can set
+ * PROCESS_CONF_PROFILE_CLOCK to this, since a simulated clock does
+ * not move while code runs.
+ */
+uint32_t process_profile_host_clock(void);
+#endif /* defined(__unix__) || defined(__APPLE__) */
+
+/** @} */
+#endif /* PROCESS_CONF_PROFILE */
+
 CCIF extern struct process *process_list;
 
 #define PROCESS_LIST() process_list
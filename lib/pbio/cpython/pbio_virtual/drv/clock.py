@@ -16,6 +16,16 @@ class VirtualClock:
     or ``pbdrv_clock_get_100us()`` is called.
     """
 
+    simulated: bool = False
+    """
+    When true, the virtual hub keeps the time itself and advances it only when
+    it is idle, jumping ahead to the next timer deadline, or by 1 µs when the
+    program reads the clock. :attr:`nanoseconds` is then only read once at
+    startup and updated with :meth:`on_advance`.
+
+    This value is read once when ``pbdrv_clock_init()`` is called.
+    """
+
     _thread_id: int
     _signum: int
 
@@ -29,7 +39,8 @@ class VirtualClock:
 
     def on_init(self, thread_id: int, signum: int):
         """
-        Called when ``pbdrv_clock_init()`` is called.
+        Called when ``pbdrv_clock_init()`` is called. Not called for
+        :attr:`simulated` clocks, which don't use the interrupt.
 
         Args:
             thread_id: The id of the thread to be interrupted.
@@ -38,6 +49,15 @@ class VirtualClock:
         self._thread_id = thread_id
         self._signum = signum
 
+    def on_advance(self, nanoseconds: int):
+        """
+        Called when the virtual hub advances a simulated clock.
+
+        Args:
+            nanoseconds: The new clock time in nanoseconds.
+        """
+        self.nanoseconds = nanoseconds
+
     @property
     def microseconds(self) -> int:
         """
@@ -125,3 +145,27 @@ class CountingClock(VirtualClock):
             self.nanoseconds += self._step_ns
 
         self.interrupt()
+
+
+class SimulatedClock(VirtualClock):
+    """
+    Clock implementation for lock-step simulation.
+
+    Time does not pass while the virtual hub is busy, no matter how much code
+    it runs. When it is idle, the time jumps directly to the next timer
+    deadline. Runs are deterministic and
+    run as fast as the computer allows, no matter how much virtual time passes.
+    """
+
+    simulated = True
+
+    def __init__(self, start: int = (2**32 - 3) * 1000) -> None:
+        """
+        Args:
+            start:
+                The starting time in microseconds. The default value is the
+                same as for :class:`CountingClock`.
+        """
+        super().__init__()
+        # convert microseconds to nanoseconds
+        self.nanoseconds = start * 1000
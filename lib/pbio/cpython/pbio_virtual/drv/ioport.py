@@ -2,8 +2,11 @@
 # Copyright (c) 2022 The Pybricks Authors
 
 from enum import IntEnum
+from typing import Optional
 import ctypes
 
+from .uart import VirtualUart
+
 
 class PortId(IntEnum):
     """
@@ -307,6 +310,8 @@ write_begin = ctypes.CFUNCTYPE(
 write_end = ctypes.CFUNCTYPE(ctypes.c_uint32, ctypes.POINTER(pbio_iodev_t))
 write_cancel = ctypes.CFUNCTYPE(None, ctypes.POINTER(pbio_iodev_t))
 
+uart_connection_changed = ctypes.CFUNCTYPE(None, ctypes.c_uint32, ctypes.c_bool)
+
 
 class pbio_iodev_ops_t(ctypes.Structure):
     _fields_ = [
@@ -342,6 +347,14 @@ class VirtualIOPort:
     attached or if nothing is attached.
     """
 
+    uart: Optional[VirtualUart] = None
+    """
+    The UART of this port, if UART devices are supported.
+
+    The same object must also be assigned to ``platform.uart[<id>]``, where
+    ``<id>`` is the index of the port.
+    """
+
     def __init__(self, port: PortId) -> None:
         """
         Creates a new virtual I/O port.
@@ -349,6 +362,7 @@ class VirtualIOPort:
         Args:
             port: The port identifier.
         """
+        self._port = port
         self._info = pbio_iodev_info_t()
         self._ops = pbio_iodev_ops_t()
         self._iodev = pbio_iodev_t(
@@ -365,3 +379,27 @@ class VirtualIOPort:
         This property is read when ``pbdrv_ioport_get_iodev()`` is called.
         """
         return ctypes.addressof(self._iodev)
+
+    def on_uart_start(self, callback: int) -> None:
+        """
+        Called when the virtual hub starts watching :attr:`uart` for devices.
+
+        When a device is plugged in, the ``uartdev`` driver of the hub is used
+        to communicate with it instead of :attr:`iodev`.
+
+        Args:
+            callback: The address of a C function
+                ``void (*)(pbio_port_id_t port, bool connected)`` that is called
+                right away if a device is plugged in and again each time a
+                device is plugged in or unplugged.
+        """
+        if self.uart is None:
+            return
+
+        # keep a reference to the ctypes function as long as it may be called
+        changed = uart_connection_changed(callback)
+        self._uart_connection_changed = changed
+        self.uart.subscribe_connection(lambda connected: changed(self._port, connected))
+
+        if self.uart.connected:
+            changed(self._port, True)
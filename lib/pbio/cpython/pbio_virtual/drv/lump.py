@@ -0,0 +1,468 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2023 The Pybricks Authors
+
+"""Emulated LEGO UART Messaging Protocol (LUMP) devices.
+
+A :class:`LumpDevice` is plugged into a :class:`~pbio_virtual.drv.uart.VirtualUart`
+and talks to the ``uartdev`` driver of the virtual hub like a real sensor: it
+negotiates the baud rate, sends its mode information until the hub
+acknowledges it, then streams data for the selected mode and watches for
+keep-alive messages. This allows testing ``uartdev`` on many ports at once,
+including plugging and unplugging, noisy links and custom device types.
+
+The protocol is described in ``lib/lego/lego_uart.h``. Values below are the
+same as the constants in that file.
+"""
+
+from __future__ import annotations
+
+import struct
+from enum import IntEnum, IntFlag
+from typing import Callable, Dict, NamedTuple, Optional, Sequence, Tuple
+
+from .ioport import IODeviceTypeId
+from .uart import UartDevice
+
+MSG_TYPE_SYS = 0x00
+MSG_TYPE_CMD = 0x40
+MSG_TYPE_INFO = 0x80
+MSG_TYPE_DATA = 0xC0
+
+SYS_SYNC = 0x00
+SYS_NACK = 0x02
+SYS_ACK = 0x04
+
+CMD_TYPE = 0x0
+CMD_MODES = 0x1
+CMD_SPEED = 0x2
+CMD_SELECT = 0x3
+CMD_WRITE = 0x4
+CMD_EXT_MODE = 0x6
+CMD_VERSION = 0x7
+
+INFO_NAME = 0x00
+INFO_RAW = 0x01
+INFO_PCT = 0x02
+INFO_SI = 0x03
+INFO_UNITS = 0x04
+INFO_MAPPING = 0x05
+INFO_MODE_COMBOS = 0x06
+INFO_FORMAT = 0x80
+INFO_MODE_PLUS_8 = 0x20
+
+SPEED_MIN = 2400
+SPEED_LPF2 = 115200
+
+
+class DataType(IntEnum):
+    """Data type of mode values. Values match ``lump_data_type_t``."""
+
+    DATA8 = 0x00
+    DATA16 = 0x01
+    DATA32 = 0x02
+    DATAF = 0x03
+
+
+class ModeFlags(IntFlag):
+    """First byte of the mode capability flags. Values match ``lump_mode_flags0_t``."""
+
+    NONE = 0
+    MOTOR_SPEED = 1 << 0
+    MOTOR_ABS_POS = 1 << 1
+    MOTOR_REL_POS = 1 << 2
+    MOTOR_POWER = 1 << 4
+    MOTOR = 1 << 5
+    NEEDS_SUPPLY_PIN1 = 1 << 6
+    NEEDS_SUPPLY_PIN2 = 1 << 7
+
+
+_STRUCT_FORMAT = {
+    DataType.DATA8: "b",
+    DataType.DATA16: "h",
+    DataType.DATA32: "i",
+    DataType.DATAF: "f",
+}
+
+
+class LumpMode(NamedTuple):
+    """Information about one mode of a device, as sent in INFO messages."""
+
+    name: str
+    num_values: int = 1
+    data_type: DataType = DataType.DATA8
+    figures: int = 4
+    decimals: int = 0
+    raw: Tuple[float, float] = (0.0, 1023.0)
+    pct: Tuple[float, float] = (0.0, 100.0)
+    si: Tuple[float, float] = (0.0, 1023.0)
+    units: str = ""
+    writable: bool = False
+    flags: ModeFlags = ModeFlags.NONE
+
+    @property
+    def size(self) -> int:
+        """Size of the values in a DATA message in bytes."""
+        return self.num_values * struct.calcsize(_STRUCT_FORMAT[self.data_type])
+
+
+def _size_code(size: int) -> Tuple[int, int]:
+    """Gets the size bits of a message header and the padded payload size."""
+    for code in range(6):
+        if size <= 1 << code:
+            return code << 3, 1 << code
+    raise ValueError("payload too large")
+
+
+def _checksum(data: bytes) -> int:
+    checksum = 0xFF
+    for byte in data:
+        checksum ^= byte
+    return checksum
+
+
+def _message(header: int, payload: bytes, info: Optional[int] = None) -> bytes:
+    """Builds a message, padding the payload with zeros."""
+    code, size = _size_code(len(payload))
+    msg = bytes([header | code]) + (bytes([info]) if info is not None else b"")
+    msg += payload.ljust(size, b"\0")
+    return msg + bytes([_checksum(msg)])
+
+
+def _message_size(header: int) -> int:
+    """Gets the full size of a message from its header, like ``uartdev`` does."""
+    if header & 0xC0 == MSG_TYPE_SYS:
+        return 1
+    size = (1 << ((header >> 3) & 0x7)) + 2
+    if header & 0xC0 == MSG_TYPE_INFO:
+        size += 1
+    return size
+
+
+class LumpDevice(UartDevice):
+    """
+    Emulated LEGO UART device.
+
+    Times are in seconds since the virtual hub started.
+    """
+
+    SYNC_TIMEOUT = 0.2
+    """How long a Powered Up device listens for the hub's SPEED command."""
+
+    INFO_REPEAT_INTERVAL = 0.1
+    """Pause before mode information is sent again if the hub does not ACK."""
+
+    ACK_DELAY = 0.02
+    """Time between the hub's ACK and switching to data mode."""
+
+    KEEP_ALIVE_TIMEOUT = 0.5
+    """The device resets if it gets no NACK from the hub for this long."""
+
+    RX_TIMEOUT = 0.01
+    """Incomplete messages from the hub are dropped after this long."""
+
+    # States of the device.
+    SYNC, INFO, ACK, DATA = range(4)
+
+    ValuesCallback = Callable[[int], Sequence[float]]
+
+    def __init__(
+        self,
+        type_id: int,
+        modes: Sequence[LumpMode],
+        speed: int = SPEED_LPF2,
+        lpf2: bool = True,
+        data_interval: float = 0.01,
+        values: Optional[ValuesCallback] = None,
+        version: Tuple[int, int] = (0x10000000, 0x10000000),
+    ) -> None:
+        """
+        Args:
+            type_id: The device type id (29 to 101).
+            modes: Information about each mode, starting at mode 0.
+            speed: The baud rate for data mode. Powered Up devices also
+                accept a lower speed above 115200 baud if the hub asks for it
+                before syncing, and then sync and run at that speed.
+            lpf2: ``True`` for Powered Up devices that can sync at 115200
+                baud, ``False`` for EV3 devices that always sync at 2400 baud.
+            data_interval: Time between DATA messages in seconds.
+            values: Called with the mode to get the values for a DATA
+                message. Defaults to :attr:`values`.
+            version: Firmware and hardware version numbers.
+        """
+        if not 1 <= len(modes) <= 16:
+            raise ValueError("devices have 1 to 16 modes")
+
+        self.type_id = type_id
+        self.modes = list(modes)
+        self.speed = speed
+        self.lpf2 = lpf2
+        self.data_interval = data_interval
+        self.version = version
+        self._values_callback = values
+
+        self.values: Dict[int, Sequence[float]] = {
+            i: [0] * m.num_values for i, m in enumerate(self.modes)
+        }
+        """Values that are sent for each mode, unless there is a callback."""
+
+        self.written: Dict[int, bytes] = {}
+        """
+        The last data written by the hub for each mode. Data from WRITE
+        commands is stored at index -1.
+        """
+
+        self.mode = 0
+        """The mode that data is sent for."""
+
+        self.state = self.SYNC
+        self.resets = 0
+        """Number of times the device had to start over."""
+        self.checksum_errors = 0
+        """Number of bad messages received from the hub."""
+
+        self._rx = bytearray()
+        self._rx_time = 0.0
+        self._ext_mode = 0
+        self._new_speed = speed
+        self._deadline = 0.0
+        self._info_end = 0.0
+        self._last_keep_alive = 0.0
+
+    def on_plug(self, time: float) -> None:
+        self.mode = 0
+        self._reset(time)
+
+    def _reset(self, time: float) -> None:
+        self._rx.clear()
+        self._ext_mode = 0
+        self._new_speed = self.speed
+
+        if self.lpf2:
+            # Listen for the hub before falling back to 2400 baud.
+            self.baud = SPEED_LPF2
+            self.state = self.SYNC
+            self._deadline = time + self.SYNC_TIMEOUT
+        else:
+            self.baud = SPEED_MIN
+            self.state = self.INFO
+            self._deadline = time
+
+    def info_messages(self) -> bytes:
+        """
+        Gets the mode information that is sent before data mode.
+        """
+        num_modes = len(self.modes)
+
+        msgs = _message(MSG_TYPE_CMD | CMD_TYPE, bytes([self.type_id]))
+
+        if num_modes > 8:
+            msgs += _message(MSG_TYPE_CMD | CMD_MODES, bytes([7, 7, num_modes - 1, num_modes - 1]))
+        else:
+            msgs += _message(MSG_TYPE_CMD | CMD_MODES, bytes([num_modes - 1, num_modes - 1]))
+
+        msgs += _message(MSG_TYPE_CMD | CMD_SPEED, struct.pack("<I", self._new_speed))
+        msgs += _message(MSG_TYPE_CMD | CMD_VERSION, struct.pack("<II", *self.version))
+
+        for index in reversed(range(num_modes)):
+            mode = self.modes[index]
+            header = MSG_TYPE_INFO | (index & 0x7)
+            plus_8 = INFO_MODE_PLUS_8 if index > 7 else 0
+
+            def info(info_type: int, payload: bytes) -> bytes:
+                return _message(header, payload, info_type | plus_8)
+
+            name = mode.name.encode()
+            if len(name) <= 5:
+                # Short names are followed by the mode capability flags.
+                name = name.ljust(6, b"\0") + bytes([mode.flags, 0, 0, 0, 0, 0])
+
+            msgs += info(INFO_NAME, name)
+            msgs += info(INFO_RAW, struct.pack("<ff", *mode.raw))
+            msgs += info(INFO_PCT, struct.pack("<ff", *mode.pct))
+            msgs += info(INFO_SI, struct.pack("<ff", *mode.si))
+            msgs += info(INFO_UNITS, mode.units.encode())
+            msgs += info(
+                INFO_MAPPING, bytes([0 if mode.writable else 0x10, 0x10 if mode.writable else 0])
+            )
+            msgs += info(
+                INFO_FORMAT,
+                bytes([mode.num_values, mode.data_type, mode.figures, mode.decimals]),
+            )
+
+        return msgs + bytes([MSG_TYPE_SYS | SYS_ACK])
+
+    def data_message(self, mode: int) -> bytes:
+        """
+        Gets the DATA message for a mode.
+        """
+        info = self.modes[mode]
+        values = self._values_callback(mode) if self._values_callback else self.values[mode]
+        fmt = "<" + _STRUCT_FORMAT[info.data_type] * info.num_values
+
+        if info.data_type == DataType.DATAF:
+            payload = struct.pack(fmt, *values)
+        else:
+            bits = 8 * struct.calcsize(_STRUCT_FORMAT[info.data_type])
+            # Wrap around like a C integer cast.
+            payload = struct.pack(
+                fmt,
+                *(
+                    ((int(v) + (1 << (bits - 1))) % (1 << bits)) - (1 << (bits - 1))
+                    for v in values
+                ),
+            )
+
+        msg = b""
+        if len(self.modes) > 8:
+            msg += _message(MSG_TYPE_CMD | CMD_EXT_MODE, bytes([mode & 0x8]))
+
+        return msg + _message(MSG_TYPE_DATA | (mode & 0x7), payload)
+
+    def update(self, time: float) -> None:
+        if self.state == self.SYNC:
+            if time >= self._deadline:
+                self.baud = SPEED_MIN
+                self.state = self.INFO
+                self._deadline = time
+
+        if self.state == self.INFO:
+            if time >= self._deadline:
+                self._info_end = self.send(time, self.info_messages())
+                self._deadline = self._info_end + self.INFO_REPEAT_INTERVAL
+
+        elif self.state == self.ACK:
+            if time >= self._deadline:
+                self._rx.clear()
+                self.baud = self._new_speed
+                self.state = self.DATA
+                self._deadline = time
+                self._last_keep_alive = time
+
+        elif self.state == self.DATA:
+            if time - self._last_keep_alive > self.KEEP_ALIVE_TIMEOUT:
+                self.resets += 1
+                self._reset(time)
+            elif time >= self._deadline:
+                self.send(time, self.data_message(self.mode))
+                self._deadline = time + self.data_interval
+
+    def on_receive(self, time: float, data: bytes) -> None:
+        if time - self._rx_time > self.RX_TIMEOUT:
+            # A garbled header may have made us wait for a long message.
+            self._rx.clear()
+
+        self._rx += data
+        self._rx_time = time
+
+        while self._rx:
+            size = _message_size(self._rx[0])
+
+            if len(self._rx) < size:
+                # Wait for the rest of the message.
+                return
+
+            msg = bytes(self._rx[:size])
+
+            if size > 1 and _checksum(msg[:-1]) != msg[-1]:
+                # Drop a byte and try to find the next message.
+                self.checksum_errors += 1
+                del self._rx[0]
+                continue
+
+            del self._rx[:size]
+            self._handle_message(time, msg)
+
+    def _handle_message(self, time: float, msg: bytes) -> None:
+        msg_type = msg[0] & 0xC0
+        cmd = msg[0] & 0x7
+
+        if msg_type == MSG_TYPE_SYS:
+            if cmd == SYS_ACK and self.state == self.INFO and time >= self._info_end:
+                # The hub got all mode info and switches speed soon.
+                self.state = self.ACK
+                self._deadline = time + self.ACK_DELAY
+            elif cmd == SYS_NACK:
+                self._last_keep_alive = time
+
+        elif msg_type == MSG_TYPE_CMD:
+            if cmd == CMD_SPEED:
+                speed = struct.unpack_from("<I", msg, 1)[0]
+
+                if self.state == self.SYNC and speed == SPEED_LPF2:
+                    # Powered Up handshake: send everything at 115200 baud.
+                    self.send(time, bytes([MSG_TYPE_SYS | SYS_ACK]))
+                    self.state = self.INFO
+                    self._deadline = time
+                elif self.state == self.SYNC and SPEED_LPF2 < speed <= self.speed:
+                    # The hub asks for a lower speed than our maximum. Accept
+                    # it, then sync and run at that speed.
+                    self.send(time, bytes([MSG_TYPE_SYS | SYS_ACK]))
+                    self.baud = speed
+                    self._new_speed = speed
+                    self.state = self.INFO
+                    # Give the hub time to switch speed too.
+                    self._deadline = time + self.ACK_DELAY
+
+            elif cmd == CMD_EXT_MODE:
+                self._ext_mode = msg[1]
+
+            elif cmd == CMD_SELECT and self.state == self.DATA:
+                if msg[1] < len(self.modes):
+                    self.mode = msg[1]
+                    # Send data for the new mode right away.
+                    self._deadline = time
+
+            elif cmd == CMD_WRITE and self.state == self.DATA:
+                self.written[-1] = msg[1:-1]
+
+        elif msg_type == MSG_TYPE_DATA and self.state == self.DATA:
+            mode = cmd + self._ext_mode
+            if mode < len(self.modes):
+                self.written[mode] = msg[1:-1]
+
+
+def spike_color_sensor(values: Optional[LumpDevice.ValuesCallback] = None) -> LumpDevice:
+    """
+    Creates a SPIKE Color Sensor.
+
+    Mode numbers are the same as ``PBIO_IODEV_MODE_PUP_COLOR_SENSOR__*``.
+    """
+    return LumpDevice(
+        IODeviceTypeId.SPIKE_COLOR_SENSOR,
+        [
+            LumpMode("COLOR", 1, DataType.DATA8, 2, si=(0, 10), units="IDX"),
+            LumpMode("REFLT", 1, DataType.DATA8, 3, si=(0, 100), units="PCT"),
+            LumpMode("AMBI", 1, DataType.DATA8, 3, si=(0, 100), units="PCT"),
+            LumpMode("LIGHT", 3, DataType.DATA8, 3, si=(0, 100), units="PCT", writable=True),
+            LumpMode("RREFL", 2, DataType.DATA16, 4, si=(0, 1024), units="RAW"),
+            LumpMode("RGB_I", 4, DataType.DATA16, 4, si=(0, 1024), units="RAW"),
+            LumpMode("HSV", 3, DataType.DATA16, 4, si=(0, 1024), units="RAW"),
+            LumpMode("SHSV", 4, DataType.DATA16, 4, si=(0, 1024), units="RAW"),
+            LumpMode("DEBUG", 2, DataType.DATA16, 4, units="RAW"),
+            LumpMode("CALIB", 7, DataType.DATA16, 5, si=(0, 65535)),
+        ],
+        values=values,
+    )
+
+
+def spike_ultrasonic_sensor(values: Optional[LumpDevice.ValuesCallback] = None) -> LumpDevice:
+    """
+    Creates a SPIKE Ultrasonic Sensor.
+
+    Mode numbers are the same as ``PBIO_IODEV_MODE_PUP_ULTRASONIC_SENSOR__*``.
+    """
+    return LumpDevice(
+        IODeviceTypeId.SPIKE_ULTRASONIC_SENSOR,
+        [
+            LumpMode("DISTL", 1, DataType.DATA16, 5, 1, si=(0, 250), units="CM"),
+            LumpMode("DISTS", 1, DataType.DATA16, 4, 1, si=(0, 32), units="CM"),
+            LumpMode("SINGL", 1, DataType.DATA16, 5, 1, si=(0, 250), units="CM"),
+            LumpMode("LISTN", 1, DataType.DATA8, 1, si=(0, 1), units="ST"),
+            LumpMode("TRAW", 1, DataType.DATA32, 5, si=(0, 14577), units="US"),
+            LumpMode("LIGHT", 4, DataType.DATA8, 3, si=(0, 100), units="PCT", writable=True),
+            LumpMode("PING", 1, DataType.DATA8, 1, si=(0, 1), units="PCT", writable=True),
+            LumpMode("ADRAW", 1, DataType.DATA16, 4, units="PCT"),
+            LumpMode("CALIB", 7, DataType.DATA16, 3, si=(0, 255), units="PCT"),
+        ],
+        values=values,
+    )
@@ -1,9 +1,30 @@
 # SPDX-License-Identifier: MIT
 # Copyright (c) 2022 The Pybricks Authors
 
+import ctypes
+from enum import IntEnum
+from math import degrees, radians
 from typing import Callable, List, NamedTuple
 
 
+class NativeModel(IntEnum):
+    """
+    Physics models that the virtual hub can simulate natively.
+
+    Values match ``pbdrv_virtual_physics_model_t``.
+    """
+
+    NONE = 0
+    """
+    No native model. Motor driver events are sent to Python.
+    """
+
+    SIMPLE_MOTOR = 1
+    """
+    Native version of :class:`pbio_virtual.physics.motors.SimpleMotor`.
+    """
+
+
 class VirtualMotorDriver:
     """
     Virtual motor driver chip implementation.
@@ -25,6 +46,21 @@ class VirtualMotorDriver:
         The requested duty cycle (-1.0 to 1.0).
         """
 
+    native_model: int = NativeModel.NONE
+    """
+    Physics model that is simulated natively for this motor driver and the
+    counter with the same index. This is read once when the driver starts.
+
+    When this is not :attr:`NativeModel.NONE`, the :meth:`on_coast()` and
+    :meth:`on_set_duty_cycle()` events are not called and the counter values
+    are not read from Python.
+    """
+
+    initial_millidegrees: int = 0
+    """
+    Initial angle of the native model.
+    """
+
     CoastCallback = Callable[[CoastEvent], None]
     DutyCycleCallback = Callable[[DutyCycleEvent], None]
     Unsubscribe = Callable[[], None]
@@ -81,3 +117,127 @@ class VirtualMotorDriver:
 
         for callback in self._duty_cycle_subscriptions:
             callback(event)
+
+
+class pbdrv_virtual_physics_drivebase_t(ctypes.Structure):
+    _fields_ = [
+        ("enabled", ctypes.c_bool),
+        ("left", ctypes.c_uint8),
+        ("right", ctypes.c_uint8),
+        ("left_direction", ctypes.c_int8),
+        ("right_direction", ctypes.c_int8),
+        ("time", ctypes.c_uint32),
+        ("wheel_diameter", ctypes.c_double),
+        ("axle_track", ctypes.c_double),
+        ("x", ctypes.c_double),
+        ("y", ctypes.c_double),
+        ("heading", ctypes.c_double),
+        ("distance", ctypes.c_double),
+        ("left_alpha", ctypes.c_double),
+        ("right_alpha", ctypes.c_double),
+    ]
+
+
+class NativeDrivebase:
+    """
+    Robot with two driven wheels on one axle that is simulated natively.
+
+    This is the native version of
+    :class:`pbio_virtual.physics.world.DifferentialDrive`. It is moved by two
+    motor drivers that use :attr:`NativeModel.SIMPLE_MOTOR`. Platforms enable it
+    by assigning ``drivebase[-1] = NativeDrivebase(...)`` during init.
+
+    The pose is updated each time the hub updates or reads either motor.
+    """
+
+    def __init__(
+        self,
+        left: int,
+        right: int,
+        wheel_diameter: float,
+        axle_track: float,
+        left_direction: int = 1,
+        right_direction: int = 1,
+        x: float = 0.0,
+        y: float = 0.0,
+        heading: float = 0.0,
+    ) -> None:
+        """
+        Args:
+            left: Index of the motor driver of the left wheel.
+            right: Index of the motor driver of the right wheel.
+            wheel_diameter: Diameter of the wheels in mm.
+            axle_track: Distance between the wheels in mm.
+            left_direction: 1 if positive angles of the left motor drive
+                forward or -1 if it is mounted mirrored.
+            right_direction: Same for the right motor.
+            x: Initial x coordinate of the center of the axle in mm.
+            y: Initial y coordinate of the center of the axle in mm.
+            heading: Initial heading in degrees, counterclockwise from the x axis.
+        """
+        self._state = pbdrv_virtual_physics_drivebase_t(
+            left=left,
+            right=right,
+            left_direction=left_direction,
+            right_direction=right_direction,
+            wheel_diameter=wheel_diameter,
+            axle_track=axle_track,
+            x=x,
+            y=y,
+            heading=radians(heading),
+        )
+
+    def on_start(self, address: int) -> None:
+        """
+        Called when the virtual hub starts simulating the drivebase.
+
+        Args:
+            address: The address of the ``pbdrv_virtual_physics_drivebase_t``
+                that holds the state in the virtual hub. The configuration is
+                copied there and the pose is read from there from now on.
+        """
+        ctypes.memmove(address, ctypes.addressof(self._state), ctypes.sizeof(self._state))
+        self._state = pbdrv_virtual_physics_drivebase_t.from_address(address)
+
+    @property
+    def enabled(self) -> bool:
+        """
+        Whether the virtual hub simulates the drivebase. This is false until it
+        is started and if either motor is not simulated natively.
+        """
+        return self._state.enabled
+
+    @property
+    def time(self) -> int:
+        """
+        Time of the pose as 32-bit unsigned microseconds.
+        """
+        return self._state.time
+
+    @property
+    def x(self) -> float:
+        """
+        X coordinate of the center of the axle in mm.
+        """
+        return self._state.x
+
+    @property
+    def y(self) -> float:
+        """
+        Y coordinate of the center of the axle in mm.
+        """
+        return self._state.y
+
+    @property
+    def heading(self) -> float:
+        """
+        Heading in degrees, counterclockwise from the x axis.
+        """
+        return degrees(self._state.heading)
+
+    @property
+    def distance(self) -> float:
+        """
+        Distance driven by the center of the axle in mm.
+        """
+        return self._state.distance
@@ -0,0 +1,268 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2023 The Pybricks Authors
+
+"""Virtual UART with a simulated wire.
+
+The hub end is driven by ``uart_virtual.c``. The other end is a
+:class:`UartDevice`, such as an emulated LEGO UART device from
+:mod:`pbio_virtual.drv.lump`.
+
+Bytes take ten bit times to go across the wire, at the baud rate of the
+sender. Bytes received at a different baud rate than they were sent at are
+garbled, just like on a real UART, so both ends must agree on the baud rate
+to communicate. Optional noise flips random bits.
+"""
+
+from __future__ import annotations
+
+import random
+from collections import deque
+from typing import Callable, Deque, List, Optional, Tuple
+
+
+class UartDevice:
+    """
+    Base class for devices attached to a :class:`VirtualUart`.
+
+    Times are in seconds since the virtual hub started.
+    """
+
+    baud: int = 2400
+    """The baud rate that the device currently sends and receives at."""
+
+    _uart: Optional[VirtualUart] = None
+
+    def on_plug(self, time: float) -> None:
+        """Called when the device is plugged in, like a power-on reset."""
+
+    def on_receive(self, time: float, data: bytes) -> None:
+        """Called with bytes received from the hub."""
+
+    def update(self, time: float) -> None:
+        """Called before the hub reads, so that the device can send data."""
+
+    def send(self, time: float, data: bytes) -> float:
+        """
+        Sends bytes to the hub at :attr:`baud`.
+
+        Returns:
+            The time when the last byte has been sent.
+        """
+        if self._uart is None:
+            return time
+        return self._uart._transmit(time, data, self.baud)
+
+
+class VirtualUart:
+    """
+    Virtual UART implementation.
+    """
+
+    RX_BUFFER_SIZE = 64
+    """
+    Number of received bytes that are kept while the hub is not reading.
+    Older bytes are lost, like in a UART ring buffer that overflows.
+    """
+
+    ConnectionCallback = Callable[[bool], None]
+    Unsubscribe = Callable[[], None]
+
+    _connection_subscriptions: List[ConnectionCallback]
+
+    def __init__(
+        self,
+        device: Optional[UartDevice] = None,
+        noise: float = 0.0,
+        seed: Optional[int] = None,
+    ) -> None:
+        """
+        Args:
+            device: The device that is plugged in, if any.
+            noise: Probability that a bit error occurs in a byte.
+            seed: Seed for the noise, for reproducible runs.
+        """
+        self.baud = 115200
+        self.noise = noise
+        self.device: Optional[UartDevice] = None
+
+        # Bytes going to the hub as (arrival time, byte, baud). The baud rate
+        # is None for bytes that have already been received at the hub's
+        # baud rate.
+        self._rx: Deque[Tuple[float, int, Optional[int]]] = deque()
+        self._tx_end = 0.0
+        self._random = random.Random(seed)
+
+        # 32-bit timestamps are unwrapped to keep the time increasing.
+        self._last_timestamp = 0
+        self._time = 0.0
+
+        self.bytes_sent = 0
+        """Number of bytes sent to the device."""
+        self.bytes_received = 0
+        """Number of bytes received from the device."""
+        self.bytes_garbled = 0
+        """Number of bytes in either direction that did not arrive intact."""
+
+        self._connection_subscriptions = []
+
+        if device:
+            self.plug(device)
+
+    @property
+    def connected(self) -> bool:
+        """
+        Whether a device is plugged in.
+        """
+        return self.device is not None
+
+    def subscribe_connection(self, callback: ConnectionCallback) -> Unsubscribe:
+        """
+        Subscribes to connection changes.
+
+        Args:
+            callback:
+                A function that will be called with :attr:`connected` each
+                time a device is plugged in or unplugged.
+
+        Returns:
+            A function that, when called, will unsubscribe from the events.
+        """
+        self._connection_subscriptions.append(callback)
+        return lambda: self._connection_subscriptions.remove(callback)
+
+    def plug(self, device: UartDevice) -> None:
+        """
+        Plugs in a device, replacing any other device.
+        """
+        self.unplug()
+        self.device = device
+        device._uart = self
+        device.on_plug(self._time)
+
+        for callback in self._connection_subscriptions:
+            callback(True)
+
+    def unplug(self) -> None:
+        """
+        Unplugs the device. Bytes that are still on the wire are lost.
+        """
+        if not self.device:
+            return
+
+        self.device._uart = None
+        self.device = None
+        self._rx.clear()
+
+        for callback in self._connection_subscriptions:
+            callback(False)
+
+    def _seconds(self, timestamp: int) -> float:
+        delta = (timestamp - self._last_timestamp) & 0xFFFFFFFF
+
+        # Ignore timestamps that are slightly older than the last one.
+        if delta < 0x80000000:
+            self._last_timestamp = timestamp
+            self._time += delta / 1e6
+
+        return self._time
+
+    def _corrupt(self, byte: int, sent_baud: Optional[int], received_baud: int) -> int:
+        if sent_baud is None:
+            return byte
+
+        if sent_baud != received_baud:
+            self.bytes_garbled += 1
+            return self._random.randrange(256)
+
+        if self.noise and self._random.random() < self.noise:
+            self.bytes_garbled += 1
+            return byte ^ (1 << self._random.randrange(8))
+
+        return byte
+
+    def _transmit(self, time: float, data: bytes, baud: int) -> float:
+        byte_time = 10 / baud
+        start = max(time, self._tx_end)
+
+        for i, byte in enumerate(data):
+            self._rx.append((start + (i + 1) * byte_time, byte, baud))
+
+        self._tx_end = start + len(data) * byte_time
+        return self._tx_end
+
+    def _arrived(self, time: float) -> int:
+        """Counts the bytes that have arrived, dropping any that overflowed."""
+        count = 0
+
+        for arrival, _, _ in self._rx:
+            if arrival > time:
+                break
+            count += 1
+
+        while count > self.RX_BUFFER_SIZE:
+            self._rx.popleft()
+            count -= 1
+
+        return count
+
+    def on_set_baud_rate(self, timestamp: int, baud: int) -> None:
+        """
+        Called when the hub changes the baud rate.
+        """
+        time = self._seconds(timestamp)
+
+        # Bytes that arrived before the change were received at the old rate.
+        for i in range(self._arrived(time)):
+            arrival, byte, sent_baud = self._rx[i]
+            self._rx[i] = (arrival, self._corrupt(byte, sent_baud, self.baud), None)
+
+        self.baud = baud
+
+    def on_write(self, timestamp: int, data: bytes) -> None:
+        """
+        Called when the hub writes bytes.
+        """
+        time = self._seconds(timestamp)
+        self.bytes_sent += len(data)
+
+        if not self.device:
+            return
+
+        # The whole message is delivered once the last byte arrives.
+        arrival = time + len(data) * 10 / self.baud
+        device_baud = self.device.baud
+        self.device.update(arrival)
+        self.device.on_receive(
+            arrival, bytes(self._corrupt(b, self.baud, device_baud) for b in data)
+        )
+
+    def on_flush(self, timestamp: int) -> None:
+        """
+        Called when the hub discards received bytes.
+        """
+        time = self._seconds(timestamp)
+
+        for _ in range(self._arrived(time)):
+            self._rx.popleft()
+
+    def read(self, timestamp: int, size: int) -> bytes:
+        """
+        Called when the hub reads bytes.
+
+        Returns:
+            Up to *size* bytes that have arrived by now.
+        """
+        time = self._seconds(timestamp)
+
+        if self.device:
+            self.device.update(time)
+
+        count = min(size, self._arrived(time))
+        data = bytearray()
+
+        for _ in range(count):
+            _, byte, baud = self._rx.popleft()
+            data.append(self._corrupt(byte, baud, self.baud))
+
+        self.bytes_received += count
+        return bytes(data)
@@ -31,18 +31,32 @@ class SimpleMotor(SimulationModel):
         alpha, alpha_dot = x
         return array([degrees(alpha) * 1000])
 
+    @classmethod
+    def coefficients(cls, duty):
+        """Gets the coefficients a and b of the equation of motion, which is
+        alpha_dotdot = -a * alpha_dot + b for a constant duty cycle.
+
+        Arguments:
+            duty (float): Duty cycle or COAST_DUTY.
+
+        Returns:
+            tuple: The coefficients a and b.
+        """
+        if duty == cls.COAST_DUTY:
+            # For coast, reduce deceleration, as if removing back EMF.
+            return cls.c0 / 4, 0.0
+
+        # Otherwise, apply normal DC motor model.
+        return cls.c0, duty * cls.c1
+
     def state_change(self, t, x, u):
         # Unpack the current state.
         alpha, alpha_dot = x
         (duty,) = u
 
         # Evaluate equation of motion, which is just the acceleration.
-        if duty == self.COAST_DUTY:
-            # For coast, reduce deceleration, as if removing back EMF.
-            alpha_dotdot = -self.c0 * alpha_dot / 4
-        else:
-            # Otherwise, apply normal DC motor model.
-            alpha_dotdot = -self.c0 * alpha_dot + duty * self.c1
+        a, b = self.coefficients(duty)
+        alpha_dotdot = -a * alpha_dot + b
 
         # Return the state derivative.
         return array([alpha_dot, alpha_dotdot])
@@ -0,0 +1,100 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2023 The Pybricks Authors
+
+"""Scripted scenarios for the headless world.
+
+A scenario runs a :class:`~pbio_virtual.physics.world.World` with a
+controller for each robot, without the virtual hub. This is meant for trying
+out navigation algorithms on many robots at once, for example::
+
+    world = World(Map(2000, 1200))
+    scenario = Scenario(world)
+
+    robot = scenario.add_robot(Robot("a", x=200, y=600), controller=follow_wall)
+    robot.add_sensor("distance", UltrasonicSensor(forward=60))
+
+    scenario.run(10, until=lambda s: robot.drivebase.x > 1500)
+    print(scenario.trajectories["a"][-1])
+"""
+
+from __future__ import annotations
+
+from typing import Callable, Dict, List, Optional, Tuple
+
+from .world import Robot, World
+
+Controller = Callable[[Robot, float], None]
+"""
+Called with the robot and the current time on each step, before the world
+moves on. It can read the robot's sensors and set its motors.
+"""
+
+Pose = Tuple[float, float, float, float]
+"""Time, x, y and heading of a robot."""
+
+
+class Scenario:
+    """Steps a world at a fixed interval, calling robot controllers."""
+
+    def __init__(self, world: World, record: bool = True) -> None:
+        """
+        Arguments:
+            world: The world to run.
+            record: Whether to record the pose of each robot on each step.
+        """
+        self.world = world
+        self.record = record
+        self.controllers: Dict[str, Controller] = {}
+        self.trajectories: Dict[str, List[Pose]] = {}
+
+    def add_robot(self, robot: Robot, controller: Optional[Controller] = None) -> Robot:
+        """Adds a robot to the world with an optional controller."""
+        self.world.add_robot(robot)
+        if controller:
+            self.controllers[robot.name] = controller
+        self.trajectories[robot.name] = []
+        self._record(robot)
+        return robot
+
+    def _record(self, robot: Robot) -> None:
+        if self.record:
+            base = robot.drivebase
+            self.trajectories[robot.name].append((self.world.time, base.x, base.y, base.heading))
+
+    def step(self, dt: float) -> None:
+        """Runs all controllers and then advances the world by *dt* seconds."""
+        world = self.world
+
+        for name, controller in self.controllers.items():
+            controller(world.robots[name], world.time)
+
+        world.advance(world.time + dt)
+
+        for robot in world.robots.values():
+            self._record(robot)
+
+    def run(
+        self,
+        duration: float,
+        dt: float = 0.01,
+        until: Optional[Callable[[Scenario], bool]] = None,
+    ) -> float:
+        """Runs the scenario.
+
+        Arguments:
+            duration: Maximum time to run in seconds.
+            dt: Controller interval in seconds.
+            until: Stops early when this returns true after a step.
+
+        Returns:
+            The time that passed.
+        """
+        start = self.world.time
+        end = start + duration
+
+        while self.world.time + dt / 2 < end:
+            self.step(min(dt, end - self.world.time))
+            if until and until(self):
+                break
+
+        return self.world.time - start
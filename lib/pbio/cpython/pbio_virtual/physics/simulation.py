@@ -1,7 +1,7 @@
 # SPDX-License-Identifier: MIT
 # Copyright (c) 2022 The Pybricks Authors
 
-from numpy import array, zeros, concatenate
+from numpy import array, zeros
 from abc import ABC, abstractmethod
 
 
@@ -50,8 +50,9 @@ class SimulationModel(ABC):
             t (float): Current time.
             u (array): Control signal vector.
         """
-        self.input_times = concatenate((self.input_times, array([t])))
-        self.input_values = concatenate((self.input_values, u.reshape(self.m, 1)), axis=1)
+        # Only the latest input is used by the simulation.
+        self.input_times = array([t])
+        self.input_values = u.reshape(self.m, 1)
 
     def simulate(self, time_end):
         """Simulates the system until time_end, subject to the ongoing input.
@@ -96,10 +97,12 @@ class SimulationModel(ABC):
             k4 = self.state_change(t + self.DT, state + self.DT * k3, u)
             state = state + self.DT / 6 * (k1 + 2 * k2 + 2 * k3 + k4)
 
-        # Concatenate results
-        self.times = concatenate((self.times, times))
-        self.states = concatenate((self.states, states), axis=1)
-        self.outputs = concatenate((self.outputs, outputs), axis=1)
+        # Keep only the latest segment. It starts at the end of the previous
+        # one, so outputs can still be interpolated from then on, while memory
+        # use and the cost of the next call don't grow with the run time.
+        self.times = times
+        self.states = states
+        self.outputs = outputs
 
     @abstractmethod
     def state_change(self, t, x, u):
@@ -142,6 +145,10 @@ class SimulationModel(ABC):
         Returns:
             array: The output vector.
         """
+        # Only the latest segment is kept, so anything older gets its start.
+        if time <= self.times[0]:
+            return self.outputs[:, 0]
+
         # If time is in the past, interpolate from available results.
         if time < self.times[-1]:
 
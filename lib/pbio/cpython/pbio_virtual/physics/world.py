@@ -0,0 +1,494 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2023 The Pybricks Authors
+
+"""Headless 2-D world with differential drive robots and their sensors.
+
+Everything here is plain Python without graphics, so that many robots can
+be simulated in one process. Distances are in millimeters, angles
+in degrees and times in seconds.
+
+The world uses the same coordinates as a map image seen from above: x to the
+right, y up and headings counterclockwise from the x axis. Sensors that
+report a heading, like :class:`IMU`, convert to the Pybricks convention where
+turning clockwise increases the heading.
+"""
+
+from __future__ import annotations
+
+from math import atan2, cos, degrees, exp, hypot, inf, pi, radians, sin
+from typing import Dict, List, Optional, Sequence, Tuple
+
+from .motors import SimpleMotor
+
+RGB = Tuple[int, int, int]
+Segment = Tuple[float, float, float, float]
+
+
+class Motor:
+    """Closed-form solution of the :class:`SimpleMotor` model.
+
+    With a constant duty cycle, the equation of motion has an exact solution,
+    so the motor can be advanced by any amount of time at the same cost. This
+    matches the native motor model of the virtual hub.
+    """
+
+    model = SimpleMotor
+    """The model that gives the equation of motion."""
+
+    def __init__(self, time: float = 0.0, angle: float = 0.0) -> None:
+        """
+        Arguments:
+            time: Start time.
+            angle: Initial angle in degrees.
+        """
+        self.time = time
+        self.alpha = radians(angle)
+        self.alpha_dot = 0.0
+        self.duty = self.model.COAST_DUTY
+
+    def advance(self, time: float) -> None:
+        """Simulates the motor up to *time* with the current actuation."""
+        dt = time - self.time
+        if dt <= 0:
+            return
+
+        a, b = self.model.coefficients(self.duty)
+
+        speed_final = b / a
+        speed_diff = self.alpha_dot - speed_final
+        decay = exp(-a * dt)
+
+        self.alpha += speed_final * dt + speed_diff * (1 - decay) / a
+        self.alpha_dot = speed_final + speed_diff * decay
+        self.time = time
+
+    def coast(self, time: float) -> None:
+        """Simulates up to *time* and then lets the motor spin freely."""
+        self.advance(time)
+        self.duty = self.model.COAST_DUTY
+
+    def set_duty_cycle(self, time: float, duty: float) -> None:
+        """Simulates up to *time* and then applies *duty* (-1.0 to 1.0)."""
+        self.advance(time)
+        self.duty = max(-1.0, min(duty, 1.0))
+
+    @property
+    def angle(self) -> float:
+        """The motor angle in degrees."""
+        return degrees(self.alpha)
+
+    @property
+    def speed(self) -> float:
+        """The motor speed in degrees per second."""
+        return degrees(self.alpha_dot)
+
+
+class DifferentialDrive:
+    """Kinematics of a robot with two driven wheels on one axle.
+
+    The pose is updated from the wheel angles, like odometry, so it stays
+    consistent with the motor model no matter how it is stepped.
+    """
+
+    def __init__(
+        self,
+        wheel_diameter: float,
+        axle_track: float,
+        x: float = 0.0,
+        y: float = 0.0,
+        heading: float = 0.0,
+    ) -> None:
+        """
+        Arguments:
+            wheel_diameter: Diameter of the wheels.
+            axle_track: Distance between the points where the wheels touch
+                the ground.
+            x: Initial x coordinate of the center of the axle.
+            y: Initial y coordinate of the center of the axle.
+            heading: Initial heading, counterclockwise from the x axis.
+        """
+        self.wheel_diameter = wheel_diameter
+        self.axle_track = axle_track
+        self.x = x
+        self.y = y
+        self.theta = radians(heading)
+        self.speed = 0.0
+        self.turn_rate = 0.0
+        self.distance = 0.0
+        self._left = None
+        self._right = None
+        self._time = None
+
+    @property
+    def heading(self) -> float:
+        """The heading in degrees, counterclockwise from the x axis."""
+        return degrees(self.theta)
+
+    def update(self, time: float, left: float, right: float) -> None:
+        """Moves the robot to match the new wheel angles.
+
+        Arguments:
+            time: The time of the wheel angles.
+            left: Angle of the left wheel in degrees, positive forward.
+            right: Angle of the right wheel in degrees, positive forward.
+        """
+        if self._time is None:
+            self._time, self._left, self._right = time, left, right
+            return
+
+        mm_per_deg = pi * self.wheel_diameter / 360
+        d_left = (left - self._left) * mm_per_deg
+        d_right = (right - self._right) * mm_per_deg
+        d_center = (d_left + d_right) / 2
+        d_theta = (d_right - d_left) / self.axle_track
+
+        # Moving along the chord of the arc is exact for constant wheel speeds.
+        chord = d_center
+        if d_theta:
+            chord *= sin(d_theta / 2) / (d_theta / 2)
+        mid_theta = self.theta + d_theta / 2
+        self.x += chord * cos(mid_theta)
+        self.y += chord * sin(mid_theta)
+        self.theta += d_theta
+        self.distance += d_center
+
+        dt = time - self._time
+        if dt > 0:
+            self.speed = d_center / dt
+            self.turn_rate = degrees(d_theta / dt)
+
+        self._time, self._left, self._right = time, left, right
+
+
+class Map:
+    """Colored floor with walls.
+
+    The floor is a grid of RGB pixels stretched over the map, with row 0 at
+    the top like an image. The edges of the map are walls too.
+    """
+
+    def __init__(
+        self,
+        width: float,
+        height: float,
+        pixels: Sequence[Sequence[RGB]] = (((255, 255, 255),),),
+        walls: Sequence[Segment] = (),
+        background: RGB = (255, 255, 255),
+    ) -> None:
+        """
+        Arguments:
+            width: Width of the map.
+            height: Height of the map.
+            pixels: Rows of RGB pixels, top row first. The default is a
+                white floor.
+            walls: Wall segments as ``(x1, y1, x2, y2)``.
+            background: Color outside of the map.
+        """
+        self.width = width
+        self.height = height
+        self.pixels = pixels
+        self.background = background
+        self._rows = len(pixels)
+        self._columns = len(pixels[0])
+        self.walls: List[Segment] = list(walls) + [
+            (0, 0, width, 0),
+            (width, 0, width, height),
+            (width, height, 0, height),
+            (0, height, 0, 0),
+        ]
+
+    @classmethod
+    def from_ppm(cls, path: str, resolution: float = 1.0, walls: Sequence[Segment] = ()) -> Map:
+        """Loads the floor from a binary (P6) or plain (P3) PPM image.
+
+        Arguments:
+            path: Path to the image.
+            resolution: Size of each pixel in millimeters.
+            walls: Wall segments as ``(x1, y1, x2, y2)``.
+        """
+        with open(path, "rb") as f:
+            data = f.read()
+
+        # Header fields are separated by whitespace and may have comments.
+        fields = []
+        pos = 0
+        while len(fields) < 4:
+            while data[pos : pos + 1].isspace():
+                pos += 1
+            if data[pos : pos + 1] == b"#":
+                pos = data.index(b"\n", pos)
+                continue
+            end = pos
+            while not data[end : end + 1].isspace():
+                end += 1
+            fields.append(data[pos:end])
+            pos = end
+
+        magic, width, height, maxval = fields[0], int(fields[1]), int(fields[2]), int(fields[3])
+
+        if magic == b"P6":
+            values = data[pos + 1 : pos + 1 + width * height * 3]
+        elif magic == b"P3":
+            values = [int(v) for v in data[pos:].split()]
+        else:
+            raise ValueError("not a PPM image")
+
+        scale = 255 / maxval
+        pixels = [
+            [
+                tuple(round(values[(r * width + c) * 3 + i] * scale) for i in range(3))
+                for c in range(width)
+            ]
+            for r in range(height)
+        ]
+
+        return cls(width * resolution, height * resolution, pixels, walls)
+
+    def color_at(self, x: float, y: float) -> RGB:
+        """Gets the floor color at a point."""
+        if not (0 <= x < self.width and 0 <= y < self.height):
+            return self.background
+
+        row = self._rows - 1 - int(y * self._rows / self.height)
+        column = int(x * self._columns / self.width)
+        return self.pixels[row][column]
+
+
+class Sensor:
+    """Base class for sensors mounted on a robot.
+
+    The position is relative to the center of the axle, with *forward* along
+    the heading of the robot and *left* perpendicular to it.
+    """
+
+    def __init__(self, forward: float = 0.0, left: float = 0.0) -> None:
+        self.forward = forward
+        self.left = left
+
+    def position(self, robot: Robot) -> Tuple[float, float]:
+        """Gets the position of the sensor in the world."""
+        base = robot.drivebase
+        c, s = cos(base.theta), sin(base.theta)
+        return (
+            base.x + self.forward * c - self.left * s,
+            base.y + self.forward * s + self.left * c,
+        )
+
+    def update(self, world: World, robot: Robot) -> None:
+        """Called after all robots have moved."""
+        raise NotImplementedError
+
+
+class ColorSensor(Sensor):
+    """Downward facing color sensor that reads the floor of the map."""
+
+    rgb: RGB = (0, 0, 0)
+    """The floor color below the sensor."""
+
+    def update(self, world: World, robot: Robot) -> None:
+        self.rgb = world.map.color_at(*self.position(robot))
+
+    @property
+    def reflection(self) -> int:
+        """The reflected light intensity in percent."""
+        return round(sum(self.rgb) * 100 / (3 * 255))
+
+
+class UltrasonicSensor(Sensor):
+    """Distance sensor that measures along a ray to walls and other robots."""
+
+    MAX_DISTANCE = 2000
+
+    distance: int = MAX_DISTANCE
+    """The distance in millimeters, or :attr:`MAX_DISTANCE` if nothing is seen."""
+
+    def __init__(self, forward: float = 0.0, left: float = 0.0, angle: float = 0.0) -> None:
+        """
+        Arguments:
+            forward: Position ahead of the axle.
+            left: Position left of the axle.
+            angle: Direction relative to the robot, counterclockwise.
+        """
+        super().__init__(forward, left)
+        self.angle = angle
+
+    def update(self, world: World, robot: Robot) -> None:
+        x, y = self.position(robot)
+        theta = robot.drivebase.theta + radians(self.angle)
+        dx, dy = cos(theta), sin(theta)
+
+        nearest = min(world.cast_ray(x, y, dx, dy, exclude=robot), self.MAX_DISTANCE)
+        self.distance = round(nearest)
+
+
+class IMU(Sensor):
+    """Inertial measurement unit in the plane of motion.
+
+    Heading and angular velocity use the Pybricks convention, where turning
+    clockwise is positive.
+    """
+
+    heading: float = 0.0
+    """Heading in degrees since the start."""
+
+    angular_velocity: float = 0.0
+    """Turn rate in degrees per second."""
+
+    acceleration: float = 0.0
+    """Forward acceleration in mm/s²."""
+
+    def __init__(self) -> None:
+        super().__init__()
+        self._start = None
+        self._speed = 0.0
+        self._time = None
+
+    def update(self, world: World, robot: Robot) -> None:
+        base = robot.drivebase
+
+        if self._start is None:
+            self._start = base.heading
+
+        self.heading = self._start - base.heading
+        self.angular_velocity = -base.turn_rate
+
+        if self._time is not None and world.time > self._time:
+            self.acceleration = (base.speed - self._speed) / (world.time - self._time)
+
+        self._speed = base.speed
+        self._time = world.time
+
+
+class Robot:
+    """Differential drive robot with a motor per wheel and optional sensors."""
+
+    def __init__(
+        self,
+        name: str,
+        x: float = 0.0,
+        y: float = 0.0,
+        heading: float = 0.0,
+        wheel_diameter: float = 56.0,
+        axle_track: float = 112.0,
+        radius: float = 80.0,
+        time: float = 0.0,
+    ) -> None:
+        """
+        Arguments:
+            name: Name of the robot in the world.
+            x: Initial x coordinate of the center of the axle.
+            y: Initial y coordinate of the center of the axle.
+            heading: Initial heading, counterclockwise from the x axis.
+            wheel_diameter: Diameter of the wheels.
+            axle_track: Distance between the wheels.
+            radius: Radius of the robot as seen by other robots' sensors.
+            time: Start time.
+        """
+        self.name = name
+        self.radius = radius
+        self.left_motor = Motor(time)
+        self.right_motor = Motor(time)
+        self.drivebase = DifferentialDrive(wheel_diameter, axle_track, x, y, heading)
+        self.drivebase.update(time, 0.0, 0.0)
+        self.imu = IMU()
+        self.sensors: Dict[str, Sensor] = {}
+
+    def add_sensor(self, name: str, sensor: Sensor) -> Sensor:
+        """Mounts a sensor on the robot and returns it."""
+        self.sensors[name] = sensor
+        return sensor
+
+    def drive(self, time: float, left: float, right: float) -> None:
+        """Sets the duty cycle (-1.0 to 1.0) of both motors from *time* on."""
+        self.left_motor.set_duty_cycle(time, left)
+        self.right_motor.set_duty_cycle(time, right)
+
+    def coast(self, time: float) -> None:
+        """Lets both motors spin freely from *time* on."""
+        self.left_motor.coast(time)
+        self.right_motor.coast(time)
+
+    def advance(self, time: float) -> None:
+        """Simulates the motors up to *time* and moves the robot."""
+        self.left_motor.advance(time)
+        self.right_motor.advance(time)
+        self.drivebase.update(time, self.left_motor.angle, self.right_motor.angle)
+
+
+class World:
+    """A map with any number of robots, stepped together in time."""
+
+    def __init__(self, map: Map, time: float = 0.0) -> None:
+        self.map = map
+        self.time = time
+        self.robots: Dict[str, Robot] = {}
+
+    def add_robot(self, robot: Robot) -> Robot:
+        """Adds a robot to the world and returns it."""
+        if robot.name in self.robots:
+            raise ValueError(f"duplicate robot name {robot.name!r}")
+        self.robots[robot.name] = robot
+        robot.imu.update(self, robot)
+        return robot
+
+    def advance(self, time: float) -> None:
+        """Moves all robots up to *time* and then updates all sensors."""
+        self.time = max(self.time, time)
+
+        for robot in self.robots.values():
+            robot.advance(self.time)
+
+        for robot in self.robots.values():
+            robot.imu.update(self, robot)
+            for sensor in robot.sensors.values():
+                sensor.update(self, robot)
+
+    def cast_ray(
+        self, x: float, y: float, dx: float, dy: float, exclude: Optional[Robot] = None
+    ) -> float:
+        """Gets the distance along a ray to the nearest wall or robot.
+
+        Arguments:
+            x: Start of the ray.
+            y: Start of the ray.
+            dx: Unit direction of the ray.
+            dy: Unit direction of the ray.
+            exclude: Robot that is not hit, usually the one casting the ray.
+
+        Returns:
+            The distance or ``inf`` if nothing is hit.
+        """
+        nearest = inf
+
+        for x1, y1, x2, y2 in self.map.walls:
+            ex, ey = x2 - x1, y2 - y1
+            denom = dx * ey - dy * ex
+            if denom == 0:
+                continue
+            wx, wy = x1 - x, y1 - y
+            t = (wx * ey - wy * ex) / denom
+            u = (wx * dy - wy * dx) / denom
+            if 0 <= t < nearest and 0 <= u <= 1:
+                nearest = t
+
+        for robot in self.robots.values():
+            if robot is exclude:
+                continue
+            cx, cy = robot.drivebase.x - x, robot.drivebase.y - y
+            along = cx * dx + cy * dy
+            if along <= 0:
+                continue
+            off = hypot(cx, cy) ** 2 - along**2
+            if off > robot.radius**2:
+                continue
+            t = along - (robot.radius**2 - off) ** 0.5
+            if 0 <= t < nearest:
+                nearest = t
+
+        return nearest
+
+    def bearing(self, robot: Robot, x: float, y: float) -> float:
+        """Gets the direction to a point relative to a robot, counterclockwise."""
+        base = robot.drivebase
+        angle = degrees(atan2(y - base.y, x - base.x)) - base.heading
+        return (angle + 180) % 360 - 180
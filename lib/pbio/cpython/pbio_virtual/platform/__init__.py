@@ -12,7 +12,8 @@ from ..drv.clock import VirtualClock
 from ..drv.counter import VirtualCounter
 from ..drv.ioport import PortId, VirtualIOPort
 from ..drv.led import VirtualLed
-from ..drv.motor_driver import VirtualMotorDriver
+from ..drv.motor_driver import NativeDrivebase, VirtualMotorDriver
+from ..drv.uart import VirtualUart
 
 
 class VirtualPlatform(abc.ABC):
@@ -52,6 +53,14 @@ class VirtualPlatform(abc.ABC):
     each counter device during init.
     """
 
+    drivebase: Dict[int, NativeDrivebase]
+    """
+    The optional natively simulated drivebase.
+
+    Platforms that simulate one should assign ``drivebase[-1] = NativeDrivebase(...)``
+    during init.
+    """
+
     ioport: Dict[PortId, VirtualIOPort]
     """
     The I/O port driver components.
@@ -76,6 +85,14 @@ class VirtualPlatform(abc.ABC):
     for each motor driver device during init.
     """
 
+    uart: Dict[int, VirtualUart]
+    """
+    The UART driver components.
+
+    Platforms that support UART devices should assign ``uart[<id>] = VirtualUart()``
+    for each port during init and also assign it to ``ioport[<port>].uart``.
+    """
+
     class PollEvent(NamedTuple):
         timestamp: int
         """
@@ -92,9 +109,11 @@ class VirtualPlatform(abc.ABC):
         self.button = {}
         self.clock = {}
         self.counter = {}
+        self.drivebase = {}
         self.ioport = {}
         self.led = {}
         self.motor_driver = {}
+        self.uart = {}
 
         self._poll_subscriptions = []
 
@@ -0,0 +1,34 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2023 The Pybricks Authors
+
+"""Headless world robot that runs on the computer's clock.
+
+This is the same robot as :mod:`pbio_virtual.platform.world`, but with a
+wall clock instead of a simulated clock, so that programs can measure how
+long code takes to run. It is used by ``tests/pup/benchmark/run_api.py``.
+"""
+
+import time
+
+from ..drv.clock import WallClock
+from . import world
+
+
+class BenchmarkClock(WallClock):
+    """
+    Wall clock that starts at 0, so the world time starts at 0 too.
+    """
+
+    def __init__(self) -> None:
+        super().__init__()
+        self._start = time.monotonic_ns()
+
+    @property
+    def nanoseconds(self) -> int:
+        return time.monotonic_ns() - self._start
+
+
+class Platform(world.Platform):
+    def __init__(self) -> None:
+        super().__init__()
+        self.clock[-1] = BenchmarkClock()
@@ -4,7 +4,8 @@
 from ..drv.button import VirtualButtons
 from ..drv.battery import VirtualBattery
 from ..drv.led import VirtualLed
-from ..drv.clock import CountingClock
+from ..drv.motor_driver import NativeDrivebase, NativeModel
+from ..drv.clock import SimulatedClock
 from ..drv.ioport import (
     VirtualIOPort,
     PortId,
@@ -25,6 +26,16 @@ class VirtualMotorDriver:
     dc motor attached to its output wires.
     """
 
+    native_model = NativeModel.NONE
+    """
+    Set to simulate the motor natively instead of with ``sim_motor``.
+    """
+
+    initial_millidegrees = 0
+    """
+    Initial angle of the natively simulated motor.
+    """
+
     def __init__(self, sim_motor):
         self.sim_motor = sim_motor
         self.coasting = True
@@ -117,6 +128,10 @@ class VirtualCounter:
 
 class Platform:
 
+    # Simulate SimpleMotor natively in the virtual hub. Other models, such as
+    # subclasses with custom equations of motion, are always simulated here.
+    NATIVE_SIMULATION = True
+
     # Ports and attached devices.
     PORTS = {
         PortId.A: IODeviceTypeId.TECHNIC_L_ANGULAR_MOTOR,
@@ -127,16 +142,21 @@ class Platform:
         PortId.F: IODeviceTypeId.NONE,
     }
 
+    # Natively simulated drivebase, with the left wheel mounted mirrored on
+    # port A and the right wheel on port B. The pose is available as
+    # ``drivebase[-1]``. Set to None to simulate no drivebase.
+    DRIVEBASE = {"wheel_diameter": 56, "axle_track": 112}
+
     def on_poll(self, *args):
-        # Push clock forward by one tick on each poll.
-        self.clock[-1].tick()
+        # The simulated clock is advanced by the virtual hub.
+        pass
 
     def __init__(self):
 
         # Initialize devices internal to the hub.
         self.battery = {-1: VirtualBattery()}
         self.button = {-1: VirtualButtons()}
-        self.clock = {-1: CountingClock(start=0, fuzz=0)}
+        self.clock = {-1: SimulatedClock(start=0)}
         self.led = {0: VirtualLed()}
 
         # Initialize all ports
@@ -177,3 +197,12 @@ class Platform:
             # Initialize counter and motor drivers with the given motor.
             self.counter[i] = VirtualCounter(self.sim_motor[i], self.clock[-1])
             self.motor_driver[i] = VirtualMotorDriver(self.sim_motor[i])
+
+            if self.NATIVE_SIMULATION and type(self.sim_motor[i]) is SimMotor:
+                self.motor_driver[i].native_model = NativeModel.SIMPLE_MOTOR
+                self.motor_driver[i].initial_millidegrees = initial_angle * 1000
+
+        # Drivebase on the first two ports, if both motors are simulated natively.
+        self.drivebase = {}
+        if self.DRIVEBASE and all(self.motor_driver[i].native_model for i in (0, 1)):
+            self.drivebase[-1] = NativeDrivebase(0, 1, left_direction=-1, **self.DRIVEBASE)
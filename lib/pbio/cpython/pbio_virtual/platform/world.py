@@ -0,0 +1,204 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2023 The Pybricks Authors
+
+"""Virtual hub driving a robot in the headless world.
+
+The hub controls a differential drive robot with its left wheel on port A
+and its right wheel on port B. Like on most robots, the left motor is mounted
+mirrored, so a program should use ``Direction.COUNTERCLOCKWISE`` for it.
+
+The robot's color sensor is an emulated SPIKE Color Sensor on port C and its
+ultrasonic sensor is an emulated SPIKE Ultrasonic Sensor on port D. These
+talk to the hub over a virtual UART, just like real sensors.
+
+Other robots in the world are driven by controllers, see
+:class:`~pbio_virtual.physics.scenario.Scenario`. To set up a different
+world, subclass :class:`Platform` and override :meth:`Platform.create_world`.
+"""
+
+from ..drv.battery import VirtualBattery
+from ..drv.button import VirtualButtons
+from ..drv.clock import SimulatedClock
+from ..drv.counter import VirtualCounter
+from ..drv.ioport import (
+    IODeviceCapabilityFlags,
+    IODeviceTypeId,
+    PortId,
+    VirtualIOPort,
+)
+from ..drv.led import VirtualLed
+from ..drv.lump import LumpDevice, spike_color_sensor, spike_ultrasonic_sensor
+from ..drv.motor_driver import VirtualMotorDriver
+from ..drv.uart import VirtualUart
+from ..physics.scenario import Scenario
+from ..physics.world import ColorSensor, Map, Motor, Robot, UltrasonicSensor, World
+from . import VirtualPlatform
+
+
+class WorldCounter(VirtualCounter):
+    """
+    Counter that reads the angle of a motor in the world.
+    """
+
+    def __init__(self, motor: Motor, sign: int) -> None:
+        self._motor = motor
+        self._sign = sign
+
+    @property
+    def _millidegrees(self) -> int:
+        return round(self._sign * self._motor.angle * 1000)
+
+    @property
+    def rotations(self) -> int:
+        return (self._millidegrees - self.millidegrees) // 360000
+
+    @property
+    def millidegrees(self) -> int:
+        # Same rounding as math.remainder() in pbio_virtual.platform.robot.
+        angle = self._millidegrees
+        return angle - round(angle / 360000) * 360000
+
+    @property
+    def millidegrees_abs(self) -> int:
+        mod_angle = self._millidegrees % 360000
+        return mod_angle if mod_angle < 180000 else mod_angle - 360000
+
+
+def world_color_sensor(sensor: ColorSensor) -> LumpDevice:
+    """
+    Creates a SPIKE Color Sensor that reads the floor below a world sensor.
+    """
+
+    def values(mode: int):
+        r, g, b = (c * 1024 // 255 for c in sensor.rgb)
+        if mode == 1:
+            return [sensor.reflection]
+        if mode == 5:
+            return [r, g, b, (r + g + b) // 3]
+        return [0] * device.modes[mode].num_values
+
+    device = spike_color_sensor(values)
+    return device
+
+
+def world_ultrasonic_sensor(sensor: UltrasonicSensor) -> LumpDevice:
+    """
+    Creates a SPIKE Ultrasonic Sensor that measures like a world sensor.
+    """
+
+    def values(mode: int):
+        if mode in (0, 1, 2):
+            # Distance in millimeters, or -1 if nothing is seen.
+            if sensor.distance >= sensor.MAX_DISTANCE:
+                return [-1]
+            return [sensor.distance]
+        return [0] * device.modes[mode].num_values
+
+    device = spike_ultrasonic_sensor(values)
+    return device
+
+
+class Platform(VirtualPlatform):
+
+    # Time between steps of the robot controllers in seconds.
+    CONTROLLER_INTERVAL = 0.01
+
+    # Name of the robot that is controlled by the hub.
+    HUB_ROBOT = "hub"
+
+    def create_world(self, scenario: Scenario) -> None:
+        """
+        Adds the hub robot and any other robots to the world.
+
+        The default is an empty 2 m by 1.2 m table with the hub robot in the
+        middle, with a color sensor and an ultrasonic sensor at the front.
+        """
+        robot = scenario.add_robot(Robot(self.HUB_ROBOT, x=1000, y=600))
+        robot.add_sensor("color", ColorSensor(forward=60))
+        robot.add_sensor("ultrasonic", UltrasonicSensor(forward=70))
+
+    def __init__(self) -> None:
+        super().__init__()
+
+        self.battery[-1] = VirtualBattery()
+        self.button[-1] = VirtualButtons()
+        self.clock[-1] = SimulatedClock(start=0)
+        self.led[0] = VirtualLed()
+
+        self.world = World(Map(2000, 1200))
+        self.scenario = Scenario(self.world, record=False)
+        self.create_world(self.scenario)
+        self.robot = self.world.robots[self.HUB_ROBOT]
+
+        # 32-bit timestamps are unwrapped to keep the world time increasing.
+        self._last_timestamp = 0
+        self._time = 0.0
+
+        # Left wheel mounted mirrored on A, right wheel on B.
+        wheels = {
+            PortId.A: (self.robot.left_motor, -1),
+            PortId.B: (self.robot.right_motor, 1),
+        }
+
+        # Sensors of the hub robot on C and D, if it has them.
+        sensors = {}
+        if "color" in self.robot.sensors:
+            sensors[PortId.C] = world_color_sensor(self.robot.sensors["color"])
+        if "ultrasonic" in self.robot.sensors:
+            sensors[PortId.D] = world_ultrasonic_sensor(self.robot.sensors["ultrasonic"])
+
+        for i, port_id in enumerate(range(PortId.A, PortId.F + 1)):
+            self.ioport[port_id] = VirtualIOPort(port_id)
+            self.motor_driver[i] = VirtualMotorDriver()
+            self.uart[i] = VirtualUart(sensors.get(port_id))
+            self.ioport[port_id].uart = self.uart[i]
+
+            if port_id not in wheels:
+                self.counter[i] = VirtualCounter()
+                continue
+
+            motor, sign = wheels[port_id]
+            self.counter[i] = WorldCounter(motor, sign)
+
+            self.ioport[port_id].motor_type_id = IODeviceTypeId.SPIKE_M_MOTOR
+            self.ioport[port_id]._iodev.info[0].capability_flags = (
+                IODeviceCapabilityFlags.PBIO_IODEV_CAPABILITY_FLAG_IS_DC_OUTPUT
+                | IODeviceCapabilityFlags.PBIO_IODEV_CAPABILITY_FLAG_HAS_MOTOR_ABS_POS
+            )
+
+            self.motor_driver[i].subscribe_coast(
+                lambda event, motor=motor: motor.coast(self._seconds(event.timestamp))
+            )
+            self.motor_driver[i].subscribe_duty_cycle(
+                lambda event, motor=motor, sign=sign: motor.set_duty_cycle(
+                    self._seconds(event.timestamp), sign * event.duty_cycle
+                )
+            )
+
+        self.subscribe_poll(self._on_poll)
+
+    def _seconds(self, timestamp: int) -> float:
+        """
+        Converts a 32-bit microsecond timestamp to world time.
+        """
+        delta = (timestamp - self._last_timestamp) & 0xFFFFFFFF
+
+        # Motor driver events are sent in order, but may be slightly older
+        # than the last poll.
+        if delta >= 0x80000000:
+            return self._time - ((-delta) & 0xFFFFFFFF) / 1e6
+
+        self._last_timestamp = timestamp
+        self._time += delta / 1e6
+        return self._time
+
+    def _on_poll(self, event: VirtualPlatform.PollEvent) -> None:
+        now = self._seconds(event.timestamp)
+        dt = self.CONTROLLER_INTERVAL
+
+        # Other robots are controlled at a fixed interval, then everything
+        # is moved to the current time before the hub reads its counters.
+        while self.world.time + dt <= now:
+            self.scenario.step(dt)
+
+        self.world.advance(now)
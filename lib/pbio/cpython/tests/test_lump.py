@@ -0,0 +1,270 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2023 The Pybricks Authors
+
+"""Tests for the virtual UART and the emulated LEGO UART devices."""
+
+import ctypes
+import struct
+import unittest
+
+from pbio_virtual.drv.ioport import PortId, VirtualIOPort
+from pbio_virtual.drv.lump import (
+    CMD_SELECT,
+    CMD_SPEED,
+    CMD_TYPE,
+    MSG_TYPE_CMD,
+    MSG_TYPE_DATA,
+    MSG_TYPE_SYS,
+    SPEED_LPF2,
+    SPEED_MIN,
+    SYS_ACK,
+    SYS_NACK,
+    LumpDevice,
+    LumpMode,
+    _message,
+    _message_size,
+    spike_color_sensor,
+)
+from pbio_virtual.drv.uart import VirtualUart
+
+ACK = MSG_TYPE_SYS | SYS_ACK
+NACK = MSG_TYPE_SYS | SYS_NACK
+
+
+def split_messages(data: bytes):
+    """Splits bytes into messages, starting at the first TYPE command."""
+    i = data.find(MSG_TYPE_CMD | CMD_TYPE)
+    messages = []
+
+    while 0 <= i < len(data):
+        size = _message_size(data[i])
+        messages.append(data[i : i + size])
+        i += size
+
+    return messages
+
+
+class Hub:
+    """
+    The hub end of the wire, doing the same steps as ``uartdev``.
+
+    Times are in microseconds, like the timestamps of the virtual hub.
+    """
+
+    def __init__(self, device: LumpDevice) -> None:
+        self.uart = VirtualUart(device)
+        self.device = device
+        self.time = 0
+        self.baud = SPEED_LPF2
+
+    def set_baud(self, baud: int) -> None:
+        self.baud = baud
+        self.uart.on_set_baud_rate(self.time, baud)
+
+    def write(self, data: bytes) -> None:
+        self.uart.on_write(self.time, data)
+
+    def read(self, duration: int, until=lambda data: False) -> bytes:
+        """Reads every millisecond, like ``uart_virtual.c``, for a while."""
+        end = self.time + duration
+        data = bytearray()
+
+        while self.time < end and not until(data):
+            self.time += 1000
+            data += self.uart.read(self.time, 64)
+
+        return bytes(data)
+
+    def sync(self, speed: int = SPEED_LPF2):
+        """
+        Syncs with the device and switches to data mode.
+
+        Returns:
+            The mode information messages.
+        """
+        self.set_baud(SPEED_LPF2)
+        self.write(_message(MSG_TYPE_CMD | CMD_SPEED, struct.pack("<I", speed)))
+
+        reply = self.read(100000, lambda data: len(data) > 0)[:1]
+
+        if reply != bytes([ACK]):
+            self.set_baud(SPEED_MIN)
+        elif speed != SPEED_LPF2:
+            self.set_baud(speed)
+
+        # Mode information ends with an ACK.
+        info = split_messages(
+            self.read(5000000, lambda data: bytes([ACK]) in split_messages(data))
+        )
+        info = info[: info.index(bytes([ACK])) + 1]
+
+        self.write(bytes([ACK]))
+
+        for msg in info:
+            if msg[0] & 0xC7 == MSG_TYPE_CMD | CMD_SPEED:
+                self.set_baud(struct.unpack_from("<I", msg, 1)[0])
+
+        return info
+
+    def read_data(self, duration: int, keep_alive: bool = True):
+        """
+        Reads for a while, sending a keep-alive every 100 ms.
+
+        Returns:
+            The DATA messages.
+        """
+        data = bytearray()
+
+        for _ in range(0, duration, 100000):
+            data += self.read(100000)
+            if keep_alive:
+                self.write(bytes([NACK]))
+
+        i = 0
+        messages = []
+
+        # Skip bytes until the first DATA message.
+        while i < len(data) and data[i] & 0xC0 != MSG_TYPE_DATA:
+            i += 1
+
+        while i < len(data):
+            size = _message_size(data[i])
+            if data[i] & 0xC0 == MSG_TYPE_DATA:
+                messages.append(bytes(data[i : i + size]))
+            i += size
+
+        return messages
+
+
+def custom_device(**kwargs) -> LumpDevice:
+    return LumpDevice(100, [LumpMode("VALUE"), LumpMode("OTHER")], **kwargs)
+
+
+class TestLumpDevice(unittest.TestCase):
+    def declared_speed(self, info):
+        for msg in info:
+            if msg[0] & 0xC7 == MSG_TYPE_CMD | CMD_SPEED:
+                return struct.unpack_from("<I", msg, 1)[0]
+
+    def test_sync(self):
+        device = spike_color_sensor()
+        device.values[0] = [7]
+        hub = Hub(device)
+
+        info = hub.sync()
+        self.assertEqual(info[0], _message(MSG_TYPE_CMD | CMD_TYPE, bytes([device.type_id])))
+        self.assertEqual(self.declared_speed(info), SPEED_LPF2)
+
+        data = hub.read_data(100000)
+        self.assertEqual(device.state, device.DATA)
+        self.assertGreater(len(data), 0)
+        self.assertEqual(data[-1][:2], bytes([MSG_TYPE_DATA | 0, 7]))
+        self.assertEqual(hub.uart.bytes_garbled, 0)
+
+    def test_sync_requested_speed(self):
+        device = custom_device(speed=460800)
+        hub = Hub(device)
+
+        # Like a hub that had errors at a higher speed before.
+        info = hub.sync(230400)
+        self.assertEqual(self.declared_speed(info), 230400)
+
+        self.assertGreater(len(hub.read_data(100000)), 0)
+        self.assertEqual(device.baud, 230400)
+        self.assertEqual(hub.uart.bytes_garbled, 0)
+
+    def test_sync_speed_not_supported(self):
+        device = custom_device()
+        hub = Hub(device)
+
+        # The device does not ACK, so both fall back to 2400 baud.
+        info = hub.sync(230400)
+        self.assertEqual(self.declared_speed(info), SPEED_LPF2)
+        self.assertGreater(len(hub.read_data(100000)), 0)
+        self.assertEqual(device.baud, SPEED_LPF2)
+
+    def test_sync_ev3(self):
+        device = custom_device(lpf2=False, speed=57600)
+        hub = Hub(device)
+
+        info = hub.sync()
+        self.assertEqual(self.declared_speed(info), 57600)
+        self.assertGreater(len(hub.read_data(100000)), 0)
+        self.assertEqual(device.baud, 57600)
+
+    def test_keep_alive(self):
+        device = custom_device()
+        hub = Hub(device)
+        hub.sync()
+
+        hub.read_data(1000000)
+        self.assertEqual(device.resets, 0)
+
+        hub.read_data(1000000, keep_alive=False)
+        self.assertEqual(device.resets, 1)
+        self.assertNotEqual(device.state, device.DATA)
+
+    def test_select_mode(self):
+        device = custom_device()
+        device.values[1] = [42]
+        hub = Hub(device)
+        hub.sync()
+        hub.read_data(100000)
+
+        hub.write(_message(MSG_TYPE_CMD | CMD_SELECT, bytes([1])))
+        data = hub.read_data(100000)
+        self.assertEqual(device.mode, 1)
+        self.assertEqual(data[-1][:2], bytes([MSG_TYPE_DATA | 1, 42]))
+
+    def test_baud_mismatch(self):
+        device = custom_device()
+        hub = Hub(device)
+        hub.sync()
+
+        hub.set_baud(SPEED_MIN)
+        hub.read_data(100000)
+        self.assertGreater(hub.uart.bytes_garbled, 0)
+
+
+class TestConnection(unittest.TestCase):
+    def test_subscribe(self):
+        uart = VirtualUart()
+        events = []
+        unsubscribe = uart.subscribe_connection(events.append)
+
+        uart.plug(custom_device())
+        uart.plug(custom_device())
+        uart.unplug()
+        uart.unplug()
+        self.assertEqual(events, [True, False, True, False])
+
+        unsubscribe()
+        uart.plug(custom_device())
+        self.assertEqual(len(events), 4)
+
+    def test_ioport_callback(self):
+        events = []
+
+        @ctypes.CFUNCTYPE(None, ctypes.c_uint32, ctypes.c_bool)
+        def callback(port, connected):
+            events.append((port, connected))
+
+        address = ctypes.cast(callback, ctypes.c_void_p).value
+
+        port = VirtualIOPort(PortId.C)
+        port.uart = VirtualUart(custom_device())
+
+        # A device that is already plugged in is reported right away.
+        port.on_uart_start(address)
+        self.assertEqual(events, [(PortId.C, True)])
+
+        port.uart.unplug()
+        self.assertEqual(events[-1], (PortId.C, False))
+
+        # Ports without a UART never call back.
+        VirtualIOPort(PortId.D).on_uart_start(address)
+        self.assertEqual(len(events), 2)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,211 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2023 The Pybricks Authors
+
+"""Tests that the native physics models of the virtual hub match the Python models."""
+
+import ctypes
+import os
+import shutil
+import subprocess
+import tempfile
+import unittest
+
+from numpy import array
+
+from pbio_virtual.drv.motor_driver import (
+    NativeDrivebase,
+    NativeModel,
+    pbdrv_virtual_physics_drivebase_t,
+)
+from pbio_virtual.physics.motors import SimpleMotor
+from pbio_virtual.physics.world import DifferentialDrive, Motor
+
+PBIO = os.path.join(os.path.dirname(__file__), "..", "..")
+
+
+def build_library(directory: str) -> ctypes.CDLL:
+    """Compiles ``drv/virtual_physics.c`` on its own into a shared library."""
+    path = os.path.join(directory, "virtual_physics.so")
+    subprocess.run(
+        [
+            os.environ.get("CC", "cc"),
+            "-shared",
+            "-fPIC",
+            "-I" + os.path.join(PBIO, "include"),
+            "-I" + os.path.join(PBIO, "platform", "virtual_hub"),
+            os.path.join(PBIO, "drv", "virtual_physics.c"),
+            "-o",
+            path,
+            "-lm",
+        ],
+        check=True,
+    )
+
+    lib = ctypes.CDLL(path)
+    lib.pbdrv_virtual_physics_get_motor.restype = ctypes.c_void_p
+    lib.pbdrv_virtual_physics_get_motor.argtypes = [ctypes.c_uint8]
+    lib.pbdrv_virtual_physics_motor_init.argtypes = [
+        ctypes.c_uint8,
+        ctypes.c_int,
+        ctypes.c_uint32,
+        ctypes.c_int32,
+    ]
+    lib.pbdrv_virtual_physics_motor_coast.argtypes = [ctypes.c_void_p, ctypes.c_uint32]
+    lib.pbdrv_virtual_physics_motor_set_duty_cycle.argtypes = [
+        ctypes.c_void_p,
+        ctypes.c_uint32,
+        ctypes.c_double,
+    ]
+    lib.pbdrv_virtual_physics_motor_get_angle.restype = ctypes.c_int64
+    lib.pbdrv_virtual_physics_motor_get_angle.argtypes = [ctypes.c_void_p, ctypes.c_uint32]
+    lib.pbdrv_virtual_physics_get_drivebase.restype = ctypes.c_void_p
+    lib.pbdrv_virtual_physics_drivebase_start.argtypes = [ctypes.c_uint32]
+    return lib
+
+
+@unittest.skipUnless(shutil.which(os.environ.get("CC", "cc")), "needs a C compiler")
+class TestNativePhysics(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.directory = tempfile.TemporaryDirectory()
+        cls.lib = build_library(cls.directory.name)
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.directory.cleanup()
+
+    def setUp(self):
+        # Each test starts without a drivebase.
+        drivebase = self.lib.pbdrv_virtual_physics_get_drivebase()
+        ctypes.memset(drivebase, 0, ctypes.sizeof(pbdrv_virtual_physics_drivebase_t))
+
+    def native_motor(self, index: int, time: int = 0, millidegrees: int = 0):
+        self.lib.pbdrv_virtual_physics_motor_init(
+            index, NativeModel.SIMPLE_MOTOR, time, millidegrees
+        )
+        return self.lib.pbdrv_virtual_physics_get_motor(index)
+
+    def actuate(self, motor, time: int, duty: float) -> None:
+        if duty == SimpleMotor.COAST_DUTY:
+            self.lib.pbdrv_virtual_physics_motor_coast(motor, time)
+        else:
+            self.lib.pbdrv_virtual_physics_motor_set_duty_cycle(motor, time, duty)
+
+    def test_no_model(self):
+        self.lib.pbdrv_virtual_physics_motor_init(2, NativeModel.NONE, 0, 0)
+        self.assertIsNone(self.lib.pbdrv_virtual_physics_get_motor(2))
+        self.assertIsNone(self.lib.pbdrv_virtual_physics_get_motor(255))
+
+    def test_motor_matches_model(self):
+        # Same inputs as the numerical model, which takes whole steps.
+        model = SimpleMotor(0, array([0.0, 0.0]))
+        model.actuate(0, array([SimpleMotor.COAST_DUTY]))
+        motor = self.native_motor(0)
+
+        for time, duty in [(0.0, 0.5), (0.3, -1.0), (0.5, SimpleMotor.COAST_DUTY), (0.6, 0.2)]:
+            model.simulate(time)
+            time = model.times[-1]
+            model.actuate(time, array([duty]))
+            self.actuate(motor, round(time * 1e6), duty)
+
+        model.simulate(0.8)
+        angle = self.lib.pbdrv_virtual_physics_motor_get_angle(motor, round(model.times[-1] * 1e6))
+
+        # Within a few millidegrees, the difference of the numerical integration.
+        self.assertAlmostEqual(angle, model.outputs[0, -1], delta=5)
+
+    def test_motor_matches_closed_form(self):
+        motor = self.native_motor(0, millidegrees=90000)
+        expected = Motor(angle=90)
+
+        for i, duty in enumerate([1.0, -0.3, SimpleMotor.COAST_DUTY, 0.7, 0.0]):
+            time = i * 0.25
+            self.actuate(motor, round(time * 1e6), duty)
+            if duty == SimpleMotor.COAST_DUTY:
+                expected.coast(time)
+            else:
+                expected.set_duty_cycle(time, duty)
+
+            # Reading the angle in between must not change the result.
+            expected.advance(time + 0.1)
+            angle = self.lib.pbdrv_virtual_physics_motor_get_angle(
+                motor, round((time + 0.1) * 1e6)
+            )
+            self.assertAlmostEqual(angle / 1000, expected.angle, delta=0.001)
+
+    def test_clock_wraps_around(self):
+        start = 2**32 - 100000
+        motor = self.native_motor(0, time=start)
+        expected = Motor()
+
+        self.actuate(motor, start, 1.0)
+        expected.set_duty_cycle(0, 1.0)
+        expected.advance(0.2)
+
+        angle = self.lib.pbdrv_virtual_physics_motor_get_angle(motor, (start + 200000) % 2**32)
+        self.assertAlmostEqual(angle / 1000, expected.angle, delta=0.001)
+
+    def test_drivebase_matches_python(self):
+        left = self.native_motor(0)
+        right = self.native_motor(1)
+
+        drivebase = NativeDrivebase(
+            0, 1, wheel_diameter=56, axle_track=112, left_direction=-1, x=10, heading=30
+        )
+        drivebase.on_start(self.lib.pbdrv_virtual_physics_get_drivebase())
+        self.lib.pbdrv_virtual_physics_drivebase_start(0)
+        self.assertTrue(drivebase.enabled)
+
+        expected = DifferentialDrive(wheel_diameter=56, axle_track=112, x=10, heading=30)
+        left_motor = Motor()
+        right_motor = Motor()
+        expected.update(0, 0, 0)
+
+        # The left motor is mounted mirrored, so it drives forward backwards.
+        steps = [(-0.8, 0.8), (-1.0, 0.2), (SimpleMotor.COAST_DUTY, -0.5), (0.4, 0.4)]
+
+        for i, (left_duty, right_duty) in enumerate(steps):
+            time = i * 0.5
+            for native, motor, duty in [
+                (left, left_motor, left_duty),
+                (right, right_motor, right_duty),
+            ]:
+                self.actuate(native, round(time * 1e6), duty)
+                if duty == SimpleMotor.COAST_DUTY:
+                    motor.coast(time)
+                else:
+                    motor.set_duty_cycle(time, duty)
+
+            # Updates as often as the hub reads the motors.
+            for j in range(1, 51):
+                now = time + j / 100
+                self.lib.pbdrv_virtual_physics_motor_get_angle(left, round(now * 1e6))
+                self.lib.pbdrv_virtual_physics_motor_get_angle(right, round(now * 1e6))
+                left_motor.advance(now)
+                right_motor.advance(now)
+                expected.update(now, -left_motor.angle, right_motor.angle)
+
+        self.assertEqual(drivebase.time, 2000000)
+        self.assertAlmostEqual(drivebase.x, expected.x, delta=0.01)
+        self.assertAlmostEqual(drivebase.y, expected.y, delta=0.01)
+        self.assertAlmostEqual(drivebase.heading, expected.heading, delta=0.01)
+        self.assertAlmostEqual(drivebase.distance, expected.distance, delta=0.01)
+        self.assertGreater(abs(expected.heading - 30), 10)
+
+    def test_drivebase_needs_two_motors(self):
+        self.native_motor(0)
+        self.lib.pbdrv_virtual_physics_motor_init(1, NativeModel.NONE, 0, 0)
+
+        drivebase = NativeDrivebase(0, 1, wheel_diameter=56, axle_track=112)
+        drivebase.on_start(self.lib.pbdrv_virtual_physics_get_drivebase())
+        self.lib.pbdrv_virtual_physics_drivebase_start(0)
+        self.assertFalse(drivebase.enabled)
+
+        drivebase = NativeDrivebase(0, 0, wheel_diameter=56, axle_track=112)
+        drivebase.on_start(self.lib.pbdrv_virtual_physics_get_drivebase())
+        self.lib.pbdrv_virtual_physics_drivebase_start(0)
+        self.assertFalse(drivebase.enabled)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,316 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2023 The Pybricks Authors
+
+"""Tests for the headless world and the virtual hub platform that uses it."""
+
+import os
+import tempfile
+import unittest
+from math import inf, pi
+
+from numpy import array
+
+from pbio_virtual.physics.motors import SimpleMotor
+from pbio_virtual.physics.world import (
+    IMU,
+    ColorSensor,
+    DifferentialDrive,
+    Map,
+    Motor,
+    Robot,
+    UltrasonicSensor,
+    World,
+)
+from pbio_virtual.platform.world import Platform
+
+RED = (255, 0, 0)
+GREEN = (0, 255, 0)
+BLUE = (0, 0, 255)
+BLACK = (0, 0, 0)
+WHITE = (255, 255, 255)
+
+
+class TestMotor(unittest.TestCase):
+    def simulate(self, actuations, time_end):
+        """Runs the closed form and the numerical model with the same inputs."""
+        motor = Motor()
+        model = SimpleMotor(0, array([0.0, 0.0]))
+        model.actuate(0, array([SimpleMotor.COAST_DUTY]))
+
+        # The model simulates in whole steps, so use the time it got to.
+        for time, duty in actuations:
+            model.simulate(time)
+            time = model.times[-1]
+            model.actuate(time, array([duty]))
+            if duty == SimpleMotor.COAST_DUTY:
+                motor.coast(time)
+            else:
+                motor.set_duty_cycle(time, duty)
+
+        model.simulate(time_end)
+        motor.advance(model.times[-1])
+        return motor, model.outputs[0, -1] / 1000
+
+    def test_matches_model(self):
+        motor, angle = self.simulate([(0.0, 0.5), (0.3, -1.0), (0.5, SimpleMotor.COAST_DUTY)], 0.8)
+        self.assertAlmostEqual(motor.angle, angle, delta=0.01)
+
+    def test_step_size(self):
+        # The closed form is exact, so many small steps give the same result.
+        one = Motor()
+        many = Motor()
+        one.set_duty_cycle(0, 0.7)
+        many.set_duty_cycle(0, 0.7)
+        one.advance(1.0)
+        for i in range(1, 1001):
+            many.advance(i / 1000)
+        self.assertAlmostEqual(one.angle, many.angle, places=6)
+        self.assertAlmostEqual(one.speed, many.speed, places=6)
+
+    def test_steady_state(self):
+        motor = Motor()
+        motor.set_duty_cycle(0, 1.0)
+        motor.advance(10)
+        a, b = SimpleMotor.coefficients(1.0)
+        self.assertAlmostEqual(motor.alpha_dot, b / a)
+
+    def test_duty_is_clamped(self):
+        motor = Motor()
+        motor.set_duty_cycle(0, 5.0)
+        self.assertEqual(motor.duty, 1.0)
+
+    def test_coast_slows_down(self):
+        motor = Motor()
+        motor.set_duty_cycle(0, 1.0)
+        motor.coast(1.0)
+        speed = motor.speed
+        motor.advance(1.1)
+        self.assertLess(motor.speed, speed)
+        self.assertGreater(motor.speed, 0)
+
+
+class TestDifferentialDrive(unittest.TestCase):
+    def test_straight(self):
+        base = DifferentialDrive(wheel_diameter=56, axle_track=112, x=100, y=200, heading=90)
+        base.update(0, 0, 0)
+        base.update(1, 360, 360)
+        self.assertAlmostEqual(base.x, 100)
+        self.assertAlmostEqual(base.y, 200 + 56 * pi)
+        self.assertAlmostEqual(base.heading, 90)
+        self.assertAlmostEqual(base.speed, 56 * pi)
+        self.assertAlmostEqual(base.distance, 56 * pi)
+
+    def test_turn_in_place(self):
+        base = DifferentialDrive(wheel_diameter=56, axle_track=112)
+        base.update(0, 0, 0)
+
+        # Each wheel travels a quarter of the circle with the axle as diameter.
+        wheel_angle = 112 * pi / 4 / (56 * pi) * 360
+        base.update(2, -wheel_angle, wheel_angle)
+        self.assertAlmostEqual(base.heading, 90)
+        self.assertAlmostEqual(base.turn_rate, 45)
+        self.assertAlmostEqual(base.x, 0)
+        self.assertAlmostEqual(base.y, 0)
+
+    def test_arc(self):
+        # With constant wheel speeds the pose is exact no matter the steps.
+        one = DifferentialDrive(wheel_diameter=56, axle_track=112)
+        many = DifferentialDrive(wheel_diameter=56, axle_track=112)
+        one.update(0, 0, 0)
+        many.update(0, 0, 0)
+        one.update(1, 500, 800)
+        for i in range(1, 101):
+            many.update(i / 100, 5 * i, 8 * i)
+        self.assertAlmostEqual(one.x, many.x)
+        self.assertAlmostEqual(one.y, many.y)
+        self.assertAlmostEqual(one.heading, many.heading)
+
+
+class TestMap(unittest.TestCase):
+    def test_color_at(self):
+        # Row 0 is at the top of the map.
+        floor = Map(200, 100, [[RED, GREEN], [BLUE, BLACK]], background=WHITE)
+        self.assertEqual(floor.color_at(50, 75), RED)
+        self.assertEqual(floor.color_at(150, 75), GREEN)
+        self.assertEqual(floor.color_at(50, 25), BLUE)
+        self.assertEqual(floor.color_at(150, 25), BLACK)
+        self.assertEqual(floor.color_at(-1, 50), WHITE)
+        self.assertEqual(floor.color_at(200, 50), WHITE)
+
+    def test_edges_are_walls(self):
+        floor = Map(200, 100, walls=[(10, 10, 20, 20)])
+        self.assertEqual(len(floor.walls), 5)
+        self.assertIn((0, 0, 200, 0), floor.walls)
+
+    def load_ppm(self, data, resolution):
+        fd, path = tempfile.mkstemp(suffix=".ppm")
+        try:
+            with os.fdopen(fd, "wb") as f:
+                f.write(data)
+            return Map.from_ppm(path, resolution)
+        finally:
+            os.remove(path)
+
+    def test_from_ppm_binary(self):
+        floor = self.load_ppm(b"P6\n# comment\n2 1\n255\n" + bytes(RED + BLUE), resolution=10)
+        self.assertEqual((floor.width, floor.height), (20, 10))
+        self.assertEqual(floor.color_at(5, 5), RED)
+        self.assertEqual(floor.color_at(15, 5), BLUE)
+
+    def test_from_ppm_plain(self):
+        floor = self.load_ppm(b"P3 1 2 15\n15 0 0\n0 15 0\n", resolution=1)
+        self.assertEqual(floor.color_at(0.5, 1.5), RED)
+        self.assertEqual(floor.color_at(0.5, 0.5), GREEN)
+
+    def test_from_ppm_invalid(self):
+        with self.assertRaises(ValueError):
+            self.load_ppm(b"P5 1 1 255\n\x00", resolution=1)
+
+
+class TestCastRay(unittest.TestCase):
+    def setUp(self):
+        self.world = World(Map(1000, 500, walls=[(600, 0, 600, 200)]))
+
+    def test_edge(self):
+        self.assertAlmostEqual(self.world.cast_ray(100, 300, 1, 0), 900)
+        self.assertAlmostEqual(self.world.cast_ray(100, 300, 0, -1), 300)
+
+    def test_wall(self):
+        self.assertAlmostEqual(self.world.cast_ray(100, 100, 1, 0), 500)
+
+        # Passes just above the end of the wall.
+        self.assertAlmostEqual(self.world.cast_ray(100, 201, 1, 0), 900)
+
+    def test_parallel_wall(self):
+        self.assertAlmostEqual(self.world.cast_ray(600, 300, 0, -1), 300)
+
+    def test_robot(self):
+        other = self.world.add_robot(Robot("other", x=400, y=300, radius=50))
+        self.assertAlmostEqual(self.world.cast_ray(100, 300, 1, 0), 250)
+
+        # Grazing the side of the robot.
+        self.assertAlmostEqual(self.world.cast_ray(100, 340, 1, 0), 270)
+
+        # Robots behind the ray or excluded are not seen.
+        self.assertAlmostEqual(self.world.cast_ray(500, 300, 1, 0), 500)
+        self.assertAlmostEqual(self.world.cast_ray(100, 300, 1, 0, exclude=other), 900)
+
+    def test_outside(self):
+        self.assertEqual(World(Map(100, 100)).cast_ray(200, 50, 1, 0), inf)
+
+    def test_bearing(self):
+        robot = self.world.add_robot(Robot("a", x=100, y=100, heading=90))
+        self.assertAlmostEqual(self.world.bearing(robot, 100, 200), 0)
+        self.assertAlmostEqual(self.world.bearing(robot, 0, 100), 90)
+        self.assertAlmostEqual(self.world.bearing(robot, 200, 100), -90)
+        self.assertAlmostEqual(abs(self.world.bearing(robot, 100, 0)), 180)
+
+
+class TestSensors(unittest.TestCase):
+    def test_position(self):
+        robot = Robot("a", x=100, y=100, heading=90)
+        self.assertEqual(
+            tuple(round(v) for v in ColorSensor(forward=50, left=20).position(robot)),
+            (80, 150),
+        )
+
+    def test_color_sensor(self):
+        world = World(Map(200, 100, [[WHITE, BLACK]]))
+        robot = world.add_robot(Robot("a", x=50, y=50))
+        sensor = robot.add_sensor("color", ColorSensor(forward=100))
+
+        world.advance(0)
+        self.assertEqual(sensor.rgb, BLACK)
+        self.assertEqual(sensor.reflection, 0)
+
+        # Backing up over the white half.
+        robot.drive(0, -0.5, -0.5)
+        world.advance(0.5)
+        self.assertEqual(sensor.rgb, WHITE)
+        self.assertEqual(sensor.reflection, 100)
+
+    def test_ultrasonic_sensor(self):
+        world = World(Map(1000, 500))
+        robot = world.add_robot(Robot("a", x=100, y=250))
+        ahead = robot.add_sensor("ahead", UltrasonicSensor(forward=50))
+        left = robot.add_sensor("left", UltrasonicSensor(angle=90))
+        world.add_robot(Robot("b", x=500, y=250, radius=50))
+
+        world.advance(0)
+        self.assertEqual(ahead.distance, 300)
+        self.assertEqual(left.distance, 250)
+
+        # Nothing within range.
+        far = World(Map(5000, 5000))
+        robot = far.add_robot(Robot("a", x=100, y=2500))
+        sensor = robot.add_sensor("ahead", UltrasonicSensor())
+        far.advance(0)
+        self.assertEqual(sensor.distance, UltrasonicSensor.MAX_DISTANCE)
+
+    def test_imu(self):
+        world = World(Map(2000, 2000))
+        robot = world.add_robot(Robot("a", x=1000, y=1000, heading=45))
+
+        # Turning counterclockwise is a negative heading for Pybricks.
+        robot.drive(0, -0.5, 0.5)
+        world.advance(0.5)
+        self.assertLess(robot.imu.heading, 0)
+        self.assertLess(robot.imu.angular_velocity, 0)
+        self.assertAlmostEqual(robot.imu.heading, 45 - robot.drivebase.heading)
+
+    def test_imu_acceleration(self):
+        imu = IMU()
+        world = World(Map(2000, 2000))
+        robot = world.add_robot(Robot("a", x=1000, y=1000))
+        robot.add_sensor("imu", imu)
+        robot.drive(0, 1.0, 1.0)
+        world.advance(0.01)
+        world.advance(0.02)
+        self.assertGreater(imu.acceleration, 0)
+
+
+class TestPlatform(unittest.TestCase):
+    def setUp(self):
+        self.platform = Platform()
+
+    def test_wheels(self):
+        # Both wheels forward, with the left one mounted mirrored.
+        self.platform.motor_driver[0].on_set_duty_cycle(0, -1.0)
+        self.platform.motor_driver[1].on_set_duty_cycle(0, 1.0)
+        self.platform.on_poll(500000)
+
+        robot = self.platform.robot
+        self.assertAlmostEqual(self.platform.world.time, 0.5)
+        self.assertGreater(robot.drivebase.x, 1000)
+        self.assertAlmostEqual(robot.drivebase.heading, 0)
+
+        left, right = self.platform.counter[0], self.platform.counter[1]
+        self.assertLess(left.rotations * 360000 + left.millidegrees, 0)
+        self.assertGreater(right.rotations * 360000 + right.millidegrees, 0)
+        self.assertLessEqual(abs(right.millidegrees), 180000)
+
+    def test_timestamp_wraps(self):
+        # Skip stepping the controllers through the hour before the wrap.
+        self.platform.CONTROLLER_INTERVAL = 1000
+        for timestamp in range(0, 0x100000000, 0x40000000):
+            self.platform.on_poll(timestamp)
+        self.platform.on_poll(0xFFFF0000)
+        time = self.platform.world.time
+        self.platform.on_poll(0x00010000)
+        self.assertAlmostEqual(self.platform.world.time - time, 0x20000 / 1e6)
+
+    def test_sensors(self):
+        self.platform.on_poll(0)
+        color = self.platform.uart[2].device
+        ultrasonic = self.platform.uart[3].device
+
+        # The value is right before the checksum at the end of the message.
+        self.assertEqual(color.data_message(1)[-2], 100)
+
+        # 1000 mm to the right edge, measured from 70 mm ahead of the axle.
+        message = ultrasonic.data_message(0)
+        self.assertEqual(int.from_bytes(message[-3:-1], "little", signed=True), 930)
+
+
+if __name__ == "__main__":
+    unittest.main()
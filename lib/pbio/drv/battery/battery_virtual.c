@@ -17,23 +17,30 @@
 void pbdrv_battery_init(void) {
 }
 
+// Values are read from the snapshot that is updated on each poll.
+
 pbio_error_t pbdrv_battery_get_voltage_now(uint16_t *value) {
-    return pbdrv_virtual_get_u16("battery", -1, "voltage", value);
+    const pbdrv_virtual_value_t *voltage = &pbdrv_virtual_get_snapshot()->battery_voltage;
+    *value = voltage->value;
+    return voltage->err;
 }
 
 pbio_error_t pbdrv_battery_get_current_now(uint16_t *value) {
-    return pbdrv_virtual_get_u16("battery", -1, "current", value);
+    const pbdrv_virtual_value_t *current = &pbdrv_virtual_get_snapshot()->battery_current;
+    *value = current->value;
+    return current->err;
 }
 
 pbio_error_t pbdrv_battery_get_temperature(uint32_t *value) {
-    return pbdrv_virtual_get_u32("battery", -1, "temperature", value);
+    const pbdrv_virtual_value_t *temperature = &pbdrv_virtual_get_snapshot()->battery_temperature;
+    *value = temperature->value;
+    return temperature->err;
 }
 
 pbio_error_t pbdrv_battery_get_type(pbdrv_battery_type_t *value) {
-    uint8_t int_value;
-    pbio_error_t err = pbdrv_virtual_get_u8("battery", -1, "type", &int_value);
-    *value = int_value;
-    return err;
+    const pbdrv_virtual_value_t *type = &pbdrv_virtual_get_snapshot()->battery_type;
+    *value = type->value;
+    return type->err;
 }
 
 #endif // PBDRV_CONFIG_BATTERY_VIRTUAL
@@ -7,6 +7,7 @@
 
 #if PBDRV_CONFIG_BLOCK_DEVICE_FLASH_STM32
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -48,6 +49,24 @@ typedef union _double_word_t {
     uint64_t dword;
 } double_word_t;
 
+/**
+ * Checks if a flash page already holds the data to be stored.
+ *
+ * @param [in] offset   Offset of the page from the start of the storage area.
+ * @param [in] buffer   The data to be stored from the start of the storage area.
+ * @param [in] size     Size of @p buffer. Anything beyond must be erased.
+ * @return              True if the page does not need to be erased and written.
+ */
+static bool block_device_page_is_equal(uint32_t offset, const uint8_t *buffer, uint32_t size) {
+    for (uint32_t i = offset; i < offset + FLASH_PAGE_SIZE; i++) {
+        uint8_t expected = i < size ? buffer[i] : 0xFF;
+        if (_pbdrv_block_device_storage_start[i] != expected) {
+            return false;
+        }
+    }
+    return true;
+}
+
 static pbio_error_t block_device_erase_and_write(uint8_t *buffer, uint32_t size) {
 
     static const uint32_t base_address = (uint32_t)(&_pbdrv_block_device_storage_start[0]);
@@ -63,51 +82,59 @@ static pbio_error_t block_device_erase_and_write(uint8_t *buffer, uint32_t size)
         return PBIO_ERROR_IO;
     }
 
-    // Erase the whole user storage area.
-    FLASH_EraseInitTypeDef erase_init = {
-        #if defined(STM32F0)
-        .PageAddress = base_address,
-        #elif defined(STM32L4)
-        .Banks = FLASH_BANK_1, // Hard coded for STM32L431RC.
-        .Page = (FLASH_SIZE - (PBDRV_CONFIG_BLOCK_DEVICE_FLASH_STM32_SIZE)) / FLASH_PAGE_SIZE,
-        #else
-        #error "Unsupported target."
-        #endif
-        .NbPages = PBDRV_CONFIG_BLOCK_DEVICE_FLASH_STM32_SIZE / FLASH_PAGE_SIZE,
-        .TypeErase = FLASH_TYPEERASE_PAGES
-    };
-
-    // Disable interrupts to avoid crash if reading while writing/erasing.
-    uint32_t state = __get_PRIMASK();
-    __disable_irq();
-
-    // Erase and re-enable interrupts.
-    uint32_t page_error;
-    hal_err = HAL_FLASHEx_Erase(&erase_init, &page_error);
-    __set_PRIMASK(state);
-    if (hal_err != HAL_OK || page_error != 0xFFFFFFFFU) {
-        HAL_FLASH_Lock();
-        return PBIO_ERROR_IO;
-    }
+    // Only erase and write the pages that changed. Pages after the data are
+    // still erased if needed, since the bootloader checksum relies on it.
+    for (uint32_t page = 0; page < PBDRV_CONFIG_BLOCK_DEVICE_FLASH_STM32_SIZE; page += FLASH_PAGE_SIZE) {
 
-    // Write data chunk by chunk.
-    uint32_t done = 0;
-    while (done < size) {
+        if (block_device_page_is_equal(page, buffer, size)) {
+            continue;
+        }
 
-        // Disable interrupts while writing as above.
-        state = __get_PRIMASK();
+        FLASH_EraseInitTypeDef erase_init = {
+            #if defined(STM32F0)
+            .PageAddress = base_address + page,
+            #elif defined(STM32L4)
+            .Banks = FLASH_BANK_1, // Hard coded for STM32L431RC.
+            .Page = (FLASH_SIZE - (PBDRV_CONFIG_BLOCK_DEVICE_FLASH_STM32_SIZE) + page) / FLASH_PAGE_SIZE,
+            #else
+            #error "Unsupported target."
+            #endif
+            .NbPages = 1,
+            .TypeErase = FLASH_TYPEERASE_PAGES
+        };
+
+        // Disable interrupts to avoid crash if reading while writing/erasing.
+        uint32_t state = __get_PRIMASK();
         __disable_irq();
 
-        // Write the data and re-enable interrupts.
-        hal_err = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, base_address + done, *(uint64_t *)(buffer + done));
+        // Erase and re-enable interrupts.
+        uint32_t page_error;
+        hal_err = HAL_FLASHEx_Erase(&erase_init, &page_error);
         __set_PRIMASK(state);
-        if (hal_err != HAL_OK) {
+        if (hal_err != HAL_OK || page_error != 0xFFFFFFFFU) {
             HAL_FLASH_Lock();
             return PBIO_ERROR_IO;
         }
 
-        // Update write progress.
-        done += sizeof(double_word_t);
+        // Write data chunk by chunk, up to the end of this page.
+        uint32_t done = page;
+        while (done < size && done < page + FLASH_PAGE_SIZE) {
+
+            // Disable interrupts while writing as above.
+            state = __get_PRIMASK();
+            __disable_irq();
+
+            // Write the data and re-enable interrupts.
+            hal_err = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, base_address + done, *(uint64_t *)(buffer + done));
+            __set_PRIMASK(state);
+            if (hal_err != HAL_OK) {
+                HAL_FLASH_Lock();
+                return PBIO_ERROR_IO;
+            }
+
+            // Update write progress.
+            done += sizeof(double_word_t);
+        }
     }
 
     // Lock flash on completion.
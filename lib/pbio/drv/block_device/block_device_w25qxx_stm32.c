@@ -79,8 +79,15 @@ typedef struct {
     DMA_HandleTypeDef tx_dma;
     /** DMA for receiving SPI data */
     DMA_HandleTypeDef rx_dma;
+    /** Where to receive the next chunk of a chained read. */
+    uint8_t *read_next;
+    /** Size of a chained read still to be received after the current chunk. */
+    volatile uint32_t read_remaining;
 } pbdrv_block_device_drv_t;
 
+// Maximum size of one SPI DMA transfer.
+#define SPI_DMA_SIZE_MAX (UINT16_MAX)
+
 /** The block device instance. */
 static pbdrv_block_device_drv_t bdev = {
     .pdata = &pbdrv_block_device_w25qxx_stm32_platform_data,
@@ -123,7 +130,22 @@ void pbdrv_block_device_w25qxx_stm32_spi_tx_complete(void) {
  * Rx transfer complete. Called from IRQ handler in platform.c.
  */
 void pbdrv_block_device_w25qxx_stm32_spi_rx_complete(void) {
-    bdev.spi_status = SPI_STATUS_COMPLETE;
+    // Reads longer than one DMA transfer continue right here, while CS is
+    // still enabled, so the flash just keeps sending data from the next
+    // address without waiting for the process to send a new command.
+    if (bdev.read_remaining) {
+        uint8_t *buffer = bdev.read_next;
+        uint32_t size = pbio_int_math_min(bdev.read_remaining, SPI_DMA_SIZE_MAX);
+        bdev.read_next += size;
+        bdev.read_remaining -= size;
+        if (HAL_SPI_Receive_DMA(&bdev.hspi, buffer, size) == HAL_OK) {
+            return;
+        }
+        bdev.read_remaining = 0;
+        bdev.spi_status = SPI_STATUS_ERROR;
+    } else {
+        bdev.spi_status = SPI_STATUS_COMPLETE;
+    }
 
     if (bdev.process) {
         process_poll(bdev.process);
@@ -156,6 +178,18 @@ static void spi_chip_select(bool set) {
     }
 }
 
+/**
+ * Cleans up after a failed SPI transfer, after the error was reported. This
+ * stops the transfer and releases the peripheral, so the next command can
+ * start.
+ */
+static void spi_recover(void) {
+    HAL_SPI_Abort(&bdev.hspi);
+    bdev.read_remaining = 0;
+    spi_chip_select(false);
+    bdev.spi_status = SPI_STATUS_COMPLETE;
+}
+
 /**
  * Initiates an SPI transfer via DMA.
  *
@@ -186,10 +220,15 @@ static pbio_error_t spi_begin(const spi_command_t *cmd) {
         err = HAL_SPI_Transmit_DMA(&bdev.hspi, cmd->buffer, cmd->size);
     }
 
+    if (err == HAL_OK) {
+        return PBIO_SUCCESS;
+    }
+
+    // Nothing was started, so there is nothing to wait for.
+    bdev.spi_status = SPI_STATUS_COMPLETE;
+
     // Handle HAL errors.
     switch (err) {
-        case HAL_OK:
-            return PBIO_SUCCESS;
         case HAL_ERROR:
             return PBIO_ERROR_INVALID_ARG;
         case HAL_BUSY:
@@ -217,7 +256,12 @@ static PT_THREAD(spi_command_thread(struct pt *pt, const spi_command_t *cmd, pbi
     }
 
     // Wait until SPI operation completes.
-    PT_WAIT_UNTIL(pt, bdev.spi_status == SPI_STATUS_COMPLETE);
+    PT_WAIT_UNTIL(pt, bdev.spi_status != SPI_STATUS_WAIT);
+    if (bdev.spi_status == SPI_STATUS_ERROR) {
+        *err = PBIO_ERROR_IO;
+        spi_recover();
+        PT_EXIT(pt);
+    }
 
     // Turn off peripheral if requested.
     if (!(cmd->operation & SPI_CS_KEEP_ENABLED)) {
@@ -267,7 +311,6 @@ enum {
  */
 enum {
     FLASH_SIZE_ERASE = 4 * 1024, // Limited by W25QXX operation
-    FLASH_SIZE_READ = UINT16_MAX + 1, // Limited by STM32 DMA transfer size.
     FLASH_SIZE_WRITE = 256, // Limited by W25QXX operation
 };
 
@@ -358,8 +401,6 @@ static spi_command_t cmd_data_read = {
 PT_THREAD(pbdrv_block_device_read(struct pt *pt, uint32_t offset, uint8_t *buffer, uint32_t size, pbio_error_t *err)) {
 
     static struct pt child;
-    static uint32_t size_done;
-    static uint32_t size_now;
 
     PT_BEGIN(pt);
 
@@ -376,28 +417,107 @@ PT_THREAD(pbdrv_block_device_read(struct pt *pt, uint32_t offset, uint8_t *buffe
 
     bdev.process = PROCESS_CURRENT();
 
-    // Split up reads to maximum chunk size.
-    for (size_done = 0; size_done < size; size_done += size_now) {
-        size_now = pbio_int_math_min(size - size_done, FLASH_SIZE_READ);
+    // Set address for the read request and send it. The flash keeps
+    // sending data for as long as CS stays enabled, so one request is
+    // enough for the whole read.
+    set_address_be(&cmd_request_read.buffer[1], PBDRV_CONFIG_BLOCK_DEVICE_W25QXX_STM32_START_ADDRESS + offset);
+    PT_SPAWN(pt, &child, spi_command_thread(&child, &cmd_request_read, err));
+    if (*err != PBIO_SUCCESS) {
+        goto out;
+    }
 
-        // Set address for this read request and send it.
-        set_address_be(&cmd_request_read.buffer[1], PBDRV_CONFIG_BLOCK_DEVICE_W25QXX_STM32_START_ADDRESS + offset + size_done);
-        PT_SPAWN(pt, &child, spi_command_thread(&child, &cmd_request_read, err));
-        if (*err != PBIO_SUCCESS) {
+    // Receive the data. Transfers after the first are chained from the Rx
+    // complete interrupt, so there are no gaps between chunks.
+    cmd_data_read.buffer = buffer;
+    cmd_data_read.size = pbio_int_math_min(size, SPI_DMA_SIZE_MAX);
+    bdev.read_next = buffer + cmd_data_read.size;
+    bdev.read_remaining = size - cmd_data_read.size;
+    PT_SPAWN(pt, &child, spi_command_thread(&child, &cmd_data_read, err));
+
+out:
+    bdev.read_remaining = 0;
+    bdev.process = NULL;
+
+    PT_END(pt);
+}
+
+// Buffers for reading back flash contents to compare with data to be stored.
+// One page is compared while the next is being received.
+static uint8_t compare_buf[2][FLASH_SIZE_WRITE];
+
+/**
+ * Checks if a sector already holds the data to be stored.
+ *
+ * @param [in] address  Address of the sector, aligned with a sector.
+ * @param [in] buffer   The data to be stored in this sector.
+ * @param [in] size     Size of @p buffer. The rest of the sector must be erased.
+ * @param [out] equal   Whether the sector needs to be erased and written.
+ * @param [out] err     ::PBIO_SUCCESS or an error from the SPI transfer.
+ */
+static PT_THREAD(flash_sector_is_equal(struct pt *pt, uint32_t address, const uint8_t *buffer, uint32_t size, bool *equal, pbio_error_t *err)) {
+
+    static struct pt child;
+    static uint32_t size_done;
+
+    PT_BEGIN(pt);
+
+    *equal = false;
+
+    // Request the whole sector at once. CS is kept enabled while receiving
+    // it page by page.
+    set_address_be(&cmd_request_read.buffer[1], address);
+    PT_SPAWN(pt, &child, spi_command_thread(&child, &cmd_request_read, err));
+    if (*err != PBIO_SUCCESS) {
+        PT_EXIT(pt);
+    }
+
+    // Start receiving the first page.
+    cmd_data_read.buffer = compare_buf[0];
+    cmd_data_read.size = FLASH_SIZE_WRITE;
+    *err = spi_begin(&cmd_data_read);
+    if (*err != PBIO_SUCCESS) {
+        goto out;
+    }
+
+    for (size_done = 0; size_done < FLASH_SIZE_ERASE; size_done += FLASH_SIZE_WRITE) {
+
+        // Wait for this page.
+        PT_WAIT_UNTIL(pt, bdev.spi_status != SPI_STATUS_WAIT);
+        if (bdev.spi_status == SPI_STATUS_ERROR) {
+            *err = PBIO_ERROR_IO;
             goto out;
         }
+        const uint8_t *received = cmd_data_read.buffer;
+
+        // Start receiving the next page before comparing this one.
+        if (size_done + FLASH_SIZE_WRITE < FLASH_SIZE_ERASE) {
+            cmd_data_read.buffer = compare_buf[received == compare_buf[0]];
+            *err = spi_begin(&cmd_data_read);
+            if (*err != PBIO_SUCCESS) {
+                goto out;
+            }
+        }
 
-        // Receive the data.
-        cmd_data_read.buffer = buffer + size_done;
-        cmd_data_read.size = size_now;
-        PT_SPAWN(pt, &child, spi_command_thread(&child, &cmd_data_read, err));
-        if (*err != PBIO_SUCCESS) {
-            goto out;
+        for (uint32_t i = 0; i < FLASH_SIZE_WRITE; i++) {
+            uint8_t expected = size_done + i < size ? buffer[size_done + i] : 0xFF;
+            if (received[i] != expected) {
+                goto out;
+            }
         }
     }
 
+    *equal = true;
+
 out:
-    bdev.process = NULL;
+    // Let any page still being received finish before releasing CS.
+    PT_WAIT_UNTIL(pt, bdev.spi_status != SPI_STATUS_WAIT);
+    if (bdev.spi_status == SPI_STATUS_ERROR) {
+        // Already reported if it matters. After a mismatch, the sector is
+        // written anyway.
+        spi_recover();
+    } else {
+        spi_chip_select(false);
+    }
 
     PT_END(pt);
 }
@@ -465,8 +585,10 @@ PT_THREAD(pbdrv_block_device_store(struct pt *pt, uint8_t *buffer, uint32_t size
 
     static struct pt child;
     static uint32_t offset;
+    static uint32_t sector_size;
     static uint32_t size_now;
     static uint32_t size_done;
+    static bool equal;
 
     PT_BEGIN(pt);
 
@@ -483,24 +605,37 @@ PT_THREAD(pbdrv_block_device_store(struct pt *pt, uint8_t *buffer, uint32_t size
 
     bdev.process = PROCESS_CURRENT();
 
-    // Erase sector by sector.
+    // Sector by sector, so that sectors that did not change are not erased
+    // and rewritten. Usually only a small part of the data changes, such as
+    // the user data in the header.
     for (offset = 0; offset < size; offset += FLASH_SIZE_ERASE) {
-        // Writing size 0 means erase.
-        PT_SPAWN(pt, &child, flash_erase_or_write(&child,
-            PBDRV_CONFIG_BLOCK_DEVICE_W25QXX_STM32_START_ADDRESS + offset, NULL, 0, err));
+        sector_size = pbio_int_math_min(size - offset, FLASH_SIZE_ERASE);
+
+        PT_SPAWN(pt, &child, flash_sector_is_equal(&child,
+            PBDRV_CONFIG_BLOCK_DEVICE_W25QXX_STM32_START_ADDRESS + offset, buffer + offset, sector_size, &equal, err));
         if (*err != PBIO_SUCCESS) {
             goto out;
         }
-    }
+        if (equal) {
+            continue;
+        }
 
-    // Write page by page.
-    for (size_done = 0; size_done < size; size_done += size_now) {
-        size_now = pbio_int_math_min(size - size_done, FLASH_SIZE_WRITE);
+        // Writing size 0 means erase.
         PT_SPAWN(pt, &child, flash_erase_or_write(&child,
-            PBDRV_CONFIG_BLOCK_DEVICE_W25QXX_STM32_START_ADDRESS + size_done, buffer + size_done, size_now, err));
+            PBDRV_CONFIG_BLOCK_DEVICE_W25QXX_STM32_START_ADDRESS + offset, NULL, 0, err));
         if (*err != PBIO_SUCCESS) {
             goto out;
         }
+
+        // Write page by page.
+        for (size_done = 0; size_done < sector_size; size_done += size_now) {
+            size_now = pbio_int_math_min(sector_size - size_done, FLASH_SIZE_WRITE);
+            PT_SPAWN(pt, &child, flash_erase_or_write(&child,
+                PBDRV_CONFIG_BLOCK_DEVICE_W25QXX_STM32_START_ADDRESS + offset + size_done, buffer + offset + size_done, size_now, err));
+            if (*err != PBIO_SUCCESS) {
+                goto out;
+            }
+        }
     }
 
 out:
@@ -96,6 +96,7 @@ static pbdrv_bluetooth_receive_handler_t receive_handler;
 static pbdrv_bluetooth_receive_handler_t notification_handler;
 static pup_handset_t handset;
 static uint8_t *event_packet;
+static pbdrv_bluetooth_start_observing_callback_t observe_callback;
 static const pbdrv_bluetooth_btstack_platform_data_t *pdata = &pbdrv_bluetooth_btstack_platform_data;
 
 // note on baud rate: with a 48MHz clock, 3000000 baud is the highest we can
@@ -311,6 +312,11 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
 
             gap_event_advertising_report_get_address(packet, address);
 
+            if (observe_callback) {
+                int8_t rssi = gap_event_advertising_report_get_rssi(packet);
+                observe_callback(event_type, data, data_length, rssi);
+            }
+
             if (handset.con_state == CON_STATE_WAIT_ADV_IND) {
                 // HACK: this is making major assumptions about how the advertising data
                 // is laid out. So far LEGO devices seem consistent in this.
@@ -526,6 +532,14 @@ bool pbdrv_bluetooth_is_connected(pbdrv_bluetooth_connection_t connection) {
     return false;
 }
 
+uint16_t pbdrv_bluetooth_get_mtu(void) {
+    if (le_con_handle == HCI_CON_HANDLE_INVALID) {
+        return ATT_DEFAULT_MTU;
+    }
+
+    return att_server_get_mtu(le_con_handle);
+}
+
 void pbdrv_bluetooth_set_on_event(pbdrv_bluetooth_on_event_t on_event) {
     bluetooth_on_event = on_event;
 }
@@ -649,4 +663,74 @@ void pbdrv_bluetooth_disconnect_remote(void) {
     }
 }
 
+static PT_THREAD(broadcast_task(struct pt *pt, pbio_task_t *task)) {
+    pbdrv_bluetooth_value_t *value = task->context;
+
+    // btstack keeps a pointer to the data instead of copying it
+    static uint8_t adv_data[31];
+
+    PT_BEGIN(pt);
+
+    if (value->size > sizeof(adv_data)) {
+        task->status = PBIO_ERROR_INVALID_ARG;
+        PT_EXIT(pt);
+    }
+
+    if (value->size == 0) {
+        gap_advertisements_enable(false);
+    } else {
+        memcpy(adv_data, value->data, value->size);
+
+        // advertising interval: 48 * 0.625ms = 30ms
+        bd_addr_t null_addr = { };
+        gap_advertisements_set_params(0x0030, 0x0030, ADV_NONCONN_IND, 0x00, null_addr, 0x07, 0x00);
+        gap_advertisements_set_data(value->size, adv_data);
+        gap_advertisements_enable(true);
+    }
+
+    task->status = PBIO_SUCCESS;
+
+    PT_END(pt);
+}
+
+void pbdrv_bluetooth_start_broadcasting(pbio_task_t *task, pbdrv_bluetooth_value_t *value) {
+    pbio_task_init(task, broadcast_task, value);
+    pbio_task_queue_add(task_queue, task);
+}
+
+static PT_THREAD(observe_task(struct pt *pt, pbio_task_t *task)) {
+    PT_BEGIN(pt);
+
+    // passive scanning, advertisements are reported via observe_callback.
+    // scan interval: 48 * 0.625ms = 30ms
+    gap_set_scan_params(0, 0x30, 0x30, 0);
+    gap_start_scan();
+
+    task->status = PBIO_SUCCESS;
+
+    PT_END(pt);
+}
+
+void pbdrv_bluetooth_start_observing(pbio_task_t *task, pbdrv_bluetooth_start_observing_callback_t callback) {
+    observe_callback = callback;
+    pbio_task_init(task, observe_task, NULL);
+    pbio_task_queue_add(task_queue, task);
+}
+
+static PT_THREAD(stop_observe_task(struct pt *pt, pbio_task_t *task)) {
+    PT_BEGIN(pt);
+
+    observe_callback = NULL;
+    gap_stop_scan();
+
+    task->status = PBIO_SUCCESS;
+
+    PT_END(pt);
+}
+
+void pbdrv_bluetooth_stop_observing(pbio_task_t *task) {
+    pbio_task_init(task, stop_observe_task, NULL);
+    pbio_task_queue_add(task_queue, task);
+}
+
 #endif // PBDRV_CONFIG_BLUETOOTH_BTSTACK
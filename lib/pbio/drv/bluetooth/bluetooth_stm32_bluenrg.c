@@ -324,6 +324,11 @@ bool pbdrv_bluetooth_is_connected(pbdrv_bluetooth_connection_t connection) {
     return false;
 }
 
+uint16_t pbdrv_bluetooth_get_mtu(void) {
+    // MTU exchange is not supported, so this is always the default.
+    return ATT_MTU;
+}
+
 void pbdrv_bluetooth_set_on_event(pbdrv_bluetooth_on_event_t on_event) {
     bluetooth_on_event = on_event;
 }
@@ -649,6 +654,20 @@ void pbdrv_bluetooth_write_remote(pbio_task_t *task, pbdrv_bluetooth_value_t *va
     pbio_task_queue_add(task_queue, task);
 }
 
+// Broadcasting and observing are not implemented for this chip yet.
+
+void pbdrv_bluetooth_start_broadcasting(pbio_task_t *task, pbdrv_bluetooth_value_t *value) {
+    task->status = PBIO_ERROR_NOT_SUPPORTED;
+}
+
+void pbdrv_bluetooth_start_observing(pbio_task_t *task, pbdrv_bluetooth_start_observing_callback_t callback) {
+    task->status = PBIO_ERROR_NOT_SUPPORTED;
+}
+
+void pbdrv_bluetooth_stop_observing(pbio_task_t *task) {
+    task->status = PBIO_ERROR_NOT_SUPPORTED;
+}
+
 static PT_THREAD(disconnect_remote_task(struct pt *pt, pbio_task_t *task)) {
     PT_BEGIN(pt);
 
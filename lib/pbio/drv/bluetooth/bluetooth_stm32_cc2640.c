@@ -19,6 +19,7 @@
 #include <pbdrv/bluetooth.h>
 #include <pbdrv/gpio.h>
 #include <pbio/error.h>
+#include <pbio/int_math.h>
 #include <pbio/protocol.h>
 #include <pbio/task.h>
 #include <pbio/util.h>
@@ -122,8 +123,14 @@ static bool hci_command_status;
 static bool hci_command_complete;
 // used to synchronize advertising data handler
 static bool advertising_data_received;
+// Whether non-connectable advertisements are being sent.
+static bool is_broadcasting;
+// Callback for advertisements received while observing.
+static pbdrv_bluetooth_start_observing_callback_t observe_callback;
 // handle to connected Bluetooth device
 static uint16_t conn_handle = NO_CONNECTION;
+// ATT MTU negotiated with the connected central
+static uint16_t conn_mtu = ATT_MTU_SIZE;
 // handle to connected remote control
 static uint16_t remote_handle = NO_CONNECTION;
 // handle to LWP3 characteristic on remote
@@ -377,6 +384,10 @@ bool pbdrv_bluetooth_is_connected(pbdrv_bluetooth_connection_t connection) {
     return false;
 }
 
+uint16_t pbdrv_bluetooth_get_mtu(void) {
+    return conn_mtu;
+}
+
 void pbdrv_bluetooth_set_on_event(pbdrv_bluetooth_on_event_t on_event) {
     bluetooth_on_event = on_event;
 }
@@ -773,6 +784,97 @@ void pbdrv_bluetooth_disconnect_remote(void) {
     pbio_task_queue_add(task_queue, &task);
 }
 
+static PT_THREAD(broadcast_task(struct pt *pt, pbio_task_t *task)) {
+    pbdrv_bluetooth_value_t *value = task->context;
+
+    PT_BEGIN(pt);
+
+    if (value->size == 0) {
+        if (is_broadcasting) {
+            PT_WAIT_WHILE(pt, write_xfer_size);
+            GAP_endDiscoverable();
+            PT_WAIT_UNTIL(pt, hci_command_complete);
+            is_broadcasting = false;
+        }
+
+        task->status = PBIO_SUCCESS;
+        PT_EXIT(pt);
+    }
+
+    if (value->size > 31) {
+        task->status = PBIO_ERROR_INVALID_ARG;
+        PT_EXIT(pt);
+    }
+
+    // Advertising data can be updated while advertisements are being sent,
+    // so only the first call needs to start advertising.
+
+    PT_WAIT_WHILE(pt, write_xfer_size);
+    GAP_updateAdvertistigData(GAP_AD_TYPE_ADVERTISEMNT_DATA, value->size, value->data);
+    PT_WAIT_UNTIL(pt, hci_command_complete);
+    // ignoring response data
+
+    if (!is_broadcasting) {
+        PT_WAIT_WHILE(pt, write_xfer_size);
+        GAP_makeDiscoverable(ADV_NONCONN_IND, GAP_INITIATOR_ADDR_TYPE_PRIVATE_NON_RESOLVE, NULL,
+            GAP_CHANNEL_MAP_ALL, GAP_FILTER_POLICY_SCAN_ANY_CONNECT_ANY);
+        PT_WAIT_UNTIL(pt, hci_command_complete);
+        is_broadcasting = true;
+    }
+
+    task->status = PBIO_SUCCESS;
+
+    PT_END(pt);
+}
+
+void pbdrv_bluetooth_start_broadcasting(pbio_task_t *task, pbdrv_bluetooth_value_t *value) {
+    pbio_task_init(task, broadcast_task, value);
+    pbio_task_queue_add(task_queue, task);
+}
+
+static PT_THREAD(observe_task(struct pt *pt, pbio_task_t *task)) {
+    PT_BEGIN(pt);
+
+    // same as scan_and_connect_task, pending notifications could be dropped
+    PT_WAIT_WHILE(pt, write_xfer_size || notification_in_progress);
+    // passive scan, advertisements are reported via observe_callback
+    GAP_DeviceDiscoveryRequest(GAP_DEVICE_DISCOVERY_MODE_ALL, 0, GAP_FILTER_POLICY_SCAN_ANY_CONNECT_ANY);
+    PT_WAIT_UNTIL(pt, hci_command_status);
+
+    task->status = ble_error_to_pbio_error(read_buf[8]);
+
+    if (task->status != PBIO_SUCCESS) {
+        observe_callback = NULL;
+    }
+
+    PT_END(pt);
+}
+
+void pbdrv_bluetooth_start_observing(pbio_task_t *task, pbdrv_bluetooth_start_observing_callback_t callback) {
+    observe_callback = callback;
+    pbio_task_init(task, observe_task, NULL);
+    pbio_task_queue_add(task_queue, task);
+}
+
+static PT_THREAD(stop_observe_task(struct pt *pt, pbio_task_t *task)) {
+    PT_BEGIN(pt);
+
+    observe_callback = NULL;
+
+    PT_WAIT_WHILE(pt, write_xfer_size);
+    GAP_DeviceDiscoveryCancel();
+    PT_WAIT_UNTIL(pt, hci_command_status);
+
+    task->status = PBIO_SUCCESS;
+
+    PT_END(pt);
+}
+
+void pbdrv_bluetooth_stop_observing(pbio_task_t *task) {
+    pbio_task_init(task, stop_observe_task, NULL);
+    pbio_task_queue_add(task_queue, task);
+}
+
 // Driver interrupt callbacks
 
 void pbdrv_bluetooth_stm32_cc2640_srdy_irq(bool srdy) {
@@ -844,12 +946,12 @@ static void handle_event(uint8_t *packet) {
 
             switch (event_code) {
                 case ATT_EVENT_EXCHANGE_MTU_REQ: {
-                    // uint16_t client_mtu = (data[7] << 8) | data[6];
+                    uint16_t client_mtu = (data[7] << 8) | data[6];
                     attExchangeMTURsp_t rsp;
 
                     rsp.serverRxMTU = ATT_MAX_MTU_SIZE;
-                    // REVISIT: may need to keep a table of min(client_mtu, MAX_ATT_MTU_SIZE)
-                    // for each connection if any known clients have smaller MTU
+                    // REVISIT: this assumes only one central is connected
+                    conn_mtu = pbio_int_math_max(ATT_MTU_SIZE, pbio_int_math_min(client_mtu, ATT_MAX_MTU_SIZE));
                     ATT_ExchangeMTURsp(connection_handle, &rsp);
                 }
                 break;
@@ -905,7 +1007,7 @@ static void handle_event(uint8_t *packet) {
                                     GATT_PROP_READ, PNP_ID_UUID);
                             } else if (start_handle <= pybricks_service_handle + 1) {
                                 read_by_type_response_uuid128(connection_handle, pybricks_service_handle + 1,
-                                    GATT_PROP_WRITE | GATT_PROP_NOTIFY,
+                                    GATT_PROP_WRITE | GATT_PROP_WRITE_NO_RSP | GATT_PROP_NOTIFY,
                                     pbio_pybricks_command_event_char_uuid);
                             } else if (start_handle <= pybricks_service_handle + 4) {
                                 read_by_type_response_uuid128(connection_handle, pybricks_service_handle + 4,
@@ -1027,8 +1129,7 @@ static void handle_event(uint8_t *packet) {
                         attReadRsp_t rsp;
                         uint8_t buf[PBIO_PYBRICKS_HUB_CAPABILITIES_VALUE_SIZE];
 
-                        // REVISIT: client MTU may be smaller, in which case we can't used fixed value for MTU
-                        pbio_pybricks_hub_capabilities(buf, ATT_MAX_MTU_SIZE - 3, PBSYS_APP_HUB_FEATURE_FLAGS, PBSYS_PROGRAM_LOAD_MAX_PROGRAM_SIZE);
+                        pbio_pybricks_hub_capabilities(buf, conn_mtu - 3, PBSYS_APP_HUB_FEATURE_FLAGS, PBSYS_PROGRAM_LOAD_MAX_PROGRAM_SIZE);
                         rsp.len = sizeof(buf);
                         rsp.pValue = buf;
                         ATT_ReadRsp(connection_handle, &rsp);
@@ -1225,6 +1326,7 @@ static void handle_event(uint8_t *packet) {
                     DBG("bye: %04x", connection_handle);
                     if (conn_handle == connection_handle) {
                         conn_handle = NO_CONNECTION;
+                        conn_mtu = ATT_MTU_SIZE;
                         pybricks_notify_en = false;
                         uart_tx_notify_en = false;
                     } else if (remote_handle == connection_handle) {
@@ -1240,6 +1342,10 @@ static void handle_event(uint8_t *packet) {
 
                 case GAP_DEVICE_INFORMATION:
                     advertising_data_received = true;
+                    if (observe_callback) {
+                        // event type, address type, address, rssi, data length, data
+                        observe_callback(data[3], &data[13], data[12], data[11]);
+                    }
                     break;
 
                 case GAP_DEVICE_INIT_DONE:
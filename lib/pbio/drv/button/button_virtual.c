@@ -14,10 +14,10 @@ void pbdrv_button_init(void) {
 }
 
 pbio_error_t pbdrv_button_is_pressed(pbio_button_flags_t *pressed) {
-    uint32_t int_flags;
-    pbio_error_t err = pbdrv_virtual_get_u32("button", -1, "pressed", &int_flags);
-    *pressed = int_flags;
-    return err;
+    // Read from the snapshot that is updated on each poll.
+    const pbdrv_virtual_value_t *value = &pbdrv_virtual_get_snapshot()->button_pressed;
+    *pressed = value->value;
+    return value->err;
 }
 
 #endif // PBDRV_CONFIG_BUTTON_VIRTUAL
@@ -1,5 +1,5 @@
 // SPDX-License-Identifier: MIT
-// Copyright (c) 2022 The Pybricks Authors
+// Copyright (c) 2022-2023 The Pybricks Authors
 
 #include <pbdrv/config.h>
 
@@ -7,6 +7,7 @@
 
 #include <errno.h>
 #include <signal.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -24,11 +25,116 @@
 
 #define TIMER_SIGNAL        SIGRTMIN
 
+// When true, the time is kept here instead of being read from CPython and it
+// only advances when pbdrv_clock_virtual_advance() is called.
+static bool simulated;
+
+// The simulated time in nanoseconds.
+static uint64_t simulated_ns;
+
 static void handle_signal(int sig) {
     etimer_request_poll();
 }
 
+static uint64_t pbdrv_clock_virtual_read_ns(const char *caller) {
+    if (simulated) {
+        return simulated_ns;
+    }
+
+    uint64_t value;
+    pbio_error_t err = pbdrv_virtual_get_u64("clock", -1, "nanoseconds", &value);
+
+    if (err != PBIO_SUCCESS) {
+        fprintf(stderr, "fatal error: %s failed\n", caller);
+        exit(1);
+    }
+
+    return value;
+}
+
+/**
+ * Gets the current time with the full resolution of the virtual clock.
+ *
+ * @returns The time in nanoseconds.
+ */
+uint64_t pbdrv_clock_virtual_get_ns(void) {
+    return pbdrv_clock_virtual_read_ns(__func__);
+}
+
+/**
+ * Tests if the clock is a lock-step simulated clock.
+ *
+ * @returns True if time only advances by calling ::pbdrv_clock_virtual_advance.
+ */
+bool pbdrv_clock_virtual_is_simulated(void) {
+    return simulated;
+}
+
+/**
+ * Advances the simulated time.
+ *
+ * The time jumps to the next etimer deadline, but not further than @p max_us,
+ * so that code polling the clock still sees time pass when no timer is
+ * pending. Nothing happens if the clock is not simulated.
+ *
+ * @param [in]  max_us  The maximum time to advance in microseconds.
+ */
+void pbdrv_clock_virtual_advance(uint32_t max_us) {
+    if (!simulated) {
+        return;
+    }
+
+    uint64_t step_ns = (uint64_t)max_us * NSEC_PER_USEC;
+
+    if (etimer_pending()) {
+        int32_t until_deadline_ms = etimer_next_expiration_time() - pbdrv_clock_get_ms();
+
+        if (until_deadline_ms <= 0) {
+            // Already expired, just needs to be handled.
+            step_ns = 0;
+        } else {
+            // Jump to the time at which the millisecond clock reaches the deadline.
+            uint64_t deadline_ns = (simulated_ns / NSEC_PER_MSEC + until_deadline_ms) * NSEC_PER_MSEC;
+            if (deadline_ns - simulated_ns < step_ns) {
+                step_ns = deadline_ns - simulated_ns;
+            }
+        }
+    }
+
+    if (step_ns) {
+        simulated_ns += step_ns;
+
+        // Keep the CPython clock in sync for CPython drivers that use it and
+        // read the values that control updates at this time will use.
+        pbio_error_t err = pbdrv_virtual_platform_advance(simulated_ns);
+
+        if (err != PBIO_SUCCESS) {
+            fprintf(stderr, "fatal error: pbdrv_clock_virtual_advance failed\n");
+            exit(1);
+        }
+    }
+
+    etimer_request_poll();
+}
+
 void pbdrv_clock_init(void) {
+    uint8_t value;
+    pbio_error_t err = pbdrv_virtual_get_u8("clock", -1, "simulated", &value);
+
+    if (err != PBIO_SUCCESS) {
+        fprintf(stderr, "fatal error: pbdrv_clock_init failed\n");
+        exit(1);
+    }
+
+    // A simulated clock polls the etimers itself when it advances, so it
+    // doesn't need the signal that CPython clocks use as an interrupt.
+    if (value) {
+        // Start counting from the initial time of the CPython clock.
+        simulated_ns = pbdrv_clock_virtual_read_ns(__func__);
+        simulated = true;
+        return;
+    }
+
     int ret;
 
     struct sigaction sa = {
@@ -50,7 +156,7 @@ void pbdrv_clock_init(void) {
     }
 
     ssize_t thread_id;
-    pbio_error_t err = pbdrv_virtual_get_thread_ident(&thread_id);
+    err = pbdrv_virtual_get_thread_ident(&thread_id);
 
     if (err != PBIO_SUCCESS) {
         fprintf(stderr, "fatal error: pbdrv_clock_init failed\n");
@@ -66,39 +172,15 @@ void pbdrv_clock_init(void) {
 }
 
 uint32_t pbdrv_clock_get_ms(void) {
-    uint64_t value;
-    pbio_error_t err = pbdrv_virtual_get_u64("clock", -1, "nanoseconds", &value);
-
-    if (err != PBIO_SUCCESS) {
-        fprintf(stderr, "fatal error: pbdrv_clock_get_ms failed\n");
-        exit(1);
-    }
-
-    return value / NSEC_PER_MSEC;
+    return pbdrv_clock_virtual_read_ns(__func__) / NSEC_PER_MSEC;
 }
 
 uint32_t pbdrv_clock_get_100us(void) {
-    uint64_t value;
-    pbio_error_t err = pbdrv_virtual_get_u64("clock", -1, "nanoseconds", &value);
-
-    if (err != PBIO_SUCCESS) {
-        fprintf(stderr, "fatal error: pbdrv_clock_get_us failed\n");
-        exit(1);
-    }
-
-    return value / NSEC_PER_100USEC;
+    return pbdrv_clock_virtual_read_ns(__func__) / NSEC_PER_100USEC;
 }
 
 uint32_t pbdrv_clock_get_us(void) {
-    uint64_t value;
-    pbio_error_t err = pbdrv_virtual_get_u64("clock", -1, "nanoseconds", &value);
-
-    if (err != PBIO_SUCCESS) {
-        fprintf(stderr, "fatal error: pbdrv_clock_get_us failed\n");
-        exit(1);
-    }
-
-    return value / NSEC_PER_USEC;
+    return pbdrv_clock_virtual_read_ns(__func__) / NSEC_PER_USEC;
 }
 
 #endif // PBDRV_CONFIG_CLOCK_VIRTUAL
@@ -8,13 +8,17 @@
 #if PBDRV_CONFIG_COUNTER_VIRTUAL_CPYTHON
 
 #include <errno.h>
+#include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 
 #include <Python.h>
 
 #include <pbio/util.h>
+#include <pbdrv/clock.h>
+
 #include "../virtual.h"
+#include "../virtual_physics.h"
 #include "counter.h"
 
 #define DEBUG 0
@@ -34,18 +38,45 @@ static private_data_t private_data[PBDRV_CONFIG_COUNTER_VIRTUAL_CPYTHON_NUM_DEV]
 static pbio_error_t pbdrv_counter_virtual_cpython_get_angle(pbdrv_counter_dev_t *dev, int32_t *rotations, int32_t *millidegrees) {
     private_data_t *priv = dev->priv;
 
-    pbio_error_t err = pbdrv_virtual_get_i32("counter", priv->index, "rotations", rotations);
-    if (err != PBIO_SUCCESS) {
-        return err;
+    #if PBDRV_CONFIG_VIRTUAL_PHYSICS
+    pbdrv_virtual_physics_motor_t *motor = pbdrv_virtual_physics_get_motor(priv->index);
+    if (motor) {
+        // Same as rounding with math.remainder() in pbio_virtual.platform.robot.
+        int64_t angle = pbdrv_virtual_physics_motor_get_angle(motor, pbdrv_clock_get_us());
+        *millidegrees = remainder(angle, 360000);
+        *rotations = (angle - *millidegrees) / 360000;
+        return PBIO_SUCCESS;
+    }
+    #endif
+
+    // Read from the snapshot that is updated on each poll.
+    const pbdrv_virtual_value_t *value = &pbdrv_virtual_get_snapshot()->counter[priv->index].rotations;
+    if (value->err != PBIO_SUCCESS) {
+        return value->err;
     }
+    *rotations = value->value;
 
-    return pbdrv_virtual_get_i32("counter", priv->index, "millidegrees", millidegrees);
+    value = &pbdrv_virtual_get_snapshot()->counter[priv->index].millidegrees;
+    *millidegrees = value->value;
+    return value->err;
 }
 
 static pbio_error_t pbdrv_counter_virtual_cpython_get_abs_angle(pbdrv_counter_dev_t *dev, int32_t *millidegrees) {
     private_data_t *priv = dev->priv;
 
-    return pbdrv_virtual_get_i32("counter", priv->index, "millidegrees_abs", millidegrees);
+    #if PBDRV_CONFIG_VIRTUAL_PHYSICS
+    pbdrv_virtual_physics_motor_t *motor = pbdrv_virtual_physics_get_motor(priv->index);
+    if (motor) {
+        int64_t angle = pbdrv_virtual_physics_motor_get_angle(motor, pbdrv_clock_get_us());
+        int32_t mod_angle = ((angle % 360000) + 360000) % 360000;
+        *millidegrees = mod_angle < 180000 ? mod_angle : mod_angle - 360000;
+        return PBIO_SUCCESS;
+    }
+    #endif
+
+    const pbdrv_virtual_value_t *value = &pbdrv_virtual_get_snapshot()->counter[priv->index].millidegrees_abs;
+    *millidegrees = value->value;
+    return value->err;
 }
 
 static const pbdrv_counter_funcs_t pbdrv_counter_virtual_cpython_funcs = {
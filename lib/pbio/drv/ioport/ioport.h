@@ -9,12 +9,14 @@
 #if PBDRV_CONFIG_IOPORT
 
 #include "ioport_lpf2.h"
+#include "ioport_virtual.h"
 
 /**
  * Initializes the ioport driver.
  */
 static inline void pbdrv_ioport_init(void) {
     pbdrv_ioport_lpf2_init();
+    pbdrv_ioport_virtual_init();
 }
 
 #else // PBDRV_CONFIG_IOPORT
@@ -5,13 +5,79 @@
 
 #if PBDRV_CONFIG_IOPORT_VIRTUAL
 
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <contiki.h>
+
+#include <pbio/config.h>
 #include <pbio/error.h>
 #include <pbio/iodev.h>
 #include <pbio/port.h>
+#include <pbio/uartdev.h>
 
 #include "../virtual.h"
+#include "ioport_virtual.h"
+
+#if PBIO_CONFIG_UARTDEV
+
+PROCESS(pbdrv_ioport_virtual_process, "ioport virtual");
+
+/** Whether an emulated UART device is plugged in, as told by CPython. */
+static volatile bool pbdrv_ioport_virtual_uart_connected[PBIO_CONFIG_UARTDEV_NUM_DEV];
+
+/** Bit flags of ports where a device was plugged in since the last poll. */
+static volatile uint32_t pbdrv_ioport_virtual_uart_plugged;
+
+/**
+ * Called by CPython when a device is plugged into or unplugged from
+ * `platform.ioport[<port>].uart`.
+ *
+ * @param [in]  port        The port.
+ * @param [in]  connected   True if a device is plugged in now.
+ */
+static void pbdrv_ioport_virtual_uart_connection_changed(pbio_port_id_t port, bool connected) {
+    uint8_t id = port - PBIO_CONFIG_UARTDEV_FIRST_PORT;
+
+    if (port < PBIO_CONFIG_UARTDEV_FIRST_PORT || id >= PBIO_CONFIG_UARTDEV_NUM_DEV) {
+        return;
+    }
+
+    pbdrv_ioport_virtual_uart_connected[id] = connected;
+
+    if (connected) {
+        pbdrv_ioport_virtual_uart_plugged |= 1 << id;
+    }
+
+    process_poll(&pbdrv_ioport_virtual_process);
+}
+
+void pbdrv_ioport_virtual_init(void) {
+    process_start(&pbdrv_ioport_virtual_process);
+}
+
+#endif // PBIO_CONFIG_UARTDEV
 
 pbio_error_t pbdrv_ioport_get_iodev(pbio_port_id_t port, pbio_iodev_t **iodev) {
+    #if PBIO_CONFIG_UARTDEV
+    uint8_t id = port - PBIO_CONFIG_UARTDEV_FIRST_PORT;
+
+    if (port >= PBIO_CONFIG_UARTDEV_FIRST_PORT && id < PBIO_CONFIG_UARTDEV_NUM_DEV && pbdrv_ioport_virtual_uart_connected[id]) {
+        pbio_error_t err = pbio_uartdev_get(id, iodev);
+
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+
+        // If there is an iodev but we don't know which one yet, it is syncing
+        if ((*iodev)->info->type_id == PBIO_IODEV_TYPE_ID_NONE) {
+            return PBIO_ERROR_AGAIN;
+        }
+
+        return PBIO_SUCCESS;
+    }
+    #endif
+
     return pbdrv_virtual_get_ctype_pointer("ioport", port, "iodev", (void **)iodev);
 }
 
@@ -19,4 +85,66 @@ pbio_error_t pbdrv_ioport_get_motor_device_type_id(pbio_port_id_t port, pbio_iod
     return pbdrv_virtual_get_u32("ioport", port, "motor_type_id", type_id);
 }
 
+#if PBIO_CONFIG_UARTDEV
+
+// Plays the role of the device connection manager on real hubs: when CPython
+// plugs in an emulated UART device, uartdev is told to start syncing. This is
+// repeated when uartdev gives up on a device that is still plugged in, so that
+// it syncs again after errors.
+PROCESS_THREAD(pbdrv_ioport_virtual_process, ev, data) {
+    static struct etimer timer;
+    // Bit flags of ports where uartdev has not started syncing yet.
+    static uint32_t ready_pending;
+
+    PROCESS_BEGIN();
+
+    // CPython calls back right away for devices that are already plugged in.
+    for (uint8_t i = 0; i < PBIO_CONFIG_UARTDEV_NUM_DEV; i++) {
+        pbdrv_virtual_call_method("ioport", PBIO_CONFIG_UARTDEV_FIRST_PORT + i, "on_uart_start", "(K)",
+            (unsigned long long)(uintptr_t)pbdrv_ioport_virtual_uart_connection_changed);
+    }
+
+    for (;;) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL || ev == PROCESS_EVENT_SERVICE_REMOVED
+            || (ev == PROCESS_EVENT_TIMER && etimer_expired(&timer)));
+
+        if (ev == PROCESS_EVENT_SERVICE_REMOVED) {
+            // uartdev lost the device, so it has to sync again if the device
+            // is still plugged in.
+            uint8_t id = ((pbio_iodev_t *)data)->port - PBIO_CONFIG_UARTDEV_FIRST_PORT;
+
+            if (id < PBIO_CONFIG_UARTDEV_NUM_DEV) {
+                ready_pending |= 1 << id;
+            }
+        }
+
+        ready_pending |= pbdrv_ioport_virtual_uart_plugged;
+        pbdrv_ioport_virtual_uart_plugged = 0;
+
+        for (uint8_t i = 0; i < PBIO_CONFIG_UARTDEV_NUM_DEV; i++) {
+            if (!(ready_pending & (1 << i))) {
+                continue;
+            }
+
+            // uartdev may not be ready for a new device yet, in which case
+            // we try again later. Unplugged devices time out by themselves.
+            if (!pbdrv_ioport_virtual_uart_connected[i] || pbio_uartdev_ready(i) != PBIO_ERROR_AGAIN) {
+                ready_pending &= ~(1 << i);
+            }
+        }
+
+        // Retry only while needed, so that an idle virtual hub does not have
+        // to wake up all the time.
+        if (ready_pending) {
+            etimer_set(&timer, 10);
+        } else {
+            etimer_stop(&timer);
+        }
+    }
+
+    PROCESS_END();
+}
+
+#endif // PBIO_CONFIG_UARTDEV
+
 #endif // PBDRV_CONFIG_IOPORT_VIRTUAL
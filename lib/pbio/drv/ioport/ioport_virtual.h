@@ -0,0 +1,18 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#ifndef _INTERNAL_PBDRV_IOPORT_VIRTUAL_H_
+#define _INTERNAL_PBDRV_IOPORT_VIRTUAL_H_
+
+#include <pbdrv/config.h>
+#include <pbio/config.h>
+
+#if PBDRV_CONFIG_IOPORT_VIRTUAL && PBIO_CONFIG_UARTDEV
+
+void pbdrv_ioport_virtual_init(void);
+
+#else // PBDRV_CONFIG_IOPORT_VIRTUAL && PBIO_CONFIG_UARTDEV
+#define pbdrv_ioport_virtual_init()
+#endif // PBDRV_CONFIG_IOPORT_VIRTUAL && PBIO_CONFIG_UARTDEV
+
+#endif // _INTERNAL_PBDRV_IOPORT_VIRTUAL_H_
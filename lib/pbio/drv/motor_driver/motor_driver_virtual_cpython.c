@@ -11,7 +11,7 @@
 #include <pbdrv/motor_driver.h>
 
 #include "../virtual.h"
-
+#include "../virtual_physics.h"
 
 struct _pbdrv_motor_driver_dev_t {
     uint8_t id;
@@ -30,18 +30,59 @@ pbio_error_t pbdrv_motor_driver_get_dev(uint8_t id, pbdrv_motor_driver_dev_t **d
 }
 
 pbio_error_t pbdrv_motor_driver_coast(pbdrv_motor_driver_dev_t *driver) {
-    return pbdrv_virtual_call_method("motor_driver", driver->id, "on_coast", "(I)", pbdrv_clock_get_us());
+    #if PBDRV_CONFIG_VIRTUAL_PHYSICS
+    pbdrv_virtual_physics_motor_t *motor = pbdrv_virtual_physics_get_motor(driver->id);
+    if (motor) {
+        pbdrv_virtual_physics_motor_coast(motor, pbdrv_clock_get_us());
+        return PBIO_SUCCESS;
+    }
+    #endif
+
+    // Sent to CPython on the next poll. Errors are reported by the poll.
+    pbdrv_virtual_queue_motor_driver_event(driver->id, pbdrv_clock_get_us(), true, 0);
+    return PBIO_SUCCESS;
 }
 
 pbio_error_t pbdrv_motor_driver_set_duty_cycle(pbdrv_motor_driver_dev_t *driver, int16_t duty_cycle) {
-    return pbdrv_virtual_call_method("motor_driver", driver->id, "on_set_duty_cycle", "Id",
-        pbdrv_clock_get_us(), (double)duty_cycle / (double)PBDRV_MOTOR_DRIVER_MAX_DUTY);
+    #if PBDRV_CONFIG_VIRTUAL_PHYSICS
+    pbdrv_virtual_physics_motor_t *motor = pbdrv_virtual_physics_get_motor(driver->id);
+    if (motor) {
+        pbdrv_virtual_physics_motor_set_duty_cycle(motor, pbdrv_clock_get_us(),
+            (double)duty_cycle / (double)PBDRV_MOTOR_DRIVER_MAX_DUTY);
+        return PBIO_SUCCESS;
+    }
+    #endif
+
+    // Sent to CPython on the next poll. Errors are reported by the poll.
+    pbdrv_virtual_queue_motor_driver_event(driver->id, pbdrv_clock_get_us(), false,
+        (double)duty_cycle / (double)PBDRV_MOTOR_DRIVER_MAX_DUTY);
+    return PBIO_SUCCESS;
 }
 
 void pbdrv_motor_driver_init(void) {
     for (int i = 0; i < PBDRV_CONFIG_MOTOR_DRIVER_NUM_DEV; i++) {
         motor_driver_devs[i].id = i;
+
+        #if PBDRV_CONFIG_VIRTUAL_PHYSICS
+        // The CPython platform chooses whether this motor is simulated
+        // natively or by the CPython motor driver and counter objects.
+        uint8_t model;
+        int32_t millidegrees;
+        if (pbdrv_virtual_get_u8("motor_driver", i, "native_model", &model) == PBIO_SUCCESS
+            && pbdrv_virtual_get_i32("motor_driver", i, "initial_millidegrees", &millidegrees) == PBIO_SUCCESS) {
+            pbdrv_virtual_physics_motor_init(i, model, pbdrv_clock_get_us(), millidegrees);
+        }
+        #endif
+    }
+
+    #if PBDRV_CONFIG_VIRTUAL_PHYSICS
+    // Two of the natively simulated motors may also drive a natively simulated
+    // drivebase. The CPython platform sets it up through ctypes.
+    if (pbdrv_virtual_has_component("drivebase", -1) && pbdrv_virtual_call_method("drivebase", -1, "on_start", "(K)",
+        (unsigned long long)(uintptr_t)pbdrv_virtual_physics_get_drivebase()) == PBIO_SUCCESS) {
+        pbdrv_virtual_physics_drivebase_start(pbdrv_clock_get_us());
     }
+    #endif
 }
 
 #endif // PBDRV_CONFIG_MOTOR_DRIVER_VIRTUAL_CPYTHON
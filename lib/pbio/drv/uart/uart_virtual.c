@@ -0,0 +1,253 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+// Virtual UART driver that exchanges bytes with CPython.
+//
+// The other end of each UART is `platform.uart[<id>]`, usually connected to
+// an emulated LEGO UART device. Received bytes are requested from CPython
+// only while a read is pending, every millisecond, like a UART that is
+// serviced by a periodic interrupt.
+
+#include <pbdrv/config.h>
+
+#if PBDRV_CONFIG_UART_VIRTUAL
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <contiki.h>
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <pbdrv/clock.h>
+#include <pbdrv/uart.h>
+#include <pbio/error.h>
+#include <pbio/util.h>
+
+#include "../virtual.h"
+
+typedef struct {
+    /** Public UART device handle. */
+    pbdrv_uart_dev_t uart_dev;
+    /** Index of the CPython uart component. */
+    uint8_t id;
+    /** Whether the device has been initialized. */
+    bool initialized;
+    /** Timer for read timeout. */
+    struct etimer read_timer;
+    /** Timer for write timeout. */
+    struct etimer write_timer;
+    /** The buffer passed to the read_begin function. */
+    uint8_t *read_buf;
+    /** The length of read_buf in bytes. */
+    uint8_t read_length;
+    /** The current position in read_buf. */
+    uint8_t read_pos;
+    /** The buffer passed to the write_begin function. */
+    uint8_t *write_buf;
+    /** The length of write_buf in bytes. */
+    uint8_t write_length;
+    /** The current position in write_buf. */
+    uint8_t write_pos;
+} pbdrv_uart_t;
+
+static pbdrv_uart_t pbdrv_uart[PBDRV_CONFIG_UART_VIRTUAL_NUM_UART];
+
+PROCESS(pbdrv_uart_process, "UART");
+
+pbio_error_t pbdrv_uart_get(uint8_t id, pbdrv_uart_dev_t **uart_dev) {
+    if (id >= PBDRV_CONFIG_UART_VIRTUAL_NUM_UART) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    if (!pbdrv_uart[id].initialized) {
+        // has not been initialized yet
+        return PBIO_ERROR_AGAIN;
+    }
+
+    *uart_dev = &pbdrv_uart[id].uart_dev;
+
+    return PBIO_SUCCESS;
+}
+
+pbio_error_t pbdrv_uart_read_begin(pbdrv_uart_dev_t *uart_dev, uint8_t *msg, uint8_t length, uint32_t timeout) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+
+    if (uart->read_buf) {
+        // Another read operation is already in progress.
+        return PBIO_ERROR_AGAIN;
+    }
+
+    uart->read_buf = msg;
+    uart->read_length = length;
+    uart->read_pos = 0;
+
+    etimer_set(&uart->read_timer, timeout);
+
+    // Bytes may already be waiting.
+    process_poll(&pbdrv_uart_process);
+
+    return PBIO_SUCCESS;
+}
+
+pbio_error_t pbdrv_uart_read_end(pbdrv_uart_dev_t *uart_dev) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+
+    // If read_pos is less that read_length then we have not read everything yet
+    if (uart->read_pos < uart->read_length) {
+        if (etimer_expired(&uart->read_timer)) {
+            uart->read_buf = NULL;
+            return PBIO_ERROR_TIMEDOUT;
+        }
+        return PBIO_ERROR_AGAIN;
+    }
+
+    etimer_stop(&uart->read_timer);
+
+    return PBIO_SUCCESS;
+}
+
+void pbdrv_uart_read_cancel(pbdrv_uart_dev_t *uart_dev) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+
+    uart->read_buf = NULL;
+    etimer_stop(&uart->read_timer);
+}
+
+pbio_error_t pbdrv_uart_write_begin(pbdrv_uart_dev_t *uart_dev, uint8_t *msg, uint8_t length, uint32_t timeout) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+
+    if (uart->write_buf) {
+        // Another write operation is already in progress.
+        return PBIO_ERROR_AGAIN;
+    }
+
+    // The whole message is handed to CPython at once, which takes care of
+    // the time it takes to transmit it.
+    pbio_error_t err = pbdrv_virtual_call_method("uart", uart->id, "on_write", "Iy#",
+        pbdrv_clock_get_us(), (const char *)msg, (Py_ssize_t)length);
+
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    uart->write_buf = msg;
+    uart->write_length = length;
+    uart->write_pos = length;
+
+    etimer_set(&uart->write_timer, timeout);
+
+    process_poll(&pbdrv_uart_process);
+
+    return PBIO_SUCCESS;
+}
+
+pbio_error_t pbdrv_uart_write_end(pbdrv_uart_dev_t *uart_dev) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+
+    // If write_pos is less that write_length then we have not written everything yet.
+    if (uart->write_pos < uart->write_length) {
+        if (etimer_expired(&uart->write_timer)) {
+            uart->write_buf = NULL;
+            return PBIO_ERROR_TIMEDOUT;
+        }
+        return PBIO_ERROR_AGAIN;
+    }
+
+    etimer_stop(&uart->write_timer);
+
+    return PBIO_SUCCESS;
+}
+
+void pbdrv_uart_write_cancel(pbdrv_uart_dev_t *uart_dev) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+
+    uart->write_buf = NULL;
+    etimer_stop(&uart->write_timer);
+}
+
+pbio_error_t pbdrv_uart_set_baud_rate(pbdrv_uart_dev_t *uart_dev, uint32_t baud) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+
+    return pbdrv_virtual_call_method("uart", uart->id, "on_set_baud_rate", "II", pbdrv_clock_get_us(), baud);
+}
+
+void pbdrv_uart_flush(pbdrv_uart_dev_t *uart_dev) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+
+    // errors are ignored, like there is nothing to flush
+    pbdrv_virtual_call_method("uart", uart->id, "on_flush", "(I)", pbdrv_clock_get_us());
+}
+
+/**
+ * Moves received bytes to pending reads and completes reads and writes.
+ *
+ * @returns True if any read is still waiting for bytes.
+ */
+static bool handle_poll(void) {
+    bool read_pending = false;
+
+    for (int i = 0; i < PBDRV_CONFIG_UART_VIRTUAL_NUM_UART; i++) {
+        pbdrv_uart_t *uart = &pbdrv_uart[i];
+
+        // if receive is pending and we have not received all bytes yet
+        if (uart->read_buf && uart->read_pos < uart->read_length) {
+            uint32_t size = uart->read_length - uart->read_pos;
+
+            if (pbdrv_virtual_call_method_read_bytes("uart", uart->id, "read",
+                &uart->read_buf[uart->read_pos], &size, "II", pbdrv_clock_get_us(), size) == PBIO_SUCCESS) {
+                uart->read_pos += size;
+            }
+        }
+
+        // broadcast when read_buf is full
+        if (uart->read_buf && uart->read_pos == uart->read_length) {
+            // clearing read_buf to prevent multiple broadcasts
+            uart->read_buf = NULL;
+            process_post(PROCESS_BROADCAST, PROCESS_EVENT_COM, NULL);
+        }
+
+        if (uart->read_buf) {
+            read_pending = true;
+        }
+
+        // broadcast when write_buf is drained
+        if (uart->write_buf && uart->write_pos == uart->write_length) {
+            // clearing write_buf to prevent multiple broadcasts
+            uart->write_buf = NULL;
+            process_post(PROCESS_BROADCAST, PROCESS_EVENT_COM, NULL);
+        }
+    }
+
+    return read_pending;
+}
+
+PROCESS_THREAD(pbdrv_uart_process, ev, data) {
+    static struct etimer timer;
+
+    PROCESS_BEGIN();
+
+    for (int i = 0; i < PBDRV_CONFIG_UART_VIRTUAL_NUM_UART; i++) {
+        pbdrv_uart[i].id = i;
+        pbdrv_uart[i].initialized = true;
+    }
+
+    etimer_set(&timer, 1);
+
+    while (true) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL || (ev == PROCESS_EVENT_TIMER && etimer_expired(&timer)));
+
+        // Keep checking for received bytes only while needed, so that an
+        // idle virtual hub does not have to wake up every millisecond.
+        if (handle_poll()) {
+            etimer_set(&timer, 1);
+        } else {
+            etimer_stop(&timer);
+        }
+    }
+
+    PROCESS_END();
+}
+
+#endif // PBDRV_CONFIG_UART_VIRTUAL
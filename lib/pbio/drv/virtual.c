@@ -9,12 +9,17 @@
 
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 
+#define PY_SSIZE_T_CLEAN
 #include <Python.h>
 
 #include <pbdrv/clock.h>
 #include <pbio/error.h>
+#include <pbio/port.h>
+#include <pbio/util.h>
 #include "virtual.h"
+#include "virtual_physics.h"
 
 #define CREATE_PLATFORM_OBJECT \
     "import importlib, os\n" \
@@ -22,9 +27,31 @@
     "platform_module = importlib.import_module(platform_module_name)\n" \
     "platform = platform_module.Platform()\n"
 
+// Maximum number of motor driver events that are sent to CPython at once.
+#define MOTOR_DRIVER_EVENT_QUEUE_SIZE 32
+
+typedef struct {
+    uint8_t index;
+    bool coast;
+    uint32_t timestamp;
+    double duty_cycle;
+} motor_driver_event_t;
+
 static PyThreadState *thread_state;
 static pbdrv_virtual_cpython_exception_handler_t cpython_exception_handler;
 
+// Polled values, updated once per clock advance instead of on each read.
+static pbdrv_virtual_snapshot_t snapshot;
+
+// Motor driver events that have not been sent to CPython yet.
+static motor_driver_event_t motor_driver_events[MOTOR_DRIVER_EVENT_QUEUE_SIZE];
+static uint8_t motor_driver_event_count;
+
+static pbio_error_t pbdrv_virtual_check_cpython_exception(void);
+static PyObject *pbdrv_virtual_get_platform(void);
+static PyObject *pbdrv_virtual_get_platform_component(PyObject *platform, const char *component, int index);
+static void pbdrv_virtual_update_snapshot(PyObject *platform);
+
 /**
  * Starts the CPython runtime and instantiates the virtual `platform` object.
  *
@@ -46,6 +73,17 @@ pbio_error_t pbdrv_virtual_platform_start(pbdrv_virtual_cpython_exception_handle
         return PBIO_ERROR_FAILED;
     }
 
+    // Drivers may read polled values before the first poll.
+    PyObject *platform = pbdrv_virtual_get_platform();
+
+    if (!platform) {
+        PyErr_Print();
+        return PBIO_ERROR_FAILED;
+    }
+
+    pbdrv_virtual_update_snapshot(platform);
+    Py_DECREF(platform);
+
     // release the GIL to allow pbio to run without blocking CPython
     thread_state = PyEval_SaveThread();
 
@@ -172,8 +210,6 @@ static PyObject *pbdrv_virtual_get_platform(void) {
  * @return A new reference to the component or `NULL` on error.
  */
 static PyObject *pbdrv_virtual_get_component(const char *component, int index) {
-    PyObject *value_obj = NULL;
-
     // new ref
     PyObject *platform = pbdrv_virtual_get_platform();
 
@@ -181,11 +217,29 @@ static PyObject *pbdrv_virtual_get_component(const char *component, int index) {
         return NULL;
     }
 
+    // new ref
+    PyObject *value_obj = pbdrv_virtual_get_platform_component(platform, component, index);
+
+    Py_DECREF(platform);
+
+    return value_obj;
+}
+
+/**
+ * Gets the value of `<platform>.<component>[<index>]`.
+ *
+ * NOTE: The GIL must be held when calling this function!
+ *
+ * @return A new reference to the component or `NULL` on error.
+ */
+static PyObject *pbdrv_virtual_get_platform_component(PyObject *platform, const char *component, int index) {
+    PyObject *value_obj = NULL;
+
     // new ref
     PyObject *component_obj = PyObject_GetAttrString(platform, component);
 
     if (!component_obj) {
-        goto err_unref_platform;
+        return NULL;
     }
 
     // new ref
@@ -201,35 +255,29 @@ static PyObject *pbdrv_virtual_get_component(const char *component, int index) {
     Py_DECREF(index_obj);
 error_unref_component:
     Py_DECREF(component_obj);
-err_unref_platform:
-    Py_DECREF(platform);
 
     return value_obj;
 }
 
 /**
- * Calls a method on the `platform.<component>` or `platform.<component>[<index>]` object.
- *
- * Refer to https://docs.python.org/3/c-api/arg.html#c.Py_BuildValue for formatting.
+ * Calls a method on the `platform.<component>[<index>]` object.
  *
- * Note that for single args, the format string needs to include `()` so that
- * it returns a tuple.
+ * NOTE: The GIL must be held when calling this function!
  *
  * @param [in]  component   The name of the component.
  * @param [in]  index       The index on component or -1 to not use an index.
  * @param [in]  method      The name of the method.
  * @param [in]  format      The format of each argument.
- * @param [in]  ...         The values for @p fmt or NULL if there are no args.
- * @returns                 ::PBIO_SUCCESS if the call was successful or an error
- *                          if there was a CPython exception.
+ * @param [in]  va          The values for @p format.
+ * @returns                 A new reference to the return value or `NULL` on error.
  */
-pbio_error_t pbdrv_virtual_call_method(const char *component, int index, const char *method, const char *format, ...) {
-    PyGILState_STATE state = PyGILState_Ensure();
+static PyObject *pbdrv_virtual_call_method_va(const char *component, int index, const char *method, const char *format, va_list va) {
+    PyObject *ret_obj = NULL;
 
     PyObject *component_obj = pbdrv_virtual_get_component(component, index);
 
     if (!component_obj) {
-        goto err;
+        return NULL;
     }
 
     // There is no va_list version of PyObject_CallMethod, so we have to get
@@ -242,11 +290,8 @@ pbio_error_t pbdrv_virtual_call_method(const char *component, int index, const c
         goto err_unref_component;
     }
 
-    va_list va;
-    va_start(va, format);
     // new reference
     PyObject *args_obj = (!format || !*format) ? PyTuple_New(0) : Py_VaBuildValue(format, va);
-    va_end(va);
 
     if (!args_obj) {
         goto err_unref_method;
@@ -258,14 +303,7 @@ pbio_error_t pbdrv_virtual_call_method(const char *component, int index, const c
     }
 
     // new reference
-    PyObject *ret_obj = PyObject_Call(method_obj, args_obj, NULL);
-
-    if (!ret_obj) {
-        goto err_unref_args;
-    }
-
-    // return value is ignored
-    Py_DECREF(ret_obj);
+    ret_obj = PyObject_Call(method_obj, args_obj, NULL);
 
 err_unref_args:
     Py_DECREF(args_obj);
@@ -274,6 +312,111 @@ err_unref_method:
 err_unref_component:
     Py_DECREF(component_obj);
 
+    return ret_obj;
+}
+
+/**
+ * Tests if the optional `platform.<component>[<index>]` object exists.
+ *
+ * @param [in]  component   The name of the component.
+ * @param [in]  index       The index on component or -1 to not use an index.
+ * @returns                 True if it exists.
+ */
+bool pbdrv_virtual_has_component(const char *component, int index) {
+    PyGILState_STATE state = PyGILState_Ensure();
+
+    // new ref
+    PyObject *component_obj = pbdrv_virtual_get_component(component, index);
+
+    // A missing component is not an error, so the exception is not reported.
+    bool exists = component_obj != NULL;
+    Py_XDECREF(component_obj);
+    PyErr_Clear();
+
+    PyGILState_Release(state);
+
+    return exists;
+}
+
+/**
+ * Calls a method on the `platform.<component>` or `platform.<component>[<index>]` object.
+ *
+ * Refer to https://docs.python.org/3/c-api/arg.html#c.Py_BuildValue for formatting.
+ *
+ * Note that for single args, the format string needs to include `()` so that
+ * it returns a tuple. Lengths for `#` formats are `Py_ssize_t`.
+ *
+ * @param [in]  component   The name of the component.
+ * @param [in]  index       The index on component or -1 to not use an index.
+ * @param [in]  method      The name of the method.
+ * @param [in]  format      The format of each argument.
+ * @param [in]  ...         The values for @p fmt or NULL if there are no args.
+ * @returns                 ::PBIO_SUCCESS if the call was successful or an error
+ *                          if there was a CPython exception.
+ */
+pbio_error_t pbdrv_virtual_call_method(const char *component, int index, const char *method, const char *format, ...) {
+    PyGILState_STATE state = PyGILState_Ensure();
+
+    va_list va;
+    va_start(va, format);
+    PyObject *ret_obj = pbdrv_virtual_call_method_va(component, index, method, format, va);
+    va_end(va);
+
+    // return value is ignored
+    Py_XDECREF(ret_obj);
+
+    pbio_error_t err = pbdrv_virtual_check_cpython_exception();
+
+    PyGILState_Release(state);
+
+    return err;
+}
+
+/**
+ * Calls a method like pbdrv_virtual_call_method() that returns a bytes-like
+ * object and copies the returned bytes.
+ *
+ * @param [in]      component   The name of the component.
+ * @param [in]      index       The index on component or -1 to not use an index.
+ * @param [in]      method      The name of the method.
+ * @param [out]     data        Buffer for the returned bytes.
+ * @param [in, out] size        The size of @p data in, the number of returned bytes out.
+ * @param [in]      format      The format of each argument.
+ * @param [in]      ...         The values for @p fmt or NULL if there are no args.
+ * @returns                     ::PBIO_SUCCESS if the call was successful or an error
+ *                              if there was a CPython exception. Returning
+ *                              more than @p size bytes is an error.
+ */
+pbio_error_t pbdrv_virtual_call_method_read_bytes(const char *component, int index, const char *method,
+    uint8_t *data, uint32_t *size, const char *format, ...) {
+
+    PyGILState_STATE state = PyGILState_Ensure();
+
+    va_list va;
+    va_start(va, format);
+    PyObject *ret_obj = pbdrv_virtual_call_method_va(component, index, method, format, va);
+    va_end(va);
+
+    if (!ret_obj) {
+        goto err;
+    }
+
+    Py_buffer view;
+
+    if (PyObject_GetBuffer(ret_obj, &view, PyBUF_SIMPLE) < 0) {
+        goto err_unref_ret;
+    }
+
+    if (view.len > *size) {
+        PyErr_SetString(PyExc_ValueError, "too many bytes");
+    } else {
+        memcpy(data, view.buf, view.len);
+        *size = view.len;
+    }
+
+    PyBuffer_Release(&view);
+err_unref_ret:
+    Py_DECREF(ret_obj);
 err:;
     pbio_error_t err = pbdrv_virtual_check_cpython_exception();
 
@@ -283,7 +426,191 @@ err:;
 }
 
 /**
- * Calls `platform.on_poll()`.
+ * Reads polled attributes of one component into the snapshot.
+ *
+ * NOTE: The GIL must be held when calling this function!
+ *
+ * Errors are kept with each value, so that they are returned to the driver
+ * that reads the value, like when reading the attribute directly.
+ *
+ * @param [in]  platform    The platform object.
+ * @param [in]  component   The name of the component.
+ * @param [in]  index       The index on @p component.
+ * @param [in]  attributes  The names of the attributes.
+ * @param [out] values      The values for each of @p attributes.
+ * @param [in]  count       The number of @p attributes.
+ */
+static void pbdrv_virtual_read_component(PyObject *platform, const char *component, int index,
+    const char *const *attributes, pbdrv_virtual_value_t *const *values, size_t count) {
+
+    // new ref
+    PyObject *component_obj = pbdrv_virtual_get_platform_component(platform, component, index);
+
+    if (!component_obj) {
+        pbio_error_t err = pbdrv_virtual_check_cpython_exception();
+
+        for (size_t i = 0; i < count; i++) {
+            values[i]->value = 0;
+            values[i]->err = err;
+        }
+
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        // new ref
+        PyObject *value_obj = PyObject_GetAttrString(component_obj, attributes[i]);
+
+        values[i]->value = value_obj ? PyLong_AsLongLong(value_obj) : 0;
+        Py_XDECREF(value_obj);
+
+        values[i]->err = pbdrv_virtual_check_cpython_exception();
+    }
+
+    Py_DECREF(component_obj);
+}
+
+/**
+ * Reads all polled values from CPython.
+ *
+ * NOTE: The GIL must be held when calling this function!
+ *
+ * @param [in]  platform    The platform object.
+ */
+static void pbdrv_virtual_update_snapshot(PyObject *platform) {
+    #if PBDRV_CONFIG_BUTTON_VIRTUAL
+    {
+        static const char *const attributes[] = { "pressed" };
+        pbdrv_virtual_value_t *const values[] = { &snapshot.button_pressed };
+        pbdrv_virtual_read_component(platform, "button", -1, attributes, values, PBIO_ARRAY_SIZE(values));
+    }
+    #endif
+
+    #if PBDRV_CONFIG_BATTERY_VIRTUAL
+    {
+        static const char *const attributes[] = { "voltage", "current", "temperature", "type" };
+        pbdrv_virtual_value_t *const values[] = {
+            &snapshot.battery_voltage,
+            &snapshot.battery_current,
+            &snapshot.battery_temperature,
+            &snapshot.battery_type,
+        };
+        pbdrv_virtual_read_component(platform, "battery", -1, attributes, values, PBIO_ARRAY_SIZE(values));
+    }
+    #endif
+
+    for (int i = 0; i < PBDRV_VIRTUAL_SNAPSHOT_NUM_COUNTER; i++) {
+        #if PBDRV_CONFIG_VIRTUAL_PHYSICS
+        // Natively simulated motors are not read from CPython.
+        if (pbdrv_virtual_physics_get_motor(i)) {
+            continue;
+        }
+        #endif
+
+        static const char *const attributes[] = { "rotations", "millidegrees", "millidegrees_abs" };
+        pbdrv_virtual_value_t *const values[] = {
+            &snapshot.counter[i].rotations,
+            &snapshot.counter[i].millidegrees,
+            &snapshot.counter[i].millidegrees_abs,
+        };
+        pbdrv_virtual_read_component(platform, "counter", i, attributes, values, PBIO_ARRAY_SIZE(values));
+    }
+}
+
+/**
+ * Gets the polled values that were read from CPython when the clock last
+ * advanced.
+ *
+ * @returns The snapshot.
+ */
+const pbdrv_virtual_snapshot_t *pbdrv_virtual_get_snapshot(void) {
+    return &snapshot;
+}
+
+/**
+ * Sends all queued motor driver events to CPython.
+ *
+ * NOTE: The GIL must be held when calling this function!
+ *
+ * @param [in]  platform    The platform object.
+ * @returns                 The first error from a CPython exception, if any.
+ */
+static pbio_error_t pbdrv_virtual_send_motor_driver_events(PyObject *platform) {
+    pbio_error_t first_err = PBIO_SUCCESS;
+
+    for (uint8_t i = 0; i < motor_driver_event_count; i++) {
+        motor_driver_event_t *event = &motor_driver_events[i];
+
+        // new ref
+        PyObject *component_obj = pbdrv_virtual_get_platform_component(platform, "motor_driver", event->index);
+
+        if (component_obj) {
+            // new ref
+            PyObject *ret = event->coast ?
+                PyObject_CallMethod(component_obj, "on_coast", "I", event->timestamp) :
+                PyObject_CallMethod(component_obj, "on_set_duty_cycle", "Id", event->timestamp, event->duty_cycle);
+
+            // return value is ignored
+            Py_XDECREF(ret);
+            Py_DECREF(component_obj);
+        }
+
+        pbio_error_t err = pbdrv_virtual_check_cpython_exception();
+
+        if (first_err == PBIO_SUCCESS) {
+            first_err = err;
+        }
+    }
+
+    motor_driver_event_count = 0;
+
+    return first_err;
+}
+
+/**
+ * Queues a motor driver event to be sent to CPython on the next poll.
+ *
+ * Events are sent in order with the time they occurred, so CPython models
+ * see the same sequence as when they are sent right away.
+ *
+ * @param [in]  index       The index of the motor driver.
+ * @param [in]  timestamp   The time of the event in microseconds.
+ * @param [in]  coast       True for `on_coast()`, false for `on_set_duty_cycle()`.
+ * @param [in]  duty_cycle  The duty cycle (-1.0 to 1.0) if not @p coast.
+ */
+void pbdrv_virtual_queue_motor_driver_event(uint8_t index, uint32_t timestamp, bool coast, double duty_cycle) {
+    if (motor_driver_event_count == MOTOR_DRIVER_EVENT_QUEUE_SIZE) {
+        PyGILState_STATE state = PyGILState_Ensure();
+
+        PyObject *platform = pbdrv_virtual_get_platform();
+
+        if (platform) {
+            // Errors are printed, like errors on poll.
+            pbdrv_virtual_send_motor_driver_events(platform);
+            Py_DECREF(platform);
+        } else {
+            pbdrv_virtual_check_cpython_exception();
+            motor_driver_event_count = 0;
+        }
+
+        PyGILState_Release(state);
+    }
+
+    motor_driver_events[motor_driver_event_count++] = (motor_driver_event_t) {
+        .index = index,
+        .coast = coast,
+        .timestamp = timestamp,
+        .duty_cycle = duty_cycle,
+    };
+}
+
+/**
+ * Exchanges all state with the CPython platform.
+ *
+ * This sends queued motor driver events and calls `platform.on_poll()`, all
+ * while holding the GIL only once. With a wall clock, it also reads all
+ * polled values. A simulated clock reads them in ::pbdrv_virtual_platform_advance
+ * instead, so all reads between two clock advances see the same values.
  *
  * This should be called whenever the runtime is "idle".
  *
@@ -299,11 +626,79 @@ pbio_error_t pbdrv_virtual_platform_poll(void) {
         goto err;
     }
 
+    pbio_error_t events_err = pbdrv_virtual_send_motor_driver_events(platform);
+
     PyObject *ret = PyObject_CallMethod(platform, "on_poll", "I", pbdrv_clock_get_us());
 
     // ignore return value/error
     Py_XDECREF(ret);
 
+    pbio_error_t poll_err = pbdrv_virtual_check_cpython_exception();
+
+    if (!pbdrv_clock_virtual_is_simulated()) {
+        pbdrv_virtual_update_snapshot(platform);
+    }
+
+    Py_DECREF(platform);
+
+    PyGILState_Release(state);
+
+    return events_err != PBIO_SUCCESS ? events_err : poll_err;
+
+err:;
+    pbio_error_t err = pbdrv_virtual_check_cpython_exception();
+
+    PyGILState_Release(state);
+
+    return err;
+}
+
+/**
+ * Lets the CPython platform catch up with the simulated clock.
+ *
+ * This sends queued motor driver events, calls `platform.clock[-1].on_advance()`
+ * and then reads all polled values, all while holding the GIL only once. The
+ * clock driver calls this each time it advances, before any etimers run, so
+ * that control updates see the values at the new time.
+ *
+ * @param [in]  nanoseconds The new clock time in nanoseconds.
+ * @returns                 ::PBIO_SUCCESS if there were no unhandled CPython
+ *                          exception or ::PBIO_ERROR_FAILED if there was an
+ *                          unhandled exception.
+ */
+pbio_error_t pbdrv_virtual_platform_advance(uint64_t nanoseconds) {
+    PyGILState_STATE state = PyGILState_Ensure();
+
+    PyObject *platform = pbdrv_virtual_get_platform();
+
+    if (!platform) {
+        goto err;
+    }
+
+    // Motor models must know the duty cycles up to now before they are read.
+    pbio_error_t events_err = pbdrv_virtual_send_motor_driver_events(platform);
+
+    // new ref
+    PyObject *clock_obj = pbdrv_virtual_get_platform_component(platform, "clock", -1);
+
+    if (clock_obj) {
+        PyObject *ret = PyObject_CallMethod(clock_obj, "on_advance", "K", (unsigned long long)nanoseconds);
+
+        // ignore return value/error
+        Py_XDECREF(ret);
+        Py_DECREF(clock_obj);
+    }
+
+    pbio_error_t advance_err = pbdrv_virtual_check_cpython_exception();
+
+    pbdrv_virtual_update_snapshot(platform);
+
+    Py_DECREF(platform);
+
+    PyGILState_Release(state);
+
+    return events_err != PBIO_SUCCESS ? events_err : advance_err;
+
 err:;
     pbio_error_t err = pbdrv_virtual_check_cpython_exception();
 
@@ -7,8 +7,10 @@
 #define _INTERNAL_PBDRV_VIRTUAL_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <unistd.h>
 
+#include <pbdrv/config.h>
 #include <pbio/error.h>
 
 typedef struct _object PyObject;
@@ -24,12 +26,60 @@ typedef struct _object PyObject;
  */
 typedef bool (*pbdrv_virtual_cpython_exception_handler_t)(PyObject *type, PyObject *value, PyObject *traceback);
 
+/** A value read from CPython and the error that occurred while reading it. */
+typedef struct {
+    int64_t value;
+    pbio_error_t err;
+} pbdrv_virtual_value_t;
+
+#if PBDRV_CONFIG_COUNTER_VIRTUAL_CPYTHON
+#define PBDRV_VIRTUAL_SNAPSHOT_NUM_COUNTER PBDRV_CONFIG_COUNTER_VIRTUAL_CPYTHON_NUM_DEV
+#else
+#define PBDRV_VIRTUAL_SNAPSHOT_NUM_COUNTER 0
+#endif
+
+/**
+ * Polled values of the CPython platform, read all at once each time the clock
+ * advances.
+ */
+typedef struct {
+    /** `platform.button[-1].pressed` */
+    pbdrv_virtual_value_t button_pressed;
+    /** `platform.battery[-1].voltage` */
+    pbdrv_virtual_value_t battery_voltage;
+    /** `platform.battery[-1].current` */
+    pbdrv_virtual_value_t battery_current;
+    /** `platform.battery[-1].temperature` */
+    pbdrv_virtual_value_t battery_temperature;
+    /** `platform.battery[-1].type` */
+    pbdrv_virtual_value_t battery_type;
+    struct {
+        /** `platform.counter[<index>].rotations` */
+        pbdrv_virtual_value_t rotations;
+        /** `platform.counter[<index>].millidegrees` */
+        pbdrv_virtual_value_t millidegrees;
+        /** `platform.counter[<index>].millidegrees_abs` */
+        pbdrv_virtual_value_t millidegrees_abs;
+    } counter[PBDRV_VIRTUAL_SNAPSHOT_NUM_COUNTER];
+} pbdrv_virtual_snapshot_t;
+
 // REVISIT: these are high-level APIs and might need to be moved to a different header file
 pbio_error_t pbdrv_virtual_platform_start(pbdrv_virtual_cpython_exception_handler_t handler);
 pbio_error_t pbdrv_virtual_platform_stop(void);
 pbio_error_t pbdrv_virtual_platform_poll(void);
+pbio_error_t pbdrv_virtual_platform_advance(uint64_t nanoseconds);
+
+uint64_t pbdrv_clock_virtual_get_ns(void);
+bool pbdrv_clock_virtual_is_simulated(void);
+void pbdrv_clock_virtual_advance(uint32_t max_us);
+
+const pbdrv_virtual_snapshot_t *pbdrv_virtual_get_snapshot(void);
+void pbdrv_virtual_queue_motor_driver_event(uint8_t index, uint32_t timestamp, bool coast, double duty_cycle);
 
+bool pbdrv_virtual_has_component(const char *component, int index);
 pbio_error_t pbdrv_virtual_call_method(const char *component, int index, const char *method, const char *format, ...);
+pbio_error_t pbdrv_virtual_call_method_read_bytes(const char *component, int index, const char *method,
+    uint8_t *data, uint32_t *size, const char *format, ...);
 pbio_error_t pbdrv_virtual_get_u8(const char *component, int index,  const char *attribute, uint8_t *value);
 pbio_error_t pbdrv_virtual_get_u16(const char *component, int index, const char *attribute, uint16_t *value);
 pbio_error_t pbdrv_virtual_get_u32(const char *component, int index, const char *attribute, uint32_t *value);
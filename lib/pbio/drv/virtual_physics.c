@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+// Native physics models for virtual (CPython) drivers.
+//
+// Simulating in CPython means crossing into the CPython runtime for every
+// duty cycle update and counter read. The models here are the same as in
+// `pbio_virtual.physics` but keep their state in C, so that virtual motors
+// can run at the same cost as any other driver.
+
+#include <pbdrv/config.h>
+
+#if PBDRV_CONFIG_VIRTUAL_PHYSICS
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pbio/util.h>
+
+#include "virtual_physics.h"
+
+// Constants of pbio_virtual.physics.motors.SimpleMotor.
+#define SIMPLE_MOTOR_C0 (22.48)
+#define SIMPLE_MOTOR_C1 (0.0455 * 10000)
+
+static pbdrv_virtual_physics_motor_t motors[PBDRV_CONFIG_VIRTUAL_PHYSICS_NUM_MOTOR];
+static pbdrv_virtual_physics_drivebase_t drivebase;
+
+/**
+ * Gets the simulated motor for a motor driver and counter index.
+ *
+ * @param [in]  index   The index of the motor driver and counter.
+ * @returns             The motor or NULL if there is no native model for it.
+ */
+pbdrv_virtual_physics_motor_t *pbdrv_virtual_physics_get_motor(uint8_t index) {
+    if (index >= PBIO_ARRAY_SIZE(motors) || motors[index].model == PBDRV_VIRTUAL_PHYSICS_MODEL_NONE) {
+        return NULL;
+    }
+    return &motors[index];
+}
+
+/**
+ * Advances the motor state to the given time, using the current actuation.
+ *
+ * With a constant input, the SimpleMotor equation of motion is linear in the
+ * speed, so the state is evaluated exactly instead of integrating in small
+ * steps. This makes each update O(1), no matter how long ago the last one was.
+ *
+ * @param [in]  motor   The motor.
+ * @param [in]  time    The new time in microseconds.
+ */
+static void simple_motor_advance(pbdrv_virtual_physics_motor_t *motor, uint32_t time) {
+    // Wraps around correctly, like the clock. Earlier times leave the state
+    // as it is.
+    int32_t dt_us = time - motor->time;
+    if (dt_us <= 0) {
+        return;
+    }
+    double dt = dt_us / 1e6;
+
+    // Acceleration is -a * alpha_dot + b.
+    double a = motor->coasting ? SIMPLE_MOTOR_C0 / 4 : SIMPLE_MOTOR_C0;
+    double b = motor->coasting ? 0 : motor->duty * SIMPLE_MOTOR_C1;
+
+    double speed_final = b / a;
+    double speed_diff = motor->alpha_dot - speed_final;
+    double decay = exp(-a * dt);
+
+    motor->alpha += speed_final * dt + speed_diff * (1 - decay) / a;
+    motor->alpha_dot = speed_final + speed_diff * decay;
+    motor->time = time;
+}
+
+/**
+ * Simulates a motor up to the given time and moves the drivebase along if it
+ * is one of its wheels.
+ *
+ * @param [in]  motor   The motor.
+ * @param [in]  time    The new time in microseconds.
+ */
+static void motor_advance(pbdrv_virtual_physics_motor_t *motor, uint32_t time) {
+    if (drivebase.enabled && (motor == &motors[drivebase.left] || motor == &motors[drivebase.right])) {
+        pbdrv_virtual_physics_drivebase_update(time);
+        return;
+    }
+
+    simple_motor_advance(motor, time);
+}
+
+/**
+ * Initializes a simulated motor at standstill.
+ *
+ * Using ::PBDRV_VIRTUAL_PHYSICS_MODEL_NONE leaves the motor to CPython.
+ *
+ * @param [in]  index           The index of the motor driver and counter.
+ * @param [in]  model           The physics model.
+ * @param [in]  time            The current time in microseconds.
+ * @param [in]  millidegrees    The initial angle.
+ */
+void pbdrv_virtual_physics_motor_init(uint8_t index, pbdrv_virtual_physics_model_t model, uint32_t time, int32_t millidegrees) {
+    if (index >= PBIO_ARRAY_SIZE(motors)) {
+        return;
+    }
+
+    pbdrv_virtual_physics_motor_t *motor = &motors[index];
+    motor->model = model;
+    motor->time = time;
+    motor->alpha = millidegrees / 1000.0 * M_PI / 180.0;
+    motor->alpha_dot = 0;
+    motor->duty = 0;
+    motor->coasting = true;
+}
+
+/**
+ * Simulates the motor up to now with the previous actuation and then coasts.
+ *
+ * @param [in]  motor   The motor.
+ * @param [in]  time    The current time in microseconds.
+ */
+void pbdrv_virtual_physics_motor_coast(pbdrv_virtual_physics_motor_t *motor, uint32_t time) {
+    motor_advance(motor, time);
+    motor->coasting = true;
+}
+
+/**
+ * Simulates the motor up to now with the previous actuation and then applies
+ * a new duty cycle.
+ *
+ * @param [in]  motor   The motor.
+ * @param [in]  time    The current time in microseconds.
+ * @param [in]  duty    The duty cycle (-1.0 to 1.0).
+ */
+void pbdrv_virtual_physics_motor_set_duty_cycle(pbdrv_virtual_physics_motor_t *motor, uint32_t time, double duty) {
+    motor_advance(motor, time);
+    motor->duty = duty;
+    motor->coasting = false;
+}
+
+/**
+ * Gets the motor angle.
+ *
+ * @param [in]  motor   The motor.
+ * @param [in]  time    The current time in microseconds.
+ * @returns             The angle in millidegrees.
+ */
+int64_t pbdrv_virtual_physics_motor_get_angle(pbdrv_virtual_physics_motor_t *motor, uint32_t time) {
+    motor_advance(motor, time);
+    return llround(motor->alpha * 180.0 / M_PI * 1000.0);
+}
+
+/**
+ * Gets the simulated drivebase, so that CPython can set it up and read its pose.
+ *
+ * @returns             The drivebase.
+ */
+pbdrv_virtual_physics_drivebase_t *pbdrv_virtual_physics_get_drivebase(void) {
+    return &drivebase;
+}
+
+/**
+ * Starts simulating the drivebase from its initial pose, after CPython has
+ * set it up.
+ *
+ * The drivebase stays disabled unless both wheels are distinct simulated
+ * motors.
+ *
+ * @param [in]  time    The current time in microseconds.
+ */
+void pbdrv_virtual_physics_drivebase_start(uint32_t time) {
+    pbdrv_virtual_physics_motor_t *left = pbdrv_virtual_physics_get_motor(drivebase.left);
+    pbdrv_virtual_physics_motor_t *right = pbdrv_virtual_physics_get_motor(drivebase.right);
+
+    drivebase.enabled = false;
+
+    if (!left || !right || left == right || drivebase.axle_track <= 0) {
+        return;
+    }
+
+    simple_motor_advance(left, time);
+    simple_motor_advance(right, time);
+
+    drivebase.time = time;
+    drivebase.distance = 0;
+    drivebase.left_alpha = left->alpha;
+    drivebase.right_alpha = right->alpha;
+    drivebase.enabled = true;
+}
+
+/**
+ * Simulates both wheels up to the given time and moves the drivebase to match
+ * the new wheel angles, like odometry.
+ *
+ * Moving along the chord of the arc is exact for constant wheel speeds. Since
+ * this runs each time either motor is updated or read, the wheel speeds hardly
+ * change in between.
+ *
+ * @param [in]  time    The new time in microseconds.
+ */
+void pbdrv_virtual_physics_drivebase_update(uint32_t time) {
+    if (!drivebase.enabled) {
+        return;
+    }
+
+    pbdrv_virtual_physics_motor_t *left = &motors[drivebase.left];
+    pbdrv_virtual_physics_motor_t *right = &motors[drivebase.right];
+
+    simple_motor_advance(left, time);
+    simple_motor_advance(right, time);
+
+    // Like the motors, earlier times leave the pose as it is.
+    if ((int32_t)(time - drivebase.time) <= 0) {
+        return;
+    }
+
+    double d_left = drivebase.left_direction * (left->alpha - drivebase.left_alpha) * drivebase.wheel_diameter / 2;
+    double d_right = drivebase.right_direction * (right->alpha - drivebase.right_alpha) * drivebase.wheel_diameter / 2;
+    double d_center = (d_left + d_right) / 2;
+    double d_heading = (d_right - d_left) / drivebase.axle_track;
+
+    double chord = d_center;
+    if (d_heading != 0) {
+        chord *= sin(d_heading / 2) / (d_heading / 2);
+    }
+    double mid_heading = drivebase.heading + d_heading / 2;
+
+    drivebase.x += chord * cos(mid_heading);
+    drivebase.y += chord * sin(mid_heading);
+    drivebase.heading += d_heading;
+    drivebase.distance += d_center;
+
+    drivebase.time = time;
+    drivebase.left_alpha = left->alpha;
+    drivebase.right_alpha = right->alpha;
+}
+
+#endif // PBDRV_CONFIG_VIRTUAL_PHYSICS
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+// Native physics models for virtual (CPython) drivers.
+
+#ifndef _INTERNAL_PBDRV_VIRTUAL_PHYSICS_H_
+#define _INTERNAL_PBDRV_VIRTUAL_PHYSICS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Physics model attached to a virtual motor driver and counter.
+ *
+ * The values match the `native_model` attribute of the CPython motor driver.
+ */
+typedef enum {
+    /** No native model. Motor driver events and counter values are handled in CPython. */
+    PBDRV_VIRTUAL_PHYSICS_MODEL_NONE = 0,
+    /** Native version of `pbio_virtual.physics.motors.SimpleMotor`. */
+    PBDRV_VIRTUAL_PHYSICS_MODEL_SIMPLE_MOTOR = 1,
+} pbdrv_virtual_physics_model_t;
+
+/**
+ * State of a simulated DC motor.
+ *
+ * The state has a fixed size, no matter how long the simulation runs.
+ */
+typedef struct {
+    /** The model or ::PBDRV_VIRTUAL_PHYSICS_MODEL_NONE if not used. */
+    pbdrv_virtual_physics_model_t model;
+    /** Time of the current state in microseconds. */
+    uint32_t time;
+    /** Motor angle in radians. */
+    double alpha;
+    /** Motor speed in radians per second. */
+    double alpha_dot;
+    /** Duty cycle (-1.0 to 1.0). */
+    double duty;
+    /** Whether the motor is coasting instead of applying @p duty. */
+    bool coasting;
+} pbdrv_virtual_physics_motor_t;
+
+/**
+ * State of a simulated robot with two driven wheels on one axle, moved by two
+ * simulated motors.
+ *
+ * This is the native version of `pbio_virtual.physics.world.DifferentialDrive`.
+ * The CPython platform sets the configuration and the initial pose through
+ * ctypes before the drivebase is started and may read the pose at any time.
+ */
+typedef struct {
+    /** Whether the drivebase is simulated. */
+    bool enabled;
+    /** Index of the motor of the left wheel. */
+    uint8_t left;
+    /** Index of the motor of the right wheel. */
+    uint8_t right;
+    /** 1 if positive angles of the left motor drive forward or -1 if it is mounted mirrored. */
+    int8_t left_direction;
+    /** 1 if positive angles of the right motor drive forward or -1 if it is mounted mirrored. */
+    int8_t right_direction;
+    /** Time of the pose in microseconds. */
+    uint32_t time;
+    /** Diameter of the wheels in mm. */
+    double wheel_diameter;
+    /** Distance between the points where the wheels touch the ground in mm. */
+    double axle_track;
+    /** X coordinate of the center of the axle in mm. */
+    double x;
+    /** Y coordinate of the center of the axle in mm. */
+    double y;
+    /** Heading in radians, counterclockwise from the x axis. */
+    double heading;
+    /** Distance driven by the center of the axle in mm. */
+    double distance;
+    /** Angle of the left motor in radians at @p time. */
+    double left_alpha;
+    /** Angle of the right motor in radians at @p time. */
+    double right_alpha;
+} pbdrv_virtual_physics_drivebase_t;
+
+pbdrv_virtual_physics_motor_t *pbdrv_virtual_physics_get_motor(uint8_t index);
+void pbdrv_virtual_physics_motor_init(uint8_t index, pbdrv_virtual_physics_model_t model, uint32_t time, int32_t millidegrees);
+void pbdrv_virtual_physics_motor_coast(pbdrv_virtual_physics_motor_t *motor, uint32_t time);
+void pbdrv_virtual_physics_motor_set_duty_cycle(pbdrv_virtual_physics_motor_t *motor, uint32_t time, double duty);
+int64_t pbdrv_virtual_physics_motor_get_angle(pbdrv_virtual_physics_motor_t *motor, uint32_t time);
+pbdrv_virtual_physics_drivebase_t *pbdrv_virtual_physics_get_drivebase(void);
+void pbdrv_virtual_physics_drivebase_start(uint32_t time);
+void pbdrv_virtual_physics_drivebase_update(uint32_t time);
+
+#endif // _INTERNAL_PBDRV_VIRTUAL_PHYSICS_H_
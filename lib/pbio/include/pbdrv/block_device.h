@@ -43,6 +43,7 @@ PT_THREAD(pbdrv_block_device_read(struct pt *pt, uint32_t offset, uint8_t *buffe
  * Store data on storage device, starting from the base address.
  *
  * This erases as many sectors as needed for the given size prior to writing.
+ * Sectors that already hold the given data are not erased or written.
  *
  * On systems with data storage on an external chip, this is implemented with
  * non-blocking I/O operations.
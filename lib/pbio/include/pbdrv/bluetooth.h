@@ -1,5 +1,5 @@
 // SPDX-License-Identifier: MIT
-// Copyright (c) 2018-2021 The Pybricks Authors
+// Copyright (c) 2018-2023 The Pybricks Authors
 
 /**
  * @addtogroup BluetoothDriver Driver: Bluetooth
@@ -76,6 +76,32 @@ typedef struct {
     uint8_t data[0];
 } pbdrv_bluetooth_value_t;
 
+/**
+ * Advertising event types. The values match the HCI advertising report.
+ */
+typedef enum {
+    /** Connectable undirected advertisement. */
+    PBDRV_BLUETOOTH_AD_TYPE_ADV_IND = 0x00,
+    /** Connectable directed advertisement. */
+    PBDRV_BLUETOOTH_AD_TYPE_ADV_DIRECT_IND = 0x01,
+    /** Scannable undirected advertisement. */
+    PBDRV_BLUETOOTH_AD_TYPE_ADV_SCAN_IND = 0x02,
+    /** Non-connectable undirected advertisement. */
+    PBDRV_BLUETOOTH_AD_TYPE_ADV_NONCONN_IND = 0x03,
+    /** Scan response. */
+    PBDRV_BLUETOOTH_AD_TYPE_SCAN_RSP = 0x04,
+} pbdrv_bluetooth_ad_type_t;
+
+/**
+ * Callback that is called when advertising data is received while observing.
+ *
+ * @param [in]  event_type  The type of advertisement.
+ * @param [in]  data        The advertising data.
+ * @param [in]  length      The size of @p data in bytes.
+ * @param [in]  rssi        The received signal strength in dBm.
+ */
+typedef void (*pbdrv_bluetooth_start_observing_callback_t)(pbdrv_bluetooth_ad_type_t event_type, const uint8_t *data, uint8_t length, int8_t rssi);
+
 typedef struct {
     lwp3_hub_kind_t hub_kind;
     uint8_t status;
@@ -130,6 +156,15 @@ void pbdrv_bluetooth_stop_advertising(void);
  */
 bool pbdrv_bluetooth_is_connected(pbdrv_bluetooth_connection_t connection);
 
+/**
+ * Gets the ATT MTU of the current connection.
+ *
+ * Notifications can carry up to 3 bytes less than this.
+ *
+ * @return                  The negotiated MTU or the default of 23 bytes.
+ */
+uint16_t pbdrv_bluetooth_get_mtu(void);
+
 /**
  * Registers a callback that is called when Bluetooth event occurs.
  *
@@ -178,6 +213,31 @@ void pbdrv_bluetooth_write_remote(pbio_task_t *task, pbdrv_bluetooth_value_t *va
 // TODO: make this a generic disconnect
 void pbdrv_bluetooth_disconnect_remote(void);
 
+/**
+ * Starts sending non-connectable advertisements with the given data, or
+ * updates the data if already broadcasting.
+ *
+ * @param [in]  task    The task that is used to wait for completion.
+ * @param [in]  value   The advertising data, up to 31 bytes. A size of 0
+ *                      stops broadcasting.
+ */
+void pbdrv_bluetooth_start_broadcasting(pbio_task_t *task, pbdrv_bluetooth_value_t *value);
+
+/**
+ * Starts passive scanning for advertisements of other devices.
+ *
+ * @param [in]  task        The task that is used to wait for completion.
+ * @param [in]  callback    Called for each advertisement that is received.
+ */
+void pbdrv_bluetooth_start_observing(pbio_task_t *task, pbdrv_bluetooth_start_observing_callback_t callback);
+
+/**
+ * Stops scanning that was started with ::pbdrv_bluetooth_start_observing.
+ *
+ * @param [in]  task    The task that is used to wait for completion.
+ */
+void pbdrv_bluetooth_stop_observing(pbio_task_t *task);
+
 #else // PBDRV_CONFIG_BLUETOOTH
 
 #define pbdrv_bluetooth_init
@@ -200,6 +260,10 @@ static inline bool pbdrv_bluetooth_is_connected(pbdrv_bluetooth_connection_t con
     return false;
 }
 
+static inline uint16_t pbdrv_bluetooth_get_mtu(void) {
+    return 23;
+}
+
 static inline void pbdrv_bluetooth_send(pbdrv_bluetooth_send_context_t *context) {
 }
 
@@ -218,6 +282,18 @@ static inline void pbdrv_bluetooth_write_remote(pbio_task_t *task, pbdrv_bluetoo
 static inline void pbdrv_bluetooth_disconnect_remote(void) {
 }
 
+static inline void pbdrv_bluetooth_start_broadcasting(pbio_task_t *task, pbdrv_bluetooth_value_t *value) {
+    task->status = PBIO_ERROR_NOT_SUPPORTED;
+}
+
+static inline void pbdrv_bluetooth_start_observing(pbio_task_t *task, pbdrv_bluetooth_start_observing_callback_t callback) {
+    task->status = PBIO_ERROR_NOT_SUPPORTED;
+}
+
+static inline void pbdrv_bluetooth_stop_observing(pbio_task_t *task) {
+    task->status = PBIO_ERROR_NOT_SUPPORTED;
+}
+
 #endif // PBDRV_CONFIG_BLUETOOTH
 
 #endif // _PBDRV_BLUETOOTH_H_
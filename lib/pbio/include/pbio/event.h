@@ -12,6 +12,8 @@ typedef enum {
     PBIO_EVENT_STATUS_SET,
     /** System status indicator was cleared. Data is ::pbio_pybricks_status_t. */
     PBIO_EVENT_STATUS_CLEARED,
+    /** An I/O device trigger fired. Data is ::pbio_iodev_t. */
+    PBIO_EVENT_IODEV_TRIGGER,
 } pbio_event_t;
 
 #endif // _PBIO_EVENT_H_
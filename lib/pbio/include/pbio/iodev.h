@@ -11,6 +11,7 @@
 #ifndef _PBIO_IODEV_H_
 #define _PBIO_IODEV_H_
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -543,6 +544,59 @@ typedef struct {
  */
 typedef struct _pbio_iodev_t pbio_iodev_t;
 
+/**
+ * Condition that makes an I/O device trigger fire.
+ */
+typedef enum {
+    /** Trigger is disabled. */
+    PBIO_IODEV_TRIGGER_TYPE_NONE,
+    /** Value is greater than the high threshold. */
+    PBIO_IODEV_TRIGGER_TYPE_ABOVE,
+    /** Value is less than the low threshold. */
+    PBIO_IODEV_TRIGGER_TYPE_BELOW,
+    /** Value is between the low and high thresholds (inclusive). */
+    PBIO_IODEV_TRIGGER_TYPE_INSIDE,
+    /** Value is less than the low or greater than the high threshold. */
+    PBIO_IODEV_TRIGGER_TYPE_OUTSIDE,
+} pbio_iodev_trigger_type_t;
+
+/**
+ * Function called from the driver when a trigger fires.
+ *
+ * @param [in]  iodev   The I/O device.
+ * @param [in]  context The caller-defined context of the trigger.
+ */
+typedef void (*pbio_iodev_trigger_callback_t)(pbio_iodev_t *iodev, void *context);
+
+/**
+ * Trigger that is evaluated by the driver for each new sample of an I/O device.
+ */
+typedef struct {
+    /** The condition. */
+    pbio_iodev_trigger_type_t type;
+    /** The mode to which the trigger applies. */
+    uint8_t mode;
+    /** Index of the value within the data of the mode. */
+    uint8_t index;
+    /**
+     * If true, the trigger fires each time the condition becomes true.
+     * Otherwise it fires once and is then disabled.
+     */
+    bool edge;
+    /** Low threshold. */
+    int32_t low;
+    /** High threshold. */
+    int32_t high;
+    /** Optional function to call when the trigger fires. */
+    pbio_iodev_trigger_callback_t callback;
+    /** Caller-defined context passed to *callback*. */
+    void *context;
+    /** Result of the condition for the previous sample (internal use). */
+    bool condition;
+    /** Number of times the trigger fired. */
+    uint32_t count;
+} pbio_iodev_trigger_t;
+
 /** @cond INTERNAL */
 
 /**
@@ -584,6 +638,10 @@ struct _pbio_iodev_t {
      * the values could be foreign-endian.
      */
     uint8_t bin_data[PBIO_IODEV_MAX_DATA_SIZE]  __attribute__((aligned(4)));
+    /**
+     * Trigger that is evaluated whenever new data is received.
+     */
+    pbio_iodev_trigger_t trigger;
 };
 
 /** @endcond */
@@ -600,6 +658,9 @@ void pbio_iodev_set_data_cancel(pbio_iodev_t *iodev);
 pbio_error_t pbio_iodev_write_begin(pbio_iodev_t *iodev, const uint8_t *data, uint8_t size);
 pbio_error_t pbio_iodev_write_end(pbio_iodev_t *iodev);
 void pbio_iodev_write_cancel(pbio_iodev_t *iodev);
+void pbio_iodev_set_trigger(pbio_iodev_t *iodev, const pbio_iodev_trigger_t *trigger);
+void pbio_iodev_clear_trigger(pbio_iodev_t *iodev);
+void pbio_iodev_update_trigger(pbio_iodev_t *iodev);
 
 #endif // _PBIO_IODEV_H_
 
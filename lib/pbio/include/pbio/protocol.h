@@ -24,7 +24,7 @@
 #define PBIO_PROTOCOL_VERSION_MAJOR 1
 
 /** The minor version number for the protocol. */
-#define PBIO_PROTOCOL_VERSION_MINOR 2
+#define PBIO_PROTOCOL_VERSION_MINOR 3
 
 /** The patch version number for the protocol. */
 #define PBIO_PROTOCOL_VERSION_PATCH 0
@@ -92,6 +92,12 @@ typedef enum {
      * - offset: The offset from the user RAM base address (32-bit little-endian unsigned integer).
      * - payload: The data to write (0 to 507 bytes).
      *
+     * The payload should be as large as the maximum characteristic value
+     * size in the hub capabilities allows. If the hub has the
+     * ::PBIO_PYBRICKS_FEATURE_USER_PROG_WRITE_WITHOUT_RESPONSE feature, this
+     * command may be sent as a write without response, in which case
+     * ::PBIO_PYBRICKS_COMMAND_VERIFY_USER_PROGRAM must be used afterwards.
+     *
      * Errors:
      * - ::PBIO_PYBRICKS_ERROR_BUSY if the user program is running and the
      *   data would write over the user program area of the user RAM.
@@ -108,6 +114,47 @@ typedef enum {
      * disconnected.
      */
     PBIO_PYBRICKS_COMMAND_REBOOT_TO_UPDATE_MODE = 5,
+
+    /**
+     * Requests to verify the user program written to user RAM.
+     *
+     * The checksum is compared against the first *size* bytes of user RAM as
+     * given by ::PBIO_PYBRICKS_COMMAND_WRITE_USER_PROGRAM_META. If it does not
+     * match, the user program size is set to 0 so the program can't be run.
+     *
+     * Parameters:
+     * - checksum: The CRC-32 (same as zlib) of the user program (32-bit little-endian unsigned integer).
+     *
+     * Errors:
+     * - ::PBIO_PYBRICKS_ERROR_BUSY if the user program is running.
+     * - ::PBIO_PYBRICKS_ERROR_VALUE_NOT_ALLOWED if the command does not have
+     *   exactly these parameters.
+     * - ::PBIO_PYBRICKS_ERROR_VERIFY_FAILED if the checksum does not match.
+     *
+     * @since Protocol v1.3.0
+     */
+    PBIO_PYBRICKS_COMMAND_VERIFY_USER_PROGRAM = 6,
+
+    /**
+     * Requests to compare a range of user RAM to a checksum.
+     *
+     * This lets the host find out which modules of a multi-module program
+     * the hub already has, so only the modules that changed need to be sent
+     * with ::PBIO_PYBRICKS_COMMAND_WRITE_USER_RAM. User RAM is not modified.
+     *
+     * Parameters:
+     * - offset: The offset from the user RAM base address (32-bit little-endian unsigned integer).
+     * - size: The size of the range in bytes (32-bit little-endian unsigned integer).
+     * - checksum: The CRC-32 (same as zlib) of the range (32-bit little-endian unsigned integer).
+     *
+     * Errors:
+     * - ::PBIO_PYBRICKS_ERROR_VALUE_NOT_ALLOWED if the range is outside of user RAM
+     *   or the command does not have exactly these parameters.
+     * - ::PBIO_PYBRICKS_ERROR_VERIFY_FAILED if the checksum does not match.
+     *
+     * @since Protocol v1.3.0
+     */
+    PBIO_PYBRICKS_COMMAND_COMPARE_USER_RAM = 7,
 } pbio_pybricks_command_t;
 
 /**
@@ -137,6 +184,12 @@ typedef enum {
      * @since Protocol v1.2.0
      */
     PBIO_PYBRICKS_ERROR_BUSY = 0x81,
+    /**
+     * The data received by the hub does not match the checksum.
+     *
+     * @since Protocol v1.3.0
+     */
+    PBIO_PYBRICKS_ERROR_VERIFY_FAILED = 0x82,
 } pbio_pybricks_error_t;
 
 pbio_pybricks_error_t pbio_pybricks_error_from_pbio_error(pbio_error_t error);
@@ -156,6 +209,16 @@ typedef enum {
      * @since Protocol v1.0.0
      */
     PBIO_PYBRICKS_EVENT_STATUS_REPORT = 0,
+    /**
+     * Telemetry record written by the user program.
+     *
+     * The payload is the record exactly as given by the user program. Its
+     * layout is defined by the program, and its size is the size of the
+     * notification minus the event type.
+     *
+     * @since Protocol v1.3.0
+     */
+    PBIO_PYBRICKS_EVENT_WRITE_TELEMETRY = 1,
 } pbio_pybricks_event_t;
 
 /**
@@ -246,6 +309,29 @@ typedef enum {
      * Hub supports user program with multiple MicroPython .mpy files ABI v6.
      */
     PBIO_PYBRICKS_FEATURE_USER_PROG_FORMAT_MULTI_MPY_V6 = 1 << 1,
+    /**
+     * Hub accepts user program data written without response and supports
+     * ::PBIO_PYBRICKS_COMMAND_VERIFY_USER_PROGRAM.
+     */
+    PBIO_PYBRICKS_FEATURE_USER_PROG_WRITE_WITHOUT_RESPONSE = 1 << 2,
+    /**
+     * Hub supports user programs compressed with LZ4.
+     *
+     * A compressed program starts with the 4 bytes ``LZ4B``, followed by
+     * the size of the uncompressed program (32-bit little-endian unsigned
+     * integer), followed by the program compressed in the LZ4 block format.
+     * The program size given by ::PBIO_PYBRICKS_COMMAND_WRITE_USER_PROGRAM_META
+     * is the size of the compressed data, including this header.
+     */
+    PBIO_PYBRICKS_FEATURE_USER_PROG_COMPRESSED_LZ4 = 1 << 3,
+    /**
+     * Hub supports ::PBIO_PYBRICKS_COMMAND_COMPARE_USER_RAM.
+     *
+     * The command compares any range of user RAM. To compare a module of a
+     * multi-MPY program, the host uses the range where the module will be
+     * in the program it is about to send.
+     */
+    PBIO_PYBRICKS_FEATURE_USER_PROG_COMPARE_RAM = 1 << 4,
 } pbio_pybricks_feature_flags_t;
 
 void pbio_pybricks_hub_capabilities(uint8_t *buf,
@@ -274,7 +360,8 @@ extern const uint8_t pbio_nus_service_uuid[];
 extern const uint8_t pbio_nus_rx_char_uuid[];
 extern const uint8_t pbio_nus_tx_char_uuid[];
 
-// Downloaded programs are received in chunks up to this size.
+// Downloaded data is received in chunks up to this size by hubs that don't
+// report a larger size in the hub capabilities.
 #define PBIO_PYBRICKS_PROTOCOL_DOWNLOAD_CHUNK_SIZE (100)
 
 #endif // _PBIO_PROTOCOL_H_
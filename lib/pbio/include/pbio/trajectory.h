@@ -78,7 +78,7 @@ typedef struct _pbio_trajectory_t {
 pbio_error_t pbio_trajectory_new_angle_command(pbio_trajectory_t *trj, const pbio_trajectory_command_t *command);
 pbio_error_t pbio_trajectory_new_time_command(pbio_trajectory_t *trj, const pbio_trajectory_command_t *command);
 void pbio_trajectory_make_constant(pbio_trajectory_t *trj, const pbio_trajectory_command_t *command);
-void pbio_trajectory_stretch(pbio_trajectory_t *trj, pbio_trajectory_t *leader);
+pbio_error_t pbio_trajectory_stretch(pbio_trajectory_t *trj, const pbio_trajectory_t *leader);
 
 // Reference getter functions:
 
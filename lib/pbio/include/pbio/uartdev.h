@@ -15,10 +15,41 @@ typedef struct {
     uint8_t uart_id;    /**< The ID of a UART device used by this uartdev */
 } pbio_uartdev_platform_data_t;
 
+/**
+ * Communication statistics for a UART device.
+ *
+ * Counters accumulate across reconnections so that intermittent connection
+ * problems can be diagnosed.
+ */
+typedef struct {
+    /** Total number of bytes in received messages. */
+    uint32_t rx_bytes;
+    /** Total number of received messages. */
+    uint32_t rx_msgs;
+    /** Number of accepted DATA messages. */
+    uint32_t data_msgs;
+    /** Number of messages with a bad checksum. */
+    uint32_t checksum_errors;
+    /** Number of bad message headers while receiving data. */
+    uint32_t framing_errors;
+    /** Number of keep alive intervals without any data. */
+    uint32_t keep_alive_timeouts;
+    /** Number of times the connection was reset and had to sync again. */
+    uint32_t resyncs;
+    /** Time in milliseconds it took to complete the last mode change. */
+    uint32_t mode_change_time;
+    /** Number of DATA messages per second during the last keep alive interval. */
+    uint32_t data_rate;
+    /** Current baud rate. */
+    uint32_t baud_rate;
+} pbio_uartdev_stats_t;
+
 #if PBIO_CONFIG_UARTDEV
 
 pbio_error_t pbio_uartdev_get(uint8_t id, pbio_iodev_t **iodev);
-void pbio_uartdev_ready(uint8_t id);
+pbio_error_t pbio_uartdev_ready(uint8_t id);
+pbio_error_t pbio_uartdev_get_stats(pbio_iodev_t *iodev, pbio_uartdev_stats_t *stats);
+void pbio_uartdev_clear_triggers(void);
 
 #if !PBIO_CONFIG_UARTDEV_NUM_DEV
 #error Must define PBIO_CONFIG_UARTDEV_NUM_DEV
@@ -33,7 +64,15 @@ static inline pbio_error_t pbio_uartdev_get(uint8_t id, pbio_iodev_t **iodev) {
     return PBIO_ERROR_NOT_SUPPORTED;
 }
 
-static inline void pbio_uartdev_ready(uint8_t id) {
+static inline pbio_error_t pbio_uartdev_ready(uint8_t id) {
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
+
+static inline pbio_error_t pbio_uartdev_get_stats(pbio_iodev_t *iodev, pbio_uartdev_stats_t *stats) {
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
+
+static inline void pbio_uartdev_clear_triggers(void) {
 }
 
 #endif // PBIO_CONFIG_UARTDEV
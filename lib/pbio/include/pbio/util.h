@@ -129,6 +129,10 @@ void pbio_uuid128_reverse_copy(uint8_t *dst, const uint8_t *src);
 
 bool pbio_oneshot(bool value, bool *state);
 
+uint32_t pbio_crc32(const uint8_t *data, uint32_t size);
+
+bool pbio_lz4_decompress(const uint8_t *src, uint32_t src_size, uint8_t *dst, uint32_t dst_size);
+
 #endif // _PBIO_UTIL_H_
 
 /** @} */
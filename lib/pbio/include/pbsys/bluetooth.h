@@ -1,5 +1,5 @@
 // SPDX-License-Identifier: MIT
-// Copyright (c) 2021-2022 The Pybricks Authors
+// Copyright (c) 2021-2023 The Pybricks Authors
 
 /**
  * @addtogroup SystemBluetooth System: Bluetooth
@@ -23,6 +23,18 @@
  */
 typedef bool (*pbsys_bluetooth_stdin_event_callback_t)(uint8_t c);
 
+/**
+ * Statistics about data sent on the Bluetooth serial port.
+ */
+typedef struct {
+    /** Number of bytes sent since the connection was made. */
+    uint32_t bytes;
+    /** Number of notifications sent since the connection was made. */
+    uint32_t notifications;
+    /** Bytes per second, measured over the last second. */
+    uint32_t rate;
+} pbsys_bluetooth_tx_stats_t;
+
 #if PBSYS_CONFIG_BLUETOOTH
 
 void pbsys_bluetooth_init(void);
@@ -32,6 +44,59 @@ uint32_t pbsys_bluetooth_rx_get_available(void);
 pbio_error_t pbsys_bluetooth_rx(uint8_t *data, uint32_t *size);
 pbio_error_t pbsys_bluetooth_tx(const uint8_t *data, uint32_t *size);
 bool pbsys_bluetooth_tx_is_idle(void);
+void pbsys_bluetooth_tx_get_stats(pbsys_bluetooth_tx_stats_t *stats);
+pbio_error_t pbsys_bluetooth_send_telemetry(const uint8_t *data, uint32_t size);
+
+#if PBSYS_CONFIG_BLUETOOTH_UART_SIO
+
+/**
+ * Pushes data received on the Nordic UART Rx characteristic to the SIO port.
+ *
+ * This is the only reader of received data. It must not block. SIO ports
+ * that only implement `tSIOAsyncPortPybricksBluetooth_eSIOCBR_pushReceive()`
+ * get a weak default implementation that pushes one byte at a time.
+ *
+ * @param [in]  src     The data.
+ * @param [in]  size    The size of @p src in bytes. This is never 0.
+ * @return              The number of bytes accepted, from 0 to @p size. These
+ *                      are the first bytes of @p src. The rest stays buffered
+ *                      and is offered again later, in order, starting with
+ *                      the first byte that was not accepted.
+ */
+uint32_t tSIOAsyncPortPybricksBluetooth_eSIOCBR_pushReceiveBuffer(const char *src, uint32_t size);
+
+/**
+ * Gets the number of bytes the SIO port has waiting to be sent on the Nordic
+ * UART Tx characteristic.
+ *
+ * This is implemented by the SIO port.
+ *
+ * @return              The number of bytes.
+ */
+int tSIOAsyncPortPybricksBluetooth_eSIOCBR_sizeSend(void);
+
+/**
+ * Takes one byte to be sent on the Nordic UART Tx characteristic from the SIO
+ * port.
+ *
+ * This is implemented by the SIO port.
+ *
+ * @param [out] dst     The byte.
+ * @return              1 if a byte was taken or less than 1 if there is none.
+ */
+int tSIOAsyncPortPybricksBluetooth_eSIOCBR_popSend(char *dst);
+
+void pb_bluetooth_uart_put_notify(void);
+
+/**
+ * Tells that the SIO port has room for received data again.
+ *
+ * The SIO port must call this after it refused received data and then made
+ * room for it, so that the remaining data is pushed again right away.
+ */
+void pb_bluetooth_uart_get_notify(void);
+
+#endif // PBSYS_CONFIG_BLUETOOTH_UART_SIO
 
 #else // PBSYS_CONFIG_BLUETOOTH
 
@@ -49,6 +114,12 @@ static inline pbio_error_t pbsys_bluetooth_tx(const uint8_t *data, uint32_t *siz
 static inline bool pbsys_bluetooth_tx_is_idle(void) {
     return false;
 }
+static inline void pbsys_bluetooth_tx_get_stats(pbsys_bluetooth_tx_stats_t *stats) {
+    *stats = (pbsys_bluetooth_tx_stats_t) { 0 };
+}
+static inline pbio_error_t pbsys_bluetooth_send_telemetry(const uint8_t *data, uint32_t size) {
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
 
 #endif // PBSYS_CONFIG_BLUETOOTH
 
@@ -49,8 +49,40 @@ typedef struct _pbsys_program_load_data_header_t {
      * Size of the application program (size of code only).
      */
     uint32_t program_size;
+    #if PBSYS_CONFIG_SETTINGS
+    /**
+     * Must be ::PBSYS_PROGRAM_LOAD_LAYOUT_SETTINGS. Data saved by firmware
+     * without settings has the program data here instead.
+     */
+    uint32_t layout;
+    /**
+     * Two copies of the key-value settings store. See pbsys/settings.h.
+     * Each copy is aligned with an erase sector of the storage, so that
+     * storing one never erases the other or the rest of the header. This is
+     * what keeps the previous copy intact if saving is interrupted.
+     *
+     * The price is the padding: the rest of the sector before the first copy
+     * and of the sectors of both copies is not used, so the header takes
+     * three whole sectors from the program (12 KiB with 4 KiB sectors). See
+     * ::PBSYS_PROGRAM_LOAD_MAX_PROGRAM_SIZE.
+     */
+    struct __attribute__((aligned(PBSYS_CONFIG_SETTINGS_ALIGN))) {
+        uint8_t data[PBSYS_CONFIG_SETTINGS_SIZE];
+    } settings[2];
+    #endif
 } pbsys_program_load_data_header_t;
 
+/**
+ * Identifies a header with settings. As the first word of a program, this
+ * would be an impossibly big module size, and it is not the start of an .mpy
+ * file or a compressed program, so it can't be mistaken for old data.
+ */
+#define PBSYS_PROGRAM_LOAD_LAYOUT_SETTINGS (0x31534250) // "PBS1"
+
+/**
+ * Maximum size of the program. With settings, this is deliberately three
+ * erase sectors less than without, see ::pbsys_program_load_data_header_t.
+ */
 #define PBSYS_PROGRAM_LOAD_MAX_PROGRAM_SIZE (PBSYS_CONFIG_PROGRAM_LOAD_ROM_SIZE - sizeof(pbsys_program_load_data_header_t))
 
 pbio_error_t pbsys_program_load_set_user_data(uint32_t offset, const uint8_t *data, uint32_t size);
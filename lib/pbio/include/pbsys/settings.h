@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+/**
+ * @addtogroup SysSettings System: Persistent key-value settings.
+ *
+ * Small named values that user programs can keep across runs, such as
+ * calibration data. Settings are stored along with the user program and
+ * saved on poweroff.
+ *
+ * @{
+ */
+
+#ifndef _PBSYS_SETTINGS_H_
+#define _PBSYS_SETTINGS_H_
+
+#include <stdint.h>
+
+#include <pbio/error.h>
+#include <pbsys/config.h>
+
+/** Maximum size of a settings key in bytes. */
+#define PBSYS_SETTINGS_MAX_KEY_SIZE (32)
+
+#if PBSYS_CONFIG_SETTINGS
+
+pbio_error_t pbsys_settings_get(const char *key, uint32_t key_size, const uint8_t **value, uint32_t *size);
+pbio_error_t pbsys_settings_set(const char *key, uint32_t key_size, const uint8_t *value, uint32_t size);
+pbio_error_t pbsys_settings_delete(const char *key, uint32_t key_size);
+
+#else
+
+static inline pbio_error_t pbsys_settings_get(const char *key, uint32_t key_size, const uint8_t **value, uint32_t *size) {
+    *value = NULL;
+    *size = 0;
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
+
+static inline pbio_error_t pbsys_settings_set(const char *key, uint32_t key_size, const uint8_t *value, uint32_t size) {
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
+
+static inline pbio_error_t pbsys_settings_delete(const char *key, uint32_t key_size) {
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
+
+#endif // PBSYS_CONFIG_SETTINGS
+
+#endif // _PBSYS_SETTINGS_H_
+
+/** @} */
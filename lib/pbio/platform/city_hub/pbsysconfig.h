@@ -12,5 +12,7 @@
 #define PBSYS_CONFIG_PROGRAM_LOAD_RAM_SIZE          (20 * 1024)
 #define PBSYS_CONFIG_PROGRAM_LOAD_ROM_SIZE          (PBDRV_CONFIG_BLOCK_DEVICE_FLASH_STM32_SIZE)
 #define PBSYS_CONFIG_PROGRAM_LOAD_USER_DATA_SIZE    (128)
+#define PBSYS_CONFIG_PROGRAM_LOAD_COMPRESSION       (1)
+#define PBSYS_CONFIG_SETTINGS                       (0)
 #define PBSYS_CONFIG_STATUS_LIGHT                   (1)
 #define PBSYS_CONFIG_STATUS_LIGHT_BATTERY           (0)
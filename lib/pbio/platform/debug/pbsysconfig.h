@@ -10,5 +10,7 @@
 #define PBSYS_CONFIG_PROGRAM_LOAD_ROM_SIZE          (0)
 #define PBSYS_CONFIG_PROGRAM_LOAD_OVERLAPS_BOOTLOADER_CHECKSUM (0)
 #define PBSYS_CONFIG_PROGRAM_LOAD_USER_DATA_SIZE    (512)
+#define PBSYS_CONFIG_PROGRAM_LOAD_COMPRESSION       (0)
+#define PBSYS_CONFIG_SETTINGS                       (0)
 #define PBSYS_CONFIG_STATUS_LIGHT                   (1)
 #define PBSYS_CONFIG_STATUS_LIGHT_BATTERY           (0)
@@ -10,5 +10,9 @@
 #define PBSYS_CONFIG_PROGRAM_LOAD_ROM_SIZE          (PBDRV_CONFIG_BLOCK_DEVICE_W25QXX_STM32_SIZE)
 #define PBSYS_CONFIG_PROGRAM_LOAD_OVERLAPS_BOOTLOADER_CHECKSUM (0)
 #define PBSYS_CONFIG_PROGRAM_LOAD_USER_DATA_SIZE    (512)
+#define PBSYS_CONFIG_PROGRAM_LOAD_COMPRESSION       (0)
+#define PBSYS_CONFIG_SETTINGS                       (1)
+#define PBSYS_CONFIG_SETTINGS_SIZE                  (1024)
+#define PBSYS_CONFIG_SETTINGS_ALIGN                 (4 * 1024)
 #define PBSYS_CONFIG_STATUS_LIGHT                   (1)
 #define PBSYS_CONFIG_STATUS_LIGHT_BATTERY           (1)
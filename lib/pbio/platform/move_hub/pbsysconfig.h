@@ -5,6 +5,7 @@
 
 #define PBSYS_CONFIG_BATTERY_CHARGER                (0)
 #define PBSYS_CONFIG_BLUETOOTH                      (1)
+#define PBSYS_CONFIG_BLUETOOTH_TELEMETRY_BUF_SIZE   (64)
 #define PBSYS_CONFIG_HUB_LIGHT_MATRIX               (0)
 #define PBSYS_CONFIG_MAIN                           (1)
 #define PBSYS_CONFIG_PROGRAM_LOAD                   (1)
@@ -12,5 +13,7 @@
 #define PBSYS_CONFIG_PROGRAM_LOAD_RAM_SIZE          (7 * 1024)
 #define PBSYS_CONFIG_PROGRAM_LOAD_ROM_SIZE          (PBDRV_CONFIG_BLOCK_DEVICE_FLASH_STM32_SIZE)
 #define PBSYS_CONFIG_PROGRAM_LOAD_USER_DATA_SIZE    (128)
+#define PBSYS_CONFIG_PROGRAM_LOAD_COMPRESSION       (1)
+#define PBSYS_CONFIG_SETTINGS                       (0)
 #define PBSYS_CONFIG_STATUS_LIGHT                   (1)
 #define PBSYS_CONFIG_STATUS_LIGHT_BATTERY           (0)
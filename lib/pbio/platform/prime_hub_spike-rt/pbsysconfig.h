@@ -16,3 +16,7 @@
 #define PBSYS_CONFIG_STATUS_LIGHT                   (1)
 #define PBSYS_CONFIG_STATUS_LIGHT_BATTERY           (1)
 #define PBSYS_CONFIG_BLUETOOTH_ADVERTISING_MANUAL_CONTROL  (1)
+#define PBSYS_CONFIG_BLUETOOTH_UART_SIO             (1)
+#define PBSYS_CONFIG_BLUETOOTH_UART_RX_BUF_SIZE     (1024)
+#define PBSYS_CONFIG_BLUETOOTH_UART_TX_SIZE_MAX     (244)
+#define PBSYS_CONFIG_BLUETOOTH_UART_TX_COALESCE_TIME (5)
@@ -16,4 +16,8 @@ typedef uint32_t clock_time_t;
 #define clock_time pbdrv_clock_get_ms
 #define clock_usecs pbdrv_clock_get_us
 
+// The event loop profiler uses the computer's clock, since a simulated clock
+// does not move while code runs.
+#define PROCESS_CONF_PROFILE_CLOCK process_profile_host_clock
+
 #endif /* _PBIO_CONF_H_ */
@@ -27,7 +27,13 @@
 #define PBDRV_CONFIG_MOTOR_DRIVER_NUM_DEV                   (6)
 #define PBDRV_CONFIG_MOTOR_DRIVER_VIRTUAL_CPYTHON           (1)
 
+#define PBDRV_CONFIG_UART                                   (1)
+#define PBDRV_CONFIG_UART_VIRTUAL                           (1)
+#define PBDRV_CONFIG_UART_VIRTUAL_NUM_UART                  (6)
+
 #define PBDRV_CONFIG_VIRTUAL                                (1)
+#define PBDRV_CONFIG_VIRTUAL_PHYSICS                        (1)
+#define PBDRV_CONFIG_VIRTUAL_PHYSICS_NUM_MOTOR              (6)
 
 #define PBDRV_CONFIG_HAS_PORT_A (1)
 #define PBDRV_CONFIG_HAS_PORT_B (1)
@@ -13,8 +13,8 @@
 #define PBIO_CONFIG_SERVO_PUP_MOVE_HUB      (1)
 #define PBIO_CONFIG_TACHO                   (1)
 
-#define PBIO_CONFIG_UARTDEV                 (0)
-#define PBIO_CONFIG_UARTDEV_NUM_DEV         (0)
+#define PBIO_CONFIG_UARTDEV                 (1)
+#define PBIO_CONFIG_UARTDEV_NUM_DEV         (6)
 #define PBIO_CONFIG_UARTDEV_FIRST_PORT      PBIO_PORT_ID_A
 
 #define PBIO_CONFIG_ENABLE_SYS              (1)
@@ -1,4 +1,27 @@
 // SPDX-License-Identifier: MIT
 // Copyright (c) 2022 The Pybricks Authors
 
-// This file is unused, but required for the common make file.
+#include <pbio/uartdev.h>
+
+// UART device on each I/O port. The virtual UART ids match the indexes of
+// `platform.uart` in CPython.
+const pbio_uartdev_platform_data_t pbio_uartdev_platform_data[PBIO_CONFIG_UARTDEV_NUM_DEV] = {
+    [0] = {
+        .uart_id = 0,
+    },
+    [1] = {
+        .uart_id = 1,
+    },
+    [2] = {
+        .uart_id = 2,
+    },
+    [3] = {
+        .uart_id = 3,
+    },
+    [4] = {
+        .uart_id = 4,
+    },
+    [5] = {
+        .uart_id = 5,
+    },
+};
@@ -476,6 +476,8 @@ static pbio_error_t pbio_drivebase_drive_relative(pbio_drivebase_t *db, int32_t
 
     // Revise follower trajectory so it takes as long as the leader, achieved
     // by picking a lower speed and accelerations that makes the times match.
+    // If that is not possible within the limits, the follower keeps its own
+    // trajectory and just finishes sooner, so the error is not returned.
     pbio_trajectory_stretch(&control_follower->trajectory, &control_leader->trajectory);
 
     return PBIO_SUCCESS;
@@ -1,11 +1,17 @@
 // SPDX-License-Identifier: MIT
-// Copyright (c) 2018-2020 The Pybricks Authors
+// Copyright (c) 2018-2023 The Pybricks Authors
 
 #include <assert.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+#include <contiki.h>
 
 #include "pbdrv/ioport.h"
 #include "pbio/error.h"
+#include "pbio/event.h"
+#include "pbio/iodev.h"
 #include "pbio/port.h"
 
 /**
@@ -183,3 +189,119 @@ void pbio_iodev_write_cancel(pbio_iodev_t *iodev) {
 
     iodev->ops->write_cancel(iodev);
 }
+
+/**
+ * Sets a trigger that is evaluated by the driver each time new data arrives.
+ *
+ * This replaces any previous trigger. The trigger only applies while the
+ * device is in *trigger->mode*, so the caller is responsible for setting the
+ * mode. The trigger count is reset.
+ *
+ * @param [in]  iodev       The I/O device
+ * @param [in]  trigger     The trigger settings
+ */
+void pbio_iodev_set_trigger(pbio_iodev_t *iodev, const pbio_iodev_trigger_t *trigger) {
+    iodev->trigger = *trigger;
+    iodev->trigger.condition = false;
+    iodev->trigger.count = 0;
+}
+
+/**
+ * Disables the trigger of an I/O device.
+ * @param [in]  iodev       The I/O device
+ */
+void pbio_iodev_clear_trigger(pbio_iodev_t *iodev) {
+    iodev->trigger.type = PBIO_IODEV_TRIGGER_TYPE_NONE;
+    iodev->trigger.callback = NULL;
+    iodev->trigger.context = NULL;
+}
+
+// Gets one value from the raw data of the current mode as an integer.
+static bool pbio_iodev_get_trigger_value(pbio_iodev_t *iodev, uint8_t index, int32_t *value) {
+    const pbio_iodev_mode_t *mode_info = &iodev->info->mode_info[iodev->mode];
+
+    if (index >= mode_info->num_values) {
+        return false;
+    }
+
+    switch (mode_info->data_type & PBIO_IODEV_DATA_TYPE_MASK) {
+        case PBIO_IODEV_DATA_TYPE_INT8:
+            *value = ((int8_t *)iodev->bin_data)[index];
+            return true;
+        case PBIO_IODEV_DATA_TYPE_INT16:
+            *value = ((int16_t *)iodev->bin_data)[index];
+            return true;
+        case PBIO_IODEV_DATA_TYPE_INT32:
+            *value = ((int32_t *)iodev->bin_data)[index];
+            return true;
+        case PBIO_IODEV_DATA_TYPE_FLOAT:
+            *value = (int32_t)((float *)iodev->bin_data)[index];
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * Evaluates the trigger of an I/O device against the current data.
+ *
+ * This is called by drivers each time new data has been copied to
+ * ``iodev->bin_data``, so the trigger fires in the same event loop iteration
+ * that the data arrives without waiting for user code to poll the device.
+ *
+ * @param [in]  iodev       The I/O device
+ */
+void pbio_iodev_update_trigger(pbio_iodev_t *iodev) {
+    pbio_iodev_trigger_t *trigger = &iodev->trigger;
+
+    if (trigger->type == PBIO_IODEV_TRIGGER_TYPE_NONE || trigger->mode != iodev->mode) {
+        return;
+    }
+
+    int32_t value;
+    if (!pbio_iodev_get_trigger_value(iodev, trigger->index, &value)) {
+        return;
+    }
+
+    bool condition;
+    switch (trigger->type) {
+        case PBIO_IODEV_TRIGGER_TYPE_ABOVE:
+            condition = value > trigger->high;
+            break;
+        case PBIO_IODEV_TRIGGER_TYPE_BELOW:
+            condition = value < trigger->low;
+            break;
+        case PBIO_IODEV_TRIGGER_TYPE_INSIDE:
+            condition = value >= trigger->low && value <= trigger->high;
+            break;
+        case PBIO_IODEV_TRIGGER_TYPE_OUTSIDE:
+            condition = value < trigger->low || value > trigger->high;
+            break;
+        default:
+            return;
+    }
+
+    // Edge triggers only fire when the condition goes from false to true.
+    bool fire = condition && !(trigger->edge && trigger->condition);
+    trigger->condition = condition;
+
+    if (!fire) {
+        return;
+    }
+
+    trigger->count++;
+
+    pbio_iodev_trigger_callback_t callback = trigger->callback;
+    void *context = trigger->context;
+
+    // One-shot triggers are disabled before the callback so it may set a new one.
+    if (!trigger->edge) {
+        trigger->type = PBIO_IODEV_TRIGGER_TYPE_NONE;
+    }
+
+    if (callback) {
+        callback(iodev, context);
+    }
+
+    process_post(PROCESS_BROADCAST, PBIO_EVENT_IODEV_TRIGGER, iodev);
+}
@@ -68,6 +68,8 @@ void pbio_stop_all(bool reset) {
         pbio_light_animation_stop_all();
     }
     #endif
+    // Triggers must go first so they can't restart anything stopped below.
+    pbio_uartdev_clear_triggers();
     pbio_dcmotor_stop_all(reset);
     pbdrv_sound_stop();
 }
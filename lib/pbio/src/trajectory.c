@@ -50,6 +50,12 @@
 #define assert_time(t) (assert((t) >= 0 && (t) < TIME_MAX))
 #define assert_accel_time(t) (assert((t) >= 0 && (t) < TIME_ACCEL_MAX))
 
+/**
+ * Stretched trajectories end with their leader if that makes the reference
+ * jump by no more than this many millidegrees.
+ */
+#define STRETCH_ANGLE_JUMP_MAX (200)
+
 /**
  * Position (mdeg) and time (1e-4 s) are the same as in control module.
  * But speed is in millidegrees/second in control units, but this module uses
@@ -143,25 +149,37 @@ static int32_t div_w_by_a(int32_t w, int32_t a) {
     return w * 1000 / a;
 }
 
-// Divides angle (mdeg) by time (s e-4), giving speed (ddeg/s).
+// Divides angle (mdeg) by time (s e-4), giving speed (ddeg/s), rounded to
+// the nearest integer.
 static int32_t div_th_by_t(int32_t th, int32_t t) {
 
     assert_time(t);
     assert_angle(th);
 
-    if (pbio_int_math_abs(th) < INT32_MAX / 100) {
-        return th * 100 / t;
+    // Scale the remainder separately so big angles don't overflow.
+    return th / t * 100 + (th % t * 100 + (th < 0 ? -t : t) / 2) / t;
+}
+
+// Divides a sum of two angles (mdeg) by a sum of two times (s e-4), giving
+// speed (ddeg/s). Each sum can be up to twice the maximum angle or time, in
+// which case both are halved first.
+static int32_t div_th_sum_by_t_sum(int32_t th, int32_t t) {
+
+    if (t >= TIME_MAX || pbio_int_math_abs(th) >= ANGLE_MAX) {
+        th /= 2;
+        t = (t + 1) / 2;
     }
-    return th / t * 100;
+    return div_th_by_t(th, t);
 }
 
-// Divides speed (ddeg/s) by time (s e-4), giving acceleration (deg/s^2).
+// Divides speed (ddeg/s) by time (s e-4), giving acceleration (deg/s^2),
+// rounded away from zero.
 static int32_t div_w_by_t(int32_t w, int32_t t) {
 
     assert_time(t);
     assert_speed_rel(w);
 
-    return w * 1000 / t;
+    return (w * 1000 + (w < 0 ? 1 - t : t - 1)) / t;
 }
 
 // Divides angle (mdeg) by speed (deg/s), giving time (s e-4).
@@ -221,7 +239,9 @@ static int32_t bind_w0(int32_t w_end, int32_t a, int32_t th) {
 // without a stationary speed phase.
 static int32_t intersect_ramp(int32_t th3, int32_t th0, int32_t a0, int32_t a2) {
 
-    assert_accel_angle(th3 - th0);
+    // The starting angle may be up to one full ramp behind the actual start
+    // if the initial speed is negative, so this can take up to two ramps.
+    assert_accel_angle((th3 - th0) / 2);
 
     // If angles are equal, that's where they intersect.
     // This avoids the acceleration ratio division, which
@@ -243,7 +263,7 @@ static int32_t intersect_ramp(int32_t th3, int32_t th0, int32_t a0, int32_t a2)
 static pbio_error_t pbio_trajectory_new_forward_time_command(pbio_trajectory_t *trj, const pbio_trajectory_command_t *c) {
 
     // Return error for a long user-specified duration.
-    if (c->duration > TIME_MAX) {
+    if (c->duration >= TIME_MAX) {
         return PBIO_ERROR_INVALID_ARG;
     }
 
@@ -321,8 +341,14 @@ static pbio_error_t pbio_trajectory_new_forward_time_command(pbio_trajectory_t *
         } else {
             // Otherwise, we can just take the intersection of the accelerating
             // and decelerating ramps to find the angle at t1 = t2.
+            // This is t1 = (w3 - w0 - a2 * t3) / (a0 - a2), split into two
+            // terms because a2 * t3 can be much more than the maximum speed
+            // for long durations. Each term is rounded, so bind the result.
             assert(trj->a0 != trj->a2);
-            trj->t1 = div_w_by_a(trj->w3 - trj->w0 - mul_a_by_t(trj->a2, trj->t3), trj->a0 - trj->a2);
+            trj->t1 = pbio_int_math_bind(
+                pbio_int_math_mult_then_div(trj->t3, -trj->a2, trj->a0 - trj->a2) +
+                pbio_int_math_mult_then_div(trj->w3 - trj->w0, 1000, trj->a0 - trj->a2),
+                0, trj->t3);
 
             // There is no constant speed phase in this case.
             t2mt1 = 0;
@@ -387,6 +413,12 @@ static pbio_error_t pbio_trajectory_new_forward_angle_command(pbio_trajectory_t
         wt = bind_w0(trj->w3, decel, fwd_angle);
     }
 
+    // Return error if maneuver would take too long, before computing the
+    // duration below which could overflow for low speeds and big angles.
+    if (fwd_angle / wt > TIME_MAX / 100) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
     // Get initial approximation of duration.
     int32_t t3_approx = div_th_by_w(fwd_angle, wt);
     if (trj->w0 < 0) {
@@ -487,6 +519,12 @@ static pbio_error_t pbio_trajectory_new_forward_angle_command(pbio_trajectory_t
         return PBIO_ERROR_FAILED;
     }
 
+    // The initial approximation of the duration leaves out the time spent
+    // accelerating and decelerating, so check again.
+    if (trj->t3 >= TIME_MAX) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
     // Assert times are valid.
     assert_time(trj->t1);
     assert_time(trj->t2);
@@ -499,39 +537,103 @@ static pbio_error_t pbio_trajectory_new_forward_angle_command(pbio_trajectory_t
     return PBIO_SUCCESS;
 }
 
-void pbio_trajectory_stretch(pbio_trajectory_t *trj, pbio_trajectory_t *leader) {
+/**
+ * Stretches a trajectory to take as long as another.
+ *
+ * The new trajectory travels the same distance from the same start speed,
+ * with the speed and accelerations that the leader's time stamps need. As for
+ * other commands, the time stamps are then derived from those, so the
+ * duration can still differ from the leader's by rounding of the speed and
+ * accelerations.
+ *
+ * If this needs more than the maximum speed or acceleration, or if it does
+ * not get closer to the leader's duration, the trajectory is left as it was.
+ *
+ * @param [in]  trj     The trajectory to stretch.
+ * @param [in]  leader  The trajectory that takes at least as long.
+ * @return              ::PBIO_SUCCESS on success or ::PBIO_ERROR_INVALID_ARG
+ *                      if the trajectory could not be stretched.
+ */
+pbio_error_t pbio_trajectory_stretch(pbio_trajectory_t *trj, const pbio_trajectory_t *leader) {
 
-    // Synchronize timestamps with leading trajectory.
-    trj->t1 = leader->t1;
-    trj->t2 = leader->t2;
-    trj->t3 = leader->t3;
+    if (trj->t3 == leader->t3) {
+        // This already takes as long, so there's nothing to recompute.
+        return PBIO_SUCCESS;
+    }
 
-    if (trj->t3 == 0) {
-        // This is a stationary maneuver, so there's nothing to recompute.
-        return;
+    // The leader can take the full acceleration time to reverse at the
+    // minimum acceleration, which is one tick too long to evaluate a ramp.
+    if (leader->t1 >= TIME_ACCEL_MAX || leader->t3 - leader->t2 >= TIME_ACCEL_MAX) {
+        return PBIO_ERROR_INVALID_ARG;
     }
 
+    // Work on a copy, so the trajectory is unchanged if this fails.
+    pbio_trajectory_t s = *trj;
+
     // This recomputes several components of a trajectory such that it travels
-    // the same distance as before, but with new time stamps t1, t2, and t3.
-    // Setting the speed integral equal to (th3 - th0) gives three constraint
-    // equations with three unknowns (a0, a2, wt), for which we can solve.
+    // the same distance as before, but with the time stamps t1, t2, and t3 of
+    // the leader. Setting the speed integral equal to (th3 - th0) gives three
+    // constraint equations with three unknowns (a0, a2, wt), for which we can
+    // solve.
 
     // Solve constraint to find peak velocity
-    trj->w1 = div_th_by_t(2 * trj->th3 - mul_w_by_t(trj->w0, trj->t1) - mul_w_by_t(trj->w3, trj->t3 - trj->t2),
-        trj->t3 + trj->t2 - trj->t1);
+    s.w1 = div_th_sum_by_t_sum(2 * s.th3 - mul_w_by_t(s.w0, leader->t1) - mul_w_by_t(s.w3, leader->t3 - leader->t2),
+        leader->t3 + leader->t2 - leader->t1);
 
-    // Get corresponding accelerations
-    trj->a0 = trj->t1 == 0 ? 0 : div_w_by_t(trj->w1 - trj->w0, trj->t1);
-    trj->a2 = (trj->t3 - trj->t2) == 0 ? 0 : div_w_by_t(trj->w3 - trj->w1, trj->t3 - trj->t2);
+    // Return error if it would go faster than before, which can happen if it
+    // has to reverse sooner than it did.
+    if (pbio_int_math_abs(s.w1) > pbio_int_math_max(pbio_int_math_abs(trj->w0), pbio_int_math_abs(trj->w1))) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
 
-    // Since the target speed may have been lowered, we need to adjust w3 too.
-    trj->w3 = (trj->t3 - trj->t2) == 0 ? trj->w1 : 0;
+    // Without a deceleration phase, keep going at the new peak speed, unless
+    // this trajectory ends standing still.
+    if (leader->t3 == leader->t2 && s.w3 != 0) {
+        s.w3 = s.w1;
+    }
+
+    // Get corresponding accelerations, rounded up so that the phases don't
+    // take longer than the leader's. A phase without duration is a jump in
+    // speed, which may be no bigger than accelerating for one tick.
+    s.a0 = div_w_by_t(s.w1 - s.w0, pbio_int_math_max(leader->t1, 1));
+    s.a2 = div_w_by_t(s.w3 - s.w1, pbio_int_math_max(leader->t3 - leader->t2, 1));
+    if (pbio_int_math_abs(s.a0) > ACCELERATION_MAX || pbio_int_math_abs(s.a2) > ACCELERATION_MAX) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
 
-    // With all constraints already satisfied, we can just compute the
-    // intermediate positions relative to the endpoints, given the now-known
-    // accelerations and speeds.
-    trj->th1 = mul_w_by_t(trj->w0, trj->t1) + mul_a_by_t2(trj->a0, trj->t1);
-    trj->th2 = trj->th1 + mul_w_by_t(trj->w1, trj->t2 - trj->t1);
+    // Get the duration and angle of each acceleration phase.
+    s.t1 = leader->t1 == 0 || s.a0 == 0 ? 0 : (s.w1 - s.w0) * 1000 / s.a0;
+    int32_t t3mt2 = leader->t3 == leader->t2 || s.a2 == 0 ? 0 : (s.w3 - s.w1) * 1000 / s.a2;
+    s.a0 = s.t1 == 0 ? 0 : s.a0;
+    s.a2 = t3mt2 == 0 ? 0 : s.a2;
+    s.th1 = mul_w_by_t(s.w0, s.t1) + mul_a_by_t2(s.a0, s.t1);
+    s.th2 = s.th3 - mul_w_by_t(s.w1, t3mt2) - mul_a_by_t2(s.a2, t3mt2);
+
+    // Travel the rest at constant speed, ending with the leader. Since speeds
+    // and accelerations are rounded, the position jumps a bit where this
+    // phase ends. If that is too much, end a bit sooner or later instead.
+    int32_t t2mt1 = leader->t3 - s.t1 - t3mt2;
+    int32_t th_jump = s.th2 - s.th1 - mul_w_by_t(s.w1, t2mt1);
+    if (pbio_int_math_abs(th_jump) > STRETCH_ANGLE_JUMP_MAX) {
+        th_jump -= pbio_int_math_sign(th_jump) * STRETCH_ANGLE_JUMP_MAX;
+        if (s.w1 == 0 || pbio_int_math_abs(th_jump) >= pbio_int_math_abs(mul_w_by_t(s.w1, TIME_MAX - 1 - s.t1 - t3mt2))) {
+            return PBIO_ERROR_INVALID_ARG;
+        }
+        t2mt1 += div_th_by_w(th_jump, s.w1);
+        if (t2mt1 < 0 || s.t1 + t2mt1 + t3mt2 >= TIME_MAX) {
+            return PBIO_ERROR_INVALID_ARG;
+        }
+    }
+    s.t2 = s.t1 + t2mt1;
+    s.t3 = s.t2 + t3mt2;
+
+    // Return error if this doesn't make it end closer to the leader.
+    if (pbio_int_math_abs(s.t3 - leader->t3) >= pbio_int_math_abs(trj->t3 - leader->t3)) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    *trj = s;
+    return PBIO_SUCCESS;
 }
 
 pbio_error_t pbio_trajectory_new_time_command(pbio_trajectory_t *trj, const pbio_trajectory_command_t *command) {
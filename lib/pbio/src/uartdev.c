@@ -32,6 +32,7 @@
 #include <contiki.h>
 #include <lego_uart.h>
 
+#include "pbdrv/clock.h"
 #include "pbdrv/config.h"
 #include "pbdrv/ioport.h"
 #include "pbdrv/uart.h"
@@ -51,7 +52,13 @@
 #define EV3_UART_TYPE_MAX           101
 #define EV3_UART_SPEED_MIN          2400
 #define EV3_UART_SPEED_LPF2         115200  // standard baud rate for Powered Up
-#define EV3_UART_SPEED_MAX          460800  // in practice 115200 is max
+#define EV3_UART_SPEED_MAX          460800  // only used by custom devices
+
+/**
+ * Number of bad checksums per keepalive interval above which a device running
+ * faster than EV3_UART_SPEED_LPF2 is reset and synced again at a lower speed.
+ */
+#define EV3_UART_MAX_FAST_CHECKSUM_ERR      4
 
 #define EV3_UART_DATA_KEEP_ALIVE_TIMEOUT    100 /* msec */
 #define EV3_UART_IO_TIMEOUT                 250 /* msec */
@@ -143,6 +150,11 @@ typedef enum {
  * @new_mode: The mode requested by set_mode. Also used to keep track of mode
  *  in INFO messages while syncing.
  * @new_baud_rate: New baud rate that will be set with ev3_uart_change_bitrate
+ * @max_baud_rate: Highest baud rate to be used with the current device. This
+ *      is lowered when communication fails at speeds above EV3_UART_SPEED_LPF2
+ *      and raised again once communication at the lower speed works.
+ * @prev_type_id: Type ID of the previously synced device, used to reset
+ *      max_baud_rate when a different device is connected.
  * @info_flags: Flags indicating what information has already been read
  *      from the data.
  * @abs_pos: The absolute position received from an LPF2 motor
@@ -152,13 +164,20 @@ typedef enum {
  * @ext_mode: Extra mode adder for Powered Up devices (for modes > LUMP_MAX_MODE)
  * @write_cmd_size: The size parameter received from a WRITE command
  * @last_err: data->msg to be printed in case of an error.
- * @err_count: Total number of errors that have occurred
+ * @stats: Communication statistics
  * @num_data_err: Number of bad reads when receiving DATA data->msgs.
+ * @num_data_msgs: Number of DATA messages since last keepalive, used for
+ *      computing the data rate.
+ * @checksum_errors_prev: Checksum error count at the last keepalive.
+ * @baud_rate_ok: Flag that indicates that data was received without too many
+ *      errors at the current baud rate.
+ * @mode_change_start: Time (ms) when the current mode change was started.
  * @data_rec: Flag that indicates that good DATA data->msg has been received
  *      since last watchdog timeout.
  * @tx_busy: mutex that protects tx_msg
  * @mode_change_tx_done: Flag to keep ev3_uart_set_mode_end() blocked until
  * mode has actually changed
+ * @mode_change_pending: Flag that indicates that mode_change_start is valid
  * @speed_payload: Buffer for holding baud rate change message data
  */
 typedef struct {
@@ -175,6 +194,8 @@ typedef struct {
     uint8_t requested_mode;
     uint8_t new_mode;
     uint32_t new_baud_rate;
+    uint32_t max_baud_rate;
+    pbio_iodev_type_id_t prev_type_id;
     uint32_t info_flags;
     uint8_t *tx_msg;
     uint8_t *rx_msg;
@@ -182,11 +203,16 @@ typedef struct {
     uint8_t ext_mode;
     uint8_t write_cmd_size;
     DBG_ERR(const char *last_err);
-    uint32_t err_count;
+    pbio_uartdev_stats_t stats;
     uint32_t num_data_err;
+    uint32_t num_data_msgs;
+    uint32_t checksum_errors_prev;
+    uint32_t mode_change_start;
     bool data_rec;
+    bool baud_rate_ok;
     bool tx_busy;
     bool mode_change_tx_done;
+    bool mode_change_pending;
     uint8_t speed_payload[4];
 } uartdev_port_data_t;
 
@@ -228,25 +254,29 @@ pbio_error_t pbio_uartdev_get(uint8_t id, pbio_iodev_t **iodev) {
  * Indicates to the uartdev driver that the port has been placed in uart mode
  * (i.e. pin mux) and is ready to start syncing with the attached I/O device.
  * @param [in] id The uartdev device id.
+ * @return        ::PBIO_SUCCESS on success, ::PBIO_ERROR_INVALID_ARG if the id
+ *                is not valid or ::PBIO_ERROR_AGAIN if the driver is not
+ *                waiting for a device, e.g. because it has not started yet or
+ *                is still busy with the previous device. The caller may try
+ *                again later.
  */
-void pbio_uartdev_ready(uint8_t id) {
+pbio_error_t pbio_uartdev_ready(uint8_t id) {
     if (id >= PBIO_CONFIG_UARTDEV_NUM_DEV) {
-        return;
+        return PBIO_ERROR_INVALID_ARG;
     }
 
     uartdev_port_data_t *data = &dev_data[id];
 
-    // REVISIT: For now we are assuming that this function is never called
-    // at the wrong time. If this assumption turns out to be false, we will
-    // need to return PBIO_ERROR_AGAIN and modify callers to retry.
     if (data->status != PBIO_UARTDEV_STATUS_WAITING) {
-        return;
+        return PBIO_ERROR_AGAIN;
     }
 
     // notify pbio_uartdev_update() that there should be a device ready to
     // communicate with now
     data->status = PBIO_UARTDEV_STATUS_SYNCING;
     process_poll(&pbio_uartdev_process);
+
+    return PBIO_SUCCESS;
 }
 
 static inline bool test_and_set_bit(uint8_t bit, uint32_t *flags) {
@@ -293,6 +323,9 @@ static void pbio_uartdev_parse_msg(uartdev_port_data_t *data) {
         mode += data->ext_mode;
     }
 
+    data->stats.rx_msgs++;
+    data->stats.rx_bytes += msg_size;
+
     if (msg_size > 1) {
         uint8_t checksum = 0xFF;
         for (int i = 0; i < msg_size - 1; i++) {
@@ -300,6 +333,7 @@ static void pbio_uartdev_parse_msg(uartdev_port_data_t *data) {
         }
         if (checksum != data->rx_msg[msg_size - 1]) {
             DBG_ERR(data->last_err = "Bad checksum");
+            data->stats.checksum_errors++;
             // if INFO messages are done and we are now receiving data, it is
             // OK to occasionally have a bad checksum
             if (data->status == PBIO_UARTDEV_STATUS_DATA) {
@@ -582,6 +616,13 @@ static void pbio_uartdev_parse_msg(uartdev_port_data_t *data) {
             data->iodev.mode = mode;
             if (mode == data->new_mode) {
                 memcpy(data->iodev.bin_data, data->rx_msg + 1, msg_size - 2);
+
+                if (data->mode_change_pending) {
+                    data->stats.mode_change_time = pbdrv_clock_get_ms() - data->mode_change_start;
+                    data->mode_change_pending = false;
+                }
+
+                pbio_iodev_update_trigger(&data->iodev);
             }
 
 
@@ -589,6 +630,8 @@ static void pbio_uartdev_parse_msg(uartdev_port_data_t *data) {
             data->info->type_id = data->type_id;
 
             data->data_rec = true;
+            data->num_data_msgs++;
+            data->stats.data_msgs++;
             if (data->num_data_err) {
                 data->num_data_err--;
             }
@@ -708,6 +751,32 @@ err:
     PT_EXIT(&data->speed_pt);
 }
 
+/**
+ * Gets the next lower standard baud rate to fall back to after communication
+ * errors at high speeds.
+ * @param [in]  speed   The baud rate that failed.
+ * @return              The baud rate to try next.
+ */
+static uint32_t ev3_uart_get_fallback_speed(uint32_t speed) {
+    if (speed > 230400) {
+        return 230400;
+    }
+    return EV3_UART_SPEED_LPF2;
+}
+
+/**
+ * Gets the next higher standard baud rate to try again after communication
+ * at a lower speed worked.
+ * @param [in]  speed   The baud rate that worked.
+ * @return              The baud rate to try next.
+ */
+static uint32_t ev3_uart_get_retry_speed(uint32_t speed) {
+    if (speed < 230400) {
+        return 230400;
+    }
+    return EV3_UART_SPEED_MAX;
+}
+
 static PT_THREAD(pbio_uartdev_update(uartdev_port_data_t * data)) {
     pbio_error_t err;
     uint8_t checksum;
@@ -737,10 +806,15 @@ static PT_THREAD(pbio_uartdev_update(uartdev_port_data_t * data)) {
 
     pbdrv_uart_flush(data->uart);
 
-    // Send SPEED command at 115200 baud
+    // Send SPEED command at 115200 baud. This is the only time the hub may
+    // ask for a speed, so a custom device that failed at a higher speed
+    // before is asked to sync and run at its lower limit instead of 115200.
+    data->new_baud_rate = data->max_baud_rate < EV3_UART_SPEED_MAX ? data->max_baud_rate : EV3_UART_SPEED_LPF2;
+    data->baud_rate_ok = false;
     PBIO_PT_WAIT_READY(&data->pt, pbdrv_uart_set_baud_rate(data->uart, EV3_UART_SPEED_LPF2));
+    data->stats.baud_rate = EV3_UART_SPEED_LPF2;
     debug_pr("set baud: %d\n", EV3_UART_SPEED_LPF2);
-    PT_SPAWN(&data->pt, &data->speed_pt, pbio_uartdev_send_speed_msg(data, EV3_UART_SPEED_LPF2));
+    PT_SPAWN(&data->pt, &data->speed_pt, pbio_uartdev_send_speed_msg(data, data->new_baud_rate));
 
     // read one byte to check for ACK
     PBIO_PT_WAIT_READY(&data->pt, err = pbdrv_uart_read_begin(data->uart, data->rx_msg, 1, 100));
@@ -752,11 +826,18 @@ static PT_THREAD(pbio_uartdev_update(uartdev_port_data_t * data)) {
     PBIO_PT_WAIT_READY(&data->pt, err = pbdrv_uart_read_end(data->uart));
     if ((err == PBIO_SUCCESS && data->rx_msg[0] != LUMP_SYS_ACK) || err == PBIO_ERROR_TIMEDOUT) {
         // if we did not get ACK within 100ms, then switch to slow baud rate for sync
+        data->new_baud_rate = EV3_UART_SPEED_MIN;
         PBIO_PT_WAIT_READY(&data->pt, pbdrv_uart_set_baud_rate(data->uart, EV3_UART_SPEED_MIN));
+        data->stats.baud_rate = EV3_UART_SPEED_MIN;
         debug_pr("set baud: %d\n", EV3_UART_SPEED_MIN);
     } else if (err != PBIO_SUCCESS) {
         DBG_ERR(data->last_err = "UART Rx error during baud");
         goto err;
+    } else if (data->new_baud_rate != EV3_UART_SPEED_LPF2) {
+        // the device accepted the requested speed, so sync at that speed
+        PBIO_PT_WAIT_READY(&data->pt, pbdrv_uart_set_baud_rate(data->uart, data->new_baud_rate));
+        data->stats.baud_rate = data->new_baud_rate;
+        debug_pr("set baud: %" PRIu32 "\n", data->new_baud_rate);
     }
 
     // To get in sync with the data stream from the sensor, we look for a valid TYPE command.
@@ -809,9 +890,17 @@ static PT_THREAD(pbio_uartdev_update(uartdev_port_data_t * data)) {
     data->info->num_modes = 1;
 
     data->type_id = data->rx_msg[1];
+    if (data->type_id != data->prev_type_id) {
+        // Different device, so give it a chance to run at full speed.
+        data->prev_type_id = data->type_id;
+        data->max_baud_rate = EV3_UART_SPEED_MAX;
+    }
     data->info_flags = EV3_UART_INFO_FLAG_CMD_TYPE;
     data->data_rec = false;
     data->num_data_err = 0;
+    data->num_data_msgs = 0;
+    data->checksum_errors_prev = data->stats.checksum_errors;
+    data->mode_change_pending = false;
     data->status = PBIO_UARTDEV_STATUS_INFO;
     debug_pr("type id: %d\n", data->type_id);
 
@@ -882,6 +971,7 @@ static PT_THREAD(pbio_uartdev_update(uartdev_port_data_t * data)) {
 
     // change the baud rate
     PBIO_PT_WAIT_READY(&data->pt, pbdrv_uart_set_baud_rate(data->uart, data->new_baud_rate));
+    data->stats.baud_rate = data->new_baud_rate;
     debug_pr("set baud: %" PRIu32 "\n", data->new_baud_rate);
 
     data->status = PBIO_UARTDEV_STATUS_DATA;
@@ -904,9 +994,32 @@ static PT_THREAD(pbio_uartdev_update(uartdev_port_data_t * data)) {
         etimer_reset_with_new_interval(&data->timer, EV3_UART_DATA_KEEP_ALIVE_TIMEOUT);
         PT_WAIT_UNTIL(&data->pt, etimer_expired(&data->timer));
 
+        data->stats.data_rate = data->num_data_msgs * 1000 / EV3_UART_DATA_KEEP_ALIVE_TIMEOUT;
+        data->num_data_msgs = 0;
+
+        // Too many bad messages at high speed means the link cannot keep up,
+        // so start over and negotiate a lower speed.
+        if (data->stats.baud_rate > EV3_UART_SPEED_LPF2 &&
+            data->stats.checksum_errors - data->checksum_errors_prev > EV3_UART_MAX_FAST_CHECKSUM_ERR) {
+            DBG_ERR(data->last_err = "Too many errors at high speed");
+            data->baud_rate_ok = false;
+            goto err;
+        }
+        data->checksum_errors_prev = data->stats.checksum_errors;
+
+        // Once the link works at a speed that was limited after errors, the
+        // next sync may try a higher speed again.
+        if (data->data_rec && !data->baud_rate_ok) {
+            data->baud_rate_ok = true;
+            if (data->max_baud_rate < EV3_UART_SPEED_MAX && data->stats.baud_rate >= data->max_baud_rate) {
+                data->max_baud_rate = ev3_uart_get_retry_speed(data->max_baud_rate);
+            }
+        }
+
         // make sure we are receiving data
         if (!data->data_rec) {
             data->num_data_err++;
+            data->stats.keep_alive_timeouts++;
             DBG_ERR(data->last_err = "No data since last keepalive");
             if (data->num_data_err > 6) {
                 data->status = PBIO_UARTDEV_STATUS_ERR;
@@ -939,7 +1052,18 @@ err:
     data->status = PBIO_UARTDEV_STATUS_ERR;
     etimer_stop(&data->timer);
     debug_pr("%s\n", data->last_err);
-    data->err_count++;
+    data->stats.resyncs++;
+
+    // If we failed at a speed above the standard speed before it worked, try
+    // a lower speed next time. Unplugging a device that worked ends up here
+    // too, but that does not lower the limit.
+    if (data->stats.baud_rate > EV3_UART_SPEED_LPF2 && !data->baud_rate_ok) {
+        data->max_baud_rate = ev3_uart_get_fallback_speed(data->stats.baud_rate);
+    }
+    data->stats.data_rate = 0;
+
+    // A trigger is only valid for the device it was set up for.
+    pbio_iodev_clear_trigger(&data->iodev);
 
     // Turn off battery supply to this port
     if (data->motor_driver) {
@@ -975,6 +1099,7 @@ static PT_THREAD(pbio_uartdev_receive_data(uartdev_port_data_t * data)) {
         data->rx_msg_size = ev3_uart_get_msg_size(data->rx_msg[0]);
         if (data->rx_msg_size < 3 || data->rx_msg_size > EV3_UART_MAX_MESSAGE_SIZE) {
             DBG_ERR(data->last_err = "Bad data message size");
+            data->stats.framing_errors++;
             continue;
         }
 
@@ -983,6 +1108,7 @@ static PT_THREAD(pbio_uartdev_receive_data(uartdev_port_data_t * data)) {
         if (msg_type != LUMP_MSG_TYPE_DATA && (msg_type != LUMP_MSG_TYPE_CMD ||
                                                (cmd != LUMP_CMD_WRITE && cmd != LUMP_CMD_EXT_MODE))) {
             DBG_ERR(data->last_err = "Bad msg type");
+            data->stats.framing_errors++;
             continue;
         }
 
@@ -1017,6 +1143,8 @@ static pbio_error_t ev3_uart_set_mode_begin(pbio_iodev_t *iodev, uint8_t mode) {
 
     port_data->new_mode = mode;
     port_data->mode_change_tx_done = false;
+    port_data->mode_change_start = pbdrv_clock_get_ms();
+    port_data->mode_change_pending = true;
 
     return PBIO_SUCCESS;
 }
@@ -1100,6 +1228,36 @@ static const pbio_iodev_ops_t pbio_uartdev_ops = {
     .write_cancel = ev3_uart_write_cancel,
 };
 
+/**
+ * Gets the communication statistics of a UART device.
+ * @param [in]  iodev       The I/O device.
+ * @param [out] stats       The statistics.
+ * @return                  ::PBIO_SUCCESS on success or
+ *                          ::PBIO_ERROR_NOT_SUPPORTED if @p iodev is not a UART device.
+ */
+pbio_error_t pbio_uartdev_get_stats(pbio_iodev_t *iodev, pbio_uartdev_stats_t *stats) {
+    if (iodev->ops != &pbio_uartdev_ops) {
+        return PBIO_ERROR_NOT_SUPPORTED;
+    }
+
+    uartdev_port_data_t *port_data = PBIO_CONTAINER_OF(iodev, uartdev_port_data_t, iodev);
+    *stats = port_data->stats;
+
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Disables the triggers of all UART devices.
+ *
+ * Triggers may act on other devices via their callback, so this must be called
+ * when the user program ends.
+ */
+void pbio_uartdev_clear_triggers(void) {
+    for (int i = 0; i < PBIO_CONFIG_UARTDEV_NUM_DEV; i++) {
+        pbio_iodev_clear_trigger(&dev_data[i].iodev);
+    }
+}
+
 static PT_THREAD(pbio_uartdev_init(struct pt *pt, uint8_t id)) {
     const pbio_uartdev_platform_data_t *pdata = &pbio_uartdev_platform_data[id];
     uartdev_port_data_t *port_data = &dev_data[id];
@@ -1114,6 +1272,7 @@ static PT_THREAD(pbio_uartdev_init(struct pt *pt, uint8_t id)) {
     port_data->info = &infos[id].info;
     port_data->tx_msg = &bufs[id][BUF_TX_MSG][0];
     port_data->rx_msg = &bufs[id][BUF_RX_MSG][0];
+    port_data->max_baud_rate = EV3_UART_SPEED_MAX;
 
     PT_END(pt);
 }
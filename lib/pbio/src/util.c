@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <pbio/util.h>
+
 /**
  * Compares two 128-bit UUIDs with opposite byte ordering for equality.
  *
@@ -51,3 +53,102 @@ bool pbio_oneshot(bool value, bool *state) {
 
     return ret;
 }
+
+/**
+ * Computes the CRC-32 of a buffer, using the same polynomial and conventions
+ * as zlib.
+ *
+ * This is done one bit at a time instead of using a lookup table to keep the
+ * code size small.
+ *
+ * @param [in]  data    The data.
+ * @param [in]  size    The size of @p data in bytes.
+ * @return              The CRC-32.
+ */
+uint32_t pbio_crc32(const uint8_t *data, uint32_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (uint32_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+
+    return ~crc;
+}
+
+/**
+ * Decompresses data in the LZ4 block format (not the LZ4 frame format).
+ *
+ * @param [in]  src         The compressed data.
+ * @param [in]  src_size    The size of @p src in bytes.
+ * @param [out] dst         Buffer for the decompressed data.
+ * @param [in]  dst_size    The expected size of the decompressed data.
+ * @return                  True if @p src decompressed to exactly @p dst_size
+ *                          bytes, false if it was malformed.
+ */
+bool pbio_lz4_decompress(const uint8_t *src, uint32_t src_size, uint8_t *dst, uint32_t dst_size) {
+    const uint8_t *src_end = src + src_size;
+    uint8_t *dst_start = dst;
+    uint8_t *dst_end = dst + dst_size;
+
+    while (src < src_end) {
+        uint8_t token = *src++;
+
+        // Copy literals.
+        uint32_t len = token >> 4;
+        if (len == 15) {
+            uint8_t b;
+            do {
+                if (src == src_end) {
+                    return false;
+                }
+                b = *src++;
+                len += b;
+            } while (b == 255);
+        }
+        if (len > (uint32_t)(src_end - src) || len > (uint32_t)(dst_end - dst)) {
+            return false;
+        }
+        while (len--) {
+            *dst++ = *src++;
+        }
+
+        // The last sequence only has literals.
+        if (src == src_end) {
+            break;
+        }
+
+        // Copy match from already decompressed data.
+        if (src_end - src < 2) {
+            return false;
+        }
+        uint32_t offset = pbio_get_uint16_le(src);
+        src += 2;
+        if (offset == 0 || offset > (uint32_t)(dst - dst_start)) {
+            return false;
+        }
+        len = (token & 0x0F) + 4;
+        if ((token & 0x0F) == 15) {
+            uint8_t b;
+            do {
+                if (src == src_end) {
+                    return false;
+                }
+                b = *src++;
+                len += b;
+            } while (b == 255);
+        }
+        if (len > (uint32_t)(dst_end - dst)) {
+            return false;
+        }
+        // Byte by byte since the match may overlap the output.
+        const uint8_t *match = dst - offset;
+        while (len--) {
+            *dst++ = *match++;
+        }
+    }
+
+    return dst == dst_end;
+}
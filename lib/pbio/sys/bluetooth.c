@@ -16,43 +16,100 @@
 #include <lwrb/lwrb.h>
 
 #include <pbdrv/bluetooth.h>
+#include <pbdrv/clock.h>
 #include <pbio/error.h>
 #include <pbio/event.h>
+#include <pbio/int_math.h>
 #include <pbio/protocol.h>
 #include <pbio/util.h>
 #include <pbsys/bluetooth.h>
 #include <pbsys/command.h>
 #include <pbsys/status.h>
 
-// REVISIT: this can be the negotiated MTU - 3 to allow for better throughput
-// max data size for Nordic UART characteristics
+// Data size for Nordic UART characteristics with the default MTU.
 #define NUS_CHAR_SIZE 20
 
+// Maximum data size of Nordic UART Tx notifications. Bigger notifications are
+// used when the negotiated MTU allows it.
+#ifndef PBSYS_CONFIG_BLUETOOTH_UART_TX_SIZE_MAX
+#define PBSYS_CONFIG_BLUETOOTH_UART_TX_SIZE_MAX NUS_CHAR_SIZE
+#endif
+
+// How long to hold back Nordic UART Tx data that does not fill a notification
+// yet, in milliseconds, so that data written in small pieces is sent in fewer
+// notifications. Zero sends data as soon as possible.
+#ifndef PBSYS_CONFIG_BLUETOOTH_UART_TX_COALESCE_TIME
+#define PBSYS_CONFIG_BLUETOOTH_UART_TX_COALESCE_TIME (0)
+#endif
+
+// Size of the buffer for telemetry records waiting to be sent as Pybricks
+// events. Each record takes one extra byte for its size.
+#ifndef PBSYS_CONFIG_BLUETOOTH_TELEMETRY_BUF_SIZE
+#define PBSYS_CONFIG_BLUETOOTH_TELEMETRY_BUF_SIZE (256)
+#endif
+
+// Time over which the UART Tx data rate is measured, in milliseconds.
+#define UART_TX_RATE_WINDOW (1000)
+
+// When (1), data on the Nordic UART service goes to and comes from the SIO
+// port (tSIOAsyncPortPybricksBluetooth) instead of pbsys_bluetooth_rx() and
+// pbsys_bluetooth_tx().
+#ifndef PBSYS_CONFIG_BLUETOOTH_UART_SIO
+#define PBSYS_CONFIG_BLUETOOTH_UART_SIO (0)
+#endif
+
+// Size of the buffer for data received on the Nordic UART Rx characteristic
+// before it is read or handed to the SIO port.
+#ifndef PBSYS_CONFIG_BLUETOOTH_UART_RX_BUF_SIZE
+#define PBSYS_CONFIG_BLUETOOTH_UART_RX_BUF_SIZE (PBIO_PYBRICKS_PROTOCOL_DOWNLOAD_CHUNK_SIZE + 1)
+#endif
+
 // Nordic UART Rx hook
 static pbsys_bluetooth_stdin_event_callback_t uart_rx_callback;
 // ring buffers for UART service
+#if !PBSYS_CONFIG_BLUETOOTH_UART_SIO
 static lwrb_t uart_tx_ring;
+#endif
 static lwrb_t uart_rx_ring;
+// ring buffer for telemetry records
+static lwrb_t telemetry_ring;
 
 typedef struct {
     list_t queue;
     pbdrv_bluetooth_send_context_t context;
     bool is_queued;
-    uint8_t payload[NUS_CHAR_SIZE];
+    uint8_t payload[PBSYS_CONFIG_BLUETOOTH_UART_TX_SIZE_MAX];
 } send_msg_t;
 
 LIST(send_queue);
-static bool send_busy;
+// The message that the driver is sending or NULL. Only one is handed to the
+// driver at a time.
+static send_msg_t *send_busy_msg;
+
+static pbsys_bluetooth_tx_stats_t uart_tx_stats;
+static uint32_t uart_tx_rate_start;
+static uint32_t uart_tx_rate_bytes;
+
+#if PBSYS_CONFIG_BLUETOOTH_UART_TX_COALESCE_TIME
+static struct etimer uart_tx_coalesce_timer;
+static bool uart_tx_coalescing;
+#endif
 
 PROCESS(pbsys_bluetooth_process, "Bluetooth");
 
 /** Initializes Bluetooth. */
 void pbsys_bluetooth_init(void) {
-    static uint8_t uart_tx_buf[NUS_CHAR_SIZE * 2 + 1];
-    static uint8_t uart_rx_buf[PBIO_PYBRICKS_PROTOCOL_DOWNLOAD_CHUNK_SIZE + 1];
+    #if !PBSYS_CONFIG_BLUETOOTH_UART_SIO
+    static uint8_t uart_tx_buf[PBSYS_CONFIG_BLUETOOTH_UART_TX_SIZE_MAX * 2 + 1];
+    #endif
+    static uint8_t uart_rx_buf[PBSYS_CONFIG_BLUETOOTH_UART_RX_BUF_SIZE];
+    static uint8_t telemetry_buf[PBSYS_CONFIG_BLUETOOTH_TELEMETRY_BUF_SIZE];
 
+    #if !PBSYS_CONFIG_BLUETOOTH_UART_SIO
     lwrb_init(&uart_tx_ring, uart_tx_buf, PBIO_ARRAY_SIZE(uart_tx_buf));
+    #endif
     lwrb_init(&uart_rx_ring, uart_rx_buf, PBIO_ARRAY_SIZE(uart_rx_buf));
+    lwrb_init(&telemetry_ring, telemetry_buf, PBIO_ARRAY_SIZE(telemetry_buf));
     process_start(&pbsys_bluetooth_process);
 }
 
@@ -74,7 +131,12 @@ void pbsys_bluetooth_rx_set_callback(pbsys_bluetooth_stdin_event_callback_t call
  * @return              The number of bytes.
  */
 uint32_t pbsys_bluetooth_rx_get_available(void) {
+    #if PBSYS_CONFIG_BLUETOOTH_UART_SIO
+    // The SIO port is the only reader.
+    return 0;
+    #else
     return lwrb_get_full(&uart_rx_ring);
+    #endif
 }
 
 /**
@@ -87,9 +149,14 @@ uint32_t pbsys_bluetooth_rx_get_available(void) {
  *                          if @p data could not be read at this time (i.e. buffer
  *                          is empty), ::PBIO_ERROR_INVALID_OP if there is not an
  *                          active Bluetooth connection or ::PBIO_ERROR_NOT_SUPPORTED
- *                          if this platform does not support Bluetooth.
+ *                          if this platform does not support Bluetooth or
+ *                          if received data goes to the SIO port.
  */
 pbio_error_t pbsys_bluetooth_rx(uint8_t *data, uint32_t *size) {
+    #if PBSYS_CONFIG_BLUETOOTH_UART_SIO
+    // The SIO port is the only reader.
+    return PBIO_ERROR_NOT_SUPPORTED;
+    #else
     // make sure we have a Bluetooth connection
     if (!pbdrv_bluetooth_is_connected(PBDRV_BLUETOOTH_CONNECTION_UART)) {
         return PBIO_ERROR_INVALID_OP;
@@ -100,6 +167,7 @@ pbio_error_t pbsys_bluetooth_rx(uint8_t *data, uint32_t *size) {
     }
 
     return PBIO_SUCCESS;
+    #endif
 }
 
 /**
@@ -120,10 +188,14 @@ static send_msg_t uart_msg;
  *                          if @p data could not be queued at this time (e.g. buffer
  *                          is full), ::PBIO_ERROR_INVALID_OP if there is not an
  *                          active Bluetooth connection or ::PBIO_ERROR_NOT_SUPPORTED
- *                          if this platform does not support Bluetooth.
+ *                          if this platform does not support Bluetooth or
+ *                          if sent data comes from the SIO port.
  */
 pbio_error_t pbsys_bluetooth_tx(const uint8_t *data, uint32_t *size) {
-
+    #if PBSYS_CONFIG_BLUETOOTH_UART_SIO
+    // The SIO port is the only writer.
+    return PBIO_ERROR_NOT_SUPPORTED;
+    #else
     // make sure we have a Bluetooth connection
     if (!pbdrv_bluetooth_is_connected(PBDRV_BLUETOOTH_CONNECTION_UART)) {
         return PBIO_ERROR_INVALID_OP;
@@ -149,6 +221,39 @@ pbio_error_t pbsys_bluetooth_tx(const uint8_t *data, uint32_t *size) {
     process_poll(&pbsys_bluetooth_process);
 
     return PBIO_SUCCESS;
+    #endif
+}
+
+/**
+ * Gets the number of bytes waiting to be sent on the UART Tx characteristic.
+ * @return              The number of bytes.
+ */
+static uint32_t uart_tx_get_pending(void) {
+    #if PBSYS_CONFIG_BLUETOOTH_UART_SIO
+    return tSIOAsyncPortPybricksBluetooth_eSIOCBR_sizeSend();
+    #else
+    return lwrb_get_full(&uart_tx_ring);
+    #endif
+}
+
+/**
+ * Takes data to be sent on the UART Tx characteristic.
+ * @param data  [out]       Buffer for the data.
+ * @param size  [in]        The size of @p data in bytes.
+ * @return                  The number of bytes taken.
+ */
+static uint32_t uart_tx_read(uint8_t *data, uint32_t size) {
+    #if PBSYS_CONFIG_BLUETOOTH_UART_SIO
+    uint32_t i;
+    for (i = 0; i < size; i++) {
+        if (tSIOAsyncPortPybricksBluetooth_eSIOCBR_popSend((char *)&data[i]) < 1) {
+            break;
+        }
+    }
+    return i;
+    #else
+    return lwrb_read(&uart_tx_ring, data, size);
+    #endif
 }
 
 /**
@@ -163,25 +268,77 @@ bool pbsys_bluetooth_tx_is_idle(void) {
         return true;
     }
 
-    return !send_busy && lwrb_get_full(&uart_tx_ring) == 0;
+    return !send_busy_msg && uart_tx_get_pending() == 0;
 }
 
+#if PBSYS_CONFIG_BLUETOOTH_UART_SIO
+/**
+ * Tells that the SIO port has new data to be sent.
+ */
+void pb_bluetooth_uart_put_notify(void) {
+    // only allow one UART Tx message in the queue at a time
+    if (!uart_msg.is_queued) {
+        // Setting data and size are deferred until we actually send the message.
+        // This way, if the caller is only writing one byte at a time, we can
+        // still buffer data to send it more efficiently.
+        uart_msg.context.connection = PBDRV_BLUETOOTH_CONNECTION_UART;
+
+        list_add(send_queue, &uart_msg);
+        uart_msg.is_queued = true;
+    }
 
-void
-pb_bluetooth_uart_put_notify(void)
-{
-  // only allow one UART Tx message in the queue at a time
-  if (!uart_msg.is_queued) {
-      // Setting data and size are deferred until we actually send the message.
-      // This way, if the caller is only writing one byte at a time, we can
-      // still buffer data to send it more efficiently.
-      uart_msg.context.connection = PBDRV_BLUETOOTH_CONNECTION_UART;
-
-      uart_msg.is_queued = true;
-      list_add(send_queue, &uart_msg);
-      process_poll(&pbsys_bluetooth_process);
-  }
+    // poll even if already queued, since a message that is being held back
+    // for coalescing may now be full
+    process_poll(&pbsys_bluetooth_process);
 }
+#endif // PBSYS_CONFIG_BLUETOOTH_UART_SIO
+
+#if PBSYS_CONFIG_BLUETOOTH_UART_SIO
+/**
+ * Tells that the SIO port has room for received data again.
+ */
+void pb_bluetooth_uart_get_notify(void) {
+    // data that the SIO port refused is pushed again by the process
+    process_poll(&pbsys_bluetooth_process);
+}
+
+/**
+ * Pushes a block of received data to the SIO port.
+ *
+ * SIO ports that only implement the single byte push get this default
+ * implementation.
+ *
+ * @param [in]  src         The data.
+ * @param [in]  size        The size of @p src in bytes.
+ * @return                  The number of bytes accepted by the SIO port.
+ */
+__attribute__((weak)) uint32_t tSIOAsyncPortPybricksBluetooth_eSIOCBR_pushReceiveBuffer(const char *src, uint32_t size) {
+    extern int tSIOAsyncPortPybricksBluetooth_eSIOCBR_pushReceive(char src);
+
+    for (uint32_t i = 0; i < size; i++) {
+        if (tSIOAsyncPortPybricksBluetooth_eSIOCBR_pushReceive(src[i]) < 1) {
+            return i;
+        }
+    }
+    return size;
+}
+
+// Hands as much buffered Rx data as the SIO port will take, one contiguous
+// block of the ring buffer at a time. Anything left over stays buffered until
+// the next call.
+static void uart_rx_push(void) {
+    uint32_t size;
+
+    while ((size = lwrb_get_linear_block_read_length(&uart_rx_ring)) > 0) {
+        const char *src = lwrb_get_linear_block_read_address(&uart_rx_ring);
+        uint32_t pushed = tSIOAsyncPortPybricksBluetooth_eSIOCBR_pushReceiveBuffer(src, size);
+        lwrb_skip(&uart_rx_ring, pushed);
+        if (pushed < size) {
+            break;
+        }
+    }
+}
+#endif // PBSYS_CONFIG_BLUETOOTH_UART_SIO
 
 static pbio_pybricks_error_t handle_receive(pbdrv_bluetooth_connection_t connection, const uint8_t *data, uint32_t size) {
     if (connection == PBDRV_BLUETOOTH_CONNECTION_PYBRICKS) {
@@ -190,37 +347,24 @@ static pbio_pybricks_error_t handle_receive(pbdrv_bluetooth_connection_t connect
 
     if (connection == PBDRV_BLUETOOTH_CONNECTION_UART) {
         // This will drop data if buffer is full
-#if 0
         if (uart_rx_callback) {
-            // If there is a callback hook, we have to process things one byte at
-            // a time.
+            // If there is a callback hook, each byte has to be checked, but
+            // the bytes not consumed by the hook are still copied in blocks.
+            uint32_t start = 0;
             for (uint32_t i = 0; i < size; i++) {
-                if (!uart_rx_callback(data[i])) {
-                    lwrb_write(&uart_rx_ring, &data[i], 1);
+                if (uart_rx_callback(data[i])) {
+                    lwrb_write(&uart_rx_ring, &data[start], i - start);
+                    start = i + 1;
                 }
             }
+            lwrb_write(&uart_rx_ring, &data[start], size - start);
         } else {
             lwrb_write(&uart_rx_ring, data, size);
         }
-#endif
 
-#if 1
-        extern int tSIOAsyncPortPybricksBluetooth_eSIOCBR_pushReceive(char src);
-
-        if (uart_rx_callback) {
-            // If there is a callback hook, we have to process things one byte at
-            // a time.
-            for (uint32_t i = 0; i < size; i++) {
-                if (!uart_rx_callback(data[i])) {
-                    tSIOAsyncPortPybricksBluetooth_eSIOCBR_pushReceive(data[i]);
-                }
-            }
-        } else {
-            for (uint32_t i = 0; i < size; i++) {
-                tSIOAsyncPortPybricksBluetooth_eSIOCBR_pushReceive(data[i]);
-            }
-        }
-#endif
+        #if PBSYS_CONFIG_BLUETOOTH_UART_SIO
+        uart_rx_push();
+        #endif
 
         return PBIO_PYBRICKS_ERROR_OK;
     }
@@ -228,19 +372,129 @@ static pbio_pybricks_error_t handle_receive(pbdrv_bluetooth_connection_t connect
     return PBIO_PYBRICKS_ERROR_INVALID_HANDLE;
 }
 
+/**
+ * Gets how much data fits in one UART Tx notification on this connection.
+ * @return              The size in bytes.
+ */
+static uint32_t uart_tx_get_packet_size(void) {
+    return pbio_int_math_bind(pbdrv_bluetooth_get_mtu() - 3, NUS_CHAR_SIZE, PBSYS_CONFIG_BLUETOOTH_UART_TX_SIZE_MAX);
+}
+
+/**
+ * Tests if the UART Tx message should be sent now.
+ *
+ * Data that fills a whole notification is always sent right away. Anything
+ * less is held back until more data arrives or the coalescing time expires.
+ *
+ * @return              @c true if the message should be sent.
+ */
+static bool uart_tx_is_ready(void) {
+    #if PBSYS_CONFIG_BLUETOOTH_UART_TX_COALESCE_TIME
+    if (uart_tx_get_pending() >= uart_tx_get_packet_size()) {
+        return true;
+    }
+
+    if (!uart_tx_coalescing) {
+        uart_tx_coalescing = true;
+        etimer_set(&uart_tx_coalesce_timer, PBSYS_CONFIG_BLUETOOTH_UART_TX_COALESCE_TIME);
+        return false;
+    }
+
+    return etimer_expired(&uart_tx_coalesce_timer);
+    #else
+    return true;
+    #endif
+}
+
+/**
+ * Updates the UART Tx statistics.
+ * @param size  [in]        The number of bytes just sent.
+ */
+static void uart_tx_update_stats(uint32_t size) {
+    uint32_t now = pbdrv_clock_get_ms();
+
+    uart_tx_stats.bytes += size;
+    uart_tx_rate_bytes += size;
+
+    if (now - uart_tx_rate_start >= UART_TX_RATE_WINDOW) {
+        uart_tx_stats.rate = uart_tx_rate_bytes * 1000 / (now - uart_tx_rate_start);
+        uart_tx_rate_start = now;
+        uart_tx_rate_bytes = 0;
+    }
+}
+
+/**
+ * Gets statistics about data sent on the UART Tx characteristic since the
+ * current connection was made.
+ * @param stats [out]       The statistics.
+ */
+void pbsys_bluetooth_tx_get_stats(pbsys_bluetooth_tx_stats_t *stats) {
+    // Bring the rate up to date in case nothing was sent for a while.
+    uart_tx_update_stats(0);
+    *stats = uart_tx_stats;
+}
+
+static send_msg_t telemetry_msg;
+/**
+ * Queues a binary telemetry record to be sent via the Pybricks service.
+ *
+ * Each record is sent whole in a single ::PBIO_PYBRICKS_EVENT_WRITE_TELEMETRY
+ * event.
+ *
+ * @param data  [in]        The record.
+ * @param size  [in]        The size of @p data in bytes.
+ * @return                  ::PBIO_SUCCESS if @p data was queued, ::PBIO_ERROR_AGAIN
+ *                          if @p data could not be queued at this time (buffer
+ *                          is full), ::PBIO_ERROR_INVALID_ARG if @p data is empty
+ *                          or does not fit in one notification, ::PBIO_ERROR_INVALID_OP
+ *                          if there is not an active Bluetooth connection or
+ *                          ::PBIO_ERROR_NOT_SUPPORTED if this platform does not
+ *                          support Bluetooth.
+ */
+pbio_error_t pbsys_bluetooth_send_telemetry(const uint8_t *data, uint32_t size) {
+    if (!pbdrv_bluetooth_is_connected(PBDRV_BLUETOOTH_CONNECTION_PYBRICKS)) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    // One byte of the notification is used for the event type.
+    if (size == 0 || size > uart_tx_get_packet_size() - 1) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    // Records are only queued whole.
+    if (lwrb_get_free(&telemetry_ring) < size + 1) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    uint8_t header = size;
+    lwrb_write(&telemetry_ring, &header, sizeof(header));
+    lwrb_write(&telemetry_ring, data, size);
+
+    if (!telemetry_msg.is_queued) {
+        telemetry_msg.context.connection = PBDRV_BLUETOOTH_CONNECTION_PYBRICKS;
+        list_add(send_queue, &telemetry_msg);
+        telemetry_msg.is_queued = true;
+    }
+
+    process_poll(&pbsys_bluetooth_process);
+
+    return PBIO_SUCCESS;
+}
+
 static void send_done(void) {
-    send_msg_t *msg = list_pop(send_queue);
-    
-    extern int tSIOAsyncPortPybricksBluetooth_eSIOCBR_sizeSend(void);
-    if (msg->context.connection == PBDRV_BLUETOOTH_CONNECTION_UART \
-        && tSIOAsyncPortPybricksBluetooth_eSIOCBR_sizeSend()) {
+    // This is not always the head of the queue, see get_next_msg().
+    send_msg_t *msg = send_busy_msg;
+    list_remove(send_queue, msg);
+
+    if ((msg == &uart_msg && uart_tx_get_pending())
+        || (msg == &telemetry_msg && lwrb_get_full(&telemetry_ring))) {
         // If there is more buffered data to send, put the message back in the queue
         list_add(send_queue, msg);
     } else {
         msg->is_queued = false;
     }
 
-    send_busy = false;
+    send_busy_msg = NULL;
     process_poll(&pbsys_bluetooth_process);
 }
 
@@ -252,10 +506,42 @@ static void reset_all(void) {
         msg->is_queued = false;
     }
 
-    send_busy = false;
+    send_busy_msg = NULL;
 
     lwrb_reset(&uart_rx_ring);
+    #if !PBSYS_CONFIG_BLUETOOTH_UART_SIO
     lwrb_reset(&uart_tx_ring);
+    #endif
+    lwrb_reset(&telemetry_ring);
+
+    uart_tx_stats = (pbsys_bluetooth_tx_stats_t) { 0 };
+    uart_tx_rate_start = pbdrv_clock_get_ms();
+    uart_tx_rate_bytes = 0;
+
+    #if PBSYS_CONFIG_BLUETOOTH_UART_TX_COALESCE_TIME
+    etimer_stop(&uart_tx_coalesce_timer);
+    uart_tx_coalescing = false;
+    #endif
+}
+
+/**
+ * Gets the next message that should be sent.
+ *
+ * UART data that is held back for coalescing stays in the queue while the
+ * messages behind it are sent.
+ *
+ * @return              The message or NULL if there is none.
+ */
+static send_msg_t *get_next_msg(void) {
+    for (send_msg_t *msg = list_head(send_queue); msg; msg = list_item_next(msg)) {
+        if (msg == &uart_msg && !uart_tx_is_ready()) {
+            // Wait for more data or the coalescing timer.
+            continue;
+        }
+        return msg;
+    }
+
+    return NULL;
 }
 
 static PT_THREAD(pbsys_bluetooth_monitor_status(struct pt *pt)) {
@@ -373,36 +659,36 @@ PROCESS_THREAD(pbsys_bluetooth_process, ev, data) {
                 PT_INIT(&status_monitor_pt);
             }
 
-            if (!send_busy) {
+            #if PBSYS_CONFIG_BLUETOOTH_UART_SIO
+            // retry data the SIO port could not take the last time, after it
+            // called pb_bluetooth_uart_get_notify() or on any other event
+            uart_rx_push();
+            #endif
+
+            if (!send_busy_msg) {
                 // msg is removed from queue in send_done callback rather than here
-                send_msg_t *msg = list_head(send_queue);
+                send_msg_t *msg = get_next_msg();
                 if (msg) {
                     msg->context.done = send_done;
-                    if (msg->context.connection == PBDRV_BLUETOOTH_CONNECTION_UART) {
-#if 0
-                        msg->context.size = lwrb_read(&uart_tx_ring, &msg->payload[0], PBIO_ARRAY_SIZE(msg->payload));
-#endif
-#if 1
-                        // TODO: msg->context.done = send_done
-                        extern int tSIOAsyncPortPybricksBluetooth_eSIOCBR_popSend(char *dst);
-                        msg->context.size = 0;
-                        for (uint32_t i = 0; i < PBIO_ARRAY_SIZE(msg->payload); i++) {
-                            if (tSIOAsyncPortPybricksBluetooth_eSIOCBR_popSend((char *)&msg->payload[i]) < 1) {
-                              break;
-                            }
-                            msg->context.size++;
-                        }
-#endif
-#if 0
-                        // TODO: msg->context.done = send_done
-                        extern int tSIOAsyncPortPybricksBluetooth_eSIOCBR_popSend(char *dst_data, uint32_t size);
-	                      msg->context.size = tSIOAsyncPortPybricksBluetooth_eSIOCBR_popSend(
-                            (char *)&msg->payload[0], PBIO_ARRAY_SIZE(msg->payload));
-#endif
+                    if (msg == &uart_msg) {
+                        msg->context.size = uart_tx_read(&msg->payload[0], uart_tx_get_packet_size());
                         assert(msg->context.size > 0);
+
+                        uart_tx_stats.notifications++;
+                        uart_tx_update_stats(msg->context.size);
+
+                        #if PBSYS_CONFIG_BLUETOOTH_UART_TX_COALESCE_TIME
+                        etimer_stop(&uart_tx_coalesce_timer);
+                        uart_tx_coalescing = false;
+                        #endif
+                    } else if (msg == &telemetry_msg) {
+                        uint8_t size;
+                        lwrb_read(&telemetry_ring, &size, sizeof(size));
+                        msg->payload[0] = PBIO_PYBRICKS_EVENT_WRITE_TELEMETRY;
+                        msg->context.size = 1 + lwrb_read(&telemetry_ring, &msg->payload[1], size);
                     }
                     msg->context.data = &msg->payload[0];
-                    send_busy = true;
+                    send_busy_msg = msg;
                     pbdrv_bluetooth_send(&msg->context);
                 }
             }
@@ -10,6 +10,20 @@
 #include "program_load.h"
 #include "program_stop.h"
 
+/**
+ * Converts the result of comparing data to a checksum.
+ *
+ * @param [in]  error   The ::pbio_error_t, ::PBIO_ERROR_FAILED on a mismatch.
+ * @returns             ::PBIO_PYBRICKS_ERROR_VERIFY_FAILED on a mismatch,
+ *                      otherwise the usual ::pbio_pybricks_error_t.
+ */
+static pbio_pybricks_error_t pbsys_command_checksum_error(pbio_error_t error) {
+    if (error == PBIO_ERROR_FAILED) {
+        return PBIO_PYBRICKS_ERROR_VERIFY_FAILED;
+    }
+    return pbio_pybricks_error_from_pbio_error(error);
+}
+
 /**
  * Parses binary data for command and dispatches handler for command.
  * @param [in]  data    The raw command data.
@@ -35,6 +49,18 @@ pbio_pybricks_error_t pbsys_command(const uint8_t *data, uint32_t size) {
         case PBIO_PYBRICKS_COMMAND_WRITE_USER_RAM:
             return pbio_pybricks_error_from_pbio_error(pbsys_program_load_set_program_data(
                 pbio_get_uint32_le(&data[1]), &data[5], size - 5));
+        case PBIO_PYBRICKS_COMMAND_VERIFY_USER_PROGRAM:
+            if (size != 5) {
+                return PBIO_PYBRICKS_ERROR_VALUE_NOT_ALLOWED;
+            }
+            return pbsys_command_checksum_error(pbsys_program_load_verify_program(
+                pbio_get_uint32_le(&data[1])));
+        case PBIO_PYBRICKS_COMMAND_COMPARE_USER_RAM:
+            if (size != 13) {
+                return PBIO_PYBRICKS_ERROR_VALUE_NOT_ALLOWED;
+            }
+            return pbsys_command_checksum_error(pbsys_program_load_compare_program_data(
+                pbio_get_uint32_le(&data[1]), pbio_get_uint32_le(&data[5]), pbio_get_uint32_le(&data[9])));
         case PBIO_PYBRICKS_COMMAND_REBOOT_TO_UPDATE_MODE:
             pbdrv_reset(PBDRV_RESET_ACTION_RESET_IN_UPDATE_MODE);
             return PBIO_PYBRICKS_ERROR_OK;
@@ -14,6 +14,7 @@
 #include <pbdrv/block_device.h>
 #include <pbio/main.h>
 #include <pbio/protocol.h>
+#include <pbio/util.h>
 #include <pbsys/main.h>
 #include <pbsys/program_load.h>
 #include <pbsys/status.h>
@@ -82,6 +83,54 @@ pbio_error_t pbsys_program_load_get_user_data(uint32_t offset, uint8_t **data, u
     return PBIO_SUCCESS;
 }
 
+#if PBSYS_CONFIG_SETTINGS
+
+// The settings copies each have an erase sector of their own, which costs
+// three sectors of program space. Catch changes that would make this more.
+_Static_assert(sizeof(pbsys_program_load_data_header_t) == 3 * PBSYS_CONFIG_SETTINGS_ALIGN,
+    "header with settings must take exactly three sectors");
+
+/**
+ * Gets one of the two copies of the settings area of the data map.
+ *
+ * @param [in]  copy        Which copy, 0 or 1.
+ * @returns                 Pointer to ::PBSYS_CONFIG_SETTINGS_SIZE bytes.
+ */
+uint8_t *pbsys_program_load_get_settings(uint32_t copy) {
+    return map->header.settings[copy].data;
+}
+
+/**
+ * Requests that the settings area is saved on poweroff, like user data.
+ */
+void pbsys_program_load_settings_changed(void) {
+    update_write_size();
+}
+
+/**
+ * Converts data saved by firmware without settings, which has the program
+ * data where the settings are now. The program is moved to where it belongs
+ * now, or discarded if it no longer fits, and the settings start empty.
+ */
+static void pbsys_program_load_upgrade_layout(void) {
+    if (map->header.layout == PBSYS_PROGRAM_LOAD_LAYOUT_SETTINGS) {
+        return;
+    }
+
+    if (map->header.program_size > PBSYS_PROGRAM_LOAD_MAX_PROGRAM_SIZE) {
+        map->header.program_size = 0;
+    }
+    memmove(map->program_data, &map->header.layout, map->header.program_size);
+
+    memset(map->header.settings, 0, sizeof(map->header.settings));
+    map->header.layout = PBSYS_PROGRAM_LOAD_LAYOUT_SETTINGS;
+
+    // Save the new layout, even if nothing else changes.
+    update_write_size();
+}
+
+#endif // PBSYS_CONFIG_SETTINGS
+
 static bool pbsys_program_load_start_user_program_requested;
 static bool pbsys_program_load_start_repl_requested;
 
@@ -169,6 +218,64 @@ pbio_error_t pbsys_program_load_set_program_data(uint32_t offset, const void *da
     return PBIO_SUCCESS;
 }
 
+/**
+ * Verifies the user program in user RAM.
+ *
+ * Since program data may be written without response, this is how the host
+ * finds out that all of it arrived intact. The program is discarded if not.
+ *
+ * @param [in]  checksum    The expected CRC-32 of the user program.
+ *
+ * @returns                 ::PBIO_ERROR_BUSY if the user program is running.
+ *                          ::PBIO_ERROR_INVALID_ARG if the program size is invalid.
+ *                          ::PBIO_ERROR_FAILED if the checksum does not match.
+ *                          Otherwise ::PBIO_SUCCESS.
+ */
+pbio_error_t pbsys_program_load_verify_program(uint32_t checksum) {
+    if (pbsys_status_test(PBIO_PYBRICKS_STATUS_USER_PROGRAM_RUNNING)) {
+        return PBIO_ERROR_BUSY;
+    }
+
+    if (map->header.program_size > PBSYS_PROGRAM_LOAD_MAX_PROGRAM_SIZE) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    if (pbio_crc32(map->program_data, map->header.program_size) != checksum) {
+        map->header.program_size = 0;
+        update_write_size();
+        return PBIO_ERROR_FAILED;
+    }
+
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Compares data in user RAM to a checksum.
+ *
+ * This is used to skip sending modules that did not change since the last
+ * download.
+ *
+ * @param [in]  offset      The offset in bytes from the base user RAM address.
+ * @param [in]  size        The size of the data to compare.
+ * @param [in]  checksum    The expected CRC-32 of the data.
+ *
+ * @returns                 ::PBIO_ERROR_INVALID_ARG if requested @p offset and
+ *                          @p size are outside of the allocated user RAM.
+ *                          ::PBIO_ERROR_FAILED if the checksum does not match.
+ *                          Otherwise ::PBIO_SUCCESS.
+ */
+pbio_error_t pbsys_program_load_compare_program_data(uint32_t offset, uint32_t size, uint32_t checksum) {
+    if (offset > sizeof(map->program_data) || size > sizeof(map->program_data) - offset) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    if (pbio_crc32(map->program_data + offset, size) != checksum) {
+        return PBIO_ERROR_FAILED;
+    }
+
+    return PBIO_SUCCESS;
+}
+
 /**
  * Requests to start the user program.
  *
@@ -250,6 +357,11 @@ PROCESS_THREAD(pbsys_program_load_process, ev, data) {
     // Reset write size, so we don't write data if nothing changed.
     map->header.write_size = 0;
 
+    #if PBSYS_CONFIG_SETTINGS
+    // This sets the write size again if the layout was upgraded.
+    pbsys_program_load_upgrade_layout();
+    #endif
+
     // Initialization done.
     pbsys_init_busy_down();
 
@@ -273,6 +385,44 @@ PROCESS_THREAD(pbsys_program_load_process, ev, data) {
     PROCESS_END();
 }
 
+#if PBSYS_CONFIG_PROGRAM_LOAD_COMPRESSION
+
+// Header of a compressed program: magic followed by the uncompressed size.
+#define COMPRESSED_MAGIC "LZ4B"
+#define COMPRESSED_HEADER_SIZE (8)
+
+/**
+ * Decompresses the user program if it was stored compressed.
+ *
+ * The program is decompressed right after the compressed data, so that the
+ * compressed data stays in place to be saved on shutdown. Only the rest of
+ * the RAM is left for the heap.
+ *
+ * @param [in, out] program     Program info structure to be updated.
+ */
+static void pbsys_program_load_decompress(pbsys_main_program_t *program) {
+    uint32_t size = map->header.program_size;
+
+    if (size < COMPRESSED_HEADER_SIZE || memcmp(map->program_data, COMPRESSED_MAGIC, 4) != 0) {
+        return;
+    }
+
+    uint32_t decompressed_size = pbio_get_uint32_le(&map->program_data[4]);
+    uint8_t *dst = map->program_data + (size + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *);
+
+    if (decompressed_size > (uint32_t)((uint8_t *)program->data_end - dst)
+        || !pbio_lz4_decompress(&map->program_data[COMPRESSED_HEADER_SIZE], size - COMPRESSED_HEADER_SIZE, dst, decompressed_size)) {
+        // Leave an empty program rather than running corrupt data.
+        program->code_end = program->code_start;
+        return;
+    }
+
+    program->code_start = dst;
+    program->code_end = dst + decompressed_size;
+}
+
+#endif // PBSYS_CONFIG_PROGRAM_LOAD_COMPRESSION
+
 /**
  * Waits for a command to start a user program or REPL.
  *
@@ -312,6 +462,10 @@ pbio_error_t pbsys_program_load_wait_command(pbsys_main_program_t *program) {
     program->code_end = map->program_data + map->header.program_size;
     program->data_end = map->program_data + sizeof(map->program_data);
 
+    #if PBSYS_CONFIG_PROGRAM_LOAD_COMPRESSION
+    pbsys_program_load_decompress(program);
+    #endif
+
     return PBIO_SUCCESS;
 }
 
@@ -17,9 +17,10 @@ void pbsys_program_load_deinit(void);
 pbio_error_t pbsys_program_load_wait_command(pbsys_main_program_t *program);
 pbio_error_t pbsys_program_load_set_program_size(uint32_t size);
 pbio_error_t pbsys_program_load_set_program_data(uint32_t offset, const void *data, uint32_t size);
+pbio_error_t pbsys_program_load_verify_program(uint32_t checksum);
+pbio_error_t pbsys_program_load_compare_program_data(uint32_t offset, uint32_t size, uint32_t checksum);
 pbio_error_t pbsys_program_load_start_user_program(void);
 pbio_error_t pbsys_program_load_start_repl(void);
-
 #else
 static inline void pbsys_program_load_init(void) {
 }
@@ -34,6 +35,12 @@ static inline pbio_error_t pbsys_program_load_set_program_size(uint32_t size) {
 static inline pbio_error_t pbsys_program_load_set_program_data(uint32_t offset, const void *data, uint32_t size) {
     return PBIO_ERROR_NOT_SUPPORTED;
 }
+static inline pbio_error_t pbsys_program_load_verify_program(uint32_t checksum) {
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
+static inline pbio_error_t pbsys_program_load_compare_program_data(uint32_t offset, uint32_t size, uint32_t checksum) {
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
 static inline pbio_error_t pbsys_program_load_start_user_program(void) {
     return PBIO_ERROR_NOT_SUPPORTED;
 }
@@ -43,4 +50,9 @@ static inline pbio_error_t pbsys_program_load_start_repl(void) {
 
 #endif // PBSYS_CONFIG_PROGRAM_LOAD
 
+#if PBSYS_CONFIG_SETTINGS
+uint8_t *pbsys_program_load_get_settings(uint32_t copy);
+void pbsys_program_load_settings_changed(void);
+#endif
+
 #endif // _PBSYS_SYS_PROGRAM_LOAD_H_
@@ -0,0 +1,268 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include <pbsys/config.h>
+
+#if PBSYS_CONFIG_SETTINGS
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <pbio/error.h>
+#include <pbio/util.h>
+#include <pbsys/settings.h>
+
+#include "program_load.h"
+
+// Each copy of the settings area starts with a CRC-32 over the rest of the
+// used area, followed by the size of all records in bytes and a sequence
+// number that increases with each update.
+#define SETTINGS_CRC_OFFSET (0)
+#define SETTINGS_USED_OFFSET (4)
+#define SETTINGS_SEQUENCE_OFFSET (6)
+#define SETTINGS_HEADER_SIZE (8)
+
+// Each record has the key size, the little-endian value size, then the key
+// and value themselves.
+#define RECORD_HEADER_SIZE (3)
+
+#define SETTINGS_MAX_USED (PBSYS_CONFIG_SETTINGS_SIZE - SETTINGS_HEADER_SIZE)
+
+// Whether the settings areas loaded from storage have been validated.
+static bool settings_checked;
+
+// Which of the two copies holds the current settings.
+static uint32_t settings_current;
+
+static uint32_t settings_crc(const uint8_t *area, uint32_t used) {
+    return pbio_crc32(area + SETTINGS_USED_OFFSET, SETTINGS_HEADER_SIZE - SETTINGS_USED_OFFSET + used);
+}
+
+static uint32_t record_size(const uint8_t *record) {
+    return RECORD_HEADER_SIZE + record[0] + pbio_get_uint16_le(&record[1]);
+}
+
+static bool settings_is_valid(const uint8_t *area) {
+    uint32_t used = pbio_get_uint16_le(&area[SETTINGS_USED_OFFSET]);
+    if (used > SETTINGS_MAX_USED || settings_crc(area, used) != pbio_get_uint32_le(&area[SETTINGS_CRC_OFFSET])) {
+        return false;
+    }
+
+    // The records must add up to exactly the used size.
+    const uint8_t *records = area + SETTINGS_HEADER_SIZE;
+    uint32_t offset = 0;
+    while (offset + RECORD_HEADER_SIZE <= used) {
+        offset += record_size(&records[offset]);
+    }
+    return offset == used;
+}
+
+/**
+ * Finds the copy with the current settings.
+ *
+ * Settings are only changed in RAM and are saved on poweroff together with
+ * the rest of the user data. Each update goes to the other copy, so the
+ * copy from before the update is still intact if saving is interrupted. Of
+ * two valid copies, the one with the newer sequence number is used. If
+ * neither is valid, for example when the firmware was updated, the settings
+ * start empty.
+ */
+static void settings_check(void) {
+    const uint8_t *first = pbsys_program_load_get_settings(0);
+    const uint8_t *second = pbsys_program_load_get_settings(1);
+
+    bool first_valid = settings_is_valid(first);
+    bool second_valid = settings_is_valid(second);
+
+    if (first_valid && second_valid) {
+        // The sequence number wraps, so compare the difference.
+        uint16_t diff = pbio_get_uint16_le(&second[SETTINGS_SEQUENCE_OFFSET]) - pbio_get_uint16_le(&first[SETTINGS_SEQUENCE_OFFSET]);
+        settings_current = diff != 0 && diff < 0x8000;
+        return;
+    }
+
+    if (first_valid || second_valid) {
+        settings_current = second_valid;
+        return;
+    }
+
+    uint8_t *area = pbsys_program_load_get_settings(0);
+    memset(area, 0, SETTINGS_HEADER_SIZE);
+    pbio_set_uint32_le(&area[SETTINGS_CRC_OFFSET], settings_crc(area, 0));
+    settings_current = 0;
+}
+
+/**
+ * Gets the current settings.
+ *
+ * @param [out] used    The size of all records in bytes.
+ * @returns             The first record.
+ */
+static uint8_t *settings_get_area(uint32_t *used) {
+    if (!settings_checked) {
+        settings_checked = true;
+        settings_check();
+    }
+
+    uint8_t *area = pbsys_program_load_get_settings(settings_current);
+    *used = pbio_get_uint16_le(&area[SETTINGS_USED_OFFSET]);
+    return area + SETTINGS_HEADER_SIZE;
+}
+
+/**
+ * Starts an update by copying the current settings to the other copy.
+ *
+ * @param [in]  used    The size of all records in bytes.
+ * @returns             The first record of the copy to be updated.
+ */
+static uint8_t *settings_begin_update(uint32_t used) {
+    const uint8_t *area = pbsys_program_load_get_settings(settings_current);
+    uint8_t *update = pbsys_program_load_get_settings(!settings_current);
+    memcpy(update, area, SETTINGS_HEADER_SIZE + used);
+    return update + SETTINGS_HEADER_SIZE;
+}
+
+/**
+ * Finishes an update, making the updated copy current, and requests a write.
+ *
+ * @param [in]  used    The new size of all records in bytes.
+ */
+static void settings_commit(uint32_t used) {
+    uint8_t *update = pbsys_program_load_get_settings(!settings_current);
+    pbio_set_uint16_le(&update[SETTINGS_USED_OFFSET], used);
+    pbio_set_uint16_le(&update[SETTINGS_SEQUENCE_OFFSET], pbio_get_uint16_le(&update[SETTINGS_SEQUENCE_OFFSET]) + 1);
+    pbio_set_uint32_le(&update[SETTINGS_CRC_OFFSET], settings_crc(update, used));
+    settings_current = !settings_current;
+    pbsys_program_load_settings_changed();
+}
+
+/**
+ * Finds a record by key.
+ *
+ * @param [in]  records     The first record.
+ * @param [in]  used        The size of all records in bytes.
+ * @param [in]  key         The key.
+ * @param [in]  key_size    The size of @p key.
+ * @returns                 The record or NULL if not found.
+ */
+static uint8_t *settings_find(uint8_t *records, uint32_t used, const char *key, uint32_t key_size) {
+    for (uint32_t offset = 0; offset < used; offset += record_size(&records[offset])) {
+        uint8_t *record = &records[offset];
+        if (record[0] == key_size && memcmp(&record[RECORD_HEADER_SIZE], key, key_size) == 0) {
+            return record;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Gets a setting.
+ *
+ * @param [in]  key         The key.
+ * @param [in]  key_size    The size of @p key.
+ * @param [out] value       Pointer to the stored value. It is only valid until
+ *                          the next call to ::pbsys_settings_set or
+ *                          ::pbsys_settings_delete.
+ * @param [out] size        The size of @p value.
+ * @returns                 ::PBIO_ERROR_INVALID_ARG if there is no setting
+ *                          with this key. Otherwise ::PBIO_SUCCESS.
+ */
+pbio_error_t pbsys_settings_get(const char *key, uint32_t key_size, const uint8_t **value, uint32_t *size) {
+    uint32_t used;
+    uint8_t *records = settings_get_area(&used);
+
+    uint8_t *record = settings_find(records, used, key, key_size);
+    if (!record) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    *value = &record[RECORD_HEADER_SIZE + key_size];
+    *size = pbio_get_uint16_le(&record[1]);
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Sets a setting, replacing any existing value for the same key.
+ *
+ * Nothing is changed if the new value does not fit.
+ *
+ * @param [in]  key         The key.
+ * @param [in]  key_size    The size of @p key.
+ * @param [in]  value       The value to be stored (copied).
+ * @param [in]  size        The size of @p value.
+ * @returns                 ::PBIO_ERROR_INVALID_ARG if the key is empty or
+ *                          too long, or if the value does not fit.
+ *                          Otherwise ::PBIO_SUCCESS.
+ */
+pbio_error_t pbsys_settings_set(const char *key, uint32_t key_size, const uint8_t *value, uint32_t size) {
+    if (key_size == 0 || key_size > PBSYS_SETTINGS_MAX_KEY_SIZE) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    uint32_t used;
+    uint8_t *records = settings_get_area(&used);
+
+    uint8_t *record = settings_find(records, used, key, key_size);
+    uint32_t old_size = record ? record_size(record) : 0;
+    uint32_t new_size = RECORD_HEADER_SIZE + key_size + size;
+
+    if (size > SETTINGS_MAX_USED || used - old_size + new_size > SETTINGS_MAX_USED) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    // Update the other copy, so that this one stays intact.
+    uint8_t *update = settings_begin_update(used);
+    if (record) {
+        record = update + (record - records);
+    }
+    records = update;
+
+    // Remove the old record by moving the ones after it down.
+    if (record) {
+        uint8_t *next = record + old_size;
+        memmove(record, next, records + used - next);
+        used -= old_size;
+    }
+
+    // Append the new record.
+    record = records + used;
+    record[0] = key_size;
+    pbio_set_uint16_le(&record[1], size);
+    memcpy(&record[RECORD_HEADER_SIZE], key, key_size);
+    memcpy(&record[RECORD_HEADER_SIZE + key_size], value, size);
+
+    settings_commit(used + new_size);
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Deletes a setting.
+ *
+ * @param [in]  key         The key.
+ * @param [in]  key_size    The size of @p key.
+ * @returns                 ::PBIO_ERROR_INVALID_ARG if there is no setting
+ *                          with this key. Otherwise ::PBIO_SUCCESS.
+ */
+pbio_error_t pbsys_settings_delete(const char *key, uint32_t key_size) {
+    uint32_t used;
+    uint8_t *records = settings_get_area(&used);
+
+    uint8_t *record = settings_find(records, used, key, key_size);
+    if (!record) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    // Update the other copy, so that this one stays intact.
+    uint8_t *update = settings_begin_update(used);
+    record = update + (record - records);
+    records = update;
+
+    uint8_t *next = record + record_size(record);
+    memmove(record, next, records + used - next);
+
+    settings_commit(used - (next - record));
+    return PBIO_SUCCESS;
+}
+
+#endif // PBSYS_CONFIG_SETTINGS
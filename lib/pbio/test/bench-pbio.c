@@ -0,0 +1,212 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+// Benchmarks for the pbio control loop.
+//
+// Each benchmark is calibrated to run for at least PBIO_BENCH_MIN_TIME_NS,
+// then timed a few times to report the fastest time per operation. Other
+// processes only ever make a run slower, so this is the most repeatable.
+//
+// Wall time depends on the machine and on what else it is doing, so results
+// are only reported. Comparing with a baseline shows the change, but does
+// not fail the program.
+//
+// Environment variables:
+//
+//     PBIO_BENCH_SEED       Seed for the random input data (default 1).
+//     PBIO_BENCH_OUTPUT     File to write the results to.
+//     PBIO_BENCH_BASELINE   File with results of an earlier run to compare to.
+//
+// Result files have one "<name> <ns/op>" line per benchmark.
+//
+// See runner-pbio.c for selecting benchmarks on the command line.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench-pbio.h"
+
+// Minimum duration of one timed sample.
+#define PBIO_BENCH_MIN_TIME_NS (100 * 1000 * 1000)
+
+// Number of timed samples, of which the fastest is reported.
+#define PBIO_BENCH_NUM_SAMPLES (7)
+
+// Upper bound on the number of operations in one sample.
+#define PBIO_BENCH_MAX_ITERATIONS (1 << 30)
+
+volatile uint32_t pbio_bench_sink;
+
+static uint32_t seed;
+static FILE *baseline;
+static FILE *output;
+
+/**
+ * Starts or resumes the timer. Benchmarks call this after their setup.
+ *
+ * @param [in]  bench   The benchmark state.
+ */
+void pbio_bench_start(pbio_bench_t *bench) {
+    bench->start = pbio_runner_get_time_ns();
+}
+
+/**
+ * Pauses the timer, for work that should not be measured.
+ *
+ * @param [in]  bench   The benchmark state.
+ */
+void pbio_bench_stop(pbio_bench_t *bench) {
+    bench->elapsed += pbio_runner_get_time_ns() - bench->start;
+}
+
+/**
+ * Exits the program if setting up a benchmark failed, instead of timing
+ * something else than intended.
+ *
+ * @param [in]  err     Error code of the setup step.
+ * @param [in]  what    Description of the setup step.
+ */
+void pbio_bench_check(pbio_error_t err, const char *what) {
+    if (err != PBIO_SUCCESS) {
+        fprintf(stderr, "%s failed: %s\n", what, pbio_error_str(err));
+        exit(1);
+    }
+}
+
+static uint64_t run_once(const pbio_bench_case_t *bench_case, uint32_t iterations) {
+    pbio_bench_t bench = {
+        .iterations = iterations,
+    };
+
+    // Each run gets the same input data.
+    pbio_runner_random_seed(seed, 0);
+
+    bench_case->func(&bench);
+    return bench.elapsed;
+}
+
+/**
+ * Runs a benchmark.
+ *
+ * @param [in]  bench_case  The benchmark.
+ * @return                  Fastest time per operation in ns.
+ */
+static double run_bench(const pbio_bench_case_t *bench_case) {
+    uint32_t iterations = 1;
+    uint64_t elapsed;
+
+    // Find how many operations take at least the minimum time.
+    while ((elapsed = run_once(bench_case, iterations)) < PBIO_BENCH_MIN_TIME_NS &&
+           iterations < PBIO_BENCH_MAX_ITERATIONS) {
+
+        // Aim a bit over the minimum, but don't grow too fast in case the
+        // first few runs were too short to be measured accurately.
+        uint64_t next = elapsed ? (uint64_t)iterations * PBIO_BENCH_MIN_TIME_NS * 6 / 5 / elapsed : 0;
+        if (next > (uint64_t)iterations * 100) {
+            next = (uint64_t)iterations * 100;
+        }
+        if (next < (uint64_t)iterations * 2) {
+            next = (uint64_t)iterations * 2;
+        }
+        iterations = next > PBIO_BENCH_MAX_ITERATIONS ? PBIO_BENCH_MAX_ITERATIONS : next;
+    }
+
+    uint64_t fastest = elapsed;
+    for (int i = 0; i < PBIO_BENCH_NUM_SAMPLES; i++) {
+        elapsed = run_once(bench_case, iterations);
+        if (elapsed < fastest) {
+            fastest = elapsed;
+        }
+    }
+
+    return (double)fastest / iterations;
+}
+
+/**
+ * Looks up the result of a benchmark in a baseline file.
+ *
+ * @param [in]  baseline    The open baseline file.
+ * @param [in]  name        Name of the benchmark.
+ * @param [out] ns_per_op   The baseline result.
+ * @return                  True if found.
+ */
+static bool get_baseline(FILE *baseline, const char *name, double *ns_per_op) {
+    char line[256];
+    char line_name[200];
+
+    rewind(baseline);
+
+    while (fgets(line, sizeof(line), baseline)) {
+        if (sscanf(line, "%199s %lf", line_name, ns_per_op) == 2 && strcmp(line_name, name) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+extern const pbio_bench_case_t pbio_control_benchmarks[];
+extern const pbio_bench_case_t pbio_observer_benchmarks[];
+extern const pbio_bench_case_t pbio_servo_benchmarks[];
+extern const pbio_bench_case_t pbio_trajectory_benchmarks[];
+
+static const pbio_runner_group_t bench_groups[] = {
+    { "src/control/", pbio_control_benchmarks },
+    { "src/observer/", pbio_observer_benchmarks },
+    { "src/servo/", pbio_servo_benchmarks },
+    { "src/trajectory/", pbio_trajectory_benchmarks },
+    { NULL, NULL }
+};
+
+static bool run_bench_case(const char *name, const void *test_case) {
+    double ns_per_op = run_bench(test_case);
+    printf("%-40s %12.1f ns/op", name, ns_per_op);
+
+    if (output) {
+        fprintf(output, "%s %.1f\n", name, ns_per_op);
+    }
+
+    double base;
+    if (baseline && get_baseline(baseline, name, &base) && base > 0) {
+        printf(" %+7.1f%%", (ns_per_op - base) * 100 / base);
+    }
+
+    printf("\n");
+
+    return true;
+}
+
+int main(int argc, const char **argv) {
+    seed = pbio_runner_get_env("PBIO_BENCH_SEED", 1);
+
+    const char *baseline_path = getenv("PBIO_BENCH_BASELINE");
+    if (baseline_path) {
+        baseline = fopen(baseline_path, "r");
+        if (!baseline) {
+            // There may be no baseline yet, such as when the benchmarks are new.
+            fprintf(stderr, "no baseline: %s\n", baseline_path);
+        }
+    }
+
+    const char *output_path = getenv("PBIO_BENCH_OUTPUT");
+    if (output_path) {
+        output = fopen(output_path, "w");
+        if (!output) {
+            perror("failed to open output");
+            return 1;
+        }
+    }
+
+    int ret = pbio_runner_main(argc, argv, bench_groups, sizeof(pbio_bench_case_t), run_bench_case);
+
+    if (baseline) {
+        fclose(baseline);
+    }
+    if (output) {
+        fclose(output);
+    }
+
+    return ret;
+}
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#ifndef _BENCH_PBIO_H_
+#define _BENCH_PBIO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pbio/error.h>
+
+#include "runner-pbio.h"
+
+/**
+ * State of one benchmark run, passed to the benchmark function.
+ */
+typedef struct {
+    /** Number of operations that the benchmark function must do. */
+    uint32_t iterations;
+    /** Time measured between pbio_bench_start() and pbio_bench_stop() in ns. */
+    uint64_t elapsed;
+    /** Start of the current measurement in ns. */
+    uint64_t start;
+} pbio_bench_t;
+
+typedef void (*pbio_bench_func_t)(pbio_bench_t *bench);
+
+/**
+ * Benchmark case, like a tinytest test case.
+ */
+typedef struct {
+    /** Name, used to match baseline results. Must be the first member. */
+    const char *name;
+    /** Does bench->iterations operations between start and stop. */
+    pbio_bench_func_t func;
+} pbio_bench_case_t;
+
+#define PBIO_BENCH(name) \
+    { #name, name }
+
+#define END_OF_BENCH_CASES { NULL, NULL }
+
+void pbio_bench_start(pbio_bench_t *bench);
+void pbio_bench_stop(pbio_bench_t *bench);
+
+void pbio_bench_check(pbio_error_t err, const char *what);
+
+/**
+ * Keeps the compiler from optimizing away results that are otherwise unused.
+ */
+extern volatile uint32_t pbio_bench_sink;
+
+#endif // _BENCH_PBIO_H_
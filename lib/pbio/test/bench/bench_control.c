@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include <stdint.h>
+
+#include <pbio/angle.h>
+#include <pbio/config.h>
+#include <pbio/control.h>
+#include <pbio/iodev.h>
+#include <pbio/observer.h>
+#include <pbio/servo.h>
+#include <pbio/trajectory.h>
+
+#include "../bench-pbio.h"
+
+// Number of different commands and disturbances that the benchmark cycles through.
+#define NUM_COMMANDS (1024)
+
+// Control loop updates between new commands: two seconds, so that some
+// commands complete and then hold while others are interrupted.
+#define COMMAND_INTERVAL (2000 / PBIO_CONFIG_CONTROL_LOOP_TIME_MS)
+
+#define LOOP_TIME_TICKS (PBIO_CONFIG_CONTROL_LOOP_TIME_MS * PBIO_TRAJECTORY_TICKS_PER_MS)
+
+static void bench_update(pbio_bench_t *bench) {
+    static int32_t targets[NUM_COMMANDS];
+    static int32_t speeds[NUM_COMMANDS];
+    static int32_t errors[NUM_COMMANDS];
+
+    // Static like the servo objects that hold them in practice.
+    static pbio_control_t control;
+    const pbio_observer_model_t *model;
+    pbio_servo_load_settings(&control.settings, &model, PBIO_IODEV_TYPE_ID_SPIKE_M_MOTOR);
+    control.settings.ctl_steps_per_app_step = 1000;
+    pbio_control_reset(&control);
+
+    // Targets in degrees, speeds in deg/s, tracking errors in millidegrees.
+    for (int i = 0; i < NUM_COMMANDS; i++) {
+        targets[i] = pbio_runner_random_range(-36000, 36000);
+        speeds[i] = pbio_runner_random_range(100, 1000);
+        errors[i] = pbio_runner_random_range(-5000, 5000);
+    }
+
+    pbio_control_state_t state = { 0 };
+    pbio_trajectory_reference_t ref = { 0 };
+    pbio_dcmotor_actuation_t actuation;
+    int32_t torque;
+    uint32_t time_now = 0;
+
+    pbio_bench_start(bench);
+    for (uint32_t i = 0; i < bench->iterations; i++) {
+
+        if (i % COMMAND_INTERVAL == 0) {
+            uint32_t c = i / COMMAND_INTERVAL % NUM_COMMANDS;
+            pbio_bench_stop(bench);
+            pbio_control_start_position_control(&control, time_now, &state, targets[c], speeds[c], PBIO_CONTROL_ON_COMPLETION_HOLD);
+            pbio_bench_start(bench);
+        }
+
+        // Follow the reference with an error, like a motor under load.
+        state.position = ref.position;
+        pbio_angle_add_mdeg(&state.position, errors[i % NUM_COMMANDS]);
+        state.speed = ref.speed;
+        state.position_estimate = state.position;
+        state.speed_estimate = ref.speed;
+
+        pbio_control_update(&control, time_now, &state, &ref, &actuation, &torque);
+        pbio_bench_sink += torque;
+
+        time_now += LOOP_TIME_TICKS;
+    }
+    pbio_bench_stop(bench);
+}
+
+const pbio_bench_case_t pbio_control_benchmarks[] = {
+    PBIO_BENCH(bench_update),
+    END_OF_BENCH_CASES
+};
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include <stdint.h>
+
+#include <pbio/angle.h>
+#include <pbio/config.h>
+#include <pbio/control_settings.h>
+#include <pbio/dcmotor.h>
+#include <pbio/int_math.h>
+#include <pbio/iodev.h>
+#include <pbio/observer.h>
+#include <pbio/servo.h>
+#include <pbio/trajectory.h>
+
+#include "../bench-pbio.h"
+
+// Number of different inputs that the benchmark cycles through.
+#define NUM_SAMPLES (1024)
+
+#define LOOP_TIME_TICKS (PBIO_CONFIG_CONTROL_LOOP_TIME_MS * PBIO_TRAJECTORY_TICKS_PER_MS)
+
+static void bench_update(pbio_bench_t *bench) {
+    static int32_t voltages[NUM_SAMPLES];
+    static int32_t errors[NUM_SAMPLES];
+
+    // Static like the servo objects that hold them in practice.
+    static pbio_observer_t observer;
+    static pbio_control_settings_t settings;
+    pbio_servo_load_settings(&settings, &observer.model, PBIO_IODEV_TYPE_ID_SPIKE_M_MOTOR);
+
+    pbio_angle_t angle = { 0 };
+    pbio_observer_reset(&observer, &settings, &angle);
+
+    // Voltages in mV, following a random walk like a controller would.
+    // Measured angles deviate from the estimate by an error in millidegrees.
+    int32_t voltage = 0;
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        voltage = pbio_int_math_clamp(voltage + pbio_runner_random_range(-1000, 1000), 9000);
+        voltages[i] = voltage;
+        errors[i] = pbio_runner_random_range(-2000, 2000);
+    }
+
+    uint32_t time_now = 0;
+
+    pbio_bench_start(bench);
+    for (uint32_t i = 0; i < bench->iterations; i++) {
+        angle = observer.angle;
+        pbio_angle_add_mdeg(&angle, errors[i % NUM_SAMPLES]);
+        pbio_observer_update(&observer, time_now, &angle, PBIO_DCMOTOR_ACTUATION_VOLTAGE, voltages[i % NUM_SAMPLES]);
+        pbio_bench_sink += observer.speed;
+        time_now += LOOP_TIME_TICKS;
+    }
+    pbio_bench_stop(bench);
+}
+
+const pbio_bench_case_t pbio_observer_benchmarks[] = {
+    PBIO_BENCH(bench_update),
+    END_OF_BENCH_CASES
+};
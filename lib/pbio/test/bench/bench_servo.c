@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <contiki.h>
+
+#include <pbdrv/config.h>
+
+#include <pbio/battery.h>
+#include <pbio/config.h>
+#include <pbio/dcmotor.h>
+#include <pbio/drivebase.h>
+#include <pbio/main.h>
+#include <pbio/port.h>
+#include <pbio/servo.h>
+
+#include "../bench-pbio.h"
+
+// Number of different commands that the benchmark cycles through.
+#define NUM_COMMANDS (1024)
+
+// Control loop updates between new commands, as in bench_control.c.
+#define COMMAND_INTERVAL (2000 / PBIO_CONFIG_CONTROL_LOOP_TIME_MS)
+
+#define NUM_SERVOS (PBDRV_CONFIG_NUM_MOTOR_CONTROLLER)
+
+#if NUM_SERVOS < 6
+#error "servo benchmark needs six motor ports"
+#endif
+
+typedef struct {
+    int32_t distance;
+    int32_t radius;
+    int32_t angle;
+    int32_t targets[2];
+    int32_t speeds[2];
+} command_t;
+
+static pbio_servo_t *servos[NUM_SERVOS];
+static pbio_drivebase_t *drivebases[2];
+
+static void setup_hub(void) {
+    static bool initialized;
+
+    if (!initialized) {
+        pbio_init();
+        for (int i = 0; i < 1000 && pbio_do_one_event(); i++) {
+        }
+        initialized = true;
+    }
+
+    // Set up everything again on each run so all runs start out the same,
+    // like a new program would. Drive bases on A+B and C+D, as on a robot
+    // with two drive trains.
+    pbio_dcmotor_stop_all(true);
+    for (int i = 0; i < NUM_SERVOS; i++) {
+        pbio_bench_check(pbio_servo_get_servo(PBDRV_CONFIG_FIRST_MOTOR_PORT + i, &servos[i]), "get servo");
+        pbio_bench_check(pbio_servo_setup(servos[i], i % 2 ? PBIO_DIRECTION_CLOCKWISE : PBIO_DIRECTION_COUNTERCLOCKWISE, 1000, true), "servo setup");
+    }
+    pbio_bench_check(pbio_drivebase_get_drivebase(&drivebases[0], servos[0], servos[1], 56, 112), "get drivebase");
+    pbio_bench_check(pbio_drivebase_get_drivebase(&drivebases[1], servos[2], servos[3], 88, 160), "get drivebase");
+}
+
+static void start_command(const command_t *command) {
+
+    // Drive bases start each move from a standstill, like a program that
+    // waits for each move to complete. Stretching a trajectory that starts
+    // out in the opposite direction may exceed the acceleration limits.
+    for (int i = 0; i < 2; i++) {
+        pbio_bench_check(pbio_drivebase_stop(drivebases[i], PBIO_CONTROL_ON_COMPLETION_HOLD), "drivebase stop");
+    }
+
+    pbio_bench_check(pbio_drivebase_drive_straight(drivebases[0], command->distance, PBIO_CONTROL_ON_COMPLETION_HOLD), "drive straight");
+    pbio_bench_check(pbio_drivebase_drive_curve(drivebases[1], command->radius, command->angle, PBIO_CONTROL_ON_COMPLETION_HOLD), "drive curve");
+
+    // The remaining motors run on their own, interrupting their last move.
+    for (int i = 0; i < 2; i++) {
+        pbio_bench_check(pbio_servo_run_target(servos[4 + i], command->speeds[i], command->targets[i], PBIO_CONTROL_ON_COMPLETION_HOLD), "run target");
+    }
+}
+
+/**
+ * One iteration is everything that the motor process does in one control
+ * loop, for six motors of which four are in drive bases.
+ */
+static void bench_update_all(pbio_bench_t *bench) {
+    static command_t commands[NUM_COMMANDS];
+
+    setup_hub();
+
+    // Distances in mm, angles in degrees, speeds in deg/s.
+    for (int i = 0; i < NUM_COMMANDS; i++) {
+        commands[i] = (command_t) {
+            .distance = pbio_runner_random_range(-1000, 1000),
+            .radius = pbio_runner_random_range(-500, 500),
+            .angle = pbio_runner_random_range(-360, 360),
+            .targets = { pbio_runner_random_range(-3600, 3600), pbio_runner_random_range(-3600, 3600) },
+            .speeds = { pbio_runner_random_range(100, 1000), pbio_runner_random_range(100, 1000) },
+        };
+    }
+
+    pbio_bench_start(bench);
+    for (uint32_t i = 0; i < bench->iterations; i++) {
+
+        if (i % COMMAND_INTERVAL == 0) {
+            pbio_bench_stop(bench);
+            start_command(&commands[i / COMMAND_INTERVAL % NUM_COMMANDS]);
+            pbio_bench_start(bench);
+        }
+
+        pbio_test_clock_tick(PBIO_CONFIG_CONTROL_LOOP_TIME_MS);
+
+        pbio_battery_update();
+        pbio_drivebase_update_all();
+        pbio_servo_update_all();
+    }
+    pbio_bench_stop(bench);
+
+    // Servos stop updating on errors, which would make this look faster.
+    for (int i = 0; i < NUM_SERVOS; i++) {
+        pbio_bench_check(pbio_servo_update_loop_is_running(servos[i]) ? PBIO_SUCCESS : PBIO_ERROR_FAILED, "servo update");
+        pbio_bench_sink += servos[i]->control.pid_average;
+    }
+}
+
+const pbio_bench_case_t pbio_servo_benchmarks[] = {
+    PBIO_BENCH(bench_update_all),
+    END_OF_BENCH_CASES
+};
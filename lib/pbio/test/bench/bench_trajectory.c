@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include <stdint.h>
+
+#include <pbio/angle.h>
+#include <pbio/trajectory.h>
+
+#include "../bench-pbio.h"
+
+// Number of different commands that benchmarks cycle through.
+#define NUM_COMMANDS (1024)
+
+#define MDEG_PER_DEG (1000)
+
+/**
+ * Makes a random angle command in control units, covering what motors and
+ * drive bases may be asked to do in practice. Slow and far maneuvers are
+ * bounded so that they take at most a few minutes.
+ *
+ * @param [out] command     The command.
+ */
+static void random_angle_command(pbio_trajectory_command_t *command) {
+
+    int32_t speed_max = pbio_runner_random_range(100, 2000) * MDEG_PER_DEG;
+
+    *command = (pbio_trajectory_command_t) {
+        .time_start = pbio_runner_random(),
+        .position_start = {
+            .rotations = pbio_runner_random_range(-10000, 10000),
+            .millidegrees = pbio_runner_random_range(-359999, 359999),
+        },
+        .speed_start = pbio_runner_random_range(-speed_max, speed_max),
+        .speed_target = pbio_runner_random_range(50 * MDEG_PER_DEG, speed_max),
+        .speed_max = speed_max,
+        .acceleration = pbio_runner_random_range(100, 20000) * MDEG_PER_DEG,
+        .deceleration = pbio_runner_random_range(100, 20000) * MDEG_PER_DEG,
+        .continue_running = pbio_runner_random() & 1,
+    };
+
+    // Anything from a small nudge to many rotations, either way.
+    command->position_end = command->position_start;
+    pbio_angle_add_mdeg(&command->position_end, pbio_runner_random_range(-20000, 20000) * MDEG_PER_DEG);
+}
+
+static void bench_new_angle_command(pbio_bench_t *bench) {
+    static pbio_trajectory_command_t commands[NUM_COMMANDS];
+    pbio_trajectory_t trj;
+
+    for (int i = 0; i < NUM_COMMANDS; i++) {
+        random_angle_command(&commands[i]);
+    }
+
+    pbio_bench_start(bench);
+    for (uint32_t i = 0; i < bench->iterations; i++) {
+        pbio_bench_sink += pbio_trajectory_new_angle_command(&trj, &commands[i % NUM_COMMANDS]);
+        pbio_bench_sink += trj.t3;
+    }
+    pbio_bench_stop(bench);
+}
+
+static void bench_get_reference(pbio_bench_t *bench) {
+    static pbio_trajectory_t trajectories[NUM_COMMANDS];
+    static uint32_t times[NUM_COMMANDS];
+    pbio_trajectory_command_t command;
+    pbio_trajectory_reference_t ref;
+
+    for (int i = 0; i < NUM_COMMANDS; i++) {
+        random_angle_command(&command);
+        pbio_trajectory_new_angle_command(&trajectories[i], &command);
+
+        // Sample each phase of the maneuver, and a bit after it.
+        uint32_t duration = pbio_trajectory_get_duration(&trajectories[i]);
+        times[i] = command.time_start + pbio_runner_random() % (duration + duration / 4 + 1);
+    }
+
+    pbio_bench_start(bench);
+    for (uint32_t i = 0; i < bench->iterations; i++) {
+        pbio_trajectory_get_reference(&trajectories[i % NUM_COMMANDS], times[i % NUM_COMMANDS], &ref);
+        pbio_bench_sink += ref.position.millidegrees + ref.speed;
+    }
+    pbio_bench_stop(bench);
+}
+
+const pbio_bench_case_t pbio_trajectory_benchmarks[] = {
+    PBIO_BENCH(bench_new_angle_command),
+    PBIO_BENCH(bench_get_reference),
+    END_OF_BENCH_CASES
+};
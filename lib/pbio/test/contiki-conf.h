@@ -19,4 +19,8 @@ void pbio_test_clock_tick(uint32_t ticks);
 #define clock_time pbdrv_clock_get_ms
 #define clock_usecs pbdrv_clock_get_us
 
+// The event loop profiler uses the computer's clock, since the test clock
+// only moves when a test ticks it.
+#define PROCESS_CONF_PROFILE_CLOCK process_profile_host_clock
+
 #endif /* _PBIO_CONF_H_ */
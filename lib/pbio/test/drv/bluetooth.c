@@ -146,6 +146,7 @@ void pbio_test_bluetooth_enable_uart_service_notifications(void) {
 }
 
 static uint32_t uart_service_notification_count;
+static uint32_t uart_service_notification_size;
 
 /**
  * This count increases each time the hub sends a notification on the Nordic UART
@@ -155,6 +156,51 @@ uint32_t pbio_test_bluetooth_get_uart_service_notification_count(void) {
     return uart_service_notification_count;
 }
 
+/**
+ * Gets the size of the last notification the hub sent on the Nordic UART
+ * service Tx characteristic.
+ */
+uint32_t pbio_test_bluetooth_get_uart_service_notification_size(void) {
+    return uart_service_notification_size;
+}
+
+/**
+ * This simulates a remote device requesting a bigger ATT MTU.
+ *
+ * @param [in]  mtu     The MTU of the remote device.
+ */
+void pbio_test_bluetooth_exchange_mtu(uint16_t mtu) {
+    const uint16_t length = 3;
+    uint8_t buffer[length + 9];
+
+    buffer[0] = 0x02; // packet type = ACL Data
+    little_endian_store_16(buffer, 1, 0x0400); // connection handle
+    buffer[2] |= 0x02 << 4; // PB flag
+    little_endian_store_16(buffer, 3, length + 4); // total data length
+    little_endian_store_16(buffer, 5, length); // L2CAP length
+    little_endian_store_16(buffer, 7, 4); // Attribute protocol
+    buffer[9] = ATT_EXCHANGE_MTU_REQUEST;
+    little_endian_store_16(buffer, 10, mtu);
+
+    queue_packet(buffer, length + 9);
+}
+
+// Gives back the controller buffer used by an ACL packet sent by the hub, so
+// that btstack can keep sending.
+static void queue_number_of_completed_packets(void) {
+    const uint8_t length = 5;
+    uint8_t buffer[length + 3];
+
+    buffer[0] = 0x04; // packet type = Event
+    buffer[1] = 0x13; // Number Of Completed Packets
+    buffer[2] = length;
+    buffer[3] = 1; // number of handles
+    little_endian_store_16(buffer, 4, 0x0400); // connection handle
+    little_endian_store_16(buffer, 6, 1); // number of completed packets
+
+    queue_packet(buffer, length + 3);
+}
+
 void pbio_test_bluetooth_send_uart_data(const uint8_t *data, uint32_t size) {
     // Nordic UART Rx characteristic value (comes from header file generated by .gatt)
     const uint16_t attribute_handle = 0x0013;
@@ -195,6 +241,21 @@ uint32_t pbio_test_bluetooth_get_pybricks_service_notification_count(void) {
     return pybricks_service_notification_count;
 }
 
+static uint8_t pybricks_service_notification[HCI_ACL_PAYLOAD_SIZE];
+static uint32_t pybricks_service_notification_size;
+
+/**
+ * Gets the value of the last notification the hub sent on the Pybricks
+ * service command characteristic.
+ *
+ * @param [out] size    The size of the value.
+ * @return              The value.
+ */
+const uint8_t *pbio_test_bluetooth_get_pybricks_service_notification(uint32_t *size) {
+    *size = pybricks_service_notification_size;
+    return pybricks_service_notification;
+}
+
 static pbio_test_bluetooth_control_state_t control_state;
 
 pbio_test_bluetooth_control_state_t pbio_test_bluetooth_get_control_state(void) {
@@ -399,6 +460,11 @@ static void handle_send(const uint8_t *buffer, uint16_t length) {
                         }
                         break;
 
+                        case 0x03: { // ATT_EXCHANGE_MTU_RESPONSE
+                            log_debug("ATT_EXCHANGE_MTU_RESPONSE: mtu: %u", little_endian_read_16(buffer, 10));
+                        }
+                        break;
+
                         case 0x13: { // ATT_WRITE_RESPONSE
                             // REVISIT: maybe set a flag here?
                         }
@@ -413,13 +479,15 @@ static void handle_send(const uint8_t *buffer, uint16_t length) {
                             switch (attr_handle) {
                                 case 0x000d:
                                     pybricks_service_notification_count++;
+                                    memcpy(pybricks_service_notification, value, size);
+                                    pybricks_service_notification_size = size;
                                     break;
                                 case 0x0013:
                                     uart_service_notification_count++;
+                                    uart_service_notification_size = size;
                                     break;
                             }
 
-                            (void)value;
                             log_debug("ATT_HANDLE_VALUE_NOTIFICATION: attr_handle: %04x, size: %u", attr_handle, size);
                         }
                         break;
@@ -435,6 +503,7 @@ static void handle_send(const uint8_t *buffer, uint16_t length) {
                     break;
             }
 
+            queue_number_of_completed_packets();
         }
         break;
 
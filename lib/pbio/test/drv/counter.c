@@ -1,39 +1,237 @@
 // SPDX-License-Identifier: MIT
-// Copyright (c) 2020-2021 The Pybricks Authors
+// Copyright (c) 2020-2023 The Pybricks Authors
 
+#include <math.h>
+#include <stdbool.h>
 #include <stdio.h>
 
 #include <tinytest.h>
 #include <tinytest_macros.h>
 
+#include <pbdrv/battery.h>
+#include <pbdrv/clock.h>
 #include <pbdrv/counter.h>
+#include <pbdrv/motor_driver.h>
 #include <pbio/error.h>
 #include <test-pbio.h>
 
 #include "../drv/counter/counter.h"
 
+// Simulated motor, connecting the test motor driver to the counter. This is
+// the same model as in doc/control/motor_model.py, with the parameters of the
+// interactive motor, which is the motor type reported by the test I/O ports.
+
+#define PLANT_TIME_STEP_US (100)
+#define PLANT_TIME_STEP (PLANT_TIME_STEP_US / 1e6)
+
+#define PLANT_KT (0.27383)          // Torque constant (Nm/A).
+#define PLANT_KE (0.30902)          // Back EMF constant (V/(rad/s)).
+#define PLANT_R (18.2437)           // Resistance (Ohm).
+#define PLANT_L (0.006)             // Inductance (H).
+#define PLANT_IN (2.3655e-4)        // Inertia (kg m^2).
+#define PLANT_FRICTION (0.011227)   // Coulomb friction (Nm).
+
+#define RAD_TO_MDEG (180000.0 / M_PI)
+
+typedef struct {
+    /** Whether the motor is simulated. */
+    bool enabled;
+    /** Whether the output shaft is stuck, as if held against an obstacle. */
+    bool blocked;
+    /** Whether the windings are disconnected. */
+    bool coasting;
+    /** Applied voltage (V). */
+    double voltage;
+    /** External load torque (Nm). */
+    double load;
+    /** Angle (rad). */
+    double angle;
+    /** Angular velocity (rad/s). */
+    double speed;
+    /** Current (A). */
+    double current;
+    /** Simulated time (us). */
+    uint32_t time;
+} test_plant_t;
+
 typedef struct {
     int32_t rotations;
     int32_t millidegrees;
+    test_plant_t plant;
 } test_private_data_t;
 
-static test_private_data_t test_private_data;
+static test_private_data_t test_private_data[PBDRV_CONFIG_COUNTER_NUM_DEV];
+
+/**
+ * Advances the motor model by one fixed time step.
+ */
+static void plant_step(test_plant_t *plant) {
+
+    // Semi-implicit in the current, which settles much faster than a step.
+    if (plant->coasting) {
+        plant->current = 0;
+    } else {
+        plant->current = (plant->current + PLANT_TIME_STEP / PLANT_L * (plant->voltage - PLANT_KE * plant->speed)) /
+            (1 + PLANT_TIME_STEP * PLANT_R / PLANT_L);
+    }
+
+    if (plant->blocked) {
+        plant->speed = 0;
+        return;
+    }
+
+    double torque = PLANT_KT * plant->current - plant->load;
+
+    // Static friction holds the motor until the torque exceeds it.
+    if (plant->speed == 0 && fabs(torque) <= PLANT_FRICTION) {
+        return;
+    }
+
+    double direction = plant->speed != 0 ? copysign(1, plant->speed) : copysign(1, torque);
+    double speed = plant->speed + (torque - PLANT_FRICTION * direction) / PLANT_IN * PLANT_TIME_STEP;
+
+    // Friction stops the motor but does not reverse it.
+    if (plant->speed != 0 && speed * plant->speed < 0) {
+        speed = 0;
+    }
+
+    plant->speed = speed;
+    plant->angle += speed * PLANT_TIME_STEP;
+}
+
+/**
+ * Advances the motor model to the current time.
+ */
+static void plant_update(test_plant_t *plant) {
+    uint32_t now = pbdrv_clock_get_us();
+    while ((int32_t)(now - plant->time) >= PLANT_TIME_STEP_US) {
+        plant_step(plant);
+        plant->time += PLANT_TIME_STEP_US;
+    }
+}
+
+static test_plant_t *get_plant(uint8_t id) {
+    if (id >= PBDRV_CONFIG_COUNTER_NUM_DEV || !test_private_data[id].plant.enabled) {
+        return NULL;
+    }
+    test_plant_t *plant = &test_private_data[id].plant;
+    plant_update(plant);
+    return plant;
+}
 
 // Functions for tests to poke counter state
 
 void pbio_test_counter_set_angle(int32_t rotations, int32_t millidegrees) {
-    test_private_data.rotations = rotations;
-    test_private_data.millidegrees = millidegrees;
+    test_private_data[0].rotations = rotations;
+    test_private_data[0].millidegrees = millidegrees;
 }
 
 void pbio_test_counter_set_abs_count(int32_t millidegrees) {
-    test_private_data.millidegrees = millidegrees;
+    test_private_data[0].millidegrees = millidegrees;
+}
+
+// Functions for tests to use the simulated motor
+
+/**
+ * Simulates a motor on this counter, starting at the current counter angle.
+ *
+ * @param [in]  id      The counter and motor driver index.
+ */
+void pbio_test_motor_plant_enable(uint8_t id) {
+    test_private_data_t *priv = &test_private_data[id];
+    priv->plant = (test_plant_t) {
+        .enabled = true,
+        .coasting = true,
+        .angle = (priv->rotations * 360000.0 + priv->millidegrees) / RAD_TO_MDEG,
+        .time = pbdrv_clock_get_us(),
+    };
+}
+
+/**
+ * Sets an external load on the simulated motor.
+ *
+ * @param [in]  id      The counter and motor driver index.
+ * @param [in]  torque  Load torque in uNm, opposing positive rotation.
+ */
+void pbio_test_motor_plant_set_load(uint8_t id, int32_t torque) {
+    test_plant_t *plant = get_plant(id);
+    if (plant) {
+        plant->load = torque / 1e6;
+    }
+}
+
+/**
+ * Blocks or releases the simulated motor.
+ *
+ * @param [in]  id      The counter and motor driver index.
+ * @param [in]  blocked True to stop the shaft as if it hit an obstacle.
+ */
+void pbio_test_motor_plant_set_blocked(uint8_t id, bool blocked) {
+    test_plant_t *plant = get_plant(id);
+    if (plant) {
+        plant->blocked = blocked;
+    }
+}
+
+/**
+ * Gets the exact angle of the simulated motor, as opposed to the angle seen
+ * through the controller.
+ *
+ * @param [in]  id      The counter and motor driver index.
+ * @return              Angle in millidegrees.
+ */
+int32_t pbio_test_motor_plant_get_angle(uint8_t id) {
+    test_plant_t *plant = get_plant(id);
+    return plant ? (int32_t)lround(plant->angle * RAD_TO_MDEG) : 0;
+}
+
+/**
+ * Gets the exact speed of the simulated motor.
+ *
+ * @param [in]  id      The counter and motor driver index.
+ * @return              Speed in millidegrees per second.
+ */
+int32_t pbio_test_motor_plant_get_speed(uint8_t id) {
+    test_plant_t *plant = get_plant(id);
+    return plant ? (int32_t)lround(plant->speed * RAD_TO_MDEG) : 0;
+}
+
+/**
+ * Applies the motor driver output to the simulated motor. This is called by
+ * the test motor driver.
+ *
+ * @param [in]  id          The counter and motor driver index.
+ * @param [in]  coast       True if the outputs are disconnected.
+ * @param [in]  duty_cycle  Signed duty cycle, ignored when coasting.
+ */
+void pbio_test_motor_plant_set_output(uint8_t id, bool coast, int32_t duty_cycle) {
+    test_plant_t *plant = get_plant(id);
+    if (!plant) {
+        return;
+    }
+
+    uint16_t battery_voltage;
+    pbdrv_battery_get_voltage_now(&battery_voltage);
+
+    plant->coasting = coast;
+    plant->voltage = coast ? 0 : battery_voltage / 1000.0 * duty_cycle / PBDRV_MOTOR_DRIVER_MAX_DUTY;
 }
 
 // Counter driver implementation
 
+static void get_plant_angle(test_private_data_t *priv) {
+    test_plant_t *plant = get_plant(priv - test_private_data);
+    if (!plant) {
+        return;
+    }
+    int64_t angle = llround(plant->angle * RAD_TO_MDEG);
+    priv->rotations = angle / 360000;
+    priv->millidegrees = angle % 360000;
+}
+
 static pbio_error_t test_get_angle(pbdrv_counter_dev_t *dev, int32_t *rotations, int32_t *millidegrees) {
     test_private_data_t *priv = dev->priv;
+    get_plant_angle(priv);
     *millidegrees = priv->millidegrees;
     *rotations = priv->rotations;
     return PBIO_SUCCESS;
@@ -41,7 +239,12 @@ static pbio_error_t test_get_angle(pbdrv_counter_dev_t *dev, int32_t *rotations,
 
 static pbio_error_t test_get_abs_angle(pbdrv_counter_dev_t *dev, int32_t *millidegrees) {
     test_private_data_t *priv = dev->priv;
+    get_plant_angle(priv);
     *millidegrees = priv->millidegrees;
+    if (priv->plant.enabled) {
+        // Absolute angles are between -180 and 180 degrees.
+        *millidegrees = (*millidegrees + 540000) % 360000 - 180000;
+    }
     return PBIO_SUCCESS;
 }
 
@@ -51,8 +254,10 @@ static const pbdrv_counter_funcs_t test_funcs = {
 };
 
 void pbdrv_counter_test_init(pbdrv_counter_dev_t *devs) {
-    devs[0].funcs = &test_funcs;
-    devs[0].priv = &test_private_data;
+    for (int i = 0; i < PBDRV_CONFIG_COUNTER_NUM_DEV; i++) {
+        devs[i].funcs = &test_funcs;
+        devs[i].priv = &test_private_data[i];
+    }
 }
 
 // Tests
@@ -64,12 +269,12 @@ static void test_counter_get(void *env) {
     tt_want(pbdrv_counter_get_dev(0, &dev) == PBIO_ERROR_AGAIN);
 
     // bad id
-    tt_want(pbdrv_counter_get_dev(1, &dev) == PBIO_ERROR_NO_DEV);
+    tt_want(pbdrv_counter_get_dev(PBDRV_CONFIG_COUNTER_NUM_DEV, &dev) == PBIO_ERROR_NO_DEV);
 
     // proper usage
     pbdrv_counter_init();
     tt_want(pbdrv_counter_get_dev(0, &dev) == PBIO_SUCCESS);
-    tt_want(dev->priv == &test_private_data);
+    tt_want(dev->priv == &test_private_data[0]);
 }
 
 struct testcase_t pbdrv_counter_tests[] = {
@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+// Randomized tests for pbio math, built with sanitizers.
+//
+// Each target is run for a number of cases with random input. The targets
+// check invariants of the results and report violations with
+// pbio_fuzz_fail(). Asserts, sanitizer errors and crashes also count as
+// failures. All failures report the case number and its input.
+//
+// Each case gets its own random numbers from the seed and the case number,
+// so a single case can be run again without running all others before it.
+//
+// Environment variables:
+//
+//     PBIO_FUZZ_SEED   Seed for the random input (default: current time).
+//     PBIO_FUZZ_CASES  Number of cases per target (default 1000000).
+//     PBIO_FUZZ_CASE   Run only this case and print its input.
+//
+// See runner-pbio.c for selecting targets on the command line.
+
+#include <inttypes.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__SANITIZE_ADDRESS__)
+#define PBIO_FUZZ_SANITIZER (1)
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define PBIO_FUZZ_SANITIZER (1)
+#endif
+#endif
+
+#if PBIO_FUZZ_SANITIZER
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+#include "fuzz-pbio.h"
+
+// Stop reporting failures of a target after this many.
+#define PBIO_FUZZ_MAX_REPORTS (10)
+
+static uint32_t seed;
+static uint32_t num_cases;
+static int64_t single_case;
+static const char *current_name;
+static const pbio_fuzz_case_t *current_case;
+static uint32_t current_index;
+static uint32_t failures;
+
+/**
+ * Gets a pseudo-random number in a range. Overflows often happen near the
+ * limits, so these and very small offsets from them are more likely than
+ * with a uniform distribution.
+ *
+ * @param [in]  min     Lowest value.
+ * @param [in]  max     Highest value, inclusive.
+ * @return              Random number.
+ */
+int32_t pbio_fuzz_random_range(int32_t min, int32_t max) {
+    uint64_t span = (uint64_t)((int64_t)max - min) + 1;
+    uint64_t r = (uint64_t)pbio_runner_random() << 32 | pbio_runner_random();
+
+    // Random number of bits, for offsets of all orders of magnitude.
+    uint64_t offset = (r >> 8) >> (r >> 58);
+
+    switch (r & 0xf) {
+        case 0:
+            return min;
+        case 1:
+            return max;
+        case 2:
+            return (int32_t)(min + offset % span);
+        case 3:
+            return (int32_t)(max - offset % span);
+        case 4:
+            // Small values of either sign, if in range.
+            if (min < 0 && max > 0) {
+                int64_t value = (r & 0x10) ? -(int64_t)offset : (int64_t)offset;
+                return value < min ? min : value > max ? max : (int32_t)value;
+            }
+        // fallthrough
+        default:
+            return (int32_t)(min + (r >> 8) % span);
+    }
+}
+
+static void print_case(void) {
+    fprintf(stderr, "%s case %" PRIu32 " (PBIO_FUZZ_SEED=%" PRIu32 " PBIO_FUZZ_CASE=%" PRIu32 ")\n",
+        current_name, current_index, seed, current_index);
+    current_case->print(stderr);
+}
+
+/**
+ * Reports that the current case breaks an invariant.
+ *
+ * @param [in]  format  Description of the failure, as for printf.
+ */
+void pbio_fuzz_fail(const char *format, ...) {
+    failures++;
+
+    if (failures > PBIO_FUZZ_MAX_REPORTS) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "FAIL: ");
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+
+    print_case();
+}
+
+static void on_crash(void) {
+    if (current_case) {
+        fprintf(stderr, "CRASH: ");
+        print_case();
+    }
+}
+
+static void on_signal(int sig) {
+    on_crash();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static void run_case(const pbio_fuzz_case_t *fuzz_case, uint32_t index, uint32_t *accepted) {
+    current_case = fuzz_case;
+    current_index = index;
+
+    pbio_runner_random_seed(seed, index);
+
+    if (fuzz_case->func()) {
+        (*accepted)++;
+    }
+
+    current_case = NULL;
+}
+
+extern const pbio_fuzz_case_t pbio_trajectory_fuzz_cases[];
+
+static const pbio_runner_group_t fuzz_groups[] = {
+    { "src/trajectory/", pbio_trajectory_fuzz_cases },
+    { NULL, NULL }
+};
+
+static bool run_target(const char *name, const void *test_case) {
+    const pbio_fuzz_case_t *fuzz_case = test_case;
+    uint32_t accepted = 0;
+
+    current_name = name;
+    failures = 0;
+
+    if (single_case >= 0) {
+        run_case(fuzz_case, single_case, &accepted);
+        current_case = fuzz_case;
+        print_case();
+        current_case = NULL;
+        printf("%-40s %s\n", name, failures ? "FAIL" : "OK");
+        return failures == 0;
+    }
+
+    uint64_t start = pbio_runner_get_time_ns();
+    for (uint32_t i = 0; i < num_cases; i++) {
+        run_case(fuzz_case, i, &accepted);
+    }
+    double elapsed = (pbio_runner_get_time_ns() - start) / 1e9;
+
+    printf("%-40s %10" PRIu32 " cases %10" PRIu32 " accepted %8.0f cases/s %s\n",
+        name, num_cases, accepted, elapsed > 0 ? num_cases / elapsed : 0, failures ? "FAIL" : "OK");
+    if (failures > PBIO_FUZZ_MAX_REPORTS) {
+        printf("%" PRIu32 " failures, only the first %d were reported\n", failures, PBIO_FUZZ_MAX_REPORTS);
+    }
+
+    return failures == 0;
+}
+
+int main(int argc, const char **argv) {
+    seed = pbio_runner_get_env("PBIO_FUZZ_SEED", (uint32_t)time(NULL));
+    num_cases = pbio_runner_get_env("PBIO_FUZZ_CASES", 1000000);
+    single_case = getenv("PBIO_FUZZ_CASE") ? (int64_t)pbio_runner_get_env("PBIO_FUZZ_CASE", 0) : -1;
+
+    signal(SIGABRT, on_signal);
+    signal(SIGFPE, on_signal);
+    signal(SIGSEGV, on_signal);
+    #if PBIO_FUZZ_SANITIZER
+    __sanitizer_set_death_callback(on_crash);
+    #endif
+
+    printf("PBIO_FUZZ_SEED=%" PRIu32 "\n", seed);
+
+    return pbio_runner_main(argc, argv, fuzz_groups, sizeof(pbio_fuzz_case_t), run_target);
+}
@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#ifndef _FUZZ_PBIO_H_
+#define _FUZZ_PBIO_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "runner-pbio.h"
+
+/**
+ * Fuzz target, like a tinytest test case.
+ */
+typedef struct {
+    /** Name, used to select targets on the command line. Must be the first member. */
+    const char *name;
+    /**
+     * Runs one case with input from pbio_runner_random() and friends. Returns
+     * false if the code under test rejected the input as invalid.
+     */
+    bool (*func)(void);
+    /** Prints the input of the current case, to reproduce failures. */
+    void (*print)(FILE *f);
+} pbio_fuzz_case_t;
+
+#define PBIO_FUZZ(name) \
+    { #name, name, name##_print }
+
+#define END_OF_FUZZ_CASES { NULL, NULL, NULL }
+
+void pbio_fuzz_fail(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+// Random number for the current case, like pbio_runner_random_range(), but
+// values at and near the ends of the range are picked more often than others.
+int32_t pbio_fuzz_random_range(int32_t min, int32_t max);
+
+#endif // _FUZZ_PBIO_H_
@@ -0,0 +1,368 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+// Fuzz targets for the trajectory module. Commands cover the full range of
+// speeds, accelerations, angles and durations, and a bit beyond where the
+// module is supposed to clamp the input. The resulting reference must be
+// continuous, stay within the limits of the command, and end where the
+// command says.
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pbio/angle.h>
+#include <pbio/error.h>
+#include <pbio/int_math.h>
+#include <pbio/trajectory.h>
+
+#include "../fuzz-pbio.h"
+
+#define MDEG_PER_DEG (1000)
+#define TICKS_PER_S (PBIO_TRAJECTORY_TICKS_PER_MS * 1000)
+
+// Limits of the trajectory module in control units, see trajectory.c.
+#define SPEED_MAX (2000 * MDEG_PER_DEG)
+#define ACCELERATION_MAX (20000 * MDEG_PER_DEG)
+#define DURATION_MAX (536 * TICKS_PER_S)
+
+// Resolution of speeds inside the trajectory module.
+#define SPEED_RESOLUTION (100)
+
+// Each segment starts and ends on a whole tick, which is a small jump in
+// speed and position compared to an exact solution. Speed and position are
+// also rounded to the resolution of the trajectory module, so the position
+// can drift by up to the speed resolution times the time since the start.
+#define SPEED_TOLERANCE (2 * ACCELERATION_MAX / TICKS_PER_S + 2 * SPEED_RESOLUTION)
+#define POSITION_TOLERANCE (1000)
+
+// How long to keep checking after the end of a maneuver.
+#define TIME_AFTER_END (TICKS_PER_S)
+
+#define NUM_RANDOM_SAMPLES (32)
+
+// Input of the current case.
+static pbio_trajectory_command_t command;
+static pbio_trajectory_command_t leader_command;
+
+static void print_command(FILE *f, const char *name, const pbio_trajectory_command_t *c) {
+    fprintf(f, "%s = {\n", name);
+    fprintf(f, "    .time_start = %" PRIu32 ",\n", c->time_start);
+    fprintf(f, "    .position_start = { %" PRId32 ", %" PRId32 " },\n", c->position_start.rotations, c->position_start.millidegrees);
+    fprintf(f, "    .position_end = { %" PRId32 ", %" PRId32 " },\n", c->position_end.rotations, c->position_end.millidegrees);
+    fprintf(f, "    .duration = %" PRIu32 ",\n", c->duration);
+    fprintf(f, "    .speed_start = %" PRId32 ",\n", c->speed_start);
+    fprintf(f, "    .speed_target = %" PRId32 ",\n", c->speed_target);
+    fprintf(f, "    .speed_max = %" PRId32 ",\n", c->speed_max);
+    fprintf(f, "    .acceleration = %" PRId32 ",\n", c->acceleration);
+    fprintf(f, "    .deceleration = %" PRId32 ",\n", c->deceleration);
+    fprintf(f, "    .continue_running = %s,\n", c->continue_running ? "true" : "false");
+    fprintf(f, "};\n");
+}
+
+/**
+ * Makes a random command, going up to twice the limits of the trajectory
+ * module where it should clamp the input. Nonzero speeds are at least the
+ * speed resolution, as for all users of the module.
+ *
+ * @param [out] c       The command.
+ * @param [in]  time    True for a timed command, false for an angle command.
+ */
+static void random_command(pbio_trajectory_command_t *c, bool time) {
+    *c = (pbio_trajectory_command_t) {
+        .time_start = pbio_runner_random(),
+        .position_start = {
+            .rotations = pbio_fuzz_random_range(-1000000, 1000000),
+            .millidegrees = pbio_fuzz_random_range(-359999, 359999),
+        },
+        .speed_start = pbio_fuzz_random_range(-2 * SPEED_MAX, 2 * SPEED_MAX),
+        .speed_target = pbio_fuzz_random_range(SPEED_RESOLUTION, 2 * SPEED_MAX),
+        .speed_max = pbio_fuzz_random_range(SPEED_RESOLUTION, 2 * SPEED_MAX),
+        .acceleration = pbio_fuzz_random_range(0, 2 * ACCELERATION_MAX),
+        .deceleration = pbio_fuzz_random_range(0, 2 * ACCELERATION_MAX),
+        .continue_running = pbio_runner_random_bool(),
+    };
+
+    // Speed zero means standing still, and the sign is the direction for
+    // time based commands.
+    if (pbio_fuzz_random_range(0, 15) == 0) {
+        c->speed_target = 0;
+    } else if (pbio_runner_random_bool()) {
+        c->speed_target *= -1;
+    }
+
+    c->position_end = c->position_start;
+    if (time) {
+        c->duration = pbio_fuzz_random_range(0, 2 * DURATION_MAX);
+    } else {
+        // Up to the largest distance that fits in one angle, so that
+        // commands that are too long for the module are included.
+        pbio_angle_add_mdeg(&c->position_end, pbio_fuzz_random_range(-INT32_MAX + 360000, INT32_MAX - 360000));
+    }
+}
+
+static int32_t get_speed_limit(const pbio_trajectory_command_t *c) {
+    int32_t start = pbio_int_math_min(pbio_int_math_abs(c->speed_start), SPEED_MAX);
+    int32_t target = pbio_int_math_min(pbio_int_math_min(pbio_int_math_abs(c->speed_target), c->speed_max), SPEED_MAX);
+    return pbio_int_math_max(start, target);
+}
+
+/**
+ * Gets the distance traveled by an angle command. A command with zero speed
+ * holds the starting position instead.
+ */
+static int32_t get_distance(const pbio_trajectory_command_t *c) {
+    if (c->speed_target == 0) {
+        return 0;
+    }
+    return pbio_angle_diff_mdeg(&c->position_end, &c->position_start);
+}
+
+static int cmp_time(const void *a, const void *b) {
+    int32_t x = *(const int32_t *)a;
+    int32_t y = *(const int32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Checks that the reference of a trajectory is continuous and stays within
+ * the limits of its command.
+ *
+ * Long trajectories are rebased when evaluated far enough beyond the end,
+ * so this must be the last check of a trajectory.
+ *
+ * @param [in]  trj         The trajectory.
+ * @param [in]  c           The command for this trajectory.
+ * @param [in]  angle       Whether this is an angle based trajectory.
+ */
+static void check_reference(pbio_trajectory_t *trj, const pbio_trajectory_command_t *c, bool angle) {
+
+    int32_t duration = pbio_trajectory_get_duration(trj);
+    int32_t end = duration + TIME_AFTER_END;
+    int32_t distance = get_distance(c);
+
+    // Check just before and after each segment boundary, where rounding
+    // errors show up, and randomly in between. Times must be increasing,
+    // as in the control loop.
+    int32_t times[12 + NUM_RANDOM_SAMPLES] = {
+        0, 1,
+        trj->t1 - 1, trj->t1, trj->t1 + 1,
+        trj->t2 - 1, trj->t2, trj->t2 + 1,
+        trj->t3 - 1, trj->t3, trj->t3 + 1,
+        end,
+    };
+    for (int i = 12; i < 12 + NUM_RANDOM_SAMPLES; i++) {
+        times[i] = pbio_fuzz_random_range(0, end);
+    }
+    qsort(times, 12 + NUM_RANDOM_SAMPLES, sizeof(times[0]), cmp_time);
+
+    int32_t speed_limit = get_speed_limit(c) + SPEED_RESOLUTION;
+
+    pbio_trajectory_reference_t prev;
+    bool have_prev = false;
+
+    for (int i = 0; i < 12 + NUM_RANDOM_SAMPLES; i++) {
+        int32_t time = times[i];
+        if (time < 0 || time > end || (have_prev && time == (int32_t)(prev.time - c->time_start))) {
+            continue;
+        }
+
+        pbio_trajectory_reference_t ref;
+        pbio_trajectory_get_reference(trj, c->time_start + time, &ref);
+        int32_t position = pbio_angle_diff_mdeg(&ref.position, &c->position_start);
+
+        if (ref.time != c->time_start + time) {
+            pbio_fuzz_fail("time %" PRId32 ": reference time is %" PRIu32, time, ref.time);
+        }
+        if (time == 0 && position != 0) {
+            pbio_fuzz_fail("starts at %" PRId32 " instead of 0", position);
+        }
+        if (pbio_int_math_abs(ref.speed) > speed_limit) {
+            pbio_fuzz_fail("time %" PRId32 ": speed %" PRId32 " exceeds %" PRId32, time, ref.speed, speed_limit);
+        }
+        if (pbio_int_math_abs(ref.acceleration) > ACCELERATION_MAX) {
+            pbio_fuzz_fail("time %" PRId32 ": acceleration %" PRId32 " exceeds %d", time, ref.acceleration, ACCELERATION_MAX);
+        }
+        // Maneuvers shorter than one tick get there only after the start.
+        if (time == duration && duration > 0 && angle && position != distance) {
+            pbio_fuzz_fail("reference ends at %" PRId32 " instead of %" PRId32, position, distance);
+        }
+        if (time >= duration && !c->continue_running && ref.speed != 0) {
+            pbio_fuzz_fail("time %" PRId32 ": speed %" PRId32 " after the end", time, ref.speed);
+        }
+
+        if (have_prev) {
+            int64_t dt = time - (int32_t)(prev.time - c->time_start);
+            int32_t prev_position = pbio_angle_diff_mdeg(&prev.position, &c->position_start);
+
+            // Between two points, the speed changes at most as fast as the
+            // larger of both accelerations.
+            int64_t accel = pbio_int_math_max(pbio_int_math_abs(prev.acceleration), pbio_int_math_abs(ref.acceleration));
+            int64_t speed_step = (int64_t)ref.speed - prev.speed;
+            if (llabs(speed_step) > accel * dt / TICKS_PER_S + SPEED_TOLERANCE) {
+                pbio_fuzz_fail("speed jumps by %" PRId64 " between %" PRId64 " and %" PRId32, speed_step, time - dt, time);
+            }
+
+            // The speed is constant or changes linearly between two points on
+            // or between the segment boundaries, so the position changes by
+            // the average speed times the time.
+            int64_t position_step = (int64_t)position - prev_position;
+            int64_t position_expected = ((int64_t)prev.speed + ref.speed) * dt / 2 / TICKS_PER_S;
+            int64_t position_tolerance = POSITION_TOLERANCE + (int64_t)SPEED_RESOLUTION * time / TICKS_PER_S;
+
+            // Ramps are solved for speeds rounded to the speed resolution,
+            // which moves where a ramp ends by up to the speed times the
+            // speed resolution divided by the acceleration.
+            int64_t accel_min = pbio_int_math_min(pbio_int_math_abs(prev.acceleration), pbio_int_math_abs(ref.acceleration));
+            if (accel_min == 0) {
+                accel_min = accel;
+            }
+            if (accel_min != 0) {
+                int64_t speed = pbio_int_math_max(pbio_int_math_abs(prev.speed), pbio_int_math_abs(ref.speed));
+                position_tolerance += speed * SPEED_RESOLUTION / accel_min;
+            }
+            if (llabs(position_step - position_expected) > position_tolerance) {
+                pbio_fuzz_fail("position jumps by %" PRId64 " instead of %" PRId64 " between %" PRId64 " and %" PRId32,
+                    position_step, position_expected, time - dt, time);
+            }
+        }
+
+        prev = ref;
+        have_prev = true;
+    }
+}
+
+/**
+ * Checks the endpoint of an angle based trajectory.
+ *
+ * @param [in]  trj         The trajectory.
+ * @param [in]  c           The command for this trajectory.
+ */
+static void check_angle_endpoint(pbio_trajectory_t *trj, const pbio_trajectory_command_t *c) {
+    int32_t distance = get_distance(c);
+
+    pbio_trajectory_reference_t end;
+    pbio_trajectory_get_endpoint(trj, &end);
+    int32_t position = pbio_angle_diff_mdeg(&end.position, &c->position_start);
+    if (position != distance) {
+        pbio_fuzz_fail("ends at %" PRId32 " instead of %" PRId32, position, distance);
+    }
+}
+
+static bool fuzz_angle_command(void) {
+    pbio_trajectory_t trj;
+
+    random_command(&command, false);
+
+    pbio_error_t err = pbio_trajectory_new_angle_command(&trj, &command);
+    if (err == PBIO_ERROR_INVALID_ARG) {
+        return false;
+    }
+    if (err != PBIO_SUCCESS) {
+        pbio_fuzz_fail("failed with %s", pbio_error_str(err));
+        return true;
+    }
+
+    check_angle_endpoint(&trj, &command);
+    check_reference(&trj, &command, true);
+    return true;
+}
+
+static void fuzz_angle_command_print(FILE *f) {
+    print_command(f, "command", &command);
+}
+
+static bool fuzz_time_command(void) {
+    pbio_trajectory_t trj;
+
+    random_command(&command, true);
+
+    pbio_error_t err = pbio_trajectory_new_time_command(&trj, &command);
+    if (err == PBIO_ERROR_INVALID_ARG) {
+        return false;
+    }
+    if (err != PBIO_SUCCESS) {
+        pbio_fuzz_fail("failed with %s", pbio_error_str(err));
+        return true;
+    }
+
+    if (pbio_trajectory_get_duration(&trj) != command.duration) {
+        pbio_fuzz_fail("takes %" PRIu32 " instead of %" PRIu32, pbio_trajectory_get_duration(&trj), command.duration);
+    }
+
+    check_reference(&trj, &command, false);
+    return true;
+}
+
+static void fuzz_time_command_print(FILE *f) {
+    print_command(f, "command", &command);
+}
+
+/**
+ * Stretches one trajectory to take as long as another, as drive bases do to
+ * make the distance and heading controllers finish at the same time. Each
+ * has its own start speed and settings, as for a drive base that is already
+ * moving or that drives and turns with different settings.
+ */
+static bool fuzz_stretch(void) {
+    pbio_trajectory_t trj;
+    pbio_trajectory_t leader;
+
+    random_command(&command, false);
+    random_command(&leader_command, false);
+
+    // Both start together and end the same way, and the leader is the one
+    // that takes longest.
+    leader_command.time_start = command.time_start;
+    leader_command.continue_running = command.continue_running;
+
+    if (pbio_trajectory_new_angle_command(&trj, &command) != PBIO_SUCCESS ||
+        pbio_trajectory_new_angle_command(&leader, &leader_command) != PBIO_SUCCESS ||
+        pbio_trajectory_get_duration(&trj) > pbio_trajectory_get_duration(&leader)) {
+        return false;
+    }
+
+    pbio_trajectory_t original = trj;
+    pbio_error_t err = pbio_trajectory_stretch(&trj, &leader);
+
+    // If it can't be stretched, the follower finishes early on its own
+    // trajectory, so that must be unchanged.
+    if (err == PBIO_ERROR_INVALID_ARG) {
+        if (memcmp(&trj, &original, sizeof(trj)) != 0) {
+            pbio_fuzz_fail("changed although it could not be stretched");
+        }
+        return true;
+    }
+    if (err != PBIO_SUCCESS) {
+        pbio_fuzz_fail("failed with %s", pbio_error_str(err));
+        return true;
+    }
+
+    // Speeds and accelerations are rounded, so the duration is not always
+    // exactly the same, but it must be closer than without stretching.
+    int32_t duration = pbio_trajectory_get_duration(&trj);
+    int32_t duration_leader = pbio_trajectory_get_duration(&leader);
+    int32_t duration_original = pbio_trajectory_get_duration(&original);
+    if (duration != duration_leader && pbio_int_math_abs(duration - duration_leader) >= duration_leader - duration_original) {
+        pbio_fuzz_fail("takes %" PRId32 " instead of %" PRId32 ", was %" PRId32, duration, duration_leader, duration_original);
+    }
+
+    check_angle_endpoint(&trj, &command);
+    check_reference(&trj, &command, true);
+    return true;
+}
+
+static void fuzz_stretch_print(FILE *f) {
+    print_command(f, "command", &command);
+    print_command(f, "leader", &leader_command);
+}
+
+const pbio_fuzz_case_t pbio_trajectory_fuzz_cases[] = {
+    PBIO_FUZZ(fuzz_angle_command),
+    PBIO_FUZZ(fuzz_time_command),
+    PBIO_FUZZ(fuzz_stretch),
+    END_OF_FUZZ_CASES
+};
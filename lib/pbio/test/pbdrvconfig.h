@@ -10,7 +10,11 @@
 #define PBDRV_CONFIG_BLUETOOTH_BTSTACK_HUB_KIND     0xff
 
 #define PBDRV_CONFIG_COUNTER                        (1)
-#define PBDRV_CONFIG_COUNTER_NUM_DEV                (1)
+#if PBIO_TEST_BENCH
+#define PBDRV_CONFIG_COUNTER_NUM_DEV                (6)
+#else
+#define PBDRV_CONFIG_COUNTER_NUM_DEV                (2)
+#endif
 #define PBDRV_CONFIG_COUNTER_TEST                   (1)
 
 #define PBDRV_CONFIG_LED                            (1)
@@ -23,7 +27,11 @@
 #define PBDRV_CONFIG_IOPORT_TEST                    (1)
 
 #define PBDRV_CONFIG_MOTOR_DRIVER                   (1)
-#define PBDRV_CONFIG_MOTOR_DRIVER_NUM_DEV           (1)
+#if PBIO_TEST_BENCH
+#define PBDRV_CONFIG_MOTOR_DRIVER_NUM_DEV           (6)
+#else
+#define PBDRV_CONFIG_MOTOR_DRIVER_NUM_DEV           (2)
+#endif
 #define PBDRV_CONFIG_MOTOR_DRIVER_TEST              (1)
 
 #define PBDRV_CONFIG_PWM                            (1)
@@ -32,7 +40,22 @@
 
 #define PBDRV_CONFIG_UART                           (1)
 
+// The benchmarks run a full hub with six motors.
+#if PBIO_TEST_BENCH
 #define PBDRV_CONFIG_HAS_PORT_A                     (1)
+#define PBDRV_CONFIG_HAS_PORT_B                     (1)
+#define PBDRV_CONFIG_HAS_PORT_C                     (1)
+#define PBDRV_CONFIG_HAS_PORT_D                     (1)
+#define PBDRV_CONFIG_HAS_PORT_E                     (1)
+#define PBDRV_CONFIG_HAS_PORT_F                     (1)
 #define PBDRV_CONFIG_FIRST_MOTOR_PORT               PBIO_PORT_ID_A
-#define PBDRV_CONFIG_LAST_MOTOR_PORT                PBIO_PORT_ID_A
+#define PBDRV_CONFIG_LAST_MOTOR_PORT                PBIO_PORT_ID_F
+#define PBDRV_CONFIG_NUM_MOTOR_CONTROLLER           (6)
+#else
+// Two motors, for drive base tests.
+#define PBDRV_CONFIG_HAS_PORT_A                     (1)
+#define PBDRV_CONFIG_HAS_PORT_B                     (1)
+#define PBDRV_CONFIG_FIRST_MOTOR_PORT               PBIO_PORT_ID_A
+#define PBDRV_CONFIG_LAST_MOTOR_PORT                PBIO_PORT_ID_B
 #define PBDRV_CONFIG_NUM_MOTOR_CONTROLLER           (2)
+#endif
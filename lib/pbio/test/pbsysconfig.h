@@ -2,7 +2,12 @@
 // Copyright (c) 2020-2022 The Pybricks Authors
 
 #define PBSYS_CONFIG_BLUETOOTH                      (1)
+#define PBSYS_CONFIG_BLUETOOTH_TELEMETRY_BUF_SIZE   (64)
+#define PBSYS_CONFIG_BLUETOOTH_UART_TX_COALESCE_TIME (20)
+#define PBSYS_CONFIG_BLUETOOTH_UART_TX_SIZE_MAX     (64)
 #define PBSYS_CONFIG_HUB_LIGHT_MATRIX               (1)
 #define PBSYS_CONFIG_MAIN                           (0)
 #define PBSYS_CONFIG_PROGRAM_LOAD                   (0)
+#define PBSYS_CONFIG_SETTINGS                       (1)
+#define PBSYS_CONFIG_SETTINGS_SIZE                  (64)
 #define PBSYS_CONFIG_STATUS_LIGHT                   (1)
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+// Common parts of the benchmark and fuzz programs: selecting and running
+// cases, timing and random input data.
+//
+// Command line arguments, if any, select cases whose names start with one of
+// the arguments.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "runner-pbio.h"
+
+static uint64_t random_state;
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Seeds the random number generator.
+ *
+ * Each index gets its own sequence for the same seed, so that a single case
+ * can be run again without running all others before it.
+ *
+ * @param [in]  seed    Any number.
+ * @param [in]  index   Number of the case.
+ */
+void pbio_runner_random_seed(uint32_t seed, uint32_t index) {
+    random_state = ((uint64_t)seed << 32) ^ index;
+    splitmix64(&random_state);
+}
+
+/**
+ * Gets the next pseudo-random number (splitmix64).
+ *
+ * @return              Random number.
+ */
+uint32_t pbio_runner_random(void) {
+    return splitmix64(&random_state) >> 32;
+}
+
+/**
+ * Gets a pseudo-random number in a range, with all values equally likely.
+ *
+ * @param [in]  min     Lowest value.
+ * @param [in]  max     Highest value, inclusive.
+ * @return              Random number.
+ */
+int32_t pbio_runner_random_range(int32_t min, int32_t max) {
+    uint64_t span = (uint64_t)((int64_t)max - min) + 1;
+    return (int32_t)(min + splitmix64(&random_state) % span);
+}
+
+/**
+ * Gets a pseudo-random boolean.
+ *
+ * @return              True or false.
+ */
+bool pbio_runner_random_bool(void) {
+    return splitmix64(&random_state) >> 63;
+}
+
+/**
+ * Gets the time of a monotonic clock.
+ *
+ * @return              The time in ns.
+ */
+uint64_t pbio_runner_get_time_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * Gets a number from an environment variable.
+ *
+ * @param [in]  name            Name of the variable.
+ * @param [in]  default_value   Value if the variable is not set.
+ * @return                      The value.
+ */
+uint32_t pbio_runner_get_env(const char *name, uint32_t default_value) {
+    const char *value = getenv(name);
+    return value ? strtoul(value, NULL, 0) : default_value;
+}
+
+static bool is_selected(int argc, const char **argv, const char *name) {
+    if (argc < 2) {
+        return true;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(name, argv[i], strlen(argv[i])) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Runs all selected cases of all groups.
+ *
+ * @param [in]  argc        Number of command line arguments.
+ * @param [in]  argv        Command line arguments.
+ * @param [in]  groups      The groups, ending with a group with a NULL prefix.
+ * @param [in]  case_size   Size of one case in the arrays of cases.
+ * @param [in]  func        Runs one case.
+ * @return                  Exit status for main(): 0 if all cases passed.
+ */
+int pbio_runner_main(int argc, const char **argv, const pbio_runner_group_t *groups, size_t case_size,
+    pbio_runner_func_t func) {
+
+    int failed = 0;
+
+    for (const pbio_runner_group_t *group = groups; group->prefix; group++) {
+        for (const char *test_case = group->cases; *(const char *const *)test_case; test_case += case_size) {
+            char name[200];
+            snprintf(name, sizeof(name), "%s%s", group->prefix, *(const char *const *)test_case);
+
+            if (!is_selected(argc, argv, name)) {
+                continue;
+            }
+
+            failed += !func(name, test_case);
+            fflush(stdout);
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#ifndef _RUNNER_PBIO_H_
+#define _RUNNER_PBIO_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Group of benchmark or fuzz cases, like a tinytest group.
+ */
+typedef struct {
+    /** Prefix of the names of the cases. */
+    const char *prefix;
+    /**
+     * Array of cases. Each case is a struct that starts with its name. The
+     * array ends with a case with a NULL name.
+     */
+    const void *cases;
+} pbio_runner_group_t;
+
+/**
+ * Runs one selected case.
+ *
+ * @param [in]  name        Full name of the case, including the group prefix.
+ * @param [in]  test_case   The case.
+ * @return                  True if the case passed.
+ */
+typedef bool (*pbio_runner_func_t)(const char *name, const void *test_case);
+
+int pbio_runner_main(int argc, const char **argv, const pbio_runner_group_t *groups, size_t case_size,
+    pbio_runner_func_t func);
+
+uint64_t pbio_runner_get_time_ns(void);
+uint32_t pbio_runner_get_env(const char *name, uint32_t default_value);
+
+// Deterministic random numbers, so that runs with the same seed use the same
+// input data.
+void pbio_runner_random_seed(uint32_t seed, uint32_t index);
+uint32_t pbio_runner_random(void);
+int32_t pbio_runner_random_range(int32_t min, int32_t max);
+bool pbio_runner_random_bool(void);
+
+#endif // _RUNNER_PBIO_H_
@@ -1,5 +1,5 @@
 // SPDX-License-Identifier: MIT
-// Copyright (c) 2020-2022 The Pybricks Authors
+// Copyright (c) 2020-2023 The Pybricks Authors
 
 
 #include <stdint.h>
@@ -42,6 +42,8 @@ pbio_error_t pbdrv_motor_driver_coast(pbdrv_motor_driver_dev_t *driver) {
     driver->output = H_BRIDGE_OUTPUT_LL;
     driver->duty_cycle = 0;
 
+    pbio_test_motor_plant_set_output(driver - test_motor_drivers, true, 0);
+
     return PBIO_SUCCESS;
 }
 
@@ -59,6 +61,8 @@ pbio_error_t pbdrv_motor_driver_set_duty_cycle(pbdrv_motor_driver_dev_t *driver,
 
     driver->duty_cycle = pbio_int_math_abs(duty_cycle);
 
+    pbio_test_motor_plant_set_output(driver - test_motor_drivers, false, duty_cycle);
+
     return PBIO_SUCCESS;
 }
 
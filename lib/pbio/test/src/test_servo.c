@@ -0,0 +1,341 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+// Closed loop tests of servos and drive bases, using the simulated motors in
+// drv/counter.c. Each test checks how well the motors track a command and
+// writes the results to <test name>.txt in the results directory, so that
+// changes to the controller can be compared by more than pass or fail.
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <contiki.h>
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#include <pbio/control.h>
+#include <pbio/drivebase.h>
+#include <pbio/error.h>
+#include <pbio/int_math.h>
+#include <pbio/port.h>
+#include <pbio/servo.h>
+#include <test-pbio.h>
+
+// Motion is considered settled when within this many degrees of the target.
+#define SETTLE_TOLERANCE (2 * 1000)
+
+// Speed is considered settled when within this many deg/s of the target.
+#define SETTLE_TOLERANCE_SPEED (25 * 1000)
+
+// Wheel sizes of the drive base in mm.
+#define WHEEL_DIAMETER (56)
+#define AXLE_TRACK (112)
+
+/**
+ * How the output of a simulation follows a fixed target.
+ */
+typedef struct {
+    /** Target value. */
+    int32_t target;
+    /** Direction of motion toward the target, used to detect overshoot. */
+    int32_t direction;
+    /** Allowed deviation from the target once settled. */
+    int32_t tolerance;
+    /** Time since the start of the command (ms). */
+    uint32_t time;
+    /** Time after which the output stayed within tolerance (ms). */
+    uint32_t settle_time;
+    /** Largest deviation past the target. */
+    int32_t overshoot;
+    /** Deviation from the target at the end. */
+    int32_t error;
+} test_metrics_t;
+
+static void metrics_init(test_metrics_t *metrics, int32_t start, int32_t target, int32_t tolerance) {
+    *metrics = (test_metrics_t) {
+        .target = target,
+        .direction = pbio_int_math_sign(target - start),
+        .tolerance = tolerance,
+    };
+}
+
+static void metrics_update(test_metrics_t *metrics, int32_t value) {
+    metrics->time++;
+    metrics->error = value - metrics->target;
+
+    if (metrics->error * metrics->direction > metrics->overshoot) {
+        metrics->overshoot = metrics->error * metrics->direction;
+    }
+
+    if (pbio_int_math_abs(metrics->error) > metrics->tolerance) {
+        metrics->settle_time = metrics->time;
+    }
+}
+
+static void metrics_write(FILE *f, const char *name, const char *unit, const test_metrics_t *metrics) {
+    if (!f) {
+        return;
+    }
+    fprintf(f, "%s_settle_time %" PRIu32 " ms\n", name, metrics->settle_time);
+    fprintf(f, "%s_overshoot %" PRId32 " %s\n", name, metrics->overshoot, unit);
+    fprintf(f, "%s_steady_state_error %" PRId32 " %s\n", name, metrics->error, unit);
+}
+
+static void results_close(FILE *f) {
+    if (f) {
+        fclose(f);
+    }
+}
+
+/**
+ * Gets a servo on a simulated motor, as a user program would.
+ */
+static pbio_servo_t *setup_servo(pbio_port_id_t port) {
+    pbio_servo_t *srv;
+
+    pbio_test_motor_plant_enable(port - PBDRV_CONFIG_FIRST_MOTOR_PORT);
+
+    tt_want_int_op(pbio_servo_get_servo(port, &srv), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_servo_setup(srv, PBIO_DIRECTION_CLOCKWISE, 1000, true), ==, PBIO_SUCCESS);
+
+    return srv;
+}
+
+/**
+ * Runs a motor by a given angle and checks how it settles at the target.
+ */
+static PT_THREAD(test_servo_run_angle(struct pt *pt)) {
+    static pbio_servo_t *srv;
+    static test_metrics_t metrics;
+    static uint32_t done_time;
+
+    FILE *f;
+
+    PT_BEGIN(pt);
+
+    srv = setup_servo(PBIO_PORT_ID_A);
+    tt_want_int_op(pbio_servo_run_angle(srv, 500, 360, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+
+    // Ramping up and down at 2000 deg/s^2 takes 250 ms each, so the whole
+    // maneuver takes 970 ms. Watch for a while longer to see it hold still.
+    metrics_init(&metrics, 0, 360 * 1000, SETTLE_TOLERANCE);
+    done_time = 0;
+    while (metrics.time < 2000) {
+        pbio_test_clock_tick(1);
+        PT_YIELD(pt);
+        metrics_update(&metrics, pbio_test_motor_plant_get_angle(0));
+        if (!done_time && pbio_control_is_done(&srv->control)) {
+            done_time = metrics.time;
+        }
+    }
+
+    f = fopen("test_servo_run_angle.txt", "w");
+    metrics_write(f, "angle", "mdeg", &metrics);
+    results_close(f);
+
+    tt_want_uint_op(done_time, >=, 970);
+    tt_want_uint_op(done_time, <, 1100);
+    tt_want_uint_op(metrics.settle_time, <, 1100);
+    tt_want_int_op(metrics.overshoot, <, 1000);
+    tt_want_int_op(pbio_int_math_abs(metrics.error), <, 500);
+
+    PT_END(pt);
+}
+
+/**
+ * Holds a motor at its target against a load that is applied afterwards,
+ * which must be overcome by the integral part of the controller.
+ */
+static PT_THREAD(test_servo_hold_load(struct pt *pt)) {
+    static pbio_servo_t *srv;
+    static test_metrics_t metrics;
+
+    FILE *f;
+
+    PT_BEGIN(pt);
+
+    srv = setup_servo(PBIO_PORT_ID_A);
+    tt_want_int_op(pbio_servo_run_target(srv, 500, 90, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+
+    while (!pbio_control_is_done(&srv->control)) {
+        pbio_test_clock_tick(1);
+        PT_YIELD(pt);
+    }
+
+    // A load that is about a third of the stall torque, such as an arm
+    // lifting a weight. It pushes the motor away from the target.
+    pbio_test_motor_plant_set_load(0, 40000);
+
+    metrics_init(&metrics, 90 * 1000, 90 * 1000, SETTLE_TOLERANCE);
+    metrics.direction = -1;
+    while (metrics.time < 3000) {
+        pbio_test_clock_tick(1);
+        PT_YIELD(pt);
+        metrics_update(&metrics, pbio_test_motor_plant_get_angle(0));
+    }
+
+    f = fopen("test_servo_hold_load.txt", "w");
+    metrics_write(f, "angle", "mdeg", &metrics);
+    results_close(f);
+
+    // Here, overshoot is how far the load pushed the motor back.
+    tt_want_int_op(metrics.overshoot, <, 10000);
+    tt_want_uint_op(metrics.settle_time, <, 2000);
+    tt_want_int_op(pbio_int_math_abs(metrics.error), <, SETTLE_TOLERANCE);
+
+    PT_END(pt);
+}
+
+/**
+ * Runs a motor at constant speed for some time and checks how well it keeps
+ * up the speed.
+ */
+static PT_THREAD(test_servo_run_time(struct pt *pt)) {
+    static pbio_servo_t *srv;
+    static test_metrics_t metrics;
+
+    FILE *f;
+
+    PT_BEGIN(pt);
+
+    srv = setup_servo(PBIO_PORT_ID_A);
+    tt_want_int_op(pbio_servo_run_time(srv, 500, 2000, PBIO_CONTROL_ON_COMPLETION_COAST), ==, PBIO_SUCCESS);
+
+    // Check the speed until it starts slowing down, 250 ms before the end.
+    metrics_init(&metrics, 0, 500 * 1000, SETTLE_TOLERANCE_SPEED);
+    while (metrics.time < 1750) {
+        pbio_test_clock_tick(1);
+        PT_YIELD(pt);
+        metrics_update(&metrics, pbio_test_motor_plant_get_speed(0));
+    }
+
+    f = fopen("test_servo_run_time.txt", "w");
+    metrics_write(f, "speed", "mdeg/s", &metrics);
+    results_close(f);
+
+    // Getting to speed takes 250 ms with the default acceleration.
+    tt_want_uint_op(metrics.settle_time, <, 400);
+    tt_want_int_op(metrics.overshoot, <, 50 * 1000);
+    tt_want_int_op(pbio_int_math_abs(metrics.error), <, SETTLE_TOLERANCE_SPEED);
+
+    // It should coast when done, well after the ramp down.
+    while (metrics.time < 2500) {
+        pbio_test_clock_tick(1);
+        PT_YIELD(pt);
+        metrics.time++;
+    }
+    tt_want(pbio_control_is_done(&srv->control));
+    tt_want_int_op(pbio_test_motor_plant_get_speed(0), ==, 0);
+
+    PT_END(pt);
+}
+
+/**
+ * Drives a drive base along a curve and checks where it ends up.
+ */
+static PT_THREAD(test_drivebase_curve(struct pt *pt)) {
+    static pbio_drivebase_t *db;
+    static test_metrics_t distance;
+    static test_metrics_t heading;
+
+    FILE *f;
+
+    PT_BEGIN(pt);
+
+    pbio_servo_t *left = setup_servo(PBIO_PORT_ID_A);
+    pbio_servo_t *right = setup_servo(PBIO_PORT_ID_B);
+    tt_want_int_op(pbio_drivebase_get_drivebase(&db, left, right, WHEEL_DIAMETER, AXLE_TRACK), ==, PBIO_SUCCESS);
+
+    // A quarter circle with 200 mm radius, so 314 mm along the curve.
+    tt_want_int_op(pbio_drivebase_drive_curve(db, 200, 90, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+
+    // Compare the wheel angles with the expected distance in um and heading
+    // in millidegrees.
+    metrics_init(&distance, 0, 314159, 1000);
+    metrics_init(&heading, 0, 90 * 1000, SETTLE_TOLERANCE);
+    while (distance.time < 3000) {
+        pbio_test_clock_tick(1);
+        PT_YIELD(pt);
+
+        int64_t angle_left = pbio_test_motor_plant_get_angle(0);
+        int64_t angle_right = pbio_test_motor_plant_get_angle(1);
+        metrics_update(&distance, (angle_left + angle_right) * 3141593 * WHEEL_DIAMETER / 2 / 360000000);
+        metrics_update(&heading, (angle_left - angle_right) * WHEEL_DIAMETER / 2 / AXLE_TRACK);
+    }
+
+    f = fopen("test_drivebase_curve.txt", "w");
+    metrics_write(f, "distance", "um", &distance);
+    metrics_write(f, "heading", "mdeg", &heading);
+    results_close(f);
+
+    tt_want(pbio_drivebase_is_done(db));
+    tt_want_uint_op(distance.settle_time, <, 2500);
+    tt_want_int_op(distance.overshoot, <, 2000);
+    tt_want_int_op(pbio_int_math_abs(distance.error), <, 1000);
+    tt_want_uint_op(heading.settle_time, <, 2500);
+    tt_want_int_op(heading.overshoot, <, SETTLE_TOLERANCE);
+    tt_want_int_op(pbio_int_math_abs(heading.error), <, SETTLE_TOLERANCE);
+
+    PT_END(pt);
+}
+
+/**
+ * Blocks a running motor and checks how long it takes to detect the stall.
+ */
+static PT_THREAD(test_servo_stall(struct pt *pt)) {
+    static pbio_servo_t *srv;
+    static uint32_t time;
+    static uint32_t latency;
+    bool stalled;
+    uint32_t stall_duration;
+
+    FILE *f;
+
+    PT_BEGIN(pt);
+
+    srv = setup_servo(PBIO_PORT_ID_A);
+    tt_want_int_op(pbio_servo_run_forever(srv, 500), ==, PBIO_SUCCESS);
+
+    for (time = 0; time < 1000; time++) {
+        pbio_test_clock_tick(1);
+        PT_YIELD(pt);
+        pbio_servo_is_stalled(srv, &stalled, &stall_duration);
+        tt_want(!stalled);
+    }
+
+    pbio_test_motor_plant_set_blocked(0, true);
+
+    for (latency = 0; latency < 2000; latency++) {
+        pbio_test_clock_tick(1);
+        PT_YIELD(pt);
+        pbio_servo_is_stalled(srv, &stalled, &stall_duration);
+        if (stalled) {
+            break;
+        }
+    }
+
+    f = fopen("test_servo_stall.txt", "w");
+    if (f) {
+        fprintf(f, "stall_latency %" PRIu32 " ms\n", latency);
+    }
+    results_close(f);
+
+    // The controller may only report a stall once the motor is stuck for the
+    // configured stall time, but it should not take much longer.
+    uint32_t stall_time = pbio_control_time_ticks_to_ms(srv->control.settings.stall_time);
+    tt_want_uint_op(latency, >=, stall_time);
+    tt_want_uint_op(latency, <, stall_time + 200);
+
+    PT_END(pt);
+}
+
+struct testcase_t pbio_servo_tests[] = {
+    PBIO_PT_THREAD_TEST(test_servo_run_angle),
+    PBIO_PT_THREAD_TEST(test_servo_hold_load),
+    PBIO_PT_THREAD_TEST(test_servo_run_time),
+    PBIO_PT_THREAD_TEST(test_drivebase_curve),
+    PBIO_PT_THREAD_TEST(test_servo_stall),
+    END_OF_TESTCASES
+};
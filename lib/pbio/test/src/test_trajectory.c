@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <pbio/int_math.h>
 #include <pbio/trajectory.h>
@@ -370,9 +371,107 @@ static void test_position_trajectory(void *env) {
     }
 }
 
+// Settings of a drive base command in degrees of motor rotation, starting
+// from zero.
+typedef struct {
+    int32_t speed_start;
+    int32_t speed_target;
+    int32_t acceleration;
+    int32_t deceleration;
+    int32_t angle;
+} stretch_command_t;
+
+static void get_stretch_command(const stretch_command_t *s, pbio_trajectory_command_t *c) {
+    *c = (pbio_trajectory_command_t) {
+        .speed_start = s->speed_start * MDEG_PER_DEG,
+        .speed_target = s->speed_target * MDEG_PER_DEG,
+        .speed_max = 1000 * MDEG_PER_DEG,
+        .acceleration = s->acceleration * MDEG_PER_DEG,
+        .deceleration = s->deceleration * MDEG_PER_DEG,
+    };
+    c->position_end.millidegrees = s->angle * MDEG_PER_DEG;
+}
+
+/**
+ * Stretches one trajectory to take as long as another, as drive bases do.
+ * Each has its own start speed and settings. Stretching used to bind the
+ * accelerations, so the reference could jump by many degrees at the end.
+ */
+static void test_stretch_trajectory(void *env) {
+
+    static const struct {
+        stretch_command_t follower;
+        stretch_command_t leader;
+        pbio_error_t err;
+    } cases[] = {
+        // Turning while driving forward from standstill.
+        {
+            .follower = { 0, 100, 400, 400, 90 },
+            .leader = { 0, 500, 1000, 1000, 720 },
+            .err = PBIO_SUCCESS,
+        },
+        // Slowing down and reversing slowly. This jumped by 20 degrees.
+        {
+            .follower = { 150, 300, 2000, 1700, 100 },
+            .leader = { 450, 250, 100, 1000, -230 },
+            .err = PBIO_SUCCESS,
+        },
+        // The leader accelerates too quickly to follow. This bound the
+        // acceleration to the maximum, and ended 1 degree off.
+        {
+            .follower = { 0, 900, 1400, 300, 170 },
+            .leader = { 150, 700, 1400, 100, 120 },
+            .err = PBIO_ERROR_INVALID_ARG,
+        },
+        // Following the leader's slow reversal would take the follower back
+        // and forth. This jumped by 15 degrees.
+        {
+            .follower = { -350, 750, 400, 1700, -690 },
+            .leader = { -350, 500, 100, 700, 280 },
+            .err = PBIO_ERROR_INVALID_ARG,
+        },
+    };
+
+    for (size_t i = 0; i < PBIO_ARRAY_SIZE(cases); i++) {
+        pbio_trajectory_command_t command;
+        pbio_trajectory_t trj;
+        pbio_trajectory_t leader;
+
+        get_stretch_command(&cases[i].leader, &command);
+        tt_want_int_op(pbio_trajectory_new_angle_command(&leader, &command), ==, PBIO_SUCCESS);
+        get_stretch_command(&cases[i].follower, &command);
+        tt_want_int_op(pbio_trajectory_new_angle_command(&trj, &command), ==, PBIO_SUCCESS);
+
+        pbio_trajectory_t original = trj;
+        pbio_error_t err = pbio_trajectory_stretch(&trj, &leader);
+        tt_want_int_op(err, ==, cases[i].err);
+
+        if (err == PBIO_SUCCESS) {
+            // Rounding can make it end a bit sooner or later, but it should
+            // take about as long as the leader.
+            int32_t duration = pbio_trajectory_get_duration(&trj);
+            int32_t duration_leader = pbio_trajectory_get_duration(&leader);
+            tt_want(pbio_int_math_abs(duration - duration_leader) <= duration_leader / 100);
+            tt_want(pbio_int_math_abs(trj.a0) <= 20000);
+            tt_want(pbio_int_math_abs(trj.a2) <= 20000);
+        } else {
+            // Otherwise it must be unchanged, so it finishes sooner.
+            tt_want(memcmp(&trj, &original, sizeof(trj)) == 0);
+        }
+
+        // Either way, it must end where commanded.
+        pbio_trajectory_reference_t end;
+        pbio_trajectory_get_endpoint(&trj, &end);
+        tt_want_int_op(pbio_angle_diff_mdeg(&end.position, &command.position_end), ==, 0);
+
+        walk_trajectory(&trj);
+    }
+}
+
 struct testcase_t pbio_trajectory_tests[] = {
     PBIO_TEST(test_simple_trajectory),
     PBIO_TEST(test_position_trajectory),
     PBIO_TEST(test_infinite_trajectory),
+    PBIO_TEST(test_stretch_trajectory),
     END_OF_TESTCASES
 };
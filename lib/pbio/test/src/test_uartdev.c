@@ -403,6 +403,14 @@ static PT_THREAD(test_boost_color_distance_sensor(struct pt *pt)) {
     tt_uint_op(pbio_iodev_set_mode_end(iodev), ==, PBIO_ERROR_AGAIN);
     tt_uint_op(iodev->mode, !=, 1);
 
+    // one-shot trigger that should fire on the first mode 1 data (value 0)
+    static const pbio_iodev_trigger_t trigger = {
+        .type = PBIO_IODEV_TRIGGER_TYPE_BELOW,
+        .mode = 1,
+        .low = 1,
+    };
+    pbio_iodev_set_trigger(iodev, &trigger);
+
     // data message with new mode
     SIMULATE_RX_MSG(msg88);
 
@@ -412,6 +420,8 @@ static PT_THREAD(test_boost_color_distance_sensor(struct pt *pt)) {
     }));
     tt_uint_op(err, ==, PBIO_SUCCESS);
     tt_uint_op(iodev->mode, ==, 1);
+    tt_want_uint_op(iodev->trigger.count, ==, 1);
+    tt_want_uint_op(iodev->trigger.type, ==, PBIO_IODEV_TRIGGER_TYPE_NONE);
 
 
     // also do mode 8 since it requires the extended mode flag
@@ -440,6 +450,13 @@ static PT_THREAD(test_boost_color_distance_sensor(struct pt *pt)) {
     tt_uint_op(err, ==, PBIO_SUCCESS);
     tt_uint_op(iodev->mode, ==, 8);
 
+    // check that the communication statistics were collected
+    pbio_uartdev_stats_t stats;
+    tt_uint_op(pbio_uartdev_get_stats(iodev, &stats), ==, PBIO_SUCCESS);
+    tt_want_uint_op(stats.rx_msgs, >, stats.data_msgs);
+    tt_want_uint_op(stats.data_msgs, >=, 3);
+    tt_want_uint_op(stats.baud_rate, ==, 115200);
+
     PT_YIELD(pt);
 
 end:
@@ -977,11 +994,142 @@ end:
     PT_END(pt);
 }
 
+static PT_THREAD(test_custom_device_fallback_speed(struct pt *pt)) {
+    // a custom device that asks for a speed above 115200 baud
+    static const uint8_t msg_type[] = { 0x40, 0x64, 0xDB }; // TYPE 100
+    static const uint8_t msg_modes[] = { 0x41, 0x00, 0xBE }; // MODES 1
+    static const uint8_t msg_speed_460800[] = { 0x52, 0x00, 0x08, 0x07, 0x00, 0xA2 }; // SPEED 460800
+    static const uint8_t msg_speed_230400[] = { 0x52, 0x00, 0x84, 0x03, 0x00, 0x2A }; // SPEED 230400
+    static const uint8_t msg_name[] = { 0x90, 0x00, 0x54, 0x45, 0x53, 0x54, 0x79 }; // mode 0 NAME "TEST"
+    static const uint8_t msg_format[] = { 0x90, 0x80, 0x01, 0x00, 0x03, 0x00, 0xED }; // mode 0 FORMAT
+    static const uint8_t msg_nack[] = { 0x02 }; // NACK
+    static const uint8_t msg_data[] = { 0xC0, 0x2A, 0x15 }; // mode 0 data
+    static const uint8_t msg_bad_data[] = { 0xC0, 0x2A, 0x00 }; // mode 0 data with bad checksum
+
+    // used in SIMULATE_RX/TX_MSG macros
+    static struct pt child;
+    static bool ok;
+
+    static pbio_iodev_t *iodev;
+    static pbio_uartdev_stats_t stats;
+    static int i;
+
+    PT_BEGIN(pt);
+
+    process_start(&pbio_uartdev_process);
+    pbio_uartdev_ready(0);
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        test_uart_dev.baud == 115200;
+    }));
+
+    // the device syncs at 115200 and asks for 460800 for data
+    SIMULATE_TX_MSG(msg_speed_115200);
+    SIMULATE_RX_MSG(msg_ack);
+    SIMULATE_RX_MSG(msg_type);
+    SIMULATE_RX_MSG(msg_modes);
+    SIMULATE_RX_MSG(msg_speed_460800);
+    SIMULATE_RX_MSG(msg_name);
+    SIMULATE_RX_MSG(msg_format);
+    SIMULATE_RX_MSG(msg_ack);
+    SIMULATE_TX_MSG(msg_ack);
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        test_uart_dev.baud == 460800;
+    }));
+
+    // too many bad checksums at this speed
+    SIMULATE_TX_MSG(msg_nack);
+    for (i = 0; i < 5; i++) {
+        SIMULATE_RX_MSG(msg_bad_data);
+    }
+
+    // the hub syncs again and asks for a lower speed before syncing, which is
+    // the only time it may send a SPEED command
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        pbio_uartdev_ready(0);
+        test_uart_dev.tx_msg_result == PBIO_ERROR_AGAIN;
+    }));
+    tt_want_uint_op(test_uart_dev.baud, ==, 115200);
+    SIMULATE_TX_MSG(msg_speed_230400);
+    SIMULATE_RX_MSG(msg_ack);
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        test_uart_dev.baud == 230400;
+    }));
+
+    SIMULATE_RX_MSG(msg_type);
+    SIMULATE_RX_MSG(msg_modes);
+    SIMULATE_RX_MSG(msg_speed_230400);
+    SIMULATE_RX_MSG(msg_name);
+    SIMULATE_RX_MSG(msg_format);
+    SIMULATE_RX_MSG(msg_ack);
+    SIMULATE_TX_MSG(msg_ack);
+
+    // communication works at the lower speed
+    for (i = 0; i < 3; i++) {
+        SIMULATE_TX_MSG(msg_nack);
+        SIMULATE_RX_MSG(msg_data);
+    }
+
+    tt_uint_op(pbio_uartdev_get(0, &iodev), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_uartdev_get_stats(iodev, &stats), ==, PBIO_SUCCESS);
+    tt_want_uint_op(stats.baud_rate, ==, 230400);
+    tt_want_uint_op(stats.resyncs, ==, 1);
+
+    // the device stops sending data, like when it is unplugged and plugged
+    // in again, which does not lower the speed any further (the first
+    // keepalive still sees the last data, then 7 are missed)
+    for (i = 0; i < 8; i++) {
+        SIMULATE_TX_MSG(msg_nack);
+    }
+
+    // since the lower speed worked, the next sync tries the higher speed again
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        pbio_uartdev_ready(0);
+        test_uart_dev.tx_msg_result == PBIO_ERROR_AGAIN;
+    }));
+    SIMULATE_TX_MSG(msg_speed_115200);
+    SIMULATE_RX_MSG(msg_ack);
+    SIMULATE_RX_MSG(msg_type);
+    SIMULATE_RX_MSG(msg_modes);
+    SIMULATE_RX_MSG(msg_speed_460800);
+    SIMULATE_RX_MSG(msg_name);
+    SIMULATE_RX_MSG(msg_format);
+    SIMULATE_RX_MSG(msg_ack);
+    SIMULATE_TX_MSG(msg_ack);
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        test_uart_dev.baud == 460800;
+    }));
+
+    SIMULATE_TX_MSG(msg_nack);
+    SIMULATE_RX_MSG(msg_data);
+
+    tt_uint_op(pbio_uartdev_get_stats(iodev, &stats), ==, PBIO_SUCCESS);
+    tt_want_uint_op(stats.baud_rate, ==, 460800);
+    tt_want_uint_op(stats.resyncs, ==, 2);
+
+    PT_YIELD(pt);
+
+end:
+    process_exit(&pbio_uartdev_process);
+
+    PT_END(pt);
+}
+
 struct testcase_t pbio_uartdev_tests[] = {
     PBIO_PT_THREAD_TEST(test_boost_color_distance_sensor),
     PBIO_PT_THREAD_TEST(test_boost_interactive_motor),
     PBIO_PT_THREAD_TEST(test_technic_large_motor),
     PBIO_PT_THREAD_TEST(test_technic_xl_motor),
+    PBIO_PT_THREAD_TEST(test_custom_device_fallback_speed),
     END_OF_TESTCASES
 };
 
@@ -1002,6 +1150,9 @@ pbio_error_t pbdrv_uart_set_baud_rate(pbdrv_uart_dev_t *uart, uint32_t baud) {
 }
 
 void pbdrv_uart_flush(pbdrv_uart_dev_t *uart_dev) {
+    // like the hardware drivers, drop any pending read
+    test_uart_dev.rx_msg = NULL;
+    test_uart_dev.rx_msg_result = PBIO_ERROR_CANCELED;
 }
 
 pbio_error_t pbdrv_uart_read_begin(pbdrv_uart_dev_t *uart, uint8_t *msg, uint8_t length, uint32_t timeout) {
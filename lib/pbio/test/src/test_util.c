@@ -63,9 +63,37 @@ static void test_oneshot(void *env) {
     tt_want(pbio_oneshot(true, &test_oneshot));
 }
 
+static void test_crc32(void *env) {
+    static const uint8_t check[] = "123456789";
+
+    // standard check value for CRC-32 (as used by zlib)
+    tt_want_uint_op(pbio_crc32(check, sizeof(check) - 1), ==, 0xCBF43926);
+    tt_want_uint_op(pbio_crc32(check, 0), ==, 0);
+}
+
+static void test_lz4_decompress(void *env) {
+    // "abc" + match (offset 3, length 9) + "d"
+    static const uint8_t compressed[] = { 0x35, 'a', 'b', 'c', 0x03, 0x00, 0x10, 'd' };
+    static const uint8_t bad_offset[] = { 0x35, 'a', 'b', 'c', 0x04, 0x00, 0x10, 'd' };
+    static const char expected[] = "abcabcabcabcd";
+    uint8_t buf[sizeof(expected) - 1];
+
+    tt_want(pbio_lz4_decompress(compressed, sizeof(compressed), buf, sizeof(buf)));
+    tt_want_int_op(memcmp(buf, expected, sizeof(buf)), ==, 0);
+
+    // wrong expected size
+    tt_want(!pbio_lz4_decompress(compressed, sizeof(compressed), buf, sizeof(buf) - 1));
+    // match before start of output
+    tt_want(!pbio_lz4_decompress(bad_offset, sizeof(bad_offset), buf, sizeof(buf)));
+    // truncated match offset
+    tt_want(!pbio_lz4_decompress(compressed, 5, buf, sizeof(buf)));
+}
+
 struct testcase_t pbio_util_tests[] = {
     PBIO_TEST(test_uuid128_reverse_compare),
     PBIO_TEST(test_uuid128_reverse_copy),
     PBIO_TEST(test_oneshot),
+    PBIO_TEST(test_crc32),
+    PBIO_TEST(test_lz4_decompress),
     END_OF_TESTCASES
 };
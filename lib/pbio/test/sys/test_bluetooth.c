@@ -3,12 +3,16 @@
 
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <btstack.h>
 #include <contiki.h>
 #include <tinytest_macros.h>
 #include <tinytest.h>
 
+#include <pbdrv/bluetooth.h>
+#include <pbdrv/clock.h>
+#include <pbio/protocol.h>
 #include <pbio/util.h>
 #include <pbsys/bluetooth.h>
 #include <pbsys/main.h>
@@ -104,7 +108,215 @@ static PT_THREAD(test_bluetooth(struct pt *pt)) {
     PT_END(pt);
 }
 
+// Fills a telemetry record with a pattern that is different for each record.
+static void make_record(uint8_t *record, uint32_t size, uint8_t id) {
+    for (uint32_t i = 0; i < size; i++) {
+        record[i] = id + i;
+    }
+}
+
+// Tests if the last notification is the given telemetry record.
+static bool is_last_notification(const uint8_t *record, uint32_t size) {
+    uint32_t notification_size;
+    const uint8_t *notification = pbio_test_bluetooth_get_pybricks_service_notification(&notification_size);
+
+    return notification_size == size + 1
+           && notification[0] == PBIO_PYBRICKS_EVENT_WRITE_TELEMETRY
+           && memcmp(&notification[1], record, size) == 0;
+}
+
+static PT_THREAD(test_bluetooth_telemetry(struct pt *pt)) {
+    // With the default MTU, a record can be up to 20 - 1 bytes. The test
+    // config has a 64 byte buffer, so three records with their size byte fit.
+    static uint8_t record[20];
+    static const uint32_t record_size_max = 19;
+
+    PT_BEGIN(pt);
+
+    pbsys_bluetooth_init();
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        pbio_test_bluetooth_is_advertising_enabled();
+    }));
+
+    // nothing can be sent without a connection
+    make_record(record, record_size_max, 0);
+    tt_want_int_op(pbsys_bluetooth_send_telemetry(record, record_size_max), ==, PBIO_ERROR_INVALID_OP);
+
+    pbio_test_bluetooth_connect();
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        pbio_test_bluetooth_is_connected();
+    }));
+
+    pbio_test_bluetooth_enable_pybricks_service_notifications();
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        pbsys_bluetooth_send_telemetry(record, record_size_max) != PBIO_ERROR_INVALID_OP;
+    }));
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        is_last_notification(record, record_size_max);
+    }));
+
+    // records must fit in one notification
+    tt_want_int_op(pbsys_bluetooth_send_telemetry(record, 0), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want_int_op(pbsys_bluetooth_send_telemetry(record, record_size_max + 1), ==, PBIO_ERROR_INVALID_ARG);
+
+    // Records are queued whole, so the buffer is full after three, even
+    // though there is space for part of a fourth one. Queuing them without
+    // yielding makes sure none of them is sent yet. Together with the first
+    // record, this makes the last one wrap around the end of the buffer.
+    for (uint8_t id = 1; id <= 3; id++) {
+        make_record(record, record_size_max, id);
+        tt_want_int_op(pbsys_bluetooth_send_telemetry(record, record_size_max), ==, PBIO_SUCCESS);
+    }
+    tt_want_int_op(pbsys_bluetooth_send_telemetry(record, record_size_max), ==, PBIO_ERROR_AGAIN);
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        is_last_notification(record, record_size_max);
+    }));
+
+    // Now that the buffer is empty, records of other sizes must still come
+    // out whole and in order.
+    make_record(record, 5, 4);
+    tt_want_int_op(pbsys_bluetooth_send_telemetry(record, 5), ==, PBIO_SUCCESS);
+    make_record(record, 7, 5);
+    tt_want_int_op(pbsys_bluetooth_send_telemetry(record, 7), ==, PBIO_SUCCESS);
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        is_last_notification(record, 7);
+    }));
+
+    PT_END(pt);
+}
+
+static PT_THREAD(test_bluetooth_uart_tx_coalesce(struct pt *pt)) {
+    // The test config holds back UART data for 20 ms and allows notifications
+    // of up to 64 bytes if the MTU is big enough.
+    static const uint32_t coalesce_time = 20;
+    static const uint32_t packet_size = 64;
+    static const uint8_t record[] = { 1, 2, 3 };
+    static uint8_t data[64];
+    static uint32_t count, start, size;
+    pbsys_bluetooth_tx_stats_t stats;
+
+    PT_BEGIN(pt);
+
+    pbsys_bluetooth_init();
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        pbio_test_bluetooth_is_advertising_enabled();
+    }));
+
+    pbio_test_bluetooth_connect();
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        pbio_test_bluetooth_is_connected();
+    }));
+
+    pbio_test_bluetooth_enable_uart_service_notifications();
+    pbio_test_bluetooth_enable_pybricks_service_notifications();
+    pbio_test_bluetooth_exchange_mtu(packet_size + 3);
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        pbdrv_bluetooth_is_connected(PBDRV_BLUETOOTH_CONNECTION_UART)
+        && pbdrv_bluetooth_is_connected(PBDRV_BLUETOOTH_CONNECTION_PYBRICKS)
+        && pbdrv_bluetooth_get_mtu() == packet_size + 3;
+    }));
+
+    memset(data, 'a', sizeof(data));
+
+    // Data that does not fill a notification is held back for the coalescing
+    // time and then sent anyway.
+    count = pbio_test_bluetooth_get_uart_service_notification_count();
+    start = pbdrv_clock_get_ms();
+    size = 5;
+    tt_want_int_op(pbsys_bluetooth_tx(data, &size), ==, PBIO_SUCCESS);
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        pbio_test_bluetooth_get_uart_service_notification_count() != count;
+    }));
+
+    tt_want_uint_op(pbdrv_clock_get_ms() - start, >=, coalesce_time);
+    tt_want_uint_op(pbio_test_bluetooth_get_uart_service_notification_size(), ==, 5);
+
+    // Data that fills a whole notification of the negotiated MTU is sent
+    // right away.
+    count = pbio_test_bluetooth_get_uart_service_notification_count();
+    start = pbdrv_clock_get_ms();
+    size = packet_size;
+    tt_want_int_op(pbsys_bluetooth_tx(data, &size), ==, PBIO_SUCCESS);
+    tt_want_uint_op(size, ==, packet_size);
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        pbio_test_bluetooth_get_uart_service_notification_count() != count;
+    }));
+
+    tt_want_uint_op(pbdrv_clock_get_ms() - start, <, coalesce_time);
+    tt_want_uint_op(pbio_test_bluetooth_get_uart_service_notification_size(), ==, packet_size);
+
+    // UART data that is held back at the head of the queue does not hold up
+    // Pybricks service notifications queued after it.
+    count = pbio_test_bluetooth_get_uart_service_notification_count();
+    start = pbdrv_clock_get_ms();
+    size = 3;
+    tt_want_int_op(pbsys_bluetooth_tx(data, &size), ==, PBIO_SUCCESS);
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        pbdrv_clock_get_ms() - start >= 2;
+    }));
+
+    tt_want_int_op(pbsys_bluetooth_send_telemetry(record, sizeof(record)), ==, PBIO_SUCCESS);
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        is_last_notification(record, sizeof(record));
+    }));
+
+    tt_want_uint_op(pbdrv_clock_get_ms() - start, <, coalesce_time);
+    tt_want_uint_op(pbio_test_bluetooth_get_uart_service_notification_count(), ==, count);
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        pbio_test_bluetooth_get_uart_service_notification_count() != count;
+    }));
+
+    tt_want_uint_op(pbio_test_bluetooth_get_uart_service_notification_size(), ==, 3);
+
+    // The rate is measured over at least one second, so wait until it is
+    // known.
+    start = pbdrv_clock_get_ms();
+
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        pbdrv_clock_get_ms() - start >= 1000;
+    }));
+
+    pbsys_bluetooth_tx_get_stats(&stats);
+    tt_want_uint_op(stats.bytes, ==, 5 + packet_size + 3);
+    tt_want_uint_op(stats.notifications, ==, 3);
+    tt_want_uint_op(stats.rate, >, 0);
+    tt_want_uint_op(stats.rate, <=, stats.bytes);
+
+    PT_END(pt);
+}
+
 struct testcase_t pbsys_bluetooth_tests[] = {
     PBIO_PT_THREAD_TEST(test_bluetooth),
+    PBIO_PT_THREAD_TEST(test_bluetooth_telemetry),
+    PBIO_PT_THREAD_TEST(test_bluetooth_uart_tx_coalesce),
     END_OF_TESTCASES
 };
@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include <stdint.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#include <pbio/protocol.h>
+#include <pbio/util.h>
+#include <pbsys/command.h>
+#include <test-pbio.h>
+
+// The test configuration has no program load module, so commands that get
+// past the parser return this.
+#define NOT_SUPPORTED PBIO_PYBRICKS_ERROR_INVALID_COMMAND
+
+static void test_command_compare_user_ram(void *env) {
+    uint8_t cmd[14] = { PBIO_PYBRICKS_COMMAND_COMPARE_USER_RAM };
+    pbio_set_uint32_le(&cmd[1], 0);
+    pbio_set_uint32_le(&cmd[5], 100);
+    pbio_set_uint32_le(&cmd[9], 0x12345678);
+
+    tt_want_uint_op(pbsys_command(cmd, 13), ==, NOT_SUPPORTED);
+
+    // The parameters must not be truncated or followed by anything else.
+    tt_want_uint_op(pbsys_command(cmd, 1), ==, PBIO_PYBRICKS_ERROR_VALUE_NOT_ALLOWED);
+    tt_want_uint_op(pbsys_command(cmd, 12), ==, PBIO_PYBRICKS_ERROR_VALUE_NOT_ALLOWED);
+    tt_want_uint_op(pbsys_command(cmd, 14), ==, PBIO_PYBRICKS_ERROR_VALUE_NOT_ALLOWED);
+}
+
+static void test_command_verify_user_program(void *env) {
+    uint8_t cmd[6] = { PBIO_PYBRICKS_COMMAND_VERIFY_USER_PROGRAM };
+    pbio_set_uint32_le(&cmd[1], 0x12345678);
+
+    tt_want_uint_op(pbsys_command(cmd, 5), ==, NOT_SUPPORTED);
+
+    // The checksum must not be truncated or followed by anything else.
+    tt_want_uint_op(pbsys_command(cmd, 1), ==, PBIO_PYBRICKS_ERROR_VALUE_NOT_ALLOWED);
+    tt_want_uint_op(pbsys_command(cmd, 4), ==, PBIO_PYBRICKS_ERROR_VALUE_NOT_ALLOWED);
+    tt_want_uint_op(pbsys_command(cmd, 6), ==, PBIO_PYBRICKS_ERROR_VALUE_NOT_ALLOWED);
+}
+
+struct testcase_t pbsys_command_tests[] = {
+    PBIO_TEST(test_command_verify_user_program),
+    PBIO_TEST(test_command_compare_user_ram),
+    END_OF_TESTCASES
+};
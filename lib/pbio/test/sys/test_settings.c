@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#include <pbio/error.h>
+#include <pbio/util.h>
+#include <pbsys/settings.h>
+#include <test-pbio.h>
+
+#include "../../sys/program_load.h"
+
+// Copies of the settings area, as loaded from storage.
+static uint8_t settings[2][PBSYS_CONFIG_SETTINGS_SIZE];
+static uint32_t settings_changed_count;
+
+uint8_t *pbsys_program_load_get_settings(uint32_t copy) {
+    return settings[copy];
+}
+
+void pbsys_program_load_settings_changed(void) {
+    settings_changed_count++;
+}
+
+// Writes a copy of the settings area like the settings module does, with one
+// record of the given key and value.
+static void make_area(uint8_t *area, uint16_t sequence, const char *key, const char *value) {
+    uint8_t *record = &area[8];
+    uint32_t key_size = strlen(key);
+    uint32_t value_size = strlen(value);
+    uint32_t used = 3 + key_size + value_size;
+
+    record[0] = key_size;
+    pbio_set_uint16_le(&record[1], value_size);
+    memcpy(&record[3], key, key_size);
+    memcpy(&record[3 + key_size], value, value_size);
+
+    pbio_set_uint16_le(&area[4], used);
+    pbio_set_uint16_le(&area[6], sequence);
+    pbio_set_uint32_le(&area[0], pbio_crc32(&area[4], 4 + used));
+}
+
+// Tests if the setting has the given value.
+static bool has_value(const char *key, const char *value) {
+    const uint8_t *data;
+    uint32_t size;
+
+    if (pbsys_settings_get(key, strlen(key), &data, &size) != PBIO_SUCCESS) {
+        return false;
+    }
+
+    return size == strlen(value) && memcmp(data, value, size) == 0;
+}
+
+static void test_settings_set_get_delete(void *env) {
+    const uint8_t *data;
+    uint32_t size;
+
+    // Storage is erased to zero, which is not valid, so it starts empty.
+    tt_want_int_op(pbsys_settings_get("a", 1, &data, &size), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want_uint_op(settings_changed_count, ==, 0);
+
+    tt_want_int_op(pbsys_settings_set("a", 1, (const uint8_t *)"one", 3), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbsys_settings_set("bb", 2, (const uint8_t *)"two", 3), ==, PBIO_SUCCESS);
+    tt_want(has_value("a", "one"));
+    tt_want(has_value("bb", "two"));
+    tt_want_uint_op(settings_changed_count, ==, 2);
+
+    // Replacing a value with one of another size keeps the other records.
+    tt_want_int_op(pbsys_settings_set("a", 1, (const uint8_t *)"three", 5), ==, PBIO_SUCCESS);
+    tt_want(has_value("a", "three"));
+    tt_want(has_value("bb", "two"));
+
+    tt_want_int_op(pbsys_settings_delete("a", 1), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbsys_settings_get("a", 1, &data, &size), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want(has_value("bb", "two"));
+    tt_want_int_op(pbsys_settings_delete("a", 1), ==, PBIO_ERROR_INVALID_ARG);
+
+    // Keys must not be empty or too long.
+    static const char long_key[PBSYS_SETTINGS_MAX_KEY_SIZE + 1];
+    tt_want_int_op(pbsys_settings_set("", 0, (const uint8_t *)"x", 1), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want_int_op(pbsys_settings_set(long_key, sizeof(long_key), (const uint8_t *)"x", 1), ==, PBIO_ERROR_INVALID_ARG);
+
+    // A value that doesn't fit changes nothing.
+    static const uint8_t big[PBSYS_CONFIG_SETTINGS_SIZE];
+    uint32_t changed_count = settings_changed_count;
+    tt_want_int_op(pbsys_settings_set("bb", 2, big, sizeof(big) - 8 - 3 - 2 + 1), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want(has_value("bb", "two"));
+    tt_want_uint_op(settings_changed_count, ==, changed_count);
+
+    // The biggest value that fits replaces the old one.
+    tt_want_int_op(pbsys_settings_set("bb", 2, big, sizeof(big) - 8 - 3 - 2), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbsys_settings_get("bb", 2, &data, &size), ==, PBIO_SUCCESS);
+    tt_want_uint_op(size, ==, sizeof(big) - 8 - 3 - 2);
+}
+
+static void test_settings_update_other_copy(void *env) {
+    make_area(settings[0], 7, "key", "old");
+
+    uint8_t saved[PBSYS_CONFIG_SETTINGS_SIZE];
+    memcpy(saved, settings[0], sizeof(saved));
+
+    tt_want_int_op(pbsys_settings_set("key", 3, (const uint8_t *)"new", 3), ==, PBIO_SUCCESS);
+    tt_want(has_value("key", "new"));
+
+    // The update went to the other copy, so the old one is still intact if
+    // saving it is interrupted.
+    tt_want_int_op(memcmp(settings[0], saved, sizeof(saved)), ==, 0);
+    tt_want_uint_op(pbio_get_uint16_le(&settings[1][6]), ==, 8);
+
+    // The next update goes back to the first copy.
+    tt_want_int_op(pbsys_settings_delete("key", 3), ==, PBIO_SUCCESS);
+    tt_want_uint_op(pbio_get_uint16_le(&settings[0][6]), ==, 9);
+    tt_want(!has_value("key", "new"));
+}
+
+static void test_settings_newest_copy(void *env) {
+    make_area(settings[0], 1, "key", "old");
+    make_area(settings[1], 2, "key", "new");
+
+    tt_want(has_value("key", "new"));
+}
+
+static void test_settings_newest_copy_wrapped(void *env) {
+    make_area(settings[0], 0, "key", "new");
+    make_area(settings[1], 0xFFFF, "key", "old");
+
+    tt_want(has_value("key", "new"));
+}
+
+static void test_settings_bad_crc(void *env) {
+    make_area(settings[0], 1, "key", "old");
+    make_area(settings[1], 2, "key", "new");
+
+    // An interrupted write of the newer copy.
+    settings[1][12] ^= 1;
+
+    tt_want(has_value("key", "old"));
+}
+
+static void test_settings_bad_record(void *env) {
+    make_area(settings[0], 1, "key", "old");
+    make_area(settings[1], 2, "key", "new");
+
+    // A record that claims to be longer than the used area makes the copy
+    // invalid even with a matching checksum.
+    pbio_set_uint16_le(&settings[1][8 + 1], 4);
+    pbio_set_uint32_le(&settings[1][0], pbio_crc32(&settings[1][4], 4 + 9));
+
+    tt_want(has_value("key", "old"));
+}
+
+static void test_settings_bad_used_size(void *env) {
+    make_area(settings[0], 1, "key", "old");
+
+    // More data than fits in the area.
+    pbio_set_uint16_le(&settings[0][4], PBSYS_CONFIG_SETTINGS_SIZE);
+
+    const uint8_t *data;
+    uint32_t size;
+    tt_want_int_op(pbsys_settings_get("key", 3, &data, &size), ==, PBIO_ERROR_INVALID_ARG);
+
+    // It starts empty, but still works.
+    tt_want_int_op(pbsys_settings_set("key", 3, (const uint8_t *)"new", 3), ==, PBIO_SUCCESS);
+    tt_want(has_value("key", "new"));
+}
+
+struct testcase_t pbsys_settings_tests[] = {
+    PBIO_TEST(test_settings_set_get_delete),
+    PBIO_TEST(test_settings_update_other_copy),
+    PBIO_TEST(test_settings_newest_copy),
+    PBIO_TEST(test_settings_newest_copy_wrapped),
+    PBIO_TEST(test_settings_bad_crc),
+    PBIO_TEST(test_settings_bad_record),
+    PBIO_TEST(test_settings_bad_used_size),
+    END_OF_TESTCASES
+};
@@ -60,6 +60,9 @@ void pbio_test_run_thread(void *env) {
     }
 
 end:;
+    #if PROCESS_CONF_PROFILE
+    process_profile_print(stderr);
+    #endif
 }
 
 static void *setup(const struct testcase_t *test_case) {
@@ -86,11 +89,14 @@ extern struct testcase_t pbio_light_animation_tests[];
 extern struct testcase_t pbio_color_light_tests[];
 extern struct testcase_t pbio_light_matrix_tests[];
 extern struct testcase_t pbio_int_math_tests[];
+extern struct testcase_t pbio_servo_tests[];
 extern struct testcase_t pbio_task_tests[];
 extern struct testcase_t pbio_trajectory_tests[];
 extern struct testcase_t pbio_uartdev_tests[];
 extern struct testcase_t pbio_util_tests[];
 extern struct testcase_t pbsys_bluetooth_tests[];
+extern struct testcase_t pbsys_command_tests[];
+extern struct testcase_t pbsys_settings_tests[];
 extern struct testcase_t pbsys_status_tests[];
 static struct testgroup_t test_groups[] = {
     { "drv/bluetooth/", pbdrv_bluetooth_tests },
@@ -103,15 +109,21 @@ static struct testgroup_t test_groups[] = {
     { "src/light/", pbio_color_light_tests },
     { "src/light/", pbio_light_matrix_tests },
     { "src/math/", pbio_int_math_tests },
+    { "src/servo/", pbio_servo_tests },
     { "src/task/", pbio_task_tests, },
     { "src/trajectory/", pbio_trajectory_tests },
     { "src/uartdev/", pbio_uartdev_tests, },
     { "src/util/", pbio_util_tests, },
     { "sys/bluetooth/", pbsys_bluetooth_tests, },
+    { "sys/command/", pbsys_command_tests, },
+    { "sys/settings/", pbsys_settings_tests, },
     { "sys/status/", pbsys_status_tests, },
     END_OF_GROUPS
 };
 
+// The benchmark program links the same drivers and has its own main.
+#if !PBIO_TEST_BENCH && !PBIO_TEST_FUZZ
+
 int main(int argc, const char **argv) {
     const char *results_dir = getenv("PBIO_TEST_RESULTS_DIR");
     if (results_dir) {
@@ -122,3 +134,5 @@ int main(int argc, const char **argv) {
 
     return tinytest_main(argc, argv, test_groups);
 }
+
+#endif // !PBIO_TEST_BENCH && !PBIO_TEST_FUZZ
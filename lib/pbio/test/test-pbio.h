@@ -4,6 +4,7 @@
 #ifndef _TEST_PBIO_H_
 #define _TEST_PBIO_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include <pbio/button.h>
@@ -29,9 +30,12 @@ bool pbio_test_bluetooth_is_connected(void);
 void pbio_test_bluetooth_connect(void);
 void pbio_test_bluetooth_enable_uart_service_notifications(void);
 uint32_t pbio_test_bluetooth_get_uart_service_notification_count(void);
+uint32_t pbio_test_bluetooth_get_uart_service_notification_size(void);
+void pbio_test_bluetooth_exchange_mtu(uint16_t mtu);
 void pbio_test_bluetooth_send_uart_data(const uint8_t *data, uint32_t size);
 void pbio_test_bluetooth_enable_pybricks_service_notifications(void);
 uint32_t pbio_test_bluetooth_get_pybricks_service_notification_count(void);
+const uint8_t *pbio_test_bluetooth_get_pybricks_service_notification(uint32_t *size);
 
 typedef enum {
     PBIO_TEST_BLUETOOTH_STATE_OFF,
@@ -44,4 +48,12 @@ pbio_test_bluetooth_control_state_t pbio_test_bluetooth_get_control_state(void);
 void pbio_test_counter_set_angle(int32_t rotations, int32_t millidegrees);
 void pbio_test_counter_set_abs_angle(int32_t millidegrees);
 
+// these can be used by tests that run motors in closed loop
+void pbio_test_motor_plant_enable(uint8_t id);
+void pbio_test_motor_plant_set_load(uint8_t id, int32_t torque);
+void pbio_test_motor_plant_set_blocked(uint8_t id, bool blocked);
+int32_t pbio_test_motor_plant_get_angle(uint8_t id);
+int32_t pbio_test_motor_plant_get_speed(uint8_t id);
+void pbio_test_motor_plant_set_output(uint8_t id, bool coast, int32_t duty_cycle);
+
 #endif // _TEST_PBIO_H_
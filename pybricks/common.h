@@ -24,6 +24,20 @@
 void pb_package_pybricks_init(bool import_all);
 void pb_package_pybricks_deinit(void);
 
+/**
+ * Garbage collection statistics, kept by ports that implement gc_collect().
+ */
+typedef struct _pb_gc_stats_t {
+    /** Number of collections. */
+    uint32_t collections;
+    /** Total time spent collecting, in microseconds. */
+    uint32_t time_us;
+    /** Longest collection, in microseconds. */
+    uint32_t time_max_us;
+} pb_gc_stats_t;
+
+extern pb_gc_stats_t pb_gc_stats;
+
 #if PYBRICKS_PY_COMMON_CHARGER
 
 extern const mp_obj_type_t pb_type_Charger;
@@ -134,6 +148,13 @@ extern const mp_obj_module_t pb_type_System;
 
 #endif // PYBRICKS_PY_COMMON_SYSTEM
 
+#if PYBRICKS_PY_COMMON_BLE
+
+extern const mp_obj_module_t pb_type_BLE;
+void pb_type_BLE_cleanup(void);
+
+#endif // PYBRICKS_PY_COMMON_BLE
+
 #endif // PYBRICKS_PY_COMMON
 
 #endif // PYBRICKS_INCLUDED_PYBRICKS_COMMON_H
@@ -0,0 +1,240 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include "py/mpconfig.h"
+
+#if PYBRICKS_PY_COMMON && PYBRICKS_PY_COMMON_BLE
+
+#include <stdint.h>
+#include <string.h>
+
+#include <pbdrv/bluetooth.h>
+#include <pbio/task.h>
+#include <lego_lwp3.h>
+
+#include "py/obj.h"
+#include "py/runtime.h"
+
+#include <pybricks/common.h>
+#include <pybricks/util_mp/pb_kwarg_helper.h>
+#include <pybricks/util_pb/pb_error.h>
+#include <pybricks/util_pb/pb_task.h>
+
+// Broadcast data is sent as a single manufacturer-specific data structure:
+// length, type (0xFF), LEGO company ID (2 bytes), channel, data.
+#define BLE_AD_HEADER_SIZE (5)
+#define BLE_AD_DATA_SIZE_MAX (31 - BLE_AD_HEADER_SIZE)
+
+// Time in ms to wait for stop tasks of the previous program during cleanup.
+#define BLE_CLEANUP_TIMEOUT (1000)
+
+// Maximum number of channels that can be observed at the same time.
+#define BLE_OBSERVE_CHANNELS_MAX (8)
+
+typedef struct {
+    uint8_t channel;
+    uint8_t size;
+    int8_t rssi;
+    bool received;
+    uint8_t data[BLE_AD_DATA_SIZE_MAX];
+} ble_observed_data_t;
+
+STATIC struct {
+    pbdrv_bluetooth_value_t value;
+    uint8_t data[31];
+} __attribute__((packed)) broadcast_value;
+
+STATIC pbio_task_t broadcast_task;
+STATIC pbio_task_t observe_task;
+
+STATIC ble_observed_data_t observed_data[BLE_OBSERVE_CHANNELS_MAX];
+STATIC uint8_t observed_count;
+STATIC bool is_observing;
+
+STATIC ble_observed_data_t *lookup_observed_data(uint8_t channel) {
+    for (uint8_t i = 0; i < observed_count; i++) {
+        if (observed_data[i].channel == channel) {
+            return &observed_data[i];
+        }
+    }
+    return NULL;
+}
+
+// Caches the latest broadcast on each of the observed channels.
+STATIC void handle_observe_event(pbdrv_bluetooth_ad_type_t event_type, const uint8_t *data, uint8_t length, int8_t rssi) {
+    if (event_type != PBDRV_BLUETOOTH_AD_TYPE_ADV_NONCONN_IND) {
+        return;
+    }
+
+    // Find the first manufacturer-specific data structure.
+    for (uint8_t offset = 0; offset + 1 < length; offset += data[offset] + 1) {
+        const uint8_t *ad = &data[offset];
+
+        if (ad[0] == 0 || offset + ad[0] + 1 > length) {
+            return;
+        }
+
+        if (ad[1] != 0xFF) {
+            continue;
+        }
+
+        if (ad[0] + 1 < BLE_AD_HEADER_SIZE || ad[2] != (LWP3_LEGO_COMPANY_ID & 0xFF) || ad[3] != (LWP3_LEGO_COMPANY_ID >> 8)) {
+            return;
+        }
+
+        ble_observed_data_t *ch_data = lookup_observed_data(ad[4]);
+        if (!ch_data) {
+            return;
+        }
+
+        ch_data->size = ad[0] + 1 - BLE_AD_HEADER_SIZE;
+        ch_data->rssi = rssi;
+        ch_data->received = true;
+        memcpy(ch_data->data, &ad[BLE_AD_HEADER_SIZE], ch_data->size);
+        return;
+    }
+}
+
+// pybricks.common.BLE.broadcast
+STATIC mp_obj_t pb_type_BLE_broadcast(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_FUNCTION(n_args, pos_args, kw_args,
+        PB_ARG_REQUIRED(channel),
+        PB_ARG_REQUIRED(data));
+
+    mp_int_t channel = mp_obj_get_int(channel_in);
+
+    if (channel < 0 || channel > UINT8_MAX) {
+        mp_raise_ValueError(MP_ERROR_TEXT("channel must be 0 to 255"));
+    }
+
+    // None stops broadcasting.
+    if (data_in == mp_const_none) {
+        broadcast_value.value.size = 0;
+        pbdrv_bluetooth_start_broadcasting(&broadcast_task, &broadcast_value.value);
+        pb_wait_task(&broadcast_task, -1);
+        return mp_const_none;
+    }
+
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(data_in, &bufinfo, MP_BUFFER_READ);
+
+    if (bufinfo.len > BLE_AD_DATA_SIZE_MAX) {
+        mp_raise_ValueError(MP_ERROR_TEXT("data is too big"));
+    }
+
+    uint8_t *ad = broadcast_value.value.data;
+    ad[0] = BLE_AD_HEADER_SIZE - 1 + bufinfo.len;
+    ad[1] = 0xFF; // manufacturer-specific data
+    ad[2] = LWP3_LEGO_COMPANY_ID & 0xFF;
+    ad[3] = LWP3_LEGO_COMPANY_ID >> 8;
+    ad[4] = channel;
+    memcpy(&ad[BLE_AD_HEADER_SIZE], bufinfo.buf, bufinfo.len);
+    broadcast_value.value.size = BLE_AD_HEADER_SIZE + bufinfo.len;
+
+    pbdrv_bluetooth_start_broadcasting(&broadcast_task, &broadcast_value.value);
+    pb_wait_task(&broadcast_task, -1);
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(pb_type_BLE_broadcast_obj, 0, pb_type_BLE_broadcast);
+
+// pybricks.common.BLE.observe
+STATIC mp_obj_t pb_type_BLE_observe(mp_obj_t channel_in) {
+    mp_int_t channel = mp_obj_get_int(channel_in);
+
+    if (channel < 0 || channel > UINT8_MAX) {
+        mp_raise_ValueError(MP_ERROR_TEXT("channel must be 0 to 255"));
+    }
+
+    ble_observed_data_t *ch_data = lookup_observed_data(channel);
+
+    // The first call for each channel adds it to the scan filter.
+    if (!ch_data) {
+        if (observed_count == BLE_OBSERVE_CHANNELS_MAX) {
+            mp_raise_ValueError(MP_ERROR_TEXT("too many channels"));
+        }
+
+        ch_data = &observed_data[observed_count++];
+        ch_data->channel = channel;
+        ch_data->received = false;
+    }
+
+    if (!is_observing) {
+        pbdrv_bluetooth_start_observing(&observe_task, handle_observe_event);
+        pb_wait_task(&observe_task, -1);
+        is_observing = true;
+    }
+
+    if (!ch_data->received) {
+        return mp_const_none;
+    }
+
+    return mp_obj_new_bytes(ch_data->data, ch_data->size);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(pb_type_BLE_observe_obj, pb_type_BLE_observe);
+
+// pybricks.common.BLE.signal_strength
+STATIC mp_obj_t pb_type_BLE_signal_strength(mp_obj_t channel_in) {
+    ble_observed_data_t *ch_data = lookup_observed_data(mp_obj_get_int(channel_in));
+
+    if (!ch_data || !ch_data->received) {
+        return MP_OBJ_NEW_SMALL_INT(INT8_MIN);
+    }
+
+    return MP_OBJ_NEW_SMALL_INT(ch_data->rssi);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(pb_type_BLE_signal_strength_obj, pb_type_BLE_signal_strength);
+
+// Waits for a stop task of the previous program to finish, so that it can be
+// queued again. It is usually done already, since any broadcast or observe
+// task of this program was queued after it and was waited for.
+STATIC bool cleanup_task_ready(pbio_task_t *task) {
+    nlr_buf_t nlr;
+
+    if (nlr_push(&nlr) == 0) {
+        pb_wait_task(task, BLE_CLEANUP_TIMEOUT);
+        nlr_pop();
+    }
+
+    // If it failed or timed out, the program has ended anyway, so the
+    // exception is not raised. Only a task that is still queued can't be used.
+    return task->status != PBIO_ERROR_AGAIN;
+}
+
+void pb_type_BLE_cleanup(void) {
+    static pbio_task_t stop_broadcast_task;
+    static pbio_task_t stop_observe_task;
+    static pbdrv_bluetooth_value_t stop_broadcast_value;
+
+    // The tasks complete after the program ends, so they are not waited for.
+    // Re-initializing a task that is still queued would corrupt the queue, so
+    // the tasks from the previous cleanup are waited for instead.
+
+    if (broadcast_value.value.size && cleanup_task_ready(&stop_broadcast_task)) {
+        broadcast_value.value.size = 0;
+        pbdrv_bluetooth_start_broadcasting(&stop_broadcast_task, &stop_broadcast_value);
+    }
+
+    if (is_observing && cleanup_task_ready(&stop_observe_task)) {
+        is_observing = false;
+        pbdrv_bluetooth_stop_observing(&stop_observe_task);
+    }
+
+    observed_count = 0;
+}
+
+STATIC const mp_rom_map_elem_t common_BLE_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_broadcast), MP_ROM_PTR(&pb_type_BLE_broadcast_obj) },
+    { MP_ROM_QSTR(MP_QSTR_observe), MP_ROM_PTR(&pb_type_BLE_observe_obj) },
+    { MP_ROM_QSTR(MP_QSTR_signal_strength), MP_ROM_PTR(&pb_type_BLE_signal_strength_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(common_BLE_locals_dict, common_BLE_locals_dict_table);
+
+// type(pybricks.common.BLE) but implemented as module for reduced build size,
+// like pybricks.common.System.
+const mp_obj_module_t pb_type_BLE = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t *)&common_BLE_locals_dict,
+};
+
+#endif // PYBRICKS_PY_COMMON && PYBRICKS_PY_COMMON_BLE
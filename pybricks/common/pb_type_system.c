@@ -1,5 +1,5 @@
 // SPDX-License-Identifier: MIT
-// Copyright (c) 2018-2022 The Pybricks Authors
+// Copyright (c) 2018-2023 The Pybricks Authors
 
 #include "py/mpconfig.h"
 
@@ -39,6 +39,7 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_0(pb_type_System_reset_reason_obj, pb_type_System
 
 #if PBIO_CONFIG_ENABLE_SYS
 
+#include <pbsys/bluetooth.h>
 #include <pbsys/status.h>
 #include <pbsys/program_stop.h>
 
@@ -123,6 +124,20 @@ STATIC mp_obj_t pb_type_System_storage(size_t n_args, const mp_obj_t *pos_args,
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(pb_type_System_storage_obj, 0, pb_type_System_storage);
 
+STATIC mp_obj_t pb_type_System_send(mp_obj_t data_in) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(data_in, &bufinfo, MP_BUFFER_READ);
+
+    // Does not block. Records that can't be sent right now are dropped.
+    pbio_error_t err = pbsys_bluetooth_send_telemetry(bufinfo.buf, bufinfo.len);
+    if (err == PBIO_ERROR_INVALID_ARG) {
+        pb_assert(err);
+    }
+
+    return mp_obj_new_bool(err == PBIO_SUCCESS);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(pb_type_System_send_obj, pb_type_System_send);
+
 #endif // PBIO_CONFIG_ENABLE_SYS
 
 // dir(pybricks.common.System)
@@ -135,6 +150,7 @@ STATIC const mp_rom_map_elem_t common_System_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_set_stop_button), MP_ROM_PTR(&pb_type_System_set_stop_button_obj) },
     { MP_ROM_QSTR(MP_QSTR_shutdown), MP_ROM_PTR(&pb_type_System_shutdown_obj) },
     { MP_ROM_QSTR(MP_QSTR_storage), MP_ROM_PTR(&pb_type_System_storage_obj) },
+    { MP_ROM_QSTR(MP_QSTR_send), MP_ROM_PTR(&pb_type_System_send_obj) },
     #endif
 };
 STATIC MP_DEFINE_CONST_DICT(common_System_locals_dict, common_System_locals_dict_table);
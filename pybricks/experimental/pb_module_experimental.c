@@ -5,12 +5,14 @@
 
 #if PYBRICKS_PY_EXPERIMENTAL
 
+#include "py/gc.h"
 #include "py/mphal.h"
 #include "py/obj.h"
 #include "py/objstr.h"
 #include "py/runtime.h"
 #include "py/mperrno.h"
 
+#include <pbio/config.h>
 #include <pbio/util.h>
 
 #include <pybricks/util_mp/pb_obj_helper.h>
@@ -18,6 +20,7 @@
 
 #include <pybricks/util_pb/pb_error.h>
 
+#include <pybricks/common.h>
 #include <pybricks/robotics.h>
 
 #if PYBRICKS_HUB_EV3BRICK
@@ -92,6 +95,53 @@ STATIC mp_obj_t experimental_hello_world(size_t n_args, const mp_obj_t *pos_args
 // See also experimental_globals_table below. This function object is added there to make it importable.
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(experimental_hello_world_obj, 0, experimental_hello_world);
 
+// pybricks.experimental.mem_stats
+STATIC mp_obj_t experimental_mem_stats(void) {
+    gc_info_t info;
+    gc_info(&info);
+
+    #if PYBRICKS_HUB_VIRTUALHUB || PYBRICKS_HUB_EV3BRICK
+    // The garbage collector of unix based ports is not ours, so it is not
+    // counted. Use the gc module instead.
+    mp_obj_t ret[] = {
+        mp_obj_new_int(info.used),
+        mp_const_none,
+        mp_const_none,
+        mp_const_none,
+    };
+    #else
+    mp_obj_t ret[] = {
+        mp_obj_new_int(info.used),
+        mp_obj_new_int(pb_gc_stats.collections),
+        mp_obj_new_int(pb_gc_stats.time_us),
+        mp_obj_new_int(pb_gc_stats.time_max_us),
+    };
+    #endif
+    return mp_obj_new_tuple(MP_ARRAY_SIZE(ret), ret);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(experimental_mem_stats_obj, experimental_mem_stats);
+
+#if PBIO_CONFIG_ENABLE_SYS
+
+#include <pbsys/bluetooth.h>
+
+// pybricks.experimental.stdout_stats
+STATIC mp_obj_t experimental_stdout_stats(void) {
+    pbsys_bluetooth_tx_stats_t stats;
+    pbsys_bluetooth_tx_get_stats(&stats);
+
+    // All zeros on hubs without Bluetooth or while not connected.
+    mp_obj_t ret[] = {
+        mp_obj_new_int_from_uint(stats.bytes),
+        mp_obj_new_int_from_uint(stats.notifications),
+        mp_obj_new_int_from_uint(stats.rate),
+    };
+    return mp_obj_new_tuple(MP_ARRAY_SIZE(ret), ret);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(experimental_stdout_stats_obj, experimental_stdout_stats);
+
+#endif // PBIO_CONFIG_ENABLE_SYS
+
 STATIC const mp_rom_map_elem_t experimental_globals_table[] = {
     #if PYBRICKS_HUB_EV3BRICK
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_experimental) },
@@ -101,6 +151,10 @@ STATIC const mp_rom_map_elem_t experimental_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_experimental) },
     #endif // PYBRICKS_HUB_EV3BRICK
     { MP_ROM_QSTR(MP_QSTR_hello_world), MP_ROM_PTR(&experimental_hello_world_obj) },
+    { MP_ROM_QSTR(MP_QSTR_mem_stats), MP_ROM_PTR(&experimental_mem_stats_obj) },
+    #if PBIO_CONFIG_ENABLE_SYS
+    { MP_ROM_QSTR(MP_QSTR_stdout_stats), MP_ROM_PTR(&experimental_stdout_stats_obj) },
+    #endif
 };
 STATIC MP_DEFINE_CONST_DICT(pb_module_experimental_globals, experimental_globals_table);
 
@@ -16,6 +16,7 @@
 typedef struct _hubs_CityHub_obj_t {
     mp_obj_base_t base;
     mp_obj_t battery;
+    mp_obj_t ble;
     mp_obj_t button;
     mp_obj_t light;
     mp_obj_t system;
@@ -29,6 +30,7 @@ STATIC mp_obj_t hubs_CityHub_make_new(const mp_obj_type_t *type, size_t n_args,
     hubs_CityHub_obj_t *self = m_new_obj(hubs_CityHub_obj_t);
     self->base.type = (mp_obj_type_t *)type;
     self->battery = MP_OBJ_FROM_PTR(&pb_module_battery);
+    self->ble = MP_OBJ_FROM_PTR(&pb_type_BLE);
     self->button = pb_type_Keypad_obj_new(MP_ARRAY_SIZE(cityhub_buttons), cityhub_buttons, pbio_button_is_pressed);
     self->light = common_ColorLight_internal_obj_new(pbsys_status_light);
     self->system = MP_OBJ_FROM_PTR(&pb_type_System);
@@ -37,6 +39,7 @@ STATIC mp_obj_t hubs_CityHub_make_new(const mp_obj_type_t *type, size_t n_args,
 
 STATIC const pb_attr_dict_entry_t hubs_CityHub_attr_dict[] = {
     PB_DEFINE_CONST_ATTR_RO(MP_QSTR_battery, hubs_CityHub_obj_t, battery),
+    PB_DEFINE_CONST_ATTR_RO(MP_QSTR_ble, hubs_CityHub_obj_t, ble),
     PB_DEFINE_CONST_ATTR_RO(MP_QSTR_button, hubs_CityHub_obj_t, button),
     PB_DEFINE_CONST_ATTR_RO(MP_QSTR_light, hubs_CityHub_obj_t, light),
     PB_DEFINE_CONST_ATTR_RO(MP_QSTR_system, hubs_CityHub_obj_t, system),
@@ -27,6 +27,7 @@
 typedef struct _hubs_EssentialHub_obj_t {
     mp_obj_base_t base;
     mp_obj_t battery;
+    mp_obj_t ble;
     mp_obj_t buttons;
     mp_obj_t charger;
     mp_obj_t imu;
@@ -46,6 +47,7 @@ STATIC mp_obj_t hubs_EssentialHub_make_new(const mp_obj_type_t *type, size_t n_a
     hubs_EssentialHub_obj_t *self = m_new_obj(hubs_EssentialHub_obj_t);
     self->base.type = (mp_obj_type_t *)type;
     self->battery = MP_OBJ_FROM_PTR(&pb_module_battery);
+    self->ble = MP_OBJ_FROM_PTR(&pb_type_BLE);
     self->buttons = pb_type_Keypad_obj_new(MP_ARRAY_SIZE(essentialhub_buttons), essentialhub_buttons, pbio_button_is_pressed);
     self->charger = pb_type_Charger_obj_new();
     self->imu = pb_type_IMU_obj_new(top_side_in, front_side_in);
@@ -56,6 +58,7 @@ STATIC mp_obj_t hubs_EssentialHub_make_new(const mp_obj_type_t *type, size_t n_a
 
 STATIC const pb_attr_dict_entry_t hubs_EssentialHub_attr_dict[] = {
     PB_DEFINE_CONST_ATTR_RO(MP_QSTR_battery, hubs_EssentialHub_obj_t, battery),
+    PB_DEFINE_CONST_ATTR_RO(MP_QSTR_ble, hubs_EssentialHub_obj_t, ble),
     PB_DEFINE_CONST_ATTR_RO(MP_QSTR_button, hubs_EssentialHub_obj_t, buttons),
     PB_DEFINE_CONST_ATTR_RO(MP_QSTR_charger, hubs_EssentialHub_obj_t, charger),
     PB_DEFINE_CONST_ATTR_RO(MP_QSTR_imu, hubs_EssentialHub_obj_t, imu),
@@ -1,11 +1,12 @@
 // SPDX-License-Identifier: MIT
-// Copyright (c) 2018-2020 The Pybricks Authors
+// Copyright (c) 2018-2023 The Pybricks Authors
 
 #include "py/mpconfig.h"
 
 #if PYBRICKS_PY_IODEVICES && PYBRICKS_PY_PUPDEVICES
 
 #include <pbio/iodev.h>
+#include <pbio/servo.h>
 
 #include "py/objstr.h"
 
@@ -51,6 +52,29 @@ STATIC mp_obj_t iodevices_PUPDevice_info(mp_obj_t self_in) {
 }
 MP_DEFINE_CONST_FUN_OBJ_1(iodevices_PUPDevice_info_obj, iodevices_PUPDevice_info);
 
+// pybricks.iodevices.PUPDevice.stats
+STATIC mp_obj_t iodevices_PUPDevice_stats(mp_obj_t self_in) {
+    iodevices_PUPDevice_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    pbio_uartdev_stats_t stats;
+    pb_device_get_uart_stats(self->pbdev, &stats);
+
+    mp_obj_t stats_dict = mp_obj_new_dict(10);
+    mp_obj_dict_store(stats_dict, MP_ROM_QSTR(MP_QSTR_rx_bytes), mp_obj_new_int_from_uint(stats.rx_bytes));
+    mp_obj_dict_store(stats_dict, MP_ROM_QSTR(MP_QSTR_rx_msgs), mp_obj_new_int_from_uint(stats.rx_msgs));
+    mp_obj_dict_store(stats_dict, MP_ROM_QSTR(MP_QSTR_data_msgs), mp_obj_new_int_from_uint(stats.data_msgs));
+    mp_obj_dict_store(stats_dict, MP_ROM_QSTR(MP_QSTR_checksum_errors), mp_obj_new_int_from_uint(stats.checksum_errors));
+    mp_obj_dict_store(stats_dict, MP_ROM_QSTR(MP_QSTR_framing_errors), mp_obj_new_int_from_uint(stats.framing_errors));
+    mp_obj_dict_store(stats_dict, MP_ROM_QSTR(MP_QSTR_keep_alive_timeouts), mp_obj_new_int_from_uint(stats.keep_alive_timeouts));
+    mp_obj_dict_store(stats_dict, MP_ROM_QSTR(MP_QSTR_resyncs), mp_obj_new_int_from_uint(stats.resyncs));
+    mp_obj_dict_store(stats_dict, MP_ROM_QSTR(MP_QSTR_mode_change_time), mp_obj_new_int_from_uint(stats.mode_change_time));
+    mp_obj_dict_store(stats_dict, MP_ROM_QSTR(MP_QSTR_data_rate), mp_obj_new_int_from_uint(stats.data_rate));
+    mp_obj_dict_store(stats_dict, MP_ROM_QSTR(MP_QSTR_baud_rate), mp_obj_new_int_from_uint(stats.baud_rate));
+
+    return stats_dict;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(iodevices_PUPDevice_stats_obj, iodevices_PUPDevice_stats);
+
 // pybricks.iodevices.PUPDevice.read
 STATIC mp_obj_t iodevices_PUPDevice_read(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
@@ -101,11 +125,84 @@ STATIC mp_obj_t iodevices_PUPDevice_write(size_t n_args, const mp_obj_t *pos_arg
 }
 MP_DEFINE_CONST_FUN_OBJ_KW(iodevices_PUPDevice_write_obj, 1, iodevices_PUPDevice_write);
 
+#if PYBRICKS_PY_COMMON_MOTORS
+// Stops the motor given as the stop argument of set_trigger. This runs in
+// the UART driver as soon as the data arrives, without waiting for the program.
+STATIC void iodevices_PUPDevice_stop_motor(pbio_iodev_t *iodev, void *context) {
+    pbio_servo_stop(context, PBIO_CONTROL_ON_COMPLETION_BRAKE);
+}
+#endif
+
+// pybricks.iodevices.PUPDevice.set_trigger
+STATIC mp_obj_t iodevices_PUPDevice_set_trigger(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        iodevices_PUPDevice_obj_t, self,
+        PB_ARG_REQUIRED(mode),
+        PB_ARG_DEFAULT_INT(index, 0),
+        PB_ARG_DEFAULT_NONE(low),
+        PB_ARG_DEFAULT_NONE(high),
+        PB_ARG_DEFAULT_FALSE(outside),
+        PB_ARG_DEFAULT_FALSE(edge),
+        PB_ARG_DEFAULT_NONE(stop));
+
+    // No thresholds means no trigger.
+    if (low_in == mp_const_none && high_in == mp_const_none) {
+        pb_device_clear_trigger(self->pbdev);
+        return mp_const_none;
+    }
+
+    pbio_iodev_trigger_t trigger = {
+        .mode = mp_obj_get_int(mode_in),
+        .index = mp_obj_get_int(index_in),
+        .edge = mp_obj_is_true(edge_in),
+    };
+
+    if (high_in == mp_const_none) {
+        trigger.type = PBIO_IODEV_TRIGGER_TYPE_BELOW;
+        trigger.low = pb_obj_get_int(low_in);
+    } else if (low_in == mp_const_none) {
+        trigger.type = PBIO_IODEV_TRIGGER_TYPE_ABOVE;
+        trigger.high = pb_obj_get_int(high_in);
+    } else {
+        trigger.type = mp_obj_is_true(outside_in) ? PBIO_IODEV_TRIGGER_TYPE_OUTSIDE : PBIO_IODEV_TRIGGER_TYPE_INSIDE;
+        trigger.low = pb_obj_get_int(low_in);
+        trigger.high = pb_obj_get_int(high_in);
+        if (trigger.low > trigger.high) {
+            pb_assert(PBIO_ERROR_INVALID_ARG);
+        }
+    }
+
+    if (stop_in != mp_const_none) {
+        #if PYBRICKS_PY_COMMON_MOTORS
+        common_Motor_obj_t *motor = pb_obj_get_base_class_obj(stop_in, &pb_type_Motor.type);
+        trigger.callback = iodevices_PUPDevice_stop_motor;
+        trigger.context = motor->srv;
+        #else
+        pb_assert(PBIO_ERROR_NOT_SUPPORTED);
+        #endif
+    }
+
+    pb_device_set_trigger(self->pbdev, &trigger);
+
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(iodevices_PUPDevice_set_trigger_obj, 1, iodevices_PUPDevice_set_trigger);
+
+// pybricks.iodevices.PUPDevice.triggered
+STATIC mp_obj_t iodevices_PUPDevice_triggered(mp_obj_t self_in) {
+    iodevices_PUPDevice_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_int_from_uint(pb_device_get_trigger_count(self->pbdev));
+}
+MP_DEFINE_CONST_FUN_OBJ_1(iodevices_PUPDevice_triggered_obj, iodevices_PUPDevice_triggered);
+
 // dir(pybricks.iodevices.PUPDevice)
 STATIC const mp_rom_map_elem_t iodevices_PUPDevice_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_read),       MP_ROM_PTR(&iodevices_PUPDevice_read_obj) },
     { MP_ROM_QSTR(MP_QSTR_write),      MP_ROM_PTR(&iodevices_PUPDevice_write_obj)},
     { MP_ROM_QSTR(MP_QSTR_info),       MP_ROM_PTR(&iodevices_PUPDevice_info_obj)},
+    { MP_ROM_QSTR(MP_QSTR_stats),      MP_ROM_PTR(&iodevices_PUPDevice_stats_obj)},
+    { MP_ROM_QSTR(MP_QSTR_set_trigger), MP_ROM_PTR(&iodevices_PUPDevice_set_trigger_obj)},
+    { MP_ROM_QSTR(MP_QSTR_triggered),  MP_ROM_PTR(&iodevices_PUPDevice_triggered_obj)},
 };
 STATIC MP_DEFINE_CONST_DICT(iodevices_PUPDevice_locals_dict, iodevices_PUPDevice_locals_dict_table);
 
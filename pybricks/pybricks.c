@@ -125,4 +125,9 @@ void pb_package_pybricks_deinit(void) {
     #if PYBRICKS_PY_PUPDEVICES
     pb_type_Remote_cleanup();
     #endif // PYBRICKS_PY_PUPDEVICES
+
+    // Stop broadcasting and observing.
+    #if PYBRICKS_PY_COMMON && PYBRICKS_PY_COMMON_BLE
+    pb_type_BLE_cleanup();
+    #endif // PYBRICKS_PY_COMMON && PYBRICKS_PY_COMMON_BLE
 }
@@ -1,5 +1,5 @@
 // SPDX-License-Identifier: MIT
-// Copyright (c) 2018-2020 The Pybricks Authors
+// Copyright (c) 2018-2023 The Pybricks Authors
 
 #ifndef PYBRICKS_INCLUDED_PYBRICKS_TOOLS_H
 #define PYBRICKS_INCLUDED_PYBRICKS_TOOLS_H
@@ -10,8 +10,18 @@
 
 #include "py/obj.h"
 
+#include <pbsys/config.h>
+
 extern const mp_obj_type_t pb_type_StopWatch;
 
+#if PYBRICKS_PY_PUPDEVICES
+extern const mp_obj_type_t pb_type_Awaitable;
+#endif
+
+#if PBSYS_CONFIG_SETTINGS
+extern const mp_obj_module_t pb_type_Settings;
+#endif
+
 #endif // PYBRICKS_PY_TOOLS
 
 #endif // PYBRICKS_INCLUDED_PYBRICKS_TOOLS_H
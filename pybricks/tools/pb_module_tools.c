@@ -1,5 +1,5 @@
 // SPDX-License-Identifier: MIT
-// Copyright (c) 2018-2020 The Pybricks Authors
+// Copyright (c) 2018-2023 The Pybricks Authors
 
 #include "py/mpconfig.h"
 
@@ -8,10 +8,12 @@
 #include "py/mphal.h"
 #include "py/runtime.h"
 
+#include <pybricks/parameters.h>
 #include <pybricks/tools.h>
 
 #include <pybricks/util_mp/pb_kwarg_helper.h>
 #include <pybricks/util_mp/pb_obj_helper.h>
+#include <pybricks/util_pb/pb_device.h>
 #include <pybricks/util_pb/pb_error.h>
 
 STATIC mp_obj_t tools_wait(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
@@ -26,10 +28,53 @@ STATIC mp_obj_t tools_wait(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(tools_wait_obj, 0, tools_wait);
 
+#if PYBRICKS_PY_PUPDEVICES
+// pybricks.tools.wait_for_devices
+STATIC mp_obj_t tools_wait_for_devices(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_FUNCTION(n_args, pos_args, kw_args,
+        PB_ARG_REQUIRED(devices));
+
+    pb_assert_type(devices_in, &mp_type_dict);
+    mp_map_t *map = mp_obj_dict_get_map(devices_in);
+
+    // Collect all ports first so we can wait for all of them at once.
+    pbio_port_id_t *ports = m_new(pbio_port_id_t, map->used);
+    size_t num_ports = 0;
+    for (size_t i = 0; i < map->alloc; i++) {
+        if (mp_map_slot_is_filled(map, i)) {
+            ports[num_ports++] = pb_type_enum_get_value(map->table[i].key, &pb_enum_type_Port);
+        }
+    }
+    pb_device_wait_ports(ports, num_ports);
+    m_del(pbio_port_id_t, ports, map->used);
+
+    // Now that all ports are ready, create the device objects, which also
+    // verifies that the expected device is attached.
+    mp_obj_t result = mp_obj_new_dict(map->used);
+    for (size_t i = 0; i < map->alloc; i++) {
+        if (mp_map_slot_is_filled(map, i)) {
+            mp_obj_t device = mp_call_function_1(map->table[i].value, map->table[i].key);
+            mp_obj_dict_store(result, map->table[i].key, device);
+        }
+    }
+    return result;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(tools_wait_for_devices_obj, 0, tools_wait_for_devices);
+#endif // PYBRICKS_PY_PUPDEVICES
+
 STATIC const mp_rom_map_elem_t tools_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__),    MP_ROM_QSTR(MP_QSTR_tools)      },
     { MP_ROM_QSTR(MP_QSTR_wait),        MP_ROM_PTR(&tools_wait_obj)     },
+    #if PYBRICKS_PY_PUPDEVICES
+    { MP_ROM_QSTR(MP_QSTR_wait_for_devices), MP_ROM_PTR(&tools_wait_for_devices_obj) },
+    #endif
     { MP_ROM_QSTR(MP_QSTR_StopWatch),   MP_ROM_PTR(&pb_type_StopWatch)  },
+    #if PYBRICKS_PY_PUPDEVICES
+    { MP_ROM_QSTR(MP_QSTR_Awaitable),   MP_ROM_PTR(&pb_type_Awaitable)  },
+    #endif
+    #if PBSYS_CONFIG_SETTINGS
+    { MP_ROM_QSTR(MP_QSTR_Settings),    MP_ROM_PTR(&pb_type_Settings)   },
+    #endif
 };
 STATIC MP_DEFINE_CONST_DICT(pb_module_tools_globals, tools_globals_table);
 
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include "py/mpconfig.h"
+
+#if PYBRICKS_PY_TOOLS && PYBRICKS_PY_PUPDEVICES
+
+#include "py/obj.h"
+#include "py/runtime.h"
+
+#include <pybricks/tools.h>
+
+#include <pybricks/util_pb/pb_device.h>
+
+// Awaitable device method call.
+typedef struct _tools_Awaitable_obj_t {
+    mp_obj_base_t base;
+    pb_device_mode_change_t change;
+    bool done;
+    mp_obj_t func;
+    size_t n_args;
+    mp_obj_t args[];
+} tools_Awaitable_obj_t;
+
+// pybricks.tools.Awaitable.__init__
+STATIC mp_obj_t tools_Awaitable_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, MP_OBJ_FUN_ARGS_MAX, false);
+
+    tools_Awaitable_obj_t *self = m_new_obj_var(tools_Awaitable_obj_t, mp_obj_t, n_args - 1);
+    self->base.type = (mp_obj_type_t *)type;
+    self->change.state = PB_DEVICE_MODE_CHANGE_IDLE;
+    self->done = false;
+    self->func = args[0];
+    self->n_args = n_args - 1;
+    for (size_t i = 0; i < self->n_args; i++) {
+        self->args[i] = args[i + 1];
+    }
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// Advances the method call. Yields None while waiting for the device and
+// returns the result of the method via StopIteration when done.
+STATIC mp_obj_t tools_Awaitable_iternext(mp_obj_t self_in) {
+    tools_Awaitable_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    if (self->done) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+
+    mp_obj_t result;
+    if (!pb_device_call_nonblocking(&self->change, self->func, self->n_args, self->args, &result)) {
+        return mp_const_none;
+    }
+
+    self->done = true;
+    nlr_raise(mp_obj_new_exception_arg1(&mp_type_StopIteration, result));
+}
+
+// pybricks.tools.Awaitable.close
+STATIC mp_obj_t tools_Awaitable_close(mp_obj_t self_in) {
+    tools_Awaitable_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    pb_device_cancel_nonblocking(&self->change);
+    self->done = true;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(tools_Awaitable_close_obj, tools_Awaitable_close);
+
+STATIC const mp_rom_map_elem_t tools_Awaitable_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_close), MP_ROM_PTR(&tools_Awaitable_close_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(tools_Awaitable_locals_dict, tools_Awaitable_locals_dict_table);
+
+// type(pybricks.tools.Awaitable)
+const mp_obj_type_t pb_type_Awaitable = {
+    { &mp_type_type },
+    .name = MP_QSTR_Awaitable,
+    .make_new = tools_Awaitable_make_new,
+    .getiter = mp_identity_getiter,
+    .iternext = tools_Awaitable_iternext,
+    .locals_dict = (mp_obj_dict_t *)&tools_Awaitable_locals_dict,
+};
+
+#endif // PYBRICKS_PY_TOOLS && PYBRICKS_PY_PUPDEVICES
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include "py/mpconfig.h"
+
+#if PYBRICKS_PY_TOOLS
+
+#include <pbsys/settings.h>
+
+#if PBSYS_CONFIG_SETTINGS
+
+#include "py/obj.h"
+#include "py/runtime.h"
+
+#include <pybricks/tools.h>
+
+#include <pybricks/util_mp/pb_kwarg_helper.h>
+#include <pybricks/util_pb/pb_error.h>
+
+// pybricks.tools.Settings.get
+STATIC mp_obj_t tools_Settings_get(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_FUNCTION(n_args, pos_args, kw_args,
+        PB_ARG_REQUIRED(key),
+        PB_ARG_DEFAULT_NONE(default));
+
+    size_t key_size;
+    const char *key = mp_obj_str_get_data(key_in, &key_size);
+
+    const uint8_t *value;
+    uint32_t size;
+    if (pbsys_settings_get(key, key_size, &value, &size) != PBIO_SUCCESS) {
+        return default_in;
+    }
+    return mp_obj_new_bytes(value, size);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(tools_Settings_get_obj, 0, tools_Settings_get);
+
+// pybricks.tools.Settings.set
+STATIC mp_obj_t tools_Settings_set(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_FUNCTION(n_args, pos_args, kw_args,
+        PB_ARG_REQUIRED(key),
+        PB_ARG_REQUIRED(value));
+
+    size_t key_size;
+    const char *key = mp_obj_str_get_data(key_in, &key_size);
+
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(value_in, &bufinfo, MP_BUFFER_READ);
+
+    pb_assert(pbsys_settings_set(key, key_size, bufinfo.buf, bufinfo.len));
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(tools_Settings_set_obj, 0, tools_Settings_set);
+
+// pybricks.tools.Settings.remove
+STATIC mp_obj_t tools_Settings_remove(mp_obj_t key_in) {
+    size_t key_size;
+    const char *key = mp_obj_str_get_data(key_in, &key_size);
+
+    if (pbsys_settings_delete(key, key_size) != PBIO_SUCCESS) {
+        nlr_raise(mp_obj_new_exception_arg1(&mp_type_KeyError, key_in));
+    }
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(tools_Settings_remove_obj, tools_Settings_remove);
+
+STATIC const mp_rom_map_elem_t tools_Settings_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_get), MP_ROM_PTR(&tools_Settings_get_obj) },
+    { MP_ROM_QSTR(MP_QSTR_set), MP_ROM_PTR(&tools_Settings_set_obj) },
+    { MP_ROM_QSTR(MP_QSTR_remove), MP_ROM_PTR(&tools_Settings_remove_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(tools_Settings_locals_dict, tools_Settings_locals_dict_table);
+
+// type(pybricks.tools.Settings) but implemented as module for reduced build size,
+// like pybricks.common.System.
+const mp_obj_module_t pb_type_Settings = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t *)&tools_Settings_locals_dict,
+};
+
+#endif // PBSYS_CONFIG_SETTINGS
+
+#endif // PYBRICKS_PY_TOOLS
@@ -5,17 +5,62 @@
 #define _PBDEVICE_H_
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include <pbio/color.h>
 #include <pbio/error.h>
 #include <pbio/iodev.h>
 #include <pbio/port.h>
+#include <pbio/uartdev.h>
+
+#include "py/obj.h"
 
 typedef struct _pb_device_t pb_device_t;
 
+/**
+ * State of a mode change done by pb_device_call_nonblocking().
+ */
+typedef enum {
+    /** No mode change in progress. */
+    PB_DEVICE_MODE_CHANGE_IDLE,
+    /** Waiting to start the mode change. */
+    PB_DEVICE_MODE_CHANGE_BEGIN,
+    /** Waiting for data in the new mode. */
+    PB_DEVICE_MODE_CHANGE_END,
+    /** Waiting for the new mode to take effect. */
+    PB_DEVICE_MODE_CHANGE_DELAY,
+} pb_device_mode_change_state_t;
+
+/**
+ * Mode change done by pb_device_call_nonblocking().
+ */
+typedef struct {
+    /** The device that is changing modes. */
+    pbio_iodev_t *iodev;
+    /** Time (ms) after which the new mode may be used. */
+    uint32_t ready_time;
+    /** The new mode. */
+    uint8_t mode;
+    /** Current state. */
+    pb_device_mode_change_state_t state;
+} pb_device_mode_change_t;
+
 pb_device_t *pb_device_get_device(pbio_port_id_t port, pbio_iodev_type_id_t valid_id);
 
+/**
+ * Waits until device detection has completed on all of the given ports.
+ *
+ * Ports with nothing attached are not an error here. That is reported when
+ * the device object is created.
+ *
+ * Raises MicroPython exception on error.
+ *
+ * @param [in]  ports       The ports to wait for.
+ * @param [in]  num_ports   The number of ports in @p ports.
+ */
+void pb_device_wait_ports(const pbio_port_id_t *ports, size_t num_ports);
+
 void pb_device_get_values(pb_device_t *pbdev, uint8_t mode, int32_t *values);
 
 void pb_device_set_values(pb_device_t *pbdev, uint8_t mode, int32_t *values, uint8_t num_values);
@@ -30,6 +75,42 @@ uint8_t pb_device_get_num_values(pb_device_t *pbdev);
 
 int8_t pb_device_get_mode_id_from_str(pb_device_t *pbdev, const char *mode_str);
 
+/**
+ * Gets the communication statistics of a UART device.
+ *
+ * Raises MicroPython exception if this is not a UART device.
+ *
+ * @param [in]  pbdev       The device.
+ * @param [out] stats       The statistics.
+ */
+void pb_device_get_uart_stats(pb_device_t *pbdev, pbio_uartdev_stats_t *stats);
+
+/**
+ * Sets a trigger that is evaluated each time the device sends new data.
+ *
+ * Switches the device to the mode of the trigger first, blocking until done.
+ * Raises MicroPython exception on error.
+ *
+ * @param [in]  pbdev       The device.
+ * @param [in]  trigger     The trigger settings.
+ */
+void pb_device_set_trigger(pb_device_t *pbdev, const pbio_iodev_trigger_t *trigger);
+
+/**
+ * Disables the trigger of a device.
+ *
+ * @param [in]  pbdev       The device.
+ */
+void pb_device_clear_trigger(pb_device_t *pbdev);
+
+/**
+ * Gets how many times the trigger of a device fired since it was set.
+ *
+ * @param [in]  pbdev       The device.
+ * @return                  The count.
+ */
+uint32_t pb_device_get_trigger_count(pb_device_t *pbdev);
+
 /**
  * Sets up the motor/port to get it ready to be used.
  *
@@ -40,4 +121,31 @@ int8_t pb_device_get_mode_id_from_str(pb_device_t *pbdev, const char *mode_str);
  */
 void pb_device_setup_motor(pbio_port_id_t port, bool is_servo);
 
+/**
+ * Calls a device method without blocking on mode changes.
+ *
+ * If the method needs a mode change, the method is aborted by raising an
+ * internal exception derived from BaseException, and the mode change is
+ * advanced on subsequent calls without blocking. Once the new mode
+ * is ready, the method is called again.
+ *
+ * Raises MicroPython exception on error.
+ *
+ * @param [in]  change      Mode change state, initialized to zero.
+ * @param [in]  func        The method to call.
+ * @param [in]  n_args      The number of arguments.
+ * @param [in]  args        The arguments.
+ * @param [out] result      The return value of the method.
+ * @return                  True if the method completed, false if this
+ *                          function must be called again later.
+ */
+bool pb_device_call_nonblocking(pb_device_mode_change_t *change, mp_obj_t func, size_t n_args, const mp_obj_t *args, mp_obj_t *result);
+
+/**
+ * Cancels a mode change started by pb_device_call_nonblocking().
+ *
+ * @param [in]  change      Mode change state.
+ */
+void pb_device_cancel_nonblocking(pb_device_mode_change_t *change);
+
 #endif // _PBDEVICE_H_
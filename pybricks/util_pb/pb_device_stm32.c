@@ -12,6 +12,7 @@
 #include <pbdrv/motor_driver.h>
 #include <pbio/color.h>
 #include <pbio/iodev.h>
+#include <pbio/uartdev.h>
 
 #include "py/mphal.h"
 #include "py/obj.h"
@@ -20,6 +21,9 @@
 #include <pybricks/util_pb/pb_device.h>
 #include <pybricks/util_pb/pb_error.h>
 
+// Time in ms between checks whether device detection on a port has completed.
+#define PB_DEVICE_DETECT_POLL_MS (50)
+
 struct _pb_device_t {
     pbio_iodev_t iodev;
 };
@@ -59,6 +63,15 @@ static uint32_t get_mode_switch_delay(pbio_iodev_type_id_t id, uint8_t mode) {
     }
 }
 
+// Mode change state of pb_device_call_nonblocking() while it calls a method.
+static pb_device_mode_change_t *nonblocking_change;
+
+// Raised to abort a method that needs a mode change. It derives from
+// BaseException so that "except Exception" in Python code doesn't catch it.
+static MP_DEFINE_EXCEPTION(ModeChange, BaseException)
+
+static mp_obj_exception_t mode_change;
+
 static void set_mode(pbio_iodev_t *iodev, uint8_t new_mode) {
     pbio_error_t err;
 
@@ -66,6 +79,22 @@ static void set_mode(pbio_iodev_t *iodev, uint8_t new_mode) {
         return;
     }
 
+    // Instead of blocking, abort the method and let the caller of
+    // pb_device_call_nonblocking() take care of the mode change.
+    if (nonblocking_change) {
+        nonblocking_change->iodev = iodev;
+        nonblocking_change->mode = new_mode;
+        nonblocking_change->state = PB_DEVICE_MODE_CHANGE_BEGIN;
+
+        // Preallocated so that no memory is needed to abort the method.
+        mode_change.base.type = &mp_type_ModeChange;
+        mode_change.traceback_alloc = 0;
+        mode_change.traceback_len = 0;
+        mode_change.traceback_data = NULL;
+        mode_change.args = (mp_obj_tuple_t *)&mp_const_empty_tuple_obj;
+        nlr_raise(MP_OBJ_FROM_PTR(&mode_change));
+    }
+
     while ((err = pbio_iodev_set_mode_begin(iodev, new_mode)) == PBIO_ERROR_AGAIN) {
         MICROPY_EVENT_POLL_HOOK
     }
@@ -79,18 +108,60 @@ static void set_mode(pbio_iodev_t *iodev, uint8_t new_mode) {
     }
 }
 
-pb_device_t *pb_device_get_device(pbio_port_id_t port, pbio_iodev_type_id_t valid_id) {
-
-    // Get the iodevice
+// Waits for the device connection manager to identify the device on a port.
+static pbio_iodev_t *get_iodev(pbio_port_id_t port) {
     pbio_iodev_t *iodev;
     pbio_error_t err;
 
-    // Set up device
     while ((err = pbdrv_ioport_get_iodev(port, &iodev)) == PBIO_ERROR_AGAIN) {
-        mp_hal_delay_ms(50);
+        mp_hal_delay_ms(PB_DEVICE_DETECT_POLL_MS);
     }
     pb_assert(err);
 
+    return iodev;
+}
+
+void pb_device_wait_ports(const pbio_port_id_t *ports, size_t num_ports) {
+    // The ioport process detects devices on all ports concurrently, so we
+    // only have to wait for the slowest one instead of one port at a time.
+    for (;;) {
+        bool busy = false;
+
+        for (size_t i = 0; i < num_ports; i++) {
+            #if PYBRICKS_HUB_MOVEHUB
+            // Built-in motors have no I/O port to wait for.
+            if (ports[i] == PBIO_PORT_ID_A || ports[i] == PBIO_PORT_ID_B) {
+                continue;
+            }
+            #endif
+
+            pbio_iodev_t *iodev;
+            pbio_error_t err = pbdrv_ioport_get_iodev(ports[i], &iodev);
+
+            if (err == PBIO_ERROR_AGAIN) {
+                busy = true;
+                continue;
+            }
+
+            // Missing devices are reported when the device object is created.
+            if (err != PBIO_ERROR_NO_DEV) {
+                pb_assert(err);
+            }
+        }
+
+        if (!busy) {
+            return;
+        }
+
+        mp_hal_delay_ms(PB_DEVICE_DETECT_POLL_MS);
+    }
+}
+
+pb_device_t *pb_device_get_device(pbio_port_id_t port, pbio_iodev_type_id_t valid_id) {
+
+    // Get the iodevice
+    pbio_iodev_t *iodev = get_iodev(port);
+
     // Verify the ID or always allow generic LUMP device
     if (iodev->info->type_id != valid_id && valid_id != PBIO_IODEV_TYPE_ID_LUMP_UART) {
         pb_assert(PBIO_ERROR_NO_DEV);
@@ -227,6 +298,97 @@ int8_t pb_device_get_mode_id_from_str(pb_device_t *pbdev, const char *mode_str)
     return 0;
 }
 
+void pb_device_get_uart_stats(pb_device_t *pbdev, pbio_uartdev_stats_t *stats) {
+    pb_assert(pbio_uartdev_get_stats(&pbdev->iodev, stats));
+}
+
+void pb_device_set_trigger(pb_device_t *pbdev, const pbio_iodev_trigger_t *trigger) {
+    pbio_iodev_t *iodev = &pbdev->iodev;
+
+    if (trigger->mode >= iodev->info->num_modes || trigger->index >= iodev->info->mode_info[trigger->mode].num_values) {
+        pb_assert(PBIO_ERROR_INVALID_ARG);
+    }
+
+    // Disarm the old trigger so it can't fire during the mode change.
+    pbio_iodev_clear_trigger(iodev);
+    set_mode(iodev, trigger->mode);
+    pbio_iodev_set_trigger(iodev, trigger);
+}
+
+void pb_device_clear_trigger(pb_device_t *pbdev) {
+    pbio_iodev_clear_trigger(&pbdev->iodev);
+}
+
+uint32_t pb_device_get_trigger_count(pb_device_t *pbdev) {
+    return pbdev->iodev.trigger.count;
+}
+
+bool pb_device_call_nonblocking(pb_device_mode_change_t *change, mp_obj_t func, size_t n_args, const mp_obj_t *args, mp_obj_t *result) {
+    pbio_error_t err;
+
+    switch (change->state) {
+        case PB_DEVICE_MODE_CHANGE_BEGIN:
+            err = pbio_iodev_set_mode_begin(change->iodev, change->mode);
+            if (err == PBIO_ERROR_AGAIN) {
+                return false;
+            }
+            pb_assert(err);
+            change->state = PB_DEVICE_MODE_CHANGE_END;
+            return false;
+        case PB_DEVICE_MODE_CHANGE_END:
+            err = pbio_iodev_set_mode_end(change->iodev);
+            if (err == PBIO_ERROR_AGAIN) {
+                return false;
+            }
+            change->state = PB_DEVICE_MODE_CHANGE_IDLE;
+            pb_assert(err);
+            // Give some time for the mode to take effect and discard stale data
+            change->ready_time = mp_hal_ticks_ms() + get_mode_switch_delay(change->iodev->info->type_id, change->mode);
+            change->state = PB_DEVICE_MODE_CHANGE_DELAY;
+            return false;
+        case PB_DEVICE_MODE_CHANGE_DELAY:
+            if ((int32_t)(mp_hal_ticks_ms() - change->ready_time) < 0) {
+                return false;
+            }
+            change->state = PB_DEVICE_MODE_CHANGE_IDLE;
+            break;
+        default:
+            break;
+    }
+
+    // The mode is ready (or not known yet), so try the actual method.
+    nlr_buf_t nlr;
+    nonblocking_change = change;
+    if (nlr_push(&nlr) == 0) {
+        *result = mp_call_function_n_kw(func, n_args, 0, args);
+        nlr_pop();
+        nonblocking_change = NULL;
+        return true;
+    }
+    nonblocking_change = NULL;
+
+    // The method needs a mode change first, which set_mode() recorded.
+    if (nlr.ret_val == &mode_change) {
+        return false;
+    }
+
+    nlr_jump(nlr.ret_val);
+}
+
+void pb_device_cancel_nonblocking(pb_device_mode_change_t *change) {
+    if (change->state != PB_DEVICE_MODE_CHANGE_END) {
+        change->state = PB_DEVICE_MODE_CHANGE_IDLE;
+        return;
+    }
+
+    // Same as cancellation in wait().
+    pbio_iodev_set_mode_cancel(change->iodev);
+    while (pbio_iodev_set_mode_end(change->iodev) == PBIO_ERROR_AGAIN) {
+        MICROPY_VM_HOOK_LOOP
+    }
+    change->state = PB_DEVICE_MODE_CHANGE_IDLE;
+}
+
 void pb_device_setup_motor(pbio_port_id_t port, bool is_servo) {
     // HACK: Built-in motors on BOOST Move hub do not have I/O ports associated
     // with them.
@@ -237,14 +399,7 @@ void pb_device_setup_motor(pbio_port_id_t port, bool is_servo) {
     #endif
 
     // Get the iodevice
-    pbio_iodev_t *iodev;
-    pbio_error_t err;
-
-    // Set up device
-    while ((err = pbdrv_ioport_get_iodev(port, &iodev)) == PBIO_ERROR_AGAIN) {
-        mp_hal_delay_ms(50);
-    }
-    pb_assert(err);
+    pbio_iodev_t *iodev = get_iodev(port);
 
     // Only motors are allowed.
     if (!PBIO_IODEV_IS_DC_OUTPUT(iodev)) {
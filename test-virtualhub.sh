@@ -22,11 +22,21 @@ make -s -j $(nproc --all) -C "$BRICK_DIR"
 
 export MICROPY_MICROPYTHON="$BUILD_DIR/virtualhub-micropython"
 export PYTHONPATH="$PBIO_DIR/cpython"
-export PBIO_VIRTUAL_PLATFORM_MODULE=pbio_virtual.platform.robot
+
+# tests for the CPython side of the virtual hub
+python3 -m unittest discover --start-directory "$PBIO_DIR/cpython/tests"
+
+run_tests() {
+    ./run-tests.py "$@" || (code=$?; ./run-tests.py --print-failures; exit $code)
+}
 
 cd "$MP_TEST_DIR"
-./run-tests.py --test-dirs $(find "$PB_TEST_DIR/virtualhub" -type d) "$@" || \
-    (code=$?; ./run-tests.py --print-failures; exit $code)
+
+# Tests in the world directory need the sensors of the world platform.
+PBIO_VIRTUAL_PLATFORM_MODULE=pbio_virtual.platform.robot \
+    run_tests --test-dirs $(find "$PB_TEST_DIR/virtualhub" -type d -not -path "*/world") "$@"
+PBIO_VIRTUAL_PLATFORM_MODULE=pbio_virtual.platform.world \
+    run_tests --test-dirs "$PB_TEST_DIR/virtualhub/world" "$@"
 
 if [[ $COVERAGE ]]; then
     lcov --capture --output-file "$BUILD_DIR/lcov.info" \
@@ -0,0 +1,168 @@
+"""
+Hardware Module: Technic Hub, Prime Hub, Inventor Hub, Essential Hub, City Hub
+or virtual hub.
+
+Description: Measures the cost of frequently used Pybricks API calls.
+
+Wiring: Motors on ports A (left wheel, mounted mirrored) and B (right wheel).
+SPIKE Color Sensor on port C. This matches pbio_virtual.platform.benchmark,
+which is what run_api.py uses for the virtual hub.
+
+Prints the firmware version on a line that starts with "#", then one line per
+benchmark:
+
+    <name> <us per call> <bytes per call> <collections> <longest collection us>
+
+Values that are not available are printed as "-". The time and allocations of
+an empty call are subtracted from the other results. Allocations are measured
+as the growth of the heap during a short run without collections. Collections
+are counted during the timed runs. The longest collection is the longest since
+the program started. Only hubs keep collection statistics.
+
+Use run_api.py to run this and save the results.
+"""
+
+from pybricks import version
+from pybricks.geometry import Matrix
+from pybricks.parameters import Direction, Port
+from pybricks.pupdevices import ColorSensor, Motor
+from pybricks.robotics import DriveBase
+from pybricks.tools import StopWatch, wait
+
+try:
+    from pybricks.experimental import mem_stats
+except ImportError:
+
+    def mem_stats():
+        return (None, None, None, None)
+
+
+try:
+    # Only on the virtual hub, where the collector is not counted.
+    import gc
+except ImportError:
+    gc = None
+
+# Each sample runs until it takes at least this long, in ms.
+SAMPLE_TIME = 200
+
+# Number of samples. Only the fastest one is reported.
+SAMPLES = 3
+
+# Number of calls to measure allocations.
+ALLOC_CALLS = 20
+
+watch = StopWatch()
+
+
+def run(func, calls):
+    for _ in range(calls):
+        func()
+
+
+def time_calls(func, calls):
+    start = watch.time()
+    run(func, calls)
+    return watch.time() - start
+
+
+def measure_time(func):
+    # Find how many calls fit in one sample.
+    calls = 16
+    while time_calls(func, calls) < SAMPLE_TIME:
+        calls *= 2
+
+    # Keep the fastest sample, and collection stats of all of them.
+    start_stats = mem_stats()
+    best = min(time_calls(func, calls) for _ in range(SAMPLES))
+    end_stats = mem_stats()
+
+    collections = None
+    if start_stats[1] is not None:
+        collections = end_stats[1] - start_stats[1]
+
+    return best * 1000 / calls, collections, end_stats[3]
+
+
+def measure_alloc(func):
+    if gc:
+        gc.disable()
+
+    try:
+        # Retry if a collection happened, since the heap then shrinks.
+        for _ in range(5):
+            start_stats = mem_stats()
+            run(func, ALLOC_CALLS)
+            end_stats = mem_stats()
+
+            if start_stats[0] is None:
+                return None
+            if start_stats[1] == end_stats[1] and end_stats[0] >= start_stats[0]:
+                return (end_stats[0] - start_stats[0]) / ALLOC_CALLS
+
+        return None
+    finally:
+        if gc:
+            gc.enable()
+
+
+def fmt(value):
+    if value is None:
+        return "-"
+    if isinstance(value, float):
+        return "{:.2f}".format(value)
+    return str(value)
+
+
+def nothing():
+    pass
+
+
+# Devices used by the benchmarks.
+left = Motor(Port.A, Direction.COUNTERCLOCKWISE)
+right = Motor(Port.B)
+sensor = ColorSensor(Port.C)
+drive_base = DriveBase(left, right, 56, 112)
+
+A = Matrix([[1, 2, 3], [4, 5, 6], [7, 8, 9]])
+B = Matrix([[9, 8, 7], [6, 5, 4], [3, 2, 1]])
+
+
+def motor_run():
+    right.run(500)
+
+
+def matrix_multiply():
+    A * B
+
+
+def wait_0():
+    wait(0)
+
+
+BENCHMARKS = (
+    ("Motor.angle", right.angle),
+    ("Motor.run", motor_run),
+    ("DriveBase.state", drive_base.state),
+    ("Matrix.__mul__", matrix_multiply),
+    ("ColorSensor.hsv", sensor.hsv),
+    ("StopWatch.time", watch.time),
+    ("wait", wait_0),
+)
+
+print("#", *version)
+
+# Make sure the sensor is in the right mode before measuring.
+sensor.hsv()
+
+overhead, _, _ = measure_time(nothing)
+alloc_overhead = measure_alloc(nothing)
+
+for name, func in BENCHMARKS:
+    time_us, collections, gc_max_us = measure_time(func)
+    alloc = measure_alloc(func)
+    if alloc is not None and alloc_overhead is not None:
+        alloc = max(alloc - alloc_overhead, 0)
+    print(name, fmt(max(time_us - overhead, 0)), fmt(alloc), fmt(collections), fmt(gc_max_us))
+
+right.stop()
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2023 The Pybricks Authors
+
+"""
+Runs api.py on the virtual hub or on a hub and saves the results as JSON.
+
+Run from the top-level directory after building the virtual hub:
+
+    ./tests/pup/benchmark/run_api.py --output api.json
+
+Or on the first hub found over Bluetooth (requires pybricksdev):
+
+    ./tests/pup/benchmark/run_api.py --hub --output api.json
+
+With --baseline, the results are compared to an earlier results file. The
+program fails if a call got slower than the tolerance allows or if it allocates
+more memory than before. Timings of different computers or hubs are not
+comparable, so only compare results from the same machine.
+"""
+
+import argparse
+import asyncio
+import json
+import os
+import subprocess
+import sys
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+TOP_DIR = os.path.join(SCRIPT_DIR, "..", "..", "..")
+SCRIPT = os.path.join(SCRIPT_DIR, "api.py")
+
+VIRTUALHUB = os.path.join(
+    TOP_DIR, "bricks", "virtualhub", "build", "virtualhub-micropython"
+)
+
+FIELDS = ("us_per_call", "alloc_bytes", "collections", "gc_max_us")
+
+
+def run_virtualhub(executable):
+    env = dict(os.environ)
+    env["PYTHONPATH"] = os.path.join(TOP_DIR, "lib", "pbio", "cpython")
+    env["PBIO_VIRTUAL_PLATFORM_MODULE"] = "pbio_virtual.platform.benchmark"
+
+    result = subprocess.run(
+        [executable, SCRIPT], env=env, capture_output=True, text=True
+    )
+    if result.returncode:
+        sys.stderr.write(result.stdout + result.stderr)
+        sys.exit(f"{SCRIPT} failed on the virtual hub")
+
+    return result.stdout.splitlines()
+
+
+async def run_hub():
+    from pybricksdev.ble import find_device
+    from pybricksdev.connections.pybricks import PybricksHub
+
+    device = await find_device()
+    hub = PybricksHub()
+    await hub.connect(device)
+    try:
+        await hub.run(SCRIPT)
+    finally:
+        await hub.disconnect()
+
+    return [line.decode() for line in hub.output]
+
+
+def parse_value(text):
+    if text == "-":
+        return None
+    return float(text) if "." in text else int(text)
+
+
+def parse(lines):
+    results = {"version": None, "benchmarks": {}}
+
+    for line in lines:
+        line = line.strip()
+        if line.startswith("#"):
+            results["version"] = line[1:].strip()
+            continue
+
+        words = line.split()
+        if len(words) != 1 + len(FIELDS):
+            # Not a result, so probably an error message.
+            sys.exit(f"unexpected output: {line}")
+
+        results["benchmarks"][words[0]] = dict(
+            zip(FIELDS, (parse_value(w) for w in words[1:]))
+        )
+
+    return results
+
+
+def compare(results, baseline, tolerance):
+    ok = True
+
+    for name, result in results["benchmarks"].items():
+        base = baseline["benchmarks"].get(name)
+        if base is None:
+            continue
+
+        limit = base["us_per_call"] * (1 + tolerance / 100)
+        if result["us_per_call"] > limit:
+            print(
+                f"{name}: {result['us_per_call']:.2f} us per call, "
+                f"was {base['us_per_call']:.2f}"
+            )
+            ok = False
+
+        if (
+            result["alloc_bytes"] is not None
+            and base["alloc_bytes"] is not None
+            and result["alloc_bytes"] > base["alloc_bytes"]
+        ):
+            print(
+                f"{name}: {result['alloc_bytes']:.2f} bytes per call, "
+                f"was {base['alloc_bytes']:.2f}"
+            )
+            ok = False
+
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument(
+        "--hub", action="store_true", help="run on a hub instead of the virtual hub"
+    )
+    parser.add_argument(
+        "--virtualhub",
+        default=VIRTUALHUB,
+        help="virtual hub executable (default: %(default)s)",
+    )
+    parser.add_argument("--output", help="file to write the results to")
+    parser.add_argument("--baseline", help="results of an earlier run")
+    parser.add_argument(
+        "--tolerance",
+        type=float,
+        default=25,
+        help="allowed slowdown in percent (default: %(default)s)",
+    )
+    args = parser.parse_args()
+
+    if args.hub:
+        lines = asyncio.run(run_hub())
+    else:
+        lines = run_virtualhub(args.virtualhub)
+
+    results = parse(lines)
+
+    print(results["version"])
+    for name, result in results["benchmarks"].items():
+        print(
+            f"{name:20}",
+            *(f"{'-' if v is None else v:>10}" for v in result.values()),
+        )
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(results, f, indent=4)
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        if not compare(results, baseline, args.tolerance):
+            sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
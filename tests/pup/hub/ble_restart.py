@@ -0,0 +1,23 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2023 The Pybricks Authors
+
+"""
+Hardware Module: Any hub with BLE broadcast and observe support.
+
+Description: Starts broadcasting and observing and ends the program right
+away, so that they are stopped after the program ends. Run this several times
+in quick succession. Each run must start broadcasting and observing again
+without errors, even while the stop tasks of the previous run may still be
+queued.
+"""
+
+from pybricks.hubs import ThisHub
+
+hub = ThisHub()
+
+for i in range(3):
+    hub.ble.broadcast(1, bytes([i]))
+
+# The hub does not receive its own broadcasts.
+assert hub.ble.observe(1) is None
+assert hub.ble.signal_strength(1) == -128
@@ -0,0 +1,56 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2023 The Pybricks Authors
+
+"""
+Hardware Module: 1
+
+Description: Verifies that sensor methods can be awaited so that mode changes
+do not block other tasks.
+"""
+
+from pybricks.pupdevices import ColorSensor
+from pybricks.parameters import Port
+from pybricks.tools import Awaitable, StopWatch
+
+# Initialize devices.
+color_sensor = ColorSensor(Port.B)
+
+
+# Reads all sensor modes, causing a mode change each time.
+async def read_all():
+    reflection = await Awaitable(color_sensor.reflection)
+    ambient = await Awaitable(color_sensor.ambient)
+    hsv = await Awaitable(color_sensor.hsv)
+    return reflection, ambient, hsv
+
+
+# Counts how often it runs while the other task is waiting.
+count = 0
+
+
+def count_forever():
+    global count
+    while True:
+        count += 1
+        yield
+
+
+# Run both tasks in a simple round-robin loop.
+watch = StopWatch()
+reader = read_all()
+counter = count_forever()
+result = None
+while result is None:
+    try:
+        reader.send(None)
+    except StopIteration as ex:
+        result = ex.value
+    counter.send(None)
+
+reflection, ambient, hsv = result
+assert 0 <= reflection <= 100
+assert 0 <= ambient <= 100
+
+# The counter task must have been running during the mode changes.
+assert count > 1, "Expected other task to run, but count is {0}".format(count)
+print("Read all modes in {0} ms with {1} other task iterations.".format(watch.time(), count))
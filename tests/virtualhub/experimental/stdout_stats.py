@@ -0,0 +1,8 @@
+from pybricks.experimental import stdout_stats
+
+# The virtual hub has no Bluetooth, so nothing is sent, but the statistics
+# have the same form as on hubs that have it.
+stats = stdout_stats()
+print(len(stats))
+print(all(type(value) is int for value in stats))
+print(stats)
@@ -0,0 +1,11 @@
+from pybricks.pupdevices import ColorSensor, UltrasonicSensor
+from pybricks.parameters import Port
+
+# The sensors of the robot in the world are emulated LEGO UART devices, so
+# this only works if they sync with the hub through the uartdev driver.
+color = ColorSensor(Port.C)
+ultrasonic = UltrasonicSensor(Port.D)
+
+# The robot is in the middle of an empty white table, facing the right edge.
+print(color.reflection())
+print(ultrasonic.distance())
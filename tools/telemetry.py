@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2023 The Pybricks Authors
+
+"""
+Reference decoder for telemetry records sent with ``hub.system.send()``.
+
+Connects to a hub running Pybricks firmware, subscribes to the Pybricks
+command/event characteristic and prints each telemetry record. If a
+``struct`` format is given, records are unpacked with it, otherwise they are
+printed as hex.
+
+Example::
+
+    ./tools/telemetry.py --name "Pybricks Hub" --format "<ii"
+"""
+
+import argparse
+import asyncio
+import struct
+import sys
+from typing import Optional
+
+from bleak import BleakClient, BleakScanner
+
+PYBRICKS_SERVICE_UUID = "c5f50001-8280-46da-89f4-6d8051e4aeef"
+PYBRICKS_COMMAND_EVENT_UUID = "c5f50002-8280-46da-89f4-6d8051e4aeef"
+
+# pbio_pybricks_event_t
+EVENT_STATUS_REPORT = 0
+EVENT_WRITE_TELEMETRY = 1
+
+
+def decode(data: bytes, fmt: Optional[str]) -> Optional[tuple]:
+    """Decodes a Pybricks event notification.
+
+    Arguments:
+        data: The notification value.
+        fmt: Optional ``struct`` format of the telemetry records.
+
+    Returns:
+        The record, unpacked if ``fmt`` is given, or ``None`` if the event is
+        not a telemetry record.
+
+    Raises:
+        struct.error: The record does not match ``fmt``.
+    """
+    if not data or data[0] != EVENT_WRITE_TELEMETRY:
+        return None
+
+    record = bytes(data[1:])
+
+    if fmt is None:
+        return (record.hex(" "),)
+
+    return struct.unpack(fmt, record)
+
+
+async def main(name: Optional[str], fmt: Optional[str]) -> None:
+    device = await BleakScanner.find_device_by_filter(
+        lambda d, ad: PYBRICKS_SERVICE_UUID in ad.service_uuids
+        and (name is None or d.name == name)
+    )
+
+    if device is None:
+        print("Hub not found.", file=sys.stderr)
+        exit(1)
+
+    def handle_notification(_, data: bytearray) -> None:
+        try:
+            record = decode(data, fmt)
+        except struct.error as e:
+            print(f"Bad record {bytes(data[1:]).hex(' ')}: {e}", file=sys.stderr)
+            return
+
+        if record is not None:
+            print(*record, sep="\t", flush=True)
+
+    async with BleakClient(device) as client:
+        await client.start_notify(PYBRICKS_COMMAND_EVENT_UUID, handle_notification)
+        print(f"Connected to {device.name}. Press CTRL+C to stop.", file=sys.stderr)
+
+        while client.is_connected:
+            await asyncio.sleep(0.1)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Print telemetry records from a hub.")
+    parser.add_argument("--name", help="name of the hub (default: first hub found)")
+    parser.add_argument("--format", help="struct format of the records (default: hex)")
+    args = parser.parse_args()
+
+    try:
+        asyncio.run(main(args.name, args.format))
+    except KeyboardInterrupt:
+        pass